@@ -23,6 +23,8 @@
 #include <QSqlQuery>
 #include <QMessageBox>
 #include <QFileDialog>
+#include <QDir>
+#include <QHash>
 
 #include <fstream>
 #include <iostream>
@@ -48,6 +50,31 @@
 
 #include <zip.h>
 
+namespace {
+
+/**
+ * @brief Lukee arkiston tiedostojen tiivisteet arkisto.sha256-tiedostosta
+ * @return tiedostonnimi, sha256 heksamuodossa
+ */
+QHash<QString,QByteArray> arkistonTiivisteet(const QDir& hakemisto)
+{
+    QHash<QString,QByteArray> tiivisteet;
+    QFile tiedosto( hakemisto.absoluteFilePath("arkisto.sha256"));
+    if( tiedosto.open(QIODevice::ReadOnly))
+    {
+        while( !tiedosto.atEnd())
+        {
+            QByteArray rivi = tiedosto.readLine().trimmed();
+            int vali = rivi.indexOf(' ');
+            if( vali > 0 )
+                tiivisteet.insert( QString::fromLatin1( rivi.mid(vali + 1)), rivi.left(vali));
+        }
+    }
+    return tiivisteet;
+}
+
+}
+
 ArkistoSivu::ArkistoSivu()
 {
     ui = new Ui::TilikausiMaaritykset;
@@ -204,6 +231,9 @@ void ArkistoSivu::vieArkisto()
                 return;
             }
 
+            // Tiedostojen tiivisteet lasketaan kopioitaessa ja verrataan arkistoitaessa laskettuihin
+            QHash<QString,QByteArray> tiivisteet = arkistonTiivisteet(mista);
+
             QProgressDialog odota(tr("Kopioidaan arkistoa"), tr("Peruuta"),0, tiedostot.count(),this);
             int kopioitu = 0;
 
@@ -223,6 +253,17 @@ void ArkistoSivu::vieArkisto()
                                           .arg(tiedosto));
                     return;
                 }
+                if( tiivisteet.contains(tiedosto) && tiivisteet.value(tiedosto) != tar.tiiviste())
+                {
+                    tar.lopeta();
+                    QFile::remove( arkisto );
+
+                    QMessageBox::critical(this, tr("Arkiston viennissä virhe"),
+                                          tr("Arkiston tiedosto %1 on muuttunut arkistoinnin jälkeen. "
+                                             "Muodosta arkisto uudelleen ennen vientiä.")
+                                          .arg(tiedosto));
+                    return;
+                }
 
                 odota.setValue(++kopioitu);
             }
@@ -400,24 +441,36 @@ bool ArkistoSivu::teeZip(const Tilikausi &kausi)
         QProgressDialog odota(tr("Kopioidaan arkistoa"), tr("Peruuta"),0, tiedostot.count(),this);
         int kopioitu = 0;
 
+        // Tiedostot luetaan levyltä vasta paketin sulkemisen aikana
+        // tiedosto kerrallaan, joten niitä ei pidetä muistissa
         for( const QString& tiedosto : tiedostot)
         {
             if( odota.wasCanceled())
+            {
+                zip_discard(paketti);
                 return false;
+            }
 
             QFileInfo info( mista.absoluteFilePath(tiedosto)) ;
 
             zip_source_t* lahde = zip_source_file(paketti, info.absoluteFilePath().toStdString().c_str(),
                                                   0,-1);
-            if( !lahde)
-                return false;
-            if( zip_file_add(paketti, info.fileName().toStdString().c_str(),
-                             lahde, 0) < 0)
+            if( !lahde || zip_file_add(paketti, info.fileName().toStdString().c_str(),
+                                       lahde, 0) < 0)
+            {
+                if( lahde )
+                    zip_source_free(lahde);
+                zip_discard(paketti);
                 return false;
+            }
 
             odota.setValue(++kopioitu);
         }
-        zip_close(paketti);
+        if( zip_close(paketti) < 0)
+        {
+            zip_discard(paketti);
+            return false;
+        }
 
         QMessageBox::information(this, tr("Arkiston vienti valmis"),
                              tr("Arkisto viety tiedostoon %1").arg(arkisto));
@@ -19,6 +19,7 @@
 
 #include <QSortFilterProxyModel>
 #include <QPalette>
+#include <QSqlQuery>
 
 BudjettiModel::BudjettiModel(QObject *parent)
     : QAbstractTableModel(parent)
@@ -79,8 +80,8 @@ QVariant BudjettiModel::data(const QModelIndex &index, int role) const
                 return proxy_->data( proxy_->index(index.row(), TiliModel::NIMI) ) ;
 
             case SENTIT:
-                QString tilinumero = proxy_->data( proxy_->index(index.row(), TiliModel::NUMERO) ).toString();
-                qlonglong sentit = sentit_.value( tilinumero, "0").toLongLong() ;
+                int tilinumero = proxy_->data( proxy_->index(index.row(), TiliModel::NUMERO) ).toInt();
+                qlonglong sentit = sentit_.value( tilinumero, 0) ;
                 if( role == Qt::EditRole)
                     return QVariant(sentit / 100.0);
 
@@ -130,10 +131,10 @@ Qt::ItemFlags BudjettiModel::flags(const QModelIndex &index) const
 
 bool BudjettiModel::setData(const QModelIndex &index, const QVariant &value, int /* role */)
 {
-    QString tilinumero = proxy_->data( proxy_->index(index.row(), TiliModel::NUMERO) ).toString();
+    int tilinumero = proxy_->data( proxy_->index(index.row(), TiliModel::NUMERO) ).toInt();
 
     if( value.toInt())
-        sentit_[tilinumero] = qRound(value.toDouble() * 100); // Delegaatti käsittelee senttejä
+        sentit_[tilinumero] = qRound64(value.toDouble() * 100); // Delegaatti käsittelee senttejä
     else
         sentit_.remove(tilinumero);          // Ei jätetä nollia kirjauksiin
 
@@ -148,8 +149,7 @@ void BudjettiModel::lataa(const QDate &paivamaara, int kohdennusid)
     paivamaara_ = paivamaara;
     kohdennusid_ = kohdennusid;
 
-    QVariantMap varmap = kp()->tilikaudet()->json(paivamaara_)->variant("Budjetti").toMap();
-    sentit_ = varmap.value( QString::number(kohdennusid_) ).toMap();
+    sentit_ = haeBudjetti( kp()->tilikaudet()->tilikausiPaivalle(paivamaara_).alkaa(), kohdennusid_);
     laskeSumma();
 
     endResetModel();
@@ -157,17 +157,31 @@ void BudjettiModel::lataa(const QDate &paivamaara, int kohdennusid)
 
 void BudjettiModel::tallenna()
 {
-    JsonKentta *json = kp()->tilikaudet()->json(paivamaara_);
+    QDate tilikausi = kp()->tilikaudet()->tilikausiPaivalle(paivamaara_).alkaa();
 
-    QVariantMap varmap = json->variant("Budjetti").toMap();
+    kp()->tietokanta()->transaction();
 
-    if( sentit_.isEmpty())
-        varmap.remove(QString::number(kohdennusid_) );
-    else
-        varmap.insert( QString::number(kohdennusid_), sentit_ );
+    QSqlQuery kysely( *kp()->tietokanta() );
+    kysely.prepare("DELETE FROM budjetti WHERE tilikausi=:tilikausi AND kohdennus=:kohdennus");
+    kysely.bindValue(":tilikausi", tilikausi);
+    kysely.bindValue(":kohdennus", kohdennusid_);
+    kysely.exec();
+
+    kysely.prepare("INSERT INTO budjetti(tilikausi, kohdennus, tilinro, sentit) "
+                   "VALUES (:tilikausi, :kohdennus, :tilinro, :sentit)");
+    QMapIterator<int,qlonglong> iter(sentit_);
+    while( iter.hasNext())
+    {
+        iter.next();
+        kysely.bindValue(":tilikausi", tilikausi);
+        kysely.bindValue(":kohdennus", kohdennusid_);
+        kysely.bindValue(":tilinro", iter.key());
+        kysely.bindValue(":sentit", iter.value());
+        kysely.exec();
+    }
 
-    json->setVar("Budjetti", varmap);
-    kp()->tilikaudet()->tallennaJSON();
+    kp()->tietokanta()->commit();
+    kp()->merkitseMuutos();     // Budjettivertailut muuttuvat
 
     muokattu_ = false;
     laskeSumma();
@@ -176,8 +190,8 @@ void BudjettiModel::tallenna()
 void BudjettiModel::laskeSumma()
 {
     qlonglong summa = 0;
-    for( const QVariant& var : sentit_.values() )
-        summa += var.toLongLong();
+    for( qlonglong sentit : sentit_ )
+        summa += sentit;
 
     emit summaMuuttui(summa);
 
@@ -188,12 +202,24 @@ void BudjettiModel::kopioiEdellinen()
     QDate pvm = kp()->tilikaudet()->tilikausiPaivalle( paivamaara_.addDays(-1) ).alkaa();
 
     beginResetModel();
-    QVariantMap varmap = kp()->tilikaudet()->json(pvm)->variant("Budjetti").toMap();
-    sentit_ = varmap.value( QString::number(kohdennusid_) ).toMap();
+    sentit_ = haeBudjetti( pvm, kohdennusid_);
     muokattu_ = true;
     laskeSumma();
 
     endResetModel();
 }
 
+QMap<int, qlonglong> BudjettiModel::haeBudjetti(const QDate &tilikausiAlkaa, int kohdennusid)
+{
+    QMap<int,qlonglong> sentit;
+
+    QSqlQuery& kysely = kp()->kysely("SELECT tilinro, sentit FROM budjetti "
+                                     "WHERE tilikausi=:tilikausi AND kohdennus=:kohdennus");
+    kysely.bindValue(":tilikausi", tilikausiAlkaa);
+    kysely.bindValue(":kohdennus", kohdennusid);
+    kysely.exec();
 
+    while( kysely.next())
+        sentit.insert( kysely.value(0).toInt(), kysely.value(1).toLongLong());
+    return sentit;
+}
@@ -27,10 +27,9 @@ class QSortFilterProxyModel;
  * @brief Budjetin model
  *
  * Yhden tilikauden budjetti yhdelle kohdennukselle.
- * Budjetti tallennetaan tilikauden json-tietueeseen Budjetti-kenttään, joka
- * sisältää QVarianMapillisen (avaimena kohdennuksen id) QVariantMappeja
- * (avaimena tilinumero ja arvona budjetti sentteinä). Menot syötetään negatiivisina
- * lukuina.
+ * Budjetti tallennetaan budjetti-tauluun, jossa kullakin tilikauden,
+ * kohdennuksen ja tilin yhdistelmällä on yksi rivi (budjetti sentteinä).
+ * Menot syötetään negatiivisina lukuina.
  *
  * @since 1.1
  *
@@ -73,7 +72,12 @@ signals:
 
 protected:
     QSortFilterProxyModel *proxy_;
-    QVariantMap sentit_;
+    QMap<int,qlonglong> sentit_;
+
+    /**
+     * @brief Tilikauden kohdennuksen budjetti sentteinä tilinumeroittain
+     */
+    static QMap<int,qlonglong> haeBudjetti(const QDate& tilikausiAlkaa, int kohdennusid);
 
     QDate paivamaara_;
     int kohdennusid_ = 0;
@@ -30,6 +30,7 @@
 #include <QPrinter>
 #include <QPainter>
 #include <QSqlError>
+#include <QElapsedTimer>
 
 Poistaja::Poistaja(QWidget *parent) :
     QDialog(parent),
@@ -49,6 +50,51 @@ bool Poistaja::teeSumuPoistot(Tilikausi kausi)
     return poistoDlg.sumupoistaja(kausi);
 }
 
+void Poistaja::haeSaldot(const QDate &paattyy, QMap<int, PoistoTili> &tilit, QHash<int, PoistoEra> &erat)
+{
+    // Tase-erän ensimmäinen vienti (id=eraid) on erän hankinta, jonka tiedoissa on poistoaika
+    QSqlQuery kysely( *kp()->tietokanta() );
+    kysely.prepare("SELECT tili.ysiluku, tili.tyyppi, vienti.tili, vienti.kohdennus, vienti.eraid, "
+                   "SUM(vienti.debetsnt), SUM(vienti.kreditsnt), era.tili, era.eraid, era.pvm, era.selite, "
+                   "era.debetsnt, era.kreditsnt, era.json, era.kohdennus "
+                   "FROM vienti JOIN tili ON vienti.tili=tili.id "
+                   "LEFT OUTER JOIN vienti AS era ON vienti.eraid=era.id "
+                   "WHERE tili.tyyppi IN ('APM','APT') AND vienti.pvm <= :paattyy "
+                   "GROUP BY vienti.tili, vienti.kohdennus, vienti.eraid "
+                   "ORDER BY era.pvm, vienti.eraid");
+    kysely.bindValue(":paattyy", paattyy);
+    kysely.exec();
+
+    while( kysely.next())
+    {
+        qlonglong saldo = kysely.value(5).toLongLong() - kysely.value(6).toLongLong();
+
+        PoistoTili& tili = tilit[ kysely.value(0).toInt() ];
+        tili.saldoSnt += saldo;
+        tili.kohdennuksittain[ kysely.value(3).toInt() ] += saldo;
+
+        int eraId = kysely.value(4).toInt();
+        bool eranAlku = eraId && kysely.value(7).toInt() == kysely.value(2).toInt() &&
+                kysely.value(8).toInt() == eraId;
+
+        if( kysely.value(1).toString() == "APT" && eranAlku)
+        {
+            if( !erat.contains(eraId))
+            {
+                PoistoEra era;
+                era.pvm = kysely.value(9).toDate();
+                era.selite = kysely.value(10).toString();
+                era.alkuSnt = kysely.value(11).toLongLong() - kysely.value(12).toLongLong();
+                era.poistoKk = JsonKentta( kysely.value(13).toByteArray() ).luku("Tasaerapoisto");
+                era.kohdennus = kysely.value(14).toInt();
+                erat.insert(eraId, era);
+                tili.erat.append(eraId);
+            }
+            erat[eraId].saldoSnt += saldo;
+        }
+    }
+}
+
 bool Poistaja::sumupoistaja(Tilikausi kausi)
 {
     EhdotusModel ehdotus;
@@ -74,13 +120,21 @@ bool Poistaja::sumupoistaja(Tilikausi kausi)
     kirjoittaja.lisaaOtsake(otsikko);
 
 
-    for( int i=0; i < kp()->tilit()->rowCount(QModelIndex()); i++)
+    QElapsedTimer ajastin;
+    ajastin.start();
+
+    QMap<int,PoistoTili> poistotilit;
+    QHash<int,PoistoEra> poistoerat;
+    haeSaldot( kausi.paattyy(), poistotilit, poistoerat);
+
+    QMapIterator<int,PoistoTili> iter( poistotilit );
+    while( iter.hasNext())
     {
-        Tili tili = kp()->tilit()->tiliIndeksilla(i);
-        if( !tili.onko(TiliLaji::POISTETTAVA))
-            continue;
+        iter.next();
+        Tili tili = kp()->tilit()->tiliYsiluvulla( iter.key() );
+        const PoistoTili& saldot = iter.value();
 
-        qlonglong saldo = tili.saldoPaivalle( kausi.paattyy());
+        qlonglong saldo = saldot.saldoSnt;
 
         if( !saldo)
             continue;
@@ -117,13 +171,15 @@ bool Poistaja::sumupoistaja(Tilikausi kausi)
 
             if( tili.json()->luku("Kohdennukset"))
             {
-                QSqlQuery kohkysely( QString("SELECT kohdennus, SUM(debetsnt), SUM(kreditsnt) FROM vienti WHERE "
-                                             "tili=%1 AND pvm < '%2' GROUP BY kohdennus ORDER BY kohdennus" )
-                                     .arg(tili.id()).arg(kausi.paattyy().toString(Qt::ISODate)) );
-                while( kohkysely.next())
+                QMapIterator<int,qlonglong> kohIter( saldot.kohdennuksittain );
+                while( kohIter.hasNext())
                 {
-                    Kohdennus kohdennus = kp()->kohdennukset()->kohdennus(kohkysely.value(0).toInt());
-                    qlonglong kohdsaldo = kohkysely.value(1).toLongLong() - kohkysely.value(2).toLongLong();
+                    kohIter.next();
+                    qlonglong kohdsaldo = kohIter.value();
+                    if( !kohdsaldo )
+                        continue;
+
+                    Kohdennus kohdennus = kp()->kohdennukset()->kohdennus( kohIter.key() );
                     qlonglong kohdpoisto = std::round( kohdsaldo * poistoprosentti / 100.0 );
                     qlonglong kohdjalkeen = kohdsaldo - kohdpoisto;
 
@@ -201,29 +257,15 @@ bool Poistaja::sumupoistaja(Tilikausi kausi)
             tiliRivi.lihavoi();
             kirjoittaja.lisaaRivi(tiliRivi);
 
-            EranValintaModel emodel;
-            emodel.lataa(tili, false, kausi.paattyy());
-            for(int eI=1; eI < emodel.rowCount(QModelIndex()); eI++)
+            for( int eranId : saldot.erat )
             {
-                QModelIndex eInd = emodel.index(eI, 0);
-
-                int eranId = eInd.data(EranValintaModel::EraIdRooli).toInt();
-                int eraSaldo = eInd.data(EranValintaModel::SaldoRooli).toInt();
-                QDate eranPvm = eInd.data(EranValintaModel::PvmRooli).toDate();
+                const PoistoEra& era = poistoerat[eranId];
+                qlonglong eraSaldo = era.saldoSnt;
+                qlonglong alkuSnt = era.alkuSnt;
+                int poistoKk = era.poistoKk;
+                QDate eranPvm = era.pvm;
 
-                int alkuSnt = 0;
-                int poistoKk = 0;
-
-                QSqlQuery alkuKysely;
-                alkuKysely.exec(QString("SELECT debetsnt, kreditsnt, json, kohdennus FROM vienti WHERE id=%1").arg(eranId) );
-                if( alkuKysely.next())
-                {
-                    alkuSnt = alkuKysely.value("debetsnt").toInt() - alkuKysely.value("kreditsnt").toInt();
-                    JsonKentta json( alkuKysely.value("json").toByteArray());
-                    poistoKk = json.luku("Tasaerapoisto");
-                }
-
-                if( !poistoKk)
+                if( !eraSaldo || !poistoKk)
                     continue;
 
                 // Montako kuukautta on kulunut hankinnasta
@@ -233,16 +275,16 @@ bool Poistaja::sumupoistaja(Tilikausi kausi)
 
 
                 // Laskennallinen poisto: Paljonko tähän asti voitaisiin poistaa
-                int laskennallinenPoisto = alkuSnt * kuukauttaKulunut / poistoKk ;
+                qlonglong laskennallinenPoisto = alkuSnt * kuukauttaKulunut / poistoKk ;
                 if( laskennallinenPoisto > alkuSnt)
                     laskennallinenPoisto = alkuSnt; // Poistetaan vain se, mitä on jäljellä ...
 
 
-                int eraPoisto = laskennallinenPoisto - alkuSnt + eraSaldo;
+                qlonglong eraPoisto = laskennallinenPoisto - alkuSnt + eraSaldo;
 
                 RaporttiRivi rr;
                 rr.lisaa( eranPvm );
-                rr.lisaa( eInd.data(EranValintaModel::SeliteRooli).toString());
+                rr.lisaa( era.selite );
                 rr.lisaa( eraSaldo );
                 if( poistoKk % 12)      // Poistoaika
                     rr.lisaa( tr( "%1 v %2 kk").arg(poistoKk / 12).arg(poistoKk % 12), 1, true);
@@ -259,10 +301,10 @@ bool Poistaja::sumupoistaja(Tilikausi kausi)
                 vienti.pvm = kausi.paattyy();
                 vienti.tili = tili;
                 vienti.kreditSnt = eraPoisto;
-                vienti.eraId = eInd.data(EranValintaModel::EraIdRooli).toInt();
-                vienti.selite = tr("Tasaeräpoisto %1 ").arg( eInd.data(EranValintaModel::SeliteRooli).toString() );
+                vienti.eraId = eranId;
+                vienti.selite = tr("Tasaeräpoisto %1 ").arg( era.selite );
                 // #123: Kohdennetaan poisto kirjauksen kohdennuksen mukaan
-                vienti.kohdennus = kp()->kohdennukset()->kohdennus( alkuKysely.value("kohdennus").toInt() );
+                vienti.kohdennus = kp()->kohdennukset()->kohdennus( era.kohdennus );
                 ehdotus.lisaaVienti(vienti);
 
                 VientiRivi poistotilille;
@@ -272,7 +314,7 @@ bool Poistaja::sumupoistaja(Tilikausi kausi)
                 poistotilille.selite = tr("Tasaeräpoisto %3 tilillä %1 %2")
                         .arg(tili.numero())
                         .arg(tili.nimi())
-                        .arg( eInd.data(EranValintaModel::SeliteRooli).toString());
+                        .arg( era.selite );
                 ehdotus.lisaaVienti(poistotilille);
 
             }
@@ -281,6 +323,8 @@ bool Poistaja::sumupoistaja(Tilikausi kausi)
         }
     }
 
+    ui->aikaLabel->setText( tr("Poistot laskettu %1 ms:ssa").arg( ajastin.elapsed() ));
+
     // Näytetään ehdotus
 
 
@@ -59,6 +59,40 @@ public:
     bool static onkoPoistoja(const Tilikausi &kausi);
 
 private:
+    /**
+     * @brief Poistettavan tilin saldot
+     */
+    struct PoistoTili
+    {
+        qlonglong saldoSnt = 0;
+        QMap<int,qlonglong> kohdennuksittain;   /** kohdennuksen id, saldo */
+        QList<int> erat;                        /** Tase-erien id:t erän päivämäärän mukaan */
+    };
+
+    /**
+     * @brief Tasaeräpoistettavan tase-erän tiedot
+     */
+    struct PoistoEra
+    {
+        QDate pvm;
+        QString selite;
+        qlonglong alkuSnt = 0;
+        qlonglong saldoSnt = 0;
+        int poistoKk = 0;
+        int kohdennus = 0;
+    };
+
+    /**
+     * @brief Hakee kaikkien poistettavien tilien saldot yhdellä kyselyllä
+     *
+     * Saldot ryhmitellään tilin, kohdennuksen ja tase-erän mukaan
+     *
+     * @param paattyy Päivä, jonka saldot haetaan
+     * @param tilit Tilit ysiluvun mukaan
+     * @param erat Tasaeräpoistojen tase-erät id:n mukaan
+     */
+    static void haeSaldot(const QDate& paattyy, QMap<int,PoistoTili>& tilit, QHash<int,PoistoEra>& erat);
+
     bool sumupoistaja(Tilikausi kausi);
 
 
@@ -20,6 +20,7 @@
 #include <QByteArray>
 
 #include <QDateTime>
+#include <QCryptographicHash>
 
 #include "tararkisto.h"
 
@@ -56,16 +57,56 @@ bool TarArkisto::lisaaTiedosto(const QString &polku)
         return false;
     }
 
+    return lisaaTiedosto( info.fileName(), &in, info.size(), info.fileTime(QFileDevice::FileModificationTime) );
+}
+
+bool TarArkisto::lisaaTiedosto(const QString &nimi, QIODevice *lahde, qint64 koko, const QDateTime &muokattu)
+{
+    tiiviste_.clear();
+
+    // Ensin otsake
+    if( write( otsake(nimi, koko, muokattu) ) != 512 )
+        return false;
+
+    // Sitten tiedosto puskuri kerrallaan, samalla tiivisteen laskien
+    QCryptographicHash sha( QCryptographicHash::Sha256 );
+    QByteArray puskuri( 64 * 1024, '\0');
+    qint64 jaljella = koko;
+
+    while( jaljella > 0 )
+    {
+        qint64 luettu = lahde->read( puskuri.data(), qMin<qint64>( puskuri.size(), jaljella ) );
+        if( luettu <= 0 || write( puskuri.constData(), luettu ) != luettu )
+            return false;
+        sha.addData( puskuri.constData(), static_cast<int>(luettu) );
+        jaljella -= luettu;
+    }
+
+    // Ja lopuksi täytetään viimeinen tietue. Täyttä tietuetta ei täytetä,
+    // koska tyhjä tietue tulkittaisiin arkiston lopuksi
+    if( koko % 512 )
+    {
+        QByteArray tyhja( 512 - koko % 512, '\0');
+        if( write( tyhja ) != tyhja.size() )
+            return false;
+    }
+
+    tiiviste_ = sha.result().toHex();
+    return true;
+}
+
+QByteArray TarArkisto::otsake(const QString &nimi, qint64 koko, const QDateTime &muokattu) const
+{
     QByteArray otsake(512, '\0');
-    QByteArray tiedostonnimi = info.fileName().toLocal8Bit();
+    QByteArray tiedostonnimi = nimi.toLocal8Bit().left(99);
 
     otsake.replace(0, tiedostonnimi.length(), tiedostonnimi);
     otsake.replace(100, QByteArray("000644 ").size() , QByteArray("000644 "));
 
-    QByteArray koko = QString("%1 ").arg( info.size(), 11, 8, QChar('0') ).toLocal8Bit();
-    otsake.replace( 124, koko.size(), koko );
+    QByteArray kokoTeksti = QString("%1 ").arg( koko, 11, 8, QChar('0') ).toLocal8Bit();
+    otsake.replace( 124, kokoTeksti.size(), kokoTeksti );
 
-    QByteArray mtime = QString("%1 ").arg( info.fileTime(QFileDevice::FileModificationTime).toSecsSinceEpoch() , 11, 8, QChar('0') ).toLocal8Bit();
+    QByteArray mtime = QString("%1 ").arg( muokattu.toSecsSinceEpoch() , 11, 8, QChar('0') ).toLocal8Bit();
 
     otsake.replace( 136, mtime.size(), mtime);
     otsake.replace( 156, QByteArray("0").size(), QByteArray("0"));
@@ -79,27 +120,14 @@ bool TarArkisto::lisaaTiedosto(const QString &polku)
     otsake.replace( 0x151, QByteArray("000000 ").size(), QByteArray("000000 "));
 
     quint32 tarkastussumma = 32 * 8;
-    // Tarkastussumman laskenta
+    // Tarkastussumman laskenta etumerkittöminä tavuina
     for( int i=0; i < otsake.size(); i++)
-        tarkastussumma += otsake.at(i);
+        tarkastussumma += static_cast<unsigned char>( otsake.at(i) );
 
     QByteArray tarkaste = QString("%1 ").arg( tarkastussumma, 6, 8, QChar('0') ).toLocal8Bit();
     otsake.replace(148, tarkaste.length(), tarkaste);
 
-    // Nyt otsake on valmis kirjoitettavaksi
-    write( otsake );
-
-    // Sitten vielä kirjoitetaan tiedosto
-    write( in.readAll() );
-
-    // Ja lopuksi täytetään viimeinen tietue
-    int jaannos = 512 - info.size() % 512;
-    QByteArray tyhja( jaannos, '\0');
-    write( tyhja );
-
-
-    return true;
-
+    return otsake;
 }
 
 void TarArkisto::lopeta()
@@ -20,9 +20,14 @@
 
 #include <QFile>
 #include <QByteArray>
+#include <QDateTime>
 
 /**
  * @brief Tar-arkiston muodostaminen
+ *
+ * Tiedostot kopioidaan arkistoon kiinteän kokoisen puskurin kautta,
+ * joten suurtenkaan liitteiden vienti ei kasvata muistinkäyttöä.
+ * Kopioinnin yhteydessä lasketaan tiedoston sha256-tiiviste.
  */
 class TarArkisto : protected QFile
 {
@@ -43,6 +48,23 @@ public:
      */
     bool lisaaTiedosto(const QString& polku);
 
+    /**
+     * @brief Lisää arkistoon laitteesta luettavan tiedoston
+     * @param nimi Tiedoston nimi arkistossa
+     * @param lahde Avattu laite, josta luetaan koko tavua
+     * @param koko Tiedoston koko tavuina
+     * @param muokattu Tiedoston muokkausaika
+     * @return tosi, jos onnistui
+     * @since 1.1
+     */
+    bool lisaaTiedosto(const QString& nimi, QIODevice* lahde, qint64 koko, const QDateTime& muokattu);
+
+    /**
+     * @brief Viimeksi lisätyn tiedoston sha256-tiiviste heksamuodossa
+     * @since 1.1
+     */
+    QByteArray tiiviste() const { return tiiviste_; }
+
     /**
      * @brief Kirjoittaa päättävät kentät ja sulkee tiedoston
      * @return tosi, jos onnistui
@@ -50,7 +72,9 @@ public:
     void lopeta();
 
 protected:
+    QByteArray otsake(const QString& nimi, qint64 koko, const QDateTime& muokattu) const;
 
+    QByteArray tiiviste_;
 };
 
 #endif // TARARKISTO_H
@@ -18,11 +18,14 @@
 
 #include <QDir>
 #include <QFile>
+#include <QFileInfo>
 #include <QSqlQuery>
 #include <QSqlError>
 #include <QTextStream>
 #include <QCryptographicHash>
 #include <QApplication>
+#include <QRunnable>
+#include <QMutexLocker>
 
 #include "arkistoija.h"
 #include "db/tositemodel.h"
@@ -36,6 +39,46 @@
 
 #include <QDebug>
 
+namespace {
+
+/**
+ * @brief Yhden raportin kirjoittaminen arkistoon työsäikeessä
+ *
+ * Raportti on jo muodostettu, joten säikeessä ei käytetä tietokantaa
+ */
+class RaportinArkistointi : public QRunnable
+{
+public:
+    RaportinArkistointi(const RaportinKirjoittaja& raportti, const QString& polku, const QString& navi,
+                        QHash<QString,QByteArray>* tiivisteet, QMutex* lukko)
+        : raportti_(raportti), polku_(polku), navi_(navi), tiivisteet_(tiivisteet), lukko_(lukko) {}
+
+    void run() override
+    {
+        // Lisätään valikko tuohon kohtaan !
+        raportti_.asetaHtmlLisat("<link rel='stylesheet' type='text/css' href='arkisto.css'>", navi_);
+        QByteArray data = raportti_.html(true).toUtf8();
+
+        QFile tiedosto( polku_ );
+        tiedosto.open( QIODevice::WriteOnly);
+        tiedosto.write( data );
+        tiedosto.close();
+
+        QByteArray sha = QCryptographicHash::hash( data, QCryptographicHash::Sha256).toHex();
+        QMutexLocker lukitus( lukko_ );
+        tiivisteet_->insert( QFileInfo(polku_).fileName(), sha);
+    }
+
+protected:
+    RaportinKirjoittaja raportti_;
+    QString polku_;
+    QString navi_;
+    QHash<QString,QByteArray>* tiivisteet_;
+    QMutex* lukko_;
+};
+
+}
+
 Arkistoija::Arkistoija(Tilikausi tilikausi)
     : tilikausi_(tilikausi)
 {
@@ -534,7 +577,7 @@ void Arkistoija::kirjoitaIndeksiJaArkistoiRaportit()
                     raportoija.lisaaTasepaiva(edellinenkausi.paattyy());
             }
 
-            arkistoiTiedosto( tiedostonnimi, raportoija.raportti().html(true) );
+            arkistoiRaportti( tiedostonnimi, raportoija.raportti() );
 
             if( raportti.contains(QChar('/')))
                     raportti.truncate( raportti.indexOf(QChar('/')) );
@@ -553,6 +596,7 @@ void Arkistoija::kirjoitaIndeksiJaArkistoiRaportit()
         out << "<li><a href=taseerittely.html>" << tr("Tase-erittely") << "</a></li>";
     out << "</ul>";
 
+    odotaRaportit();
     kirjoitaHash();
 
     out << tr("<p class=info>Tämä kirjanpidon sähköinen arkisto on luotu %1 <a href=https://kitupiikki.info>Kitupiikki-ohjelman</a> versiolla %2 <br>")
@@ -577,22 +621,52 @@ void Arkistoija::kirjoitaIndeksiJaArkistoiRaportit()
 
 
 
-void Arkistoija::arkistoiTiedosto(const QString &tiedostonnimi, const QString &html)
+void Arkistoija::arkistoiRaportti(const QString &tiedostonnimi, const RaportinKirjoittaja &raportti)
 {
+    raporttijono_.append(tiedostonnimi);
+    raporttiSaikeet_.start( new RaportinArkistointi( raportti, hakemisto_.absoluteFilePath(tiedostonnimi), navipalkki(),
+                                                     &raporttiTiivisteet_, &tiivisteLukko_ ));
+}
 
-    QByteArray bArray;
-    QTextStream out( &bArray );
-    out.setCodec("UTF-8");
+void Arkistoija::arkistoiRaporttiVirtana(const QString &tiedostonnimi, std::function<void (RaportinKirjoittaja &)> kirjoitus)
+{
+    raporttijono_.append(tiedostonnimi);
+
+    QFile tiedosto( hakemisto_.absoluteFilePath(tiedostonnimi) );
+    tiedosto.open( QIODevice::WriteOnly);
+
+    RaportinKirjoittaja rk;
+    rk.asetaHtmlLisat("<link rel='stylesheet' type='text/css' href='arkisto.css'>", navipalkki());
+    rk.asetaVirta( &tiedosto, RaportinKirjoittaja::HTML, true);
+    kirjoitus( rk );
+    if( !rk.lopetaVirta() )
+        qWarning() << "Raportin arkistointi epäonnistui " << tiedostonnimi;
+    tiedosto.close();
+
+    // Tiiviste lasketaan kirjoitetusta tiedostosta
+    QCryptographicHash hash( QCryptographicHash::Sha256 );
+    tiedosto.open( QIODevice::ReadOnly );
+    hash.addData( &tiedosto );
+    tiedosto.close();
 
-    // Lisätään valikko tuohon kohtaan !
-    QString txt = html;
-    txt.insert( txt.indexOf("</head>"), "<link rel='stylesheet' type='text/css' href='arkisto.css'>");
-    txt.insert( txt.indexOf("<body>") + 6, navipalkki( ));
-    out << txt;
+    QMutexLocker lukitus( &tiivisteLukko_ );
+    raporttiTiivisteet_.insert( tiedostonnimi, hash.result().toHex());
+}
 
-    out.flush();
+void Arkistoija::odotaRaportit()
+{
+    raporttiSaikeet_.waitForDone();
 
-    arkistoiByteArray( tiedostonnimi, bArray );
+    // SHA-varmistus
+    for( const QString& tiedostonnimi : raporttijono_)
+    {
+        shaBytes.append( raporttiTiivisteet_.value(tiedostonnimi) );
+        shaBytes.append(" ");
+        shaBytes.append(tiedostonnimi.toLatin1());
+        shaBytes.append("\n");
+    }
+    raporttijono_.clear();
+    raporttiTiivisteet_.clear();
 }
 
 void Arkistoija::arkistoiByteArray(const QString &tiedostonnimi, const QByteArray &array)
@@ -657,18 +731,21 @@ QString Arkistoija::arkistoi(Tilikausi &tilikausi)
     arkistoija.luoHakemistot();
     arkistoija.arkistoiTositteet();
 
-    arkistoija.arkistoiTiedosto("taseerittely.html",
-                                 TaseErittely::kirjoitaRaportti( tilikausi.alkaa(), tilikausi.paattyy()).html(true) );
-    arkistoija.arkistoiTiedosto("paivakirja.html",
-                                PaivakirjaRaportti::kirjoitaRaportti( tilikausi.alkaa(), tilikausi.paattyy(), -1, false, false, true, true).html(true) );
-    arkistoija.arkistoiTiedosto("paakirja.html",
-                                PaakirjaRaportti::kirjoitaRaportti( tilikausi.alkaa(), tilikausi.paattyy(), -1, true, true).html(true));
-    arkistoija.arkistoiTiedosto("tililuettelo.html",
-                                TilikarttaRaportti::kirjoitaRaportti(TilikarttaRaportti::KAYTOSSA_TILIT, tilikausi, false, tilikausi.paattyy(),true).html(true));
-    arkistoija.arkistoiTiedosto("tositeluettelo.html",
-                                TositeluetteloRaportti::kirjoitaRaportti( tilikausi.alkaa(), tilikausi.paattyy(), true, true, false, false, true).html(true) );
-    arkistoija.arkistoiTiedosto("tositepaivakirja.html",
-                                TositeluetteloRaportti::kirjoitaRaportti( tilikausi.alkaa(), tilikausi.paattyy(), true, true, true, true, true).html(true));
+    arkistoija.arkistoiRaportti("taseerittely.html",
+                                 TaseErittely::kirjoitaRaportti( tilikausi.alkaa(), tilikausi.paattyy()) );
+    // Päiväkirja ja pääkirja ovat suurimmat raportit, joten ne kirjoitetaan suoraan tiedostoon
+    arkistoija.arkistoiRaporttiVirtana("paivakirja.html", [&tilikausi] (RaportinKirjoittaja& rk) {
+        PaivakirjaRaportti::kirjoita(rk, tilikausi.alkaa(), tilikausi.paattyy(), -1, false, false, true, true);
+    });
+    arkistoija.arkistoiRaporttiVirtana("paakirja.html", [&tilikausi] (RaportinKirjoittaja& rk) {
+        PaakirjaRaportti::kirjoita(rk, tilikausi.alkaa(), tilikausi.paattyy(), -1, true, true);
+    });
+    arkistoija.arkistoiRaportti("tililuettelo.html",
+                                TilikarttaRaportti::kirjoitaRaportti(TilikarttaRaportti::KAYTOSSA_TILIT, tilikausi, false, tilikausi.paattyy(),true) );
+    arkistoija.arkistoiRaportti("tositeluettelo.html",
+                                TositeluetteloRaportti::kirjoitaRaportti( tilikausi.alkaa(), tilikausi.paattyy(), true, true, false, false, true) );
+    arkistoija.arkistoiRaportti("tositepaivakirja.html",
+                                TositeluetteloRaportti::kirjoitaRaportti( tilikausi.alkaa(), tilikausi.paattyy(), true, true, true, true, true) );
 
     // Tämän pitää tulla lopuksi jotta hash toimii !!!
     arkistoija.kirjoitaIndeksiJaArkistoiRaportit();
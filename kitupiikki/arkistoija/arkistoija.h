@@ -29,11 +29,22 @@
 #include <QByteArray>
 #include <QTextStream>
 #include <QBuffer>
+#include <QThreadPool>
+#include <QMutex>
+#include <QHash>
 
 #include "db/kirjanpito.h"
+#include "raportti/raportinkirjoittaja.h"
 
 /**
  * @brief Arkiston kirjoittaja
+ *
+ * Raporttien tiedot haetaan tietokannasta pääsäikeessä, mutta niiden
+ * muuntaminen html-muotoon, tiivisteiden laskeminen ja tiedostojen
+ * kirjoittaminen tehdään rinnakkain työsäikeissä. Tiivisteet lisätään
+ * arkisto.sha256-tiedostoon lopuksi samassa järjestyksessä, jossa
+ * raportit arkistoitiin. Päiväkirja ja pääkirja kirjoitetaan kuitenkin
+ * pääsäikeessä suoraan tiedostoon, jotta niitä ei tarvitse pitää muistissa.
  */
 class Arkistoija : public QObject
 {
@@ -46,8 +57,25 @@ protected:
 
     void kirjoitaIndeksiJaArkistoiRaportit();
 
-    void arkistoiTiedosto(const QString& tiedostonnimi,
-                          const QString& html);
+    /**
+     * @brief Arkistoi raportin html-muodossa taustalla
+     */
+    void arkistoiRaportti(const QString& tiedostonnimi, const RaportinKirjoittaja& raportti);
+    /**
+     * @brief Kirjoittaa pitkän raportin suoraan tiedostoon
+     *
+     * Raportin rivit kirjoitetaan tiedostoon sitä mukaa kuin ne haetaan
+     * tietokannasta, joten koko raporttia ei pidetä muistissa. Tämä tehdään
+     * pääsäikeessä, koska raportti luetaan tietokannasta.
+     *
+     * @param kirjoitus Funktio, joka kirjoittaa raportin annettuun kirjoittajaan
+     * @since 1.1
+     */
+    void arkistoiRaporttiVirtana(const QString& tiedostonnimi, std::function<void(RaportinKirjoittaja&)> kirjoitus);
+    /**
+     * @brief Odottaa taustalla arkistoitavat raportit ja lisää niiden tiivisteet
+     */
+    void odotaRaportit();
 
     void arkistoiByteArray(const QString& tiedostonnimi, const QByteArray& array);
 
@@ -61,6 +89,11 @@ protected:
     bool onkoLogoa = false;
 
     QByteArray shaBytes;
+
+    QThreadPool raporttiSaikeet_;
+    QStringList raporttijono_;                  /** Raporttien tiedostonnimet arkistointijärjestyksessä */
+    QHash<QString,QByteArray> raporttiTiivisteet_;
+    QMutex tiivisteLukko_;
     
 public:    
     /**
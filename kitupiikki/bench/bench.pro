@@ -0,0 +1,19 @@
+# Suorituskykymittaukset synteettisellä kirjanpidolla
+#
+#   qmake kitupiikki.pro "CONFIG+=bench"
+#   ./bench/kitupiikki-bench --vuodet 3 --tositteita 20 -o tulos.json
+
+include(../kitupiikki.pri)
+
+TARGET = kitupiikki-bench
+
+TEMPLATE = app
+
+SOURCES += \
+    main.cpp \
+    generaattori.cpp \
+    suorituskykyajo.cpp
+
+HEADERS += \
+    generaattori.h \
+    suorituskykyajo.h
@@ -0,0 +1,447 @@
+/*
+   Copyright (C) 2018 Arto Hyvättinen
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QBuffer>
+#include <QFile>
+#include <QPainter>
+#include <QPdfWriter>
+#include <QSqlError>
+#include <QVariantMap>
+
+#include "generaattori.h"
+
+#include "db/kirjanpito.h"
+#include "db/tositemodel.h"
+#include "db/vientimodel.h"
+#include "db/liitemodel.h"
+#include "uusikp/uusikirjanpito.h"
+
+QJsonObject Mitoitus::json() const
+{
+    QJsonObject mitat;
+    mitat.insert("vuodet", vuodet);
+    mitat.insert("tositteitaPaivassa", tositteitaPaivassa);
+    mitat.insert("kohdennuksia", kohdennuksia);
+    mitat.insert("avoimiaEria", avoimiaEria);
+    mitat.insert("liitteita", liitteita);
+    mitat.insert("tilioterivit", tilioterivit);
+    mitat.insert("siemen", static_cast<qint64>(siemen));
+    return mitat;
+}
+
+KirjanpidonGeneraattori::KirjanpidonGeneraattori(const Mitoitus &mitoitus) :
+    mitoitus_( mitoitus ),
+    satunnainen_( mitoitus.siemen ),
+    alkaa_( 2017, 1, 1)
+{
+    // Kiinteä alkupäivä, jotta sama siemen tuottaa aina saman kirjanpidon
+    paattyy_ = alkaa_.addYears( qMax(1, mitoitus_.vuodet) ).addDays(-1);
+}
+
+KirjanpidonGeneraattori::~KirjanpidonGeneraattori()
+{
+    delete tosite_;
+}
+
+bool KirjanpidonGeneraattori::luo(const QString &polku, QString *virhe)
+{
+    virhe_ = virhe;
+
+    QVariantMap valinnat;
+    valinnat.insert("tilikartta", ":/tilikartat/tilitin.kpk");
+    valinnat.insert("nimi", "Suorituskyky Oy");
+    valinnat.insert("iban", "FI2112345600000785");
+    valinnat.insert("harjoitus", true);
+    valinnat.insert("alkaa", alkaa_);
+    valinnat.insert("paattyy", alkaa_.addYears(1).addDays(-1));
+    valinnat.insert("onekakausi", true);
+    valinnat.insert("suoriteperuste", true);
+
+    QFile::remove(polku);
+    if( !UusiKirjanpito::luoKirjanpito(polku, valinnat, virhe) || !virhe->isEmpty())
+        return false;
+
+    if( !kp()->avaaTietokanta(polku, false))
+    {
+        *virhe = Kirjanpito::tr("Luotua kirjanpitoa %1 ei voi avata").arg(polku);
+        return false;
+    }
+
+    if( !alusta())
+        return false;
+
+    for( QDate pvm = alkaa_; pvm <= paattyy_; pvm = pvm.addDays(1))
+        if( !kirjaaPaiva(pvm))
+            return false;
+
+    return true;
+}
+
+bool KirjanpidonGeneraattori::kirjoitaTiliote(const QString &polku)
+{
+    // Tiliote viimeiseltä neljältä viikolta
+    QDate mista = paattyy_.addDays(-27);
+    QStringList rivit;
+
+    QString alku(322, ' ');
+    alku.replace(0, 9, "T00322100");
+    alku.replace(26, 6, mista.toString("yyMMdd"));
+    alku.replace(32, 6, paattyy_.toString("yyMMdd"));
+    alku.replace(292, iban_.length(), iban_);
+    rivit.append(alku);
+
+    for(int i=0; i < mitoitus_.tilioterivit; i++)
+    {
+        QDate pvm = mista.addDays( i * 28 / mitoitus_.tilioterivit );
+        qlonglong sentit = 0;
+        QString viite;
+        QString iban;
+        QString selite;
+
+        if( i < avoimet_.count())
+        {
+            // Avoimen laskun maksu viitteellä
+            const AvoinEra& era = avoimet_.at(i);
+            sentit = era.iban.isEmpty() ? era.sentit : 0 - era.sentit;
+            viite = era.viite;
+            iban = era.iban;
+            selite = era.asiakas.toUpper();
+        }
+        else if( satunnainen_.bounded(2) )
+        {
+            sentit = summa();
+            selite = "TALLETUS";
+        }
+        else
+        {
+            sentit = 0 - summa();
+            selite = "KORTTIOSTO";
+        }
+
+        QString rivi(188, ' ');
+        rivi.replace(0, 6, "T10188");
+        rivi.replace(6, 6, QString("%1").arg(i + 1, 6, 10, QChar('0')));
+        rivi.replace(12, 18, QString("%1%2").arg(pvm.toString("yyMMdd")).arg(i + 1, 12, 10, QChar('0')));
+        rivi.replace(30, 6, pvm.toString("yyMMdd"));
+        rivi.replace(36, 6, pvm.toString("yyMMdd"));
+        rivi.replace(87, 1, sentit < 0 ? "-" : "+");
+        rivi.replace(88, 19, QString("%1").arg(qAbs(sentit), 19, 10, QChar('0')));
+        rivi.replace(108, qMin(35, selite.length()), selite.left(35));
+        if( !viite.isEmpty())
+            rivi.replace(159, 20, QString("%1").arg(viite, 20, QChar('0')));
+        rivit.append(rivi);
+
+        if( !iban.isEmpty())
+        {
+            // Saajan tilinumero täydentävänä tietona
+            QString lisatieto(78, ' ');
+            lisatieto.replace(0, 8, "T1107811");
+            lisatieto.replace(43, iban.length(), iban);
+            rivit.append(lisatieto);
+        }
+    }
+    // Viimeinen tapahtuma kirjataan, kun sitä seuraa jokin muu tietue
+    rivit.append( QString("T40050").leftJustified(50, ' ') );
+
+    QFile tiedosto(polku);
+    if( !tiedosto.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    return tiedosto.write( rivit.join("\r\n").toLatin1() ) > 0;
+}
+
+bool KirjanpidonGeneraattori::alusta()
+{
+    // Luonnin kestolla ei ole merkitystä, joten levylle kirjoittamista ei odoteta
+    kp()->tietokanta()->exec("PRAGMA synchronous=OFF");
+
+    for(int vuosi = 1; vuosi < mitoitus_.vuodet; vuosi++)
+        kp()->tilikaudet()->lisaaTilikausi( Tilikausi( alkaa_.addYears(vuosi), alkaa_.addYears(vuosi + 1).addDays(-1) ));
+
+    for(int i=0; i < mitoitus_.kohdennuksia; i++)
+        kp()->kohdennukset()->lisaaUusi( Kohdennus( Kohdennus::KUSTANNUSPAIKKA, QString("Kustannuspaikka %1").arg(i + 1) ));
+    kp()->kohdennukset()->tallenna();
+    for(int i=0; i < mitoitus_.kohdennuksia; i++)
+        kohdennukset_.append( kp()->kohdennukset()->kohdennus( QString("Kustannuspaikka %1").arg(i + 1) ));
+
+    for(int i=0; i < kp()->tilit()->rowCount(QModelIndex()); i++)
+    {
+        Tili tili = kp()->tilit()->tiliIndeksilla(i);
+        if( tili.otsikkotaso() || !tili.tila())
+            continue;
+        if( tili.onko(TiliLaji::TULO))
+            tulotilit_.append(tili);
+        else if( tili.onko(TiliLaji::MENO))
+            menotilit_.append(tili);
+    }
+
+    myyntilaji_ = tositelaji(TositelajiModel::MYYNTILASKUT);
+    ostolaji_ = tositelaji(TositelajiModel::OSTOLASKUT);
+    tiliotelaji_ = tositelaji(TositelajiModel::TILIOTE);
+
+    pankkitili_ = kp()->tilit()->tiliNumerolla( kp()->asetukset()->luku("LaskuTili") );
+    iban_ = pankkitili_.json()->str("IBAN");
+
+    if( tulotilit_.isEmpty() || menotilit_.isEmpty() || !myyntilaji_.isValid() || !ostolaji_.isValid() ||
+        !tiliotelaji_.isValid() || !pankkitili_.onkoValidi() || iban_.isEmpty())
+    {
+        *virhe_ = Kirjanpito::tr("Tilikartasta puuttuu mittauksissa tarvittavia tilejä tai tositelajeja");
+        return false;
+    }
+
+    tosite_ = kp()->tositemodel();
+
+    // Liitteet jaetaan tasaisesti tositteiden kesken
+    int arvio = ( alkaa_.daysTo(paattyy_) + 1 ) * mitoitus_.tositteitaPaivassa;
+    if( mitoitus_.liitteita > 0)
+        liitevali_ = qMax(1, arvio / mitoitus_.liitteita);
+
+    return true;
+}
+
+bool KirjanpidonGeneraattori::kirjaaPaiva(const QDate &pvm)
+{
+    for(int i=0; i < mitoitus_.tositteitaPaivassa; i++)
+    {
+        bool onnistui = true;
+        int valinta = satunnainen_.bounded(100);
+
+        if( valinta < 35)
+            onnistui = kirjaaMyyntilasku(pvm);
+        else if( valinta < 65)
+            onnistui = kirjaaOstolasku(pvm);
+        else if( valinta < 85 && !avoimet_.isEmpty())
+            onnistui = kirjaaMaksu(pvm, satunnainen_.bounded( avoimet_.count() ));
+        else
+            onnistui = kirjaaPankkikulu(pvm);
+
+        // Vanhimmat laskut maksetaan, jotta avoimia eriä on korkeintaan mitoituksen verran
+        while( onnistui && avoimet_.count() > mitoitus_.avoimiaEria)
+            onnistui = kirjaaMaksu(pvm, 0);
+
+        if( !onnistui )
+            return false;
+    }
+    return true;
+}
+
+bool KirjanpidonGeneraattori::kirjaaMyyntilasku(const QDate &pvm)
+{
+    AvoinEra era;
+    era.sentit = summa();
+    era.viite = QString::number( 1000 + ++laskuja_ );
+    era.asiakas = QString("Asiakas %1").arg( satunnainen_.bounded(1, 51) );
+
+    aloitaTosite(pvm, myyntilaji_, era.asiakas);
+
+    VientiRivi saatava;
+    saatava.pvm = pvm;
+    saatava.tili = kp()->tilit()->tiliNumerolla( myyntilaji_.data(TositelajiModel::VastatiliNroRooli).toInt() );
+    saatava.debetSnt = era.sentit;
+    saatava.eraId = TaseEra::UUSIERA;
+    saatava.viite = era.viite;
+    saatava.laskupvm = pvm;
+    saatava.erapvm = pvm.addDays(14);
+    saatava.asiakas = era.asiakas;
+    saatava.selite = era.asiakas;
+    tosite_->vientiModel()->lisaaVienti(saatava);
+
+    VientiRivi myynti;
+    myynti.pvm = pvm;
+    myynti.tili = tulotilit_.at( satunnainen_.bounded( tulotilit_.count() ));
+    myynti.kreditSnt = era.sentit;
+    myynti.kohdennus = kohdennus();
+    myynti.selite = era.asiakas;
+    tosite_->vientiModel()->lisaaVienti(myynti);
+
+    if( !tallennaTosite())
+        return false;
+
+    era.eraId = tosite_->vientiModel()->index(0, 0).data(VientiModel::IdRooli).toInt();
+    avoimet_.append(era);
+    return true;
+}
+
+bool KirjanpidonGeneraattori::kirjaaOstolasku(const QDate &pvm)
+{
+    int toimittaja = satunnainen_.bounded(1, 21);
+
+    AvoinEra era;
+    era.sentit = summa();
+    era.viite = QString::number( 1000 + ++laskuja_ );
+    era.iban = QString("FI55%1").arg( 10000000000000LL + toimittaja, 14, 10, QChar('0'));
+    era.asiakas = QString("Toimittaja %1").arg(toimittaja);
+
+    aloitaTosite(pvm, ostolaji_, era.asiakas);
+
+    VientiRivi kulu;
+    kulu.pvm = pvm;
+    kulu.tili = menotilit_.at( satunnainen_.bounded( menotilit_.count() ));
+    kulu.debetSnt = era.sentit;
+    kulu.kohdennus = kohdennus();
+    kulu.selite = era.asiakas;
+    tosite_->vientiModel()->lisaaVienti(kulu);
+
+    VientiRivi velka;
+    velka.pvm = pvm;
+    velka.tili = kp()->tilit()->tiliNumerolla( ostolaji_.data(TositelajiModel::VastatiliNroRooli).toInt() );
+    velka.kreditSnt = era.sentit;
+    velka.eraId = TaseEra::UUSIERA;
+    velka.viite = era.viite;
+    velka.ibanTili = era.iban;
+    velka.laskupvm = pvm;
+    velka.erapvm = pvm.addDays(21);
+    velka.asiakas = era.asiakas;
+    velka.selite = era.asiakas;
+    tosite_->vientiModel()->lisaaVienti(velka);
+
+    if( !tallennaTosite())
+        return false;
+
+    era.eraId = tosite_->vientiModel()->index(1, 0).data(VientiModel::IdRooli).toInt();
+    avoimet_.append(era);
+    return true;
+}
+
+bool KirjanpidonGeneraattori::kirjaaMaksu(const QDate &pvm, int indeksi)
+{
+    AvoinEra era = avoimet_.takeAt(indeksi);
+    bool myynti = era.iban.isEmpty();
+
+    aloitaTosite(pvm, tiliotelaji_, era.asiakas);
+
+    VientiRivi pankki;
+    pankki.pvm = pvm;
+    pankki.tili = pankkitili_;
+    pankki.selite = era.asiakas;
+
+    VientiRivi lasku;
+    lasku.pvm = pvm;
+    lasku.tili = kp()->tilit()->tiliNumerolla( ( myynti ? myyntilaji_ : ostolaji_ ).data(TositelajiModel::VastatiliNroRooli).toInt() );
+    lasku.eraId = era.eraId;
+    lasku.selite = era.asiakas;
+
+    if( myynti )
+    {
+        pankki.debetSnt = era.sentit;
+        lasku.kreditSnt = era.sentit;
+    }
+    else
+    {
+        lasku.debetSnt = era.sentit;
+        pankki.kreditSnt = era.sentit;
+    }
+
+    tosite_->vientiModel()->lisaaVienti(pankki);
+    tosite_->vientiModel()->lisaaVienti(lasku);
+    return tallennaTosite();
+}
+
+bool KirjanpidonGeneraattori::kirjaaPankkikulu(const QDate &pvm)
+{
+    aloitaTosite(pvm, tiliotelaji_, "Palvelumaksu");
+
+    qlonglong sentit = satunnainen_.bounded(100, 5000);
+
+    VientiRivi kulu;
+    kulu.pvm = pvm;
+    kulu.tili = menotilit_.at( satunnainen_.bounded( menotilit_.count() ));
+    kulu.debetSnt = sentit;
+    kulu.selite = "Palvelumaksu";
+    tosite_->vientiModel()->lisaaVienti(kulu);
+
+    VientiRivi pankki;
+    pankki.pvm = pvm;
+    pankki.tili = pankkitili_;
+    pankki.kreditSnt = sentit;
+    pankki.selite = "Palvelumaksu";
+    tosite_->vientiModel()->lisaaVienti(pankki);
+
+    return tallennaTosite();
+}
+
+void KirjanpidonGeneraattori::aloitaTosite(const QDate &pvm, const QModelIndex &laji, const QString &otsikko)
+{
+    tosite_->tyhjaa();
+    tosite_->asetaPvm(pvm);
+    tosite_->asetaTositelaji( laji.data(TositelajiModel::IdRooli).toInt() );
+    // Tunniste lasketaan tilikauden mukaan, joka vaihtuu päivämäärän mukana
+    tosite_->asetaTunniste( tosite_->seuraavaTunnistenumero() );
+    tosite_->asetaOtsikko(otsikko);
+}
+
+bool KirjanpidonGeneraattori::tallennaTosite()
+{
+    if( liitteita_ < mitoitus_.liitteita && tositteita_ % liitevali_ == 0)
+    {
+        tosite_->liiteModel()->lisaaLiite( liite( ++liitteita_ ), Kirjanpito::tr("Kuitti"));
+    }
+
+    if( !tosite_->tallenna())
+    {
+        *virhe_ = Kirjanpito::tr("Tositteen %1 tallentaminen epäonnistui: %2")
+                .arg( tosite_->otsikko() ).arg( kp()->tietokanta()->lastError().text() );
+        return false;
+    }
+    tositteita_++;
+    return true;
+}
+
+QModelIndex KirjanpidonGeneraattori::tositelaji(int kirjaustyyppi) const
+{
+    for(int i=0; i < kp()->tositelajit()->rowCount(QModelIndex()); i++)
+    {
+        QModelIndex indeksi = kp()->tositelajit()->index(i, 0);
+        if( indeksi.data(TositelajiModel::KirjausTyyppiRooli).toInt() == kirjaustyyppi)
+            return indeksi;
+    }
+    return QModelIndex();
+}
+
+QByteArray KirjanpidonGeneraattori::liite(int numero) const
+{
+    QByteArray data;
+    QBuffer puskuri(&data);
+    puskuri.open(QIODevice::WriteOnly);
+
+    QPdfWriter pdf(&puskuri);
+    pdf.setTitle( QString("Kuitti %1").arg(numero));
+
+    // Tekstiä hakuindeksiä varten
+    QPainter painter(&pdf);
+    painter.drawText( QRect(0, 0, pdf.width(), pdf.height() / 4), Qt::TextWordWrap,
+                      QString("Kuitti %1\n%2\n%3\nYhteensä %4 €")
+                      .arg(numero)
+                      .arg( tosite_->pvm().toString("dd.MM.yyyy"))
+                      .arg( tosite_->otsikko())
+                      .arg( tosite_->vientiModel()->debetSumma() / 100.0, 0, 'f', 2));
+    painter.end();
+
+    return data;
+}
+
+qlonglong KirjanpidonGeneraattori::summa()
+{
+    return satunnainen_.bounded(1000, 200000);
+}
+
+Kohdennus KirjanpidonGeneraattori::kohdennus()
+{
+    if( kohdennukset_.isEmpty())
+        return Kohdennus();
+    return kohdennukset_.at( satunnainen_.bounded( kohdennukset_.count() ));
+}
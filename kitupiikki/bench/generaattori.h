@@ -0,0 +1,144 @@
+/*
+   Copyright (C) 2018 Arto Hyvättinen
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+  * @dir bench
+  * @brief Suorituskykymittaukset synteettisellä kirjanpidolla
+  */
+
+#ifndef GENERAATTORI_H
+#define GENERAATTORI_H
+
+#include <QDate>
+#include <QList>
+#include <QJsonObject>
+#include <QModelIndex>
+#include <QRandomGenerator>
+
+#include "db/tili.h"
+#include "db/kohdennus.h"
+
+class TositeModel;
+
+/**
+ * @brief Synteettisen kirjanpidon koko
+ *
+ * Samoilla mitoilla ja siemenellä syntyy aina sama kirjanpito, joten
+ * eri versioiden mittaustuloksia voidaan verrata keskenään.
+ *
+ * @since 1.1
+ */
+struct Mitoitus
+{
+    int vuodet = 1;                 /** Tilikausien määrä */
+    int tositteitaPaivassa = 10;
+    int kohdennuksia = 5;           /** Kustannuspaikkojen määrä */
+    int avoimiaEria = 200;          /** Avoimia laskuja enintään, vanhimmat maksetaan */
+    int liitteita = 100;            /** Tositteisiin liitettävien pdf-tiedostojen määrä */
+    int tilioterivit = 500;         /** Tuotavan tiliotteen rivit */
+    quint32 siemen = 1;
+
+    QJsonObject json() const;
+};
+
+/**
+ * @brief Luo mittauksissa käytettävän kirjanpidon
+ *
+ * Kirjanpito luodaan uuden kirjanpidon tavoin luo.sql:stä ja Tilitin-tilikartasta,
+ * ja tositteet kirjataan TositeModelin ja VientiModelin kautta samoin kuin
+ * käyttöliittymässä: myynti- ja ostolaskuja tase-erineen, niiden maksuja sekä
+ * pankkikuluja. Lisäksi kirjoitetaan TITO-tiliote, jolla maksetaan avoimeksi
+ * jääneet laskut.
+ *
+ * @since 1.1
+ */
+class KirjanpidonGeneraattori
+{
+public:
+    KirjanpidonGeneraattori(const Mitoitus& mitoitus);
+    ~KirjanpidonGeneraattori();
+
+    /**
+     * @brief Luo kirjanpidon ja jättää sen avatuksi
+     * @param polku Luotava .kitupiikki-tiedosto
+     * @param virhe Virheilmoitus, jos luominen epäonnistuu
+     */
+    bool luo(const QString& polku, QString* virhe);
+
+    /**
+     * @brief Kirjoittaa TITO-tiliotteen avoimien laskujen maksuista
+     *
+     * Avoimet laskut maksetaan viitteillä, ja loput rivit ovat
+     * satunnaisia tilitapahtumia ilman viitettä.
+     */
+    bool kirjoitaTiliote(const QString& polku);
+
+    QDate alkaa() const { return alkaa_; }
+    QDate paattyy() const { return paattyy_; }
+    int tositteita() const { return tositteita_; }
+
+protected:
+    struct AvoinEra
+    {
+        int eraId = 0;
+        qlonglong sentit = 0;
+        QString viite;
+        QString iban;           /** Toimittajan tili, tyhjä myyntilaskulla */
+        QString asiakas;
+    };
+
+    bool alusta();
+    bool kirjaaPaiva(const QDate& pvm);
+    bool kirjaaMyyntilasku(const QDate& pvm);
+    bool kirjaaOstolasku(const QDate& pvm);
+    bool kirjaaMaksu(const QDate& pvm, int indeksi);
+    bool kirjaaPankkikulu(const QDate& pvm);
+
+    void aloitaTosite(const QDate& pvm, const QModelIndex& laji, const QString& otsikko);
+    bool tallennaTosite();
+
+    QModelIndex tositelaji(int kirjaustyyppi) const;
+    QByteArray liite(int numero) const;
+    qlonglong summa();
+    Kohdennus kohdennus();
+
+    Mitoitus mitoitus_;
+    QRandomGenerator satunnainen_;
+    TositeModel *tosite_ = nullptr;
+    QString *virhe_ = nullptr;
+
+    QDate alkaa_;
+    QDate paattyy_;
+
+    QModelIndex myyntilaji_;
+    QModelIndex ostolaji_;
+    QModelIndex tiliotelaji_;
+
+    Tili pankkitili_;
+    QString iban_;
+    QList<Tili> tulotilit_;
+    QList<Tili> menotilit_;
+    QList<Kohdennus> kohdennukset_;
+
+    QList<AvoinEra> avoimet_;
+    int tositteita_ = 0;
+    int laskuja_ = 0;
+    int liitteita_ = 0;
+    int liitevali_ = 1;
+};
+
+#endif // GENERAATTORI_H
@@ -0,0 +1,54 @@
+/*
+   Copyright (C) 2018 Arto Hyvättinen
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QApplication>
+#include <QDir>
+#include <QLocale>
+#include <QTranslator>
+
+#include "db/kirjanpito.h"
+#include "versio.h"
+#include "suorituskykyajo.h"
+
+int main(int argc, char *argv[])
+{
+    // Mittaukset ajetaan ilman näyttöä
+    if( qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QApplication a(argc, argv);
+
+    a.setApplicationName("Kitupiikki");
+    a.setApplicationVersion(KITUPIIKKI_VERSIO);
+    a.setOrganizationDomain("kitupiikki.info");
+    a.setOrganizationName("Kitupiikki Kirjanpito");
+
+    QLocale::setDefault(QLocale(QLocale::Finnish, QLocale::Finland));
+
+    QTranslator translator;
+    translator.load("fi.qm",":/aloitus/");
+    a.installTranslator(&translator);
+
+    // Mittausten kirjanpidot eivät päädy käyttäjän viimeisimpien kirjanpitojen listalle
+    QString asetuspolku = QDir::temp().absoluteFilePath("kitupiikki-bench");
+    QDir().mkpath(asetuspolku);
+    Kirjanpito kirjanpito(asetuspolku);
+    Kirjanpito::asetaInstanssi(&kirjanpito);
+
+    Suorituskykyajo ajo;
+    return ajo.suorita( a.arguments() );
+}
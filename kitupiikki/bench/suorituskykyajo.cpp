@@ -0,0 +1,181 @@
+/*
+   Copyright (C) 2018 Arto Hyvättinen
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QJsonObject>
+#include <QScopedPointer>
+#include <QTextStream>
+
+#include "suorituskykyajo.h"
+
+#include "db/kirjanpito.h"
+#include "db/tositemodel.h"
+#include "db/vientimodel.h"
+#include "kirjaus/kirjauswg.h"
+#include "tuonti/tuonti.h"
+
+Suorituskykyajo::Suorituskykyajo()
+{
+
+}
+
+int Suorituskykyajo::suorita(const QStringList &argumentit)
+{
+    QCommandLineParser jasennin;
+    jasennin.setApplicationDescription(tr("Kitupiikin suorituskykymittaus synteettisellä kirjanpidolla"));
+    jasennin.addHelpOption();
+
+    QCommandLineOption vuodetValinta("vuodet", tr("Tilikausien määrä"), tr("määrä"), QString::number(mitoitus_.vuodet));
+    QCommandLineOption tositteitaValinta("tositteita", tr("Tositteita päivässä"), tr("määrä"), QString::number(mitoitus_.tositteitaPaivassa));
+    QCommandLineOption kohdennuksiaValinta("kohdennuksia", tr("Kustannuspaikkojen määrä"), tr("määrä"), QString::number(mitoitus_.kohdennuksia));
+    QCommandLineOption avoimiaValinta("avoimia", tr("Avoimia laskuja enintään"), tr("määrä"), QString::number(mitoitus_.avoimiaEria));
+    QCommandLineOption liitteitaValinta("liitteita", tr("Pdf-liitteiden määrä"), tr("määrä"), QString::number(mitoitus_.liitteita));
+    QCommandLineOption tilioteValinta("tilioterivit", tr("Tuotavan tiliotteen rivien määrä"), tr("määrä"), QString::number(mitoitus_.tilioterivit));
+    QCommandLineOption siemenValinta("siemen", tr("Satunnaislukujen siemen"), tr("luku"), QString::number(mitoitus_.siemen));
+    QCommandLineOption muotoValinta(QStringList() << "m" << "muoto", tr("Raporttien tiedostomuoto: pdf, csv tai html"), tr("muoto"), "html");
+    QCommandLineOption hakemistoValinta(QStringList() << "d" << "hakemisto", tr("Työhakemisto kirjanpidolle ja raporteille"),
+                                        tr("hakemisto"), QDir::temp().absoluteFilePath("kitupiikki-bench"));
+    QCommandLineOption ajoitusValinta(QStringList() << "o" << "ajoitus", tr("JSON-tiedosto, johon kestot kirjoitetaan"),
+                                      tr("tiedosto"), "kitupiikki-bench.json");
+
+    jasennin.addOption(vuodetValinta);
+    jasennin.addOption(tositteitaValinta);
+    jasennin.addOption(kohdennuksiaValinta);
+    jasennin.addOption(avoimiaValinta);
+    jasennin.addOption(liitteitaValinta);
+    jasennin.addOption(tilioteValinta);
+    jasennin.addOption(siemenValinta);
+    jasennin.addOption(muotoValinta);
+    jasennin.addOption(hakemistoValinta);
+    jasennin.addOption(ajoitusValinta);
+
+    if( !jasennin.parse(argumentit))
+    {
+        virhe( jasennin.errorText() );
+        return 2;
+    }
+    if( jasennin.isSet("help"))
+    {
+        QTextStream(stdout) << jasennin.helpText();
+        return 0;
+    }
+
+    mitoitus_.vuodet = qMax(1, jasennin.value(vuodetValinta).toInt());
+    mitoitus_.tositteitaPaivassa = jasennin.value(tositteitaValinta).toInt();
+    mitoitus_.kohdennuksia = jasennin.value(kohdennuksiaValinta).toInt();
+    mitoitus_.avoimiaEria = jasennin.value(avoimiaValinta).toInt();
+    mitoitus_.liitteita = jasennin.value(liitteitaValinta).toInt();
+    mitoitus_.tilioterivit = jasennin.value(tilioteValinta).toInt();
+    mitoitus_.siemen = jasennin.value(siemenValinta).toUInt();
+
+    muoto_ = jasennin.value(muotoValinta).toLower();
+    ajoitustiedosto_ = QFileInfo(jasennin.value(ajoitusValinta)).absoluteFilePath();
+    arkisto_ = true;
+
+    if( muoto_ != "pdf" && muoto_ != "csv" && muoto_ != "html")
+    {
+        virhe( tr("Tuntematon tiedostomuoto %1").arg(muoto_));
+        return 2;
+    }
+
+    QDir hakemisto( jasennin.value(hakemistoValinta) );
+    kohde_ = hakemisto.absoluteFilePath("raportit");
+    if( !QDir().mkpath(kohde_))
+    {
+        virhe( tr("Hakemistoa %1 ei voi luoda").arg(kohde_));
+        return 2;
+    }
+
+    QString tiedosto = hakemisto.absoluteFilePath("bench.kitupiikki");
+    QString tiliote = hakemisto.absoluteFilePath("tiliote.txt");
+
+    // Kirjanpidon luominen
+    QElapsedTimer ajastin;
+    ajastin.start();
+
+    KirjanpidonGeneraattori generaattori(mitoitus_);
+    QString virheteksti;
+    if( !generaattori.luo(tiedosto, &virheteksti) || !generaattori.kirjoitaTiliote(tiliote))
+    {
+        virhe( tr("Kirjanpidon luominen epäonnistui: %1").arg(virheteksti));
+        return 1;
+    }
+    qint64 luonti = ajastin.elapsed();
+
+    raportit_ = QStringList{"paakirja", "paivakirja", "taseerittely"} + kp()->asetukset()->lista("ArkistoRaportit");
+    annettuAlkaa_ = generaattori.alkaa();
+    annettuPaattyy_ = generaattori.paattyy();
+
+    // Avaus, selaus, raportit ja arkisto kuten eräajossa
+    bool onnistui = kasitteleKirjanpito(tiedosto);
+
+    if( ajoitukset_.isEmpty())
+        return 1;
+
+    // Luonti ja tuonti samaan kirjanpidon ajoitukseen eräajon vaiheiden kanssa
+    QJsonObject kirjanpito = ajoitukset_.takeAt( ajoitukset_.count() - 1 ).toObject();
+    vaiheet_ = QJsonArray();
+    kirjaaAjoitus("luonti", luonti, generaattori.tositteita());
+    for( const QJsonValue& vaihe : kirjanpito.value("vaiheet").toArray())
+        vaiheet_.append(vaihe);
+
+    if( !tuoTiliote(tiedosto, tiliote))
+        onnistui = false;
+
+    kirjanpito.insert("vaiheet", vaiheet_);
+    kirjanpito.insert("mitoitus", mitoitus_.json());
+    ajoitukset_.append(kirjanpito);
+
+    if( !kirjoitaAjoitukset())
+        onnistui = false;
+
+    QTextStream(stdout) << ajoitustiedosto_ << "\n";
+    return onnistui ? 0 : 1;
+}
+
+bool Suorituskykyajo::tuoTiliote(const QString &kirjanpito, const QString &tiliote)
+{
+    if( !kp()->avaaTietokanta(kirjanpito, false))
+    {
+        virhe( tr("Kirjanpitoa %1 ei voi avata").arg(kirjanpito));
+        return false;
+    }
+
+    QElapsedTimer ajastin;
+    ajastin.start();
+
+    QScopedPointer<TositeModel> tosite( kp()->tositemodel() );
+    KirjausWg kirjaus( tosite.data() );
+    Tuonti::tuo(tiliote, &kirjaus);
+    int rivit = tosite->vientiModel()->rowCount(QModelIndex());
+    kirjaaAjoitus("tuonti:tito", ajastin.restart(), rivit);
+
+    if( !rivit || !tosite->tallenna())
+    {
+        virhe( tr("Tiliotteen %1 tuominen epäonnistui").arg(tiliote));
+        return false;
+    }
+    kirjaaAjoitus("tuonti:tallennus", ajastin.restart(), rivit);
+
+    // Kuten kirjauksessa tuonnin tallentamisen jälkeen
+    kp()->paivitaTilastot();
+    kirjaaAjoitus("tuonti:tilastot", ajastin.elapsed());
+    return true;
+}
@@ -0,0 +1,63 @@
+/*
+   Copyright (C) 2018 Arto Hyvättinen
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SUORITUSKYKYAJO_H
+#define SUORITUSKYKYAJO_H
+
+#include "eraajo/eraajo.h"
+#include "generaattori.h"
+
+/**
+ * @brief Suorituskykymittaus synteettisellä kirjanpidolla
+ *
+ * Luo annetun kokoisen kirjanpidon KirjanpidonGeneraattorilla ja ajaa sille
+ * eräajon ajoitetut vaiheet: avaamisen, selausnäkymät ja laskulistan,
+ * raportit sekä arkistoinnin. Lopuksi kirjanpito avataan muokattavaksi ja
+ * siihen tuodaan TITO-tiliote, jolla maksetaan avoimet laskut.
+ *
+ * Kestot kirjoitetaan eräajon --ajoitus -valinnan muotoiseen JSON-tiedostoon,
+ * johon lisätään kirjanpidon mitoitus.
+ *
+ * @code
+ * kitupiikki-bench --vuodet 3 --tositteita 20 --siemen 7 -o tulos.json
+ * @endcode
+ *
+ * @since 1.1
+ */
+class Suorituskykyajo : public Eraajo
+{
+    Q_OBJECT
+public:
+    Suorituskykyajo();
+
+    /**
+     * @brief Suorittaa mittauksen
+     * @param argumentit Ohjelman komentoriviargumentit
+     * @return Ohjelman paluuarvo, 0 jos kaikki onnistui
+     */
+    int suorita(const QStringList& argumentit);
+
+protected:
+    /**
+     * @brief Tuo tiliotteen kirjaus-widgetin kautta ja tallentaa tositteen
+     */
+    bool tuoTiliote(const QString& kirjanpito, const QString& tiliote);
+
+    Mitoitus mitoitus_;
+};
+
+#endif // SUORITUSKYKYAJO_H
@@ -0,0 +1,127 @@
+/*
+   Copyright (C) 2018 Arto Hyvättinen
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "asiakas.h"
+#include "kirjanpito.h"
+
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QDateTime>
+#include <QDebug>
+
+bool Asiakas::tallenna(bool toimittaja)
+{
+    // Nimellä haettaessa asiakas myös merkitään myynnin tai oston osapuoleksi
+    if( !nimi.isEmpty())
+        id = idNimella(nimi, toimittaja);
+    if( !id )
+        return false;
+
+    QSqlQuery& kysely = kp()->kysely("UPDATE asiakas SET osoite=:osoite, email=:email, ytunnus=:ytunnus, "
+                                     "verkkolaskuosoite=:verkkolaskuosoite, verkkolaskuvalittaja=:verkkolaskuvalittaja, "
+                                     "muokattu=:muokattu WHERE id=:id");
+    kysely.bindValue(":osoite", osoite);
+    kysely.bindValue(":email", email);
+    kysely.bindValue(":ytunnus", ytunnus);
+    kysely.bindValue(":verkkolaskuosoite", verkkolaskuosoite);
+    kysely.bindValue(":verkkolaskuvalittaja", verkkolaskuvalittaja);
+    kysely.bindValue(":muokattu", QDateTime::currentDateTime());
+    kysely.bindValue(":id", id);
+
+    if( !kysely.exec())
+    {
+        qWarning() << "Asiakkaan tallentaminen epäonnistui" << kysely.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+Asiakas Asiakas::haeNimella(const QString &nimi)
+{
+    Asiakas asiakas;
+    asiakas.nimi = nimi;
+
+    QSqlQuery& kysely = kp()->kysely("SELECT id, osoite, email, ytunnus, verkkolaskuosoite, verkkolaskuvalittaja "
+                                     "FROM asiakas WHERE nimi=:nimi");
+    kysely.bindValue(":nimi", nimi);
+    kysely.exec();
+    if( kysely.next())
+    {
+        asiakas.id = kysely.value(0).toInt();
+        asiakas.osoite = kysely.value(1).toString();
+        asiakas.email = kysely.value(2).toString();
+        asiakas.ytunnus = kysely.value(3).toString();
+        asiakas.verkkolaskuosoite = kysely.value(4).toString();
+        asiakas.verkkolaskuvalittaja = kysely.value(5).toString();
+    }
+    kysely.finish();
+    return asiakas;
+}
+
+int Asiakas::idNimella(const QString &nimi, bool toimittaja)
+{
+    if( nimi.isEmpty())
+        return 0;
+
+    QSqlQuery& haku = kp()->kysely("SELECT id, myynti, osto FROM asiakas WHERE nimi=:nimi");
+    haku.bindValue(":nimi", nimi);
+    haku.exec();
+    if( haku.next())
+    {
+        int id = haku.value(0).toInt();
+        bool merkitty = toimittaja ? haku.value(2).toBool() : haku.value(1).toBool();
+        haku.finish();
+
+        if( !merkitty )
+        {
+            QSqlQuery& merkinta = kp()->kysely( toimittaja ? "UPDATE asiakas SET osto=1 WHERE id=:id" :
+                                                             "UPDATE asiakas SET myynti=1 WHERE id=:id");
+            merkinta.bindValue(":id", id);
+            merkinta.exec();
+        }
+        return id;
+    }
+    haku.finish();
+
+    QSqlQuery& lisays = kp()->kysely("INSERT INTO asiakas(nimi, myynti, osto, muokattu) "
+                                     "VALUES (:nimi, :myynti, :osto, :muokattu)");
+    lisays.bindValue(":nimi", nimi);
+    lisays.bindValue(":myynti", !toimittaja);
+    lisays.bindValue(":osto", toimittaja);
+    lisays.bindValue(":muokattu", QDateTime::currentDateTime());
+    if( !lisays.exec())
+    {
+        qWarning() << "Asiakkaan lisääminen epäonnistui" << lisays.lastError().text();
+        return 0;
+    }
+    return lisays.lastInsertId().toInt();
+}
+
+QStringList Asiakas::nimet(const QString &alku, int enintaan)
+{
+    // Alkuosan haku välinä, jotta nimen indeksiä voidaan käyttää
+    QSqlQuery& kysely = kp()->kysely("SELECT nimi FROM asiakas WHERE nimi >= :alku COLLATE NOCASE "
+                                     "AND nimi < :loppu COLLATE NOCASE ORDER BY nimi COLLATE NOCASE LIMIT :enintaan");
+    kysely.bindValue(":alku", alku);
+    kysely.bindValue(":loppu", alku + QChar(0xffff));
+    kysely.bindValue(":enintaan", enintaan);
+    kysely.exec();
+
+    QStringList lista;
+    while( kysely.next())
+        lista.append( kysely.value(0).toString());
+    return lista;
+}
@@ -0,0 +1,76 @@
+/*
+   Copyright (C) 2018 Arto Hyvättinen
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef ASIAKAS_H
+#define ASIAKAS_H
+
+#include <QString>
+#include <QStringList>
+
+/**
+ * @brief Asiakas- ja toimittajarekisterin yhteystiedot
+ *
+ * Asiakkaat ovat asiakas-taulussa, johon viennit viittaavat
+ * asiakasid-kentällä. Vientiin tallennetaan edelleen myös asiakkaan nimi,
+ * jota raportit ja laskuluettelot käyttävät.
+ *
+ * @since 1.1
+ */
+struct Asiakas
+{
+    int id = 0;
+    QString nimi;
+    QString osoite;
+    QString email;
+    QString ytunnus;
+    QString verkkolaskuosoite;
+    QString verkkolaskuvalittaja;
+
+    /**
+     * @brief Tallentaa yhteystiedot, uusi asiakas lisätään rekisteriin
+     * @param toimittaja Tallennetaanko toimittajan (ostolaskujen) vai asiakkaan tiedot,
+     *        asiakas merkitään rekisterissä vastaavasti
+     */
+    bool tallenna(bool toimittaja);
+
+    /**
+     * @brief Hakee asiakkaan tiedot nimellä
+     *
+     * Jos asiakasta ei ole rekisterissä, palautetaan vain nimi
+     */
+    static Asiakas haeNimella(const QString& nimi);
+
+    /**
+     * @brief Vientiin tallennettava asiakkaan id
+     *
+     * Lisää asiakkaan rekisteriin, ellei sitä vielä ole, ja merkitsee
+     * sen asiakkaaksi tai toimittajaksi
+     *
+     * @param toimittaja Onko kyseessä ostolasku (vienti, jolla on IBAN)
+     * @return id, 0 jos nimeä ei ole annettu
+     */
+    static int idNimella(const QString& nimi, bool toimittaja);
+
+    /**
+     * @brief Asiakkaiden nimet, jotka alkavat annetulla tekstillä
+     *
+     * Haku käyttää nimen indeksiä, joten se ei käy vientejä läpi.
+     * Kirjainkoolla ei ole merkitystä.
+     */
+    static QStringList nimet(const QString& alku, int enintaan = 50);
+};
+
+#endif // ASIAKAS_H
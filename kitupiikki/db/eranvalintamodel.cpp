@@ -133,22 +133,25 @@ TaseEra::TaseEra(int id)
     // Jos id annetaan rakentajaan, hakee halutun erän tiedot
     if(id)
     {
-        QSqlQuery query( *( kp()->tietokanta() ));
-        query.exec(QString("SELECT sum(debetsnt),sum(kreditsnt) from vienti "
-                           "where eraid=%1").arg(id ));
+        QSqlQuery& query = kp()->kysely("SELECT sum(debetsnt),sum(kreditsnt) from vienti "
+                                        "where eraid=:era");
+        query.bindValue(":era", id);
+        query.exec();
         if( query.next() )
         {
             saldoSnt = query.value(0).toLongLong();
             saldoSnt -= query.value(1).toLongLong();
         }
 
-        query.exec(QString("SELECT pvm, selite, tosite from vienti "
-                   "where id=%1").arg( id ));
-        if( query.next())
+        QSqlQuery& tietokysely = kp()->kysely("SELECT pvm, selite, tosite from vienti "
+                                              "where id=:id");
+        tietokysely.bindValue(":id", id);
+        tietokysely.exec();
+        if( tietokysely.next())
         {
-            pvm = query.value("pvm").toDate();
-            selite = query.value("selite").toString();
-            tositeId = query.value("tosite").toInt();
+            pvm = tietokysely.value("pvm").toDate();
+            selite = tietokysely.value("selite").toString();
+            tositeId = tietokysely.value("tosite").toInt();
         }
 
     }
@@ -158,7 +161,9 @@ QString TaseEra::tositteenTunniste()
 {
     if(eraId)
     {
-        QSqlQuery query(QString("select tositelaji.tunnus, tosite.tunniste from tositelaji,tosite WHERE tosite.id=%1 and tosite.laji=tositelaji.id").arg(tositeId));
+        QSqlQuery& query = kp()->kysely("select tositelaji.tunnus, tosite.tunniste from tositelaji,tosite WHERE tosite.id=:tosite and tosite.laji=tositelaji.id");
+        query.bindValue(":tosite", tositeId);
+        query.exec();
         if( query.next())
         {
             return QString("%1%2/%3").arg( query.value(0).toString() )
@@ -0,0 +1,326 @@
+/*
+   Copyright (C) 2018 Arto Hyvättinen
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QRegularExpression>
+#include <QSet>
+#include <QRunnable>
+#include <QDebug>
+
+#include <poppler/qt5/poppler-qt5.h>
+
+#include "hakuindeksi.h"
+#include "kirjanpito.h"
+
+namespace {
+
+/**
+ * @brief Poimii liitteen tekstin taustasäikeessä
+ *
+ * Tietokantaa käytetään vain pääsäikeestä, joten tulos palautetaan
+ * jonotettuna kutsuna HakuIndeksille tallennettavaksi.
+ */
+class LiitteenPoiminta : public QRunnable
+{
+public:
+    LiitteenPoiminta(HakuIndeksi* indeksi, int sukupolvi, int liiteId, int tositeId,
+                     const QString& otsikko, const QByteArray& data)
+        : indeksi_(indeksi), sukupolvi_(sukupolvi), liiteId_(liiteId), tositeId_(tositeId),
+          otsikko_(otsikko), data_(data) {}
+
+    void run() override
+    {
+        QString teksti = HakuIndeksi::pdfTeksti(data_);
+        QMetaObject::invokeMethod( indeksi_, "tallennaPoimittu", Qt::QueuedConnection,
+                                   Q_ARG(int, sukupolvi_), Q_ARG(int, liiteId_), Q_ARG(int, tositeId_),
+                                   Q_ARG(QString, otsikko_), Q_ARG(QString, teksti));
+    }
+
+private:
+    HakuIndeksi* indeksi_;
+    int sukupolvi_;
+    int liiteId_;
+    int tositeId_;
+    QString otsikko_;
+    QByteArray data_;
+};
+
+}
+
+HakuIndeksi::HakuIndeksi(QObject *parent)
+    : QObject(parent)
+{
+    ajastin_.setInterval(100);
+    connect( &ajastin_, &QTimer::timeout, this, &HakuIndeksi::indeksoiLiitteita);
+    poimija_.setMaxThreadCount(1);
+}
+
+void HakuIndeksi::alusta(bool vainLuku)
+{
+    ajastin_.stop();
+    sukupolvi_++;
+    poiminnassa_ = false;
+    ohitetut_.clear();
+
+    // Taulut luodaan tietokannan päivityksessä (update15.sql). Jos SQLite
+    // on käännetty ilman FTS5-tukea, tauluja ei ole ja haetaan vertailulla.
+    QSqlQuery kysely( *kp()->tietokanta() );
+    kysely.exec("SELECT name FROM sqlite_master WHERE type='table' AND name='tositehaku'");
+    kaytossa_ = kysely.next();
+
+    // Indeksoimattomien liitteiden tekstit poimitaan taustalla
+    if( kaytossa_ && !vainLuku )
+        ajastin_.start();
+}
+
+void HakuIndeksi::paivitaTosite(int tositeId)
+{
+    if( !kaytossa_ )
+        return;
+
+    QSqlQuery& poisto = kp()->kysely("DELETE FROM tositehaku WHERE rowid=:id");
+    poisto.bindValue(":id", tositeId);
+    poisto.exec();
+
+    QSqlQuery& lisays = kp()->kysely("INSERT INTO tositehaku(rowid, otsikko, kommentti, viennit) "
+                                     "SELECT id, otsikko, kommentti, "
+                                     "(SELECT group_concat( coalesce(selite,'') || ' ' || coalesce(asiakas,''), ' ') "
+                                     "FROM vienti WHERE vienti.tosite=tosite.id) FROM tosite WHERE id=:id");
+    lisays.bindValue(":id", tositeId);
+    lisays.exec();
+}
+
+void HakuIndeksi::poistaTosite(int tositeId)
+{
+    if( !kaytossa_ )
+        return;
+
+    QSqlQuery kysely( *kp()->tietokanta() );
+    kysely.prepare("DELETE FROM liitehaku WHERE rowid IN (SELECT id FROM liite WHERE tosite=:id)");
+    kysely.bindValue(":id", tositeId);
+    kysely.exec();
+
+    kysely.prepare("DELETE FROM tositehaku WHERE rowid=:id");
+    kysely.bindValue(":id", tositeId);
+    kysely.exec();
+}
+
+void HakuIndeksi::indeksoiUudetLiitteet()
+{
+    if( kaytossa_ && !ajastin_.isActive())
+        ajastin_.start();
+}
+
+void HakuIndeksi::paivitaLiitteenOtsikko(int liiteId, const QString &otsikko)
+{
+    if( !kaytossa_ )
+        return;
+
+    QSqlQuery& kysely = kp()->kysely("UPDATE liitehaku SET otsikko=:otsikko WHERE rowid=:id");
+    kysely.bindValue(":id", liiteId);
+    kysely.bindValue(":otsikko", otsikko);
+    kysely.exec();
+}
+
+void HakuIndeksi::poistaLiite(int liiteId)
+{
+    if( !kaytossa_ )
+        return;
+
+    QSqlQuery& kysely = kp()->kysely("DELETE FROM liitehaku WHERE rowid=:id");
+    kysely.bindValue(":id", liiteId);
+    kysely.exec();
+}
+
+QList<HakuIndeksi::Osuma> HakuIndeksi::hae(const QString &teksti, int enintaan) const
+{
+    if( !kaytossa_ )
+        return haeVertailulla(teksti, enintaan);
+
+    QList<Osuma> osumat;
+    QString lauseke = hakulauseke(teksti);
+    if( lauseke.isEmpty())
+        return osumat;
+
+    // Sama tosite voi löytyä sekä omista että liitteen teksteistä,
+    // joten haetaan ylimääräisiä ja karsitaan kaksoiskappaleet
+    QSqlQuery kysely( *kp()->tietokanta() );
+    kysely.prepare("SELECT tosite.id, tosite.pvm, tosite.laji, tosite.tunniste, tosite.otsikko, osumat.ote, "
+                   "(SELECT max(sum(debetsnt), sum(kreditsnt)) FROM vienti WHERE vienti.tosite=tosite.id) "
+                   "FROM (SELECT rowid AS tositeid, bm25(tositehaku, 10.0, 2.0, 1.0) AS arvo, "
+                   "snippet(tositehaku, -1, '', '', '…', 8) AS ote FROM tositehaku WHERE tositehaku MATCH :haku "
+                   "UNION ALL "
+                   "SELECT tosite AS tositeid, bm25(liitehaku, 0.0, 2.0, 0.5) AS arvo, "
+                   "snippet(liitehaku, -1, '', '', '…', 8) AS ote FROM liitehaku WHERE liitehaku MATCH :liitehaku) AS osumat "
+                   "JOIN tosite ON tosite.id=osumat.tositeid ORDER BY osumat.arvo LIMIT :enintaan");
+    kysely.bindValue(":haku", lauseke);
+    kysely.bindValue(":liitehaku", lauseke);
+    kysely.bindValue(":enintaan", enintaan * 2);
+
+    if( !kysely.exec())
+        qWarning() << "Tekstihaku epäonnistui" << kysely.lastError().text();
+
+    QSet<int> loydetyt;
+    while( kysely.next() && osumat.count() < enintaan)
+    {
+        int id = kysely.value(0).toInt();
+        if( loydetyt.contains(id))
+            continue;
+        loydetyt.insert(id);
+
+        Osuma osuma;
+        osuma.tositeId = id;
+        osuma.pvm = kysely.value(1).toDate();
+        osuma.tositeLaji = kysely.value(2).toInt();
+        osuma.tositeTunniste = kysely.value(3).toInt();
+        osuma.otsikko = kysely.value(4).toString();
+        osuma.ote = kysely.value(5).toString().simplified();
+        osuma.summa = kysely.value(6).toLongLong();
+        osumat.append(osuma);
+    }
+    return osumat;
+}
+
+QString HakuIndeksi::pdfTeksti(const QByteArray &data)
+{
+    if( !data.startsWith("%PDF"))
+        return QString();
+
+    QString teksti;
+    Poppler::Document *pdfDoc = Poppler::Document::loadFromData( data );
+    if( pdfDoc && !pdfDoc->isLocked())
+    {
+        for(int i=0; i < pdfDoc->numPages(); i++)
+        {
+            Poppler::Page *sivu = pdfDoc->page(i);
+            if( sivu )
+            {
+                teksti.append( sivu->text(QRectF()) );
+                teksti.append('\n');
+                delete sivu;
+            }
+        }
+    }
+    delete pdfDoc;
+    return teksti;
+}
+
+void HakuIndeksi::indeksoiLiitteita()
+{
+    // Edellisen liitteen teksti on vielä poimittavana
+    if( poiminnassa_ )
+        return;
+
+    QStringList ohitetut;
+    for( int id : ohitetut_)
+        ohitetut.append( QString::number(id));
+    if( ohitetut.isEmpty())
+        ohitetut.append("0");
+
+    QSqlQuery kysely( *kp()->tietokanta() );
+    kysely.exec( QString("SELECT id, tosite, otsikko, data FROM liite WHERE tosite IS NOT NULL "
+                         "AND id NOT IN (SELECT rowid FROM liitehaku) AND id NOT IN (%1) LIMIT 1")
+                 .arg( ohitetut.join(',')));
+
+    if( !kysely.next())
+    {
+        ajastin_.stop();
+        return;
+    }
+
+    poiminnassa_ = true;
+    poimija_.start( new LiitteenPoiminta( this, sukupolvi_, kysely.value(0).toInt(), kysely.value(1).toInt(),
+                                          kysely.value(2).toString(), kysely.value(3).toByteArray()));
+}
+
+void HakuIndeksi::tallennaPoimittu(int sukupolvi, int liiteId, int tositeId, const QString &otsikko, const QString &teksti)
+{
+    // Poiminta on käynnistetty ennen kirjanpidon vaihtamista
+    if( sukupolvi != sukupolvi_ )
+        return;
+
+    poiminnassa_ = false;
+    if( !kaytossa_ )
+        return;
+
+    // Epäonnistunutta liitettä ei yritetä uudelleen joka kierroksella
+    if( !tallennaTeksti(liiteId, tositeId, otsikko, teksti))
+        ohitetut_.insert(liiteId);
+}
+
+bool HakuIndeksi::tallennaTeksti(int liiteId, int tositeId, const QString &otsikko, const QString &teksti)
+{
+    QSqlQuery& kysely = kp()->kysely("INSERT INTO liitehaku(rowid, tosite, otsikko, teksti) VALUES (:id, :tosite, :otsikko, :teksti)");
+    kysely.bindValue(":id", liiteId);
+    kysely.bindValue(":tosite", tositeId);
+    kysely.bindValue(":otsikko", otsikko);
+    kysely.bindValue(":teksti", teksti);
+    if( !kysely.exec())
+    {
+        qWarning() << "Liitteen tekstiä ei voitu indeksoida" << liiteId << kysely.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+QString HakuIndeksi::hakulauseke(const QString &teksti)
+{
+    // Jokainen sana lainausmerkkeihin, jotta käyttäjän syötettä ei tulkita
+    // FTS5:n operaattoreiksi, ja haetaan sanan alulla
+    QStringList sanat;
+    for( QString sana : teksti.split(QRegularExpression("\\s+"), QString::SkipEmptyParts))
+    {
+        sana.remove('"');
+        if( !sana.isEmpty())
+            sanat.append( QString("\"%1\"*").arg(sana) );
+    }
+    return sanat.join(' ');
+}
+
+QList<HakuIndeksi::Osuma> HakuIndeksi::haeVertailulla(const QString &teksti, int enintaan) const
+{
+    QList<Osuma> osumat;
+    if( teksti.trimmed().isEmpty())
+        return osumat;
+
+    QSqlQuery kysely( *kp()->tietokanta() );
+    kysely.prepare("SELECT id, pvm, laji, tunniste, otsikko, "
+                   "(SELECT max(sum(debetsnt), sum(kreditsnt)) FROM vienti WHERE vienti.tosite=tosite.id) "
+                   "FROM tosite WHERE otsikko LIKE :haku OR kommentti LIKE :kommentti "
+                   "OR id IN (SELECT tosite FROM vienti WHERE selite LIKE :selite) "
+                   "ORDER BY pvm DESC LIMIT :enintaan");
+    QString vertailu = QString("%%1%").arg(teksti.trimmed());
+    kysely.bindValue(":haku", vertailu);
+    kysely.bindValue(":kommentti", vertailu);
+    kysely.bindValue(":selite", vertailu);
+    kysely.bindValue(":enintaan", enintaan);
+    kysely.exec();
+
+    while( kysely.next())
+    {
+        Osuma osuma;
+        osuma.tositeId = kysely.value(0).toInt();
+        osuma.pvm = kysely.value(1).toDate();
+        osuma.tositeLaji = kysely.value(2).toInt();
+        osuma.tositeTunniste = kysely.value(3).toInt();
+        osuma.otsikko = kysely.value(4).toString();
+        osuma.summa = kysely.value(5).toLongLong();
+        osumat.append(osuma);
+    }
+    return osumat;
+}
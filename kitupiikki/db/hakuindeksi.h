@@ -0,0 +1,148 @@
+/*
+   Copyright (C) 2018 Arto Hyvättinen
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HAKUINDEKSI_H
+#define HAKUINDEKSI_H
+
+#include <QObject>
+#include <QDate>
+#include <QList>
+#include <QTimer>
+#include <QSet>
+#include <QThreadPool>
+
+/**
+ * @brief Kirjanpidon tekstihaun indeksi
+ *
+ * Tositteiden otsikot, kommentit, vientien selitteet ja asiakkaiden nimet
+ * ovat SQLiten FTS5-taulussa tositehaku (rivinä tositteen id) ja
+ * liitteiden otsikot sekä pdf-liitteistä poimittu teksti taulussa
+ * liitehaku (rivinä liitteen id).
+ *
+ * Tositteen tekstit päivitetään tositetta tallennettaessa (TositeModel ja
+ * tilinavaus). Tietokantaan suoraan kirjoittavat päivitykset eivät päivitä
+ * indeksiä, vaan indeksi täydennetään tietokannan päivityksessä.
+ *
+ * Liitteiden tekstit poimitaan taustasäikeessä liite kerrallaan sekä
+ * aiemmin tallennetuista että uusista liitteistä, jottei suurten
+ * pdf-liitteiden käsittely jäädytä käyttöliittymää.
+ *
+ * Jos SQLite on käännetty ilman FTS5-tukea, haku tehdään vanhaan tapaan
+ * LIKE-vertailulla otsikoista ja selitteistä.
+ *
+ * @since 1.1
+ */
+class HakuIndeksi : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief Yksi hakutulos
+     */
+    struct Osuma
+    {
+        int tositeId = 0;
+        QDate pvm;
+        int tositeLaji = 0;
+        int tositeTunniste = 0;
+        QString otsikko;
+        QString ote;            /** Osuman ympäristö */
+        qlonglong summa = 0;
+    };
+
+    HakuIndeksi(QObject *parent = nullptr);
+
+    /**
+     * @brief Ottaa avatun kirjanpidon indeksin käyttöön
+     *
+     * Indeksin taulut luodaan tietokannan päivityksessä. Jos niitä ei ole
+     * (SQLite ilman FTS5-tukea), haetaan ilman indeksiä.
+     *
+     * @param vainLuku Vain luettavaksi avatun kirjanpidon liitteitä ei indeksoida
+     */
+    void alusta(bool vainLuku);
+
+    /**
+     * @brief Onko avatussa kirjanpidossa tekstihaun indeksi
+     */
+    bool kaytossa() const { return kaytossa_; }
+
+    /**
+     * @brief Päivittää tositteen tekstit indeksiin
+     *
+     * Kutsutaan tositteen tallentamisen yhteydessä samassa transaktiossa
+     */
+    void paivitaTosite(int tositeId);
+    /**
+     * @brief Poistaa tositteen ja sen liitteet indeksistä
+     *
+     * Kutsuttava ennen kuin liitteet poistetaan tietokannasta
+     */
+    void poistaTosite(int tositeId);
+
+    /**
+     * @brief Käynnistää tallennettujen uusien liitteiden tekstin poiminnan taustalla
+     *
+     * Liitteen tekstiä ei poimita tallennettaessa, jottei monisivuinen pdf
+     * hidasta tositteen tallentamista.
+     */
+    void indeksoiUudetLiitteet();
+    void paivitaLiitteenOtsikko(int liiteId, const QString& otsikko);
+    void poistaLiite(int liiteId);
+
+    /**
+     * @brief Hakee tositteita kaikilta tilikausilta
+     * @param teksti Haettavat sanat, jotka kaikki on löydyttävä (sanan alkuna)
+     * @param enintaan Palautettavien osumien enimmäismäärä
+     * @return Osumat osuvuuden mukaan järjestettynä
+     */
+    QList<Osuma> hae(const QString& teksti, int enintaan = 200) const;
+
+    /**
+     * @brief Pdf-tiedoston teksti
+     */
+    static QString pdfTeksti(const QByteArray& data);
+
+protected slots:
+    /**
+     * @brief Käynnistää seuraavan indeksoimattoman liitteen tekstin poiminnan
+     */
+    void indeksoiLiitteita();
+    /**
+     * @brief Tallentaa taustasäikeessä poimitun liitteen tekstin
+     * @param sukupolvi Poiminnan käynnistäneen alusta()-kutsun järjestysnumero
+     */
+    void tallennaPoimittu(int sukupolvi, int liiteId, int tositeId, const QString& otsikko, const QString& teksti);
+
+protected:
+    /**
+     * @brief Muuttaa käyttäjän syöttämän hakutekstin FTS5-hauksi
+     */
+    static QString hakulauseke(const QString& teksti);
+    QList<Osuma> haeVertailulla(const QString& teksti, int enintaan) const;
+    bool tallennaTeksti(int liiteId, int tositeId, const QString& otsikko, const QString& teksti);
+
+    bool kaytossa_ = false;
+    QTimer ajastin_;
+
+    int sukupolvi_ = 0;         /** Kasvaa kirjanpitoa vaihdettaessa, vanhat poiminnat hylätään */
+    bool poiminnassa_ = false;
+    QSet<int> ohitetut_;        /** Liitteet, joiden tekstiä ei saatu tallennettua */
+    QThreadPool poimija_;
+};
+
+#endif // HAKUINDEKSI_H
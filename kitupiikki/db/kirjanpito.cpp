@@ -29,13 +29,18 @@
 #include <QTextStream>
 #include <QBuffer>
 #include <QRandomGenerator>
+#include <QPair>
 
 #include <QDebug>
 
 #include <ctime>
 
 #include "kirjanpito.h"
+#include "hakuindeksi.h"
+#include "asiakas.h"
+#include "vientimodel.h"
 #include "naytin/naytinikkuna.h"
+#include "laskutus/laskupohja.h"
 
 Kirjanpito::Kirjanpito(const QString& portableDir) : QObject(nullptr),
     harjoitusPvm( QDate::currentDate()), tempDir_(nullptr), portableDir_(portableDir)
@@ -59,7 +64,20 @@ Kirjanpito::Kirjanpito(const QString& portableDir) : QObject(nullptr),
     veroTyypit_ = new VerotyyppiModel(this);
     tiliTyypit_ = new TilityyppiModel(this);
     tuotteet_ = new TuoteModel(this);
+    hakuindeksi_ = new HakuIndeksi(this);
     liitteet_ = nullptr;
+    laskupohja_ = nullptr;
+
+    // Tilikartan, tilikausien ja kohdennusten muutokset koskevat kaikkia raportteja
+    for( QAbstractItemModel* model : QList<QAbstractItemModel*>{ tositelajiModel_, tiliModel_, tilikaudetModel_, kohdennukset_ })
+    {
+        connect( model, &QAbstractItemModel::dataChanged, this, [this] { merkitseMuutos(); });
+        connect( model, &QAbstractItemModel::modelReset, this, [this] { merkitseMuutos(); });
+        connect( model, &QAbstractItemModel::rowsInserted, this, [this] { merkitseMuutos(); });
+        connect( model, &QAbstractItemModel::rowsRemoved, this, [this] { merkitseMuutos(); });
+    }
+    connect( this, &Kirjanpito::perusAsetusMuuttui, this, [this] { merkitseMuutos(); });
+    connect( this, &Kirjanpito::tietokantaVaihtui, this, [this] { merkitseMuutos(); });
 
     printer_ = new QPrinter(QPrinter::HighResolution);
 
@@ -75,8 +93,10 @@ Kirjanpito::Kirjanpito(const QString& portableDir) : QObject(nullptr),
 
 Kirjanpito::~Kirjanpito()
 {
+    kyselyt_.clear();
     tietokanta_.close();
     delete tempDir_;
+    delete laskupohja_;
 }
 
 QString Kirjanpito::asetus(const QString &avain) const
@@ -177,24 +197,32 @@ QString Kirjanpito::arkistopolku() const
 
 
 
-bool Kirjanpito::avaaTietokanta(const QString &tiedosto, bool ilmoitaVirheesta)
+bool Kirjanpito::avaaTietokanta(const QString &tiedosto, bool ilmoitaVirheesta, bool vainLuku)
 {
+    // Valmistellut kyselyt kuuluvat edelliselle yhteydelle
+    kyselyt_.clear();
+
+    vainLuku_ = vainLuku;
+    tietokanta_.setConnectOptions( vainLuku ? "QSQLITE_OPEN_READONLY" : QString() );
     tietokanta_.setDatabaseName(tiedosto);
     polkuTiedostoon_ = tiedosto;
 
     if( !tietokanta_.open() )
     {
-        QMessageBox::critical(nullptr, tr("Tiedostoa %1 ei voi avata").arg(tiedosto),
+        avausvirhe(tr("Tiedostoa %1 ei voi avata").arg(tiedosto),
                               tr("Tiedoston avaamisessa tapahtui virhe\n %1").arg( tietokanta_.lastError().text() ));
         return false;
     }
 
     // Tehostetaan tietokannan nopeutta määrittelemällä, että tietokanta on vain tämän yhden
-    // yhteyden käytössä.
+    // yhteyden käytössä. Vain luettaessa ei lukita, jotta kirjanpitoa voi samaan aikaan käyttää.
 
-    tietokanta()->exec("PRAGMA LOCKING_MODE = EXCLUSIVE");
+    if( !vainLuku )
+    {
+        tietokanta()->exec("PRAGMA LOCKING_MODE = EXCLUSIVE");
 
-    tietokanta()->exec("PRAGMA JOURNAL_MODE = PERSIST");
+        tietokanta()->exec("PRAGMA JOURNAL_MODE = PERSIST");
+    }
 
     if( tietokanta()->lastError().isValid())
     {
@@ -203,14 +231,14 @@ bool Kirjanpito::avaaTietokanta(const QString &tiedosto, bool ilmoitaVirheesta)
         {
             if( tietokanta()->lastError().text().contains("locked"))
             {
-                QMessageBox::critical(nullptr, tr("Kitupiikki").arg(tiedosto),
+                avausvirhe(tr("Kitupiikki").arg(tiedosto),
                                       tr("Kirjanpitotiedosto on jo käytössä.\n\n%1\n\n"
                                          "Sulje kaikki Kitupiikki-ohjelman ikkunat ja yritä uudelleen.\n"
                                          "Ellei tämä auta, käynnistä tietokoneesi uudelleen.").arg(tiedosto));
             }
             else
             {
-                QMessageBox::critical(nullptr, tr("Tiedostoa %1 ei voi avata").arg(tiedosto),
+                avausvirhe(tr("Tiedostoa %1 ei voi avata").arg(tiedosto),
                                   tr("Sql-virhe: %1").arg(tietokanta()->lastError().text()));
             }
         }
@@ -229,7 +257,7 @@ bool Kirjanpito::avaaTietokanta(const QString &tiedosto, bool ilmoitaVirheesta)
     if( asetusModel_->asetus("Nimi").isEmpty() || !asetusModel_->luku("KpVersio"))
     {
         // Tämä ei ole lainkaan kelvollinen tietokanta
-        QMessageBox::critical(nullptr, tr("Tiedostoa %1 ei voi avata").arg(tiedosto),
+        avausvirhe(tr("Tiedostoa %1 ei voi avata").arg(tiedosto),
                               tr("Valitsemasi tiedosto ei ole Kitupiikin tietokanta, tai tiedosto on vahingoittunut."));
         tietokanta()->close();
         asetusModel_->lataa();
@@ -243,7 +271,7 @@ bool Kirjanpito::avaaTietokanta(const QString &tiedosto, bool ilmoitaVirheesta)
     if( asetusModel_->luku("KpVersio") > TIETOKANTAVERSIO )
     {
         // Luotu uudemmalla tietokannalla, sellainen ei kelpaa!
-        QMessageBox::critical(nullptr, tr("Kirjanpitoa %1 ei voi avata").arg(asetusModel_->asetus("Nimi")),
+        avausvirhe(tr("Kirjanpitoa %1 ei voi avata").arg(asetusModel_->asetus("Nimi")),
                               tr("Kirjanpito on luotu Kitupiikin versiolla %1, eikä käytössäsi oleva versio %2 pysty avaamaan sitä.\n\n"
                                  "Voidaksesi avata tiedoston, sinun on asennettava uudempi versio Kitupiikistä. Lataa ohjelma "
                                  "osoitteesta https://kitupiikki.info").arg( asetusModel_->asetus("LuotuVersiolla"))
@@ -261,10 +289,21 @@ bool Kirjanpito::avaaTietokanta(const QString &tiedosto, bool ilmoitaVirheesta)
     //
     if( asetusModel_->luku("KpVersio") < TIETOKANTAVERSIO )
     {
+        if( vainLuku )
+        {
+            // Vain luettavaa kirjanpitoa ei voi päivittää
+            avausvirhe(tr("Kirjanpitoa %1 ei voi avata").arg(asetusModel_->asetus("Nimi")),
+                       tr("Kirjanpito on luotu Kitupiikin versiolla %1 ja se täytyy päivittää avaamalla se ohjelmassa.")
+                       .arg(asetusModel_->asetus("LuotuVersiolla")));
+            tietokanta()->close();
+            asetusModel_->lataa();
+            emit tietokantaVaihtui();
+            return false;
+        }
         if( QMessageBox::question(nullptr, tr("Kirjanpidon %1 päivittäminen").arg(asetusModel_->asetus("Nimi")),
                                   tr("Kirjanpito on luotu Kitupiikin versiolla %1 ja se täytyy päivittää, ennen kuin sitä "
                                      "voi käyttää nykyisellä versiolla %2.\n\n"
-                                     "Päivittämisen jälkeen kirjanpitoa ei voi enää avata vanhemmilla versioilla kuin 0.11\n\n"
+                                     "Päivittämisen jälkeen kirjanpitoa ei voi enää avata vanhemmilla versioilla kuin 1.1\n\n"
                                      "On erittäin suositeltavaa varmuuskopioida kirjanpito ennen päivittämistä!\n\n"
                                      "Päivitetäänkö tietokanta Kitupiikin nykyiselle versiolle?").arg(asetusModel_->asetus("LuotuVersiolla"))
                                      .arg(qApp->applicationVersion()),
@@ -363,6 +402,39 @@ bool Kirjanpito::avaaTietokanta(const QString &tiedosto, bool ilmoitaVirheesta)
             asetaLogo(logo);
             liitteet_->tallenna();
         }
+        if( asetusModel_->luku("KpVersio") < 11)
+        {
+            // Raporttikyselyjen yhdistelmäindeksit
+            paivita(11);
+        }
+        if( asetusModel_->luku("KpVersio") < 12)
+        {
+            // Laskurivit omaan tauluunsa
+            paivita(12);
+            siirraLaskurivit();
+        }
+        if( asetusModel_->luku("KpVersio") < 13)
+        {
+            // Budjetit omaan tauluunsa
+            paivita(13);
+            siirraBudjetit();
+        }
+        if( asetusModel_->luku("KpVersio") < 14)
+        {
+            // Asiakasrekisteri
+            paivita(14);
+            siirraAsiakkaat();
+        }
+        if( asetusModel_->luku("KpVersio") < 15)
+        {
+            // Tekstihaun indeksi. Ilman FTS5-tukea tauluja ei synny,
+            // jolloin haetaan vertailulla
+            paivita(15);
+        }
+
+        // Laskurivien, budjettien ja asiakkaiden siirrot ovat lisänneet
+        // rivejä tauluihin, joiden tilastot ovat vanhentuneet
+        paivitaTilastot();
 
         asetusModel_->aseta("KpVersio", TIETOKANTAVERSIO);
         asetusModel_->aseta("LuotuVersiolla", qApp->applicationVersion());
@@ -371,13 +443,15 @@ bool Kirjanpito::avaaTietokanta(const QString &tiedosto, bool ilmoitaVirheesta)
 
     }
     // Lukitaan tietokanta
-    asetusModel_->aseta("Avattu", QDateTime::currentDateTime().toString(Qt::ISODate));
+    if( !vainLuku )
+        asetusModel_->aseta("Avattu", QDateTime::currentDateTime().toString(Qt::ISODate));
 
     tositelajiModel_->lataa();
     tiliModel_->lataa();
     tilikaudetModel_->lataa();
     kohdennukset_->lataa();
     tuotteet_->lataa();
+    hakuindeksi_->alusta( vainLuku );
 
     // Tilapäishakemiston luominen
     // #124 Jos väliaikaistiedosto ei toimi...
@@ -393,7 +467,7 @@ bool Kirjanpito::avaaTietokanta(const QString &tiedosto, bool ilmoitaVirheesta)
 
         tempDir_ = new QTemporaryDir( info.dir().absoluteFilePath("Temp")  );
         if( !tempDir_->isValid())
-            QMessageBox::critical(nullptr, tr("Tilapäishakemiston luominen epäonnistui"),
+            avausvirhe(tr("Tilapäishakemiston luominen epäonnistui"),
                                   tr("Kitupiikki ei onnistunut luomaan tilapäishakemistoa. Raporttien ja laskujen esikatselu ei toimi."));
     }
 
@@ -410,7 +484,7 @@ bool Kirjanpito::avaaTietokanta(const QString &tiedosto, bool ilmoitaVirheesta)
 
 bool Kirjanpito::lataaUudelleen()
 {
-    return avaaTietokanta(tiedostopolku());
+    return avaaTietokanta(tiedostopolku(), true, vainLuku_);
 }
 
 void Kirjanpito::asetaHarjoitteluPvm(const QDate &pvm)
@@ -429,6 +503,71 @@ void Kirjanpito::asetaInstanssi(Kirjanpito *kp)
     instanssi__ = kp;
 }
 
+qulonglong Kirjanpito::muutosversio(const QDate &alkaa, const QDate &loppuu) const
+{
+    qulonglong versio = yleisversio_;
+    for( const KirjausMuutos& muutos : muutokset_)
+    {
+        // Huomioidaan muutokset, joiden aikaväli leikkaa kysyttyä väliä
+        if( muutos.versio > versio &&
+            ( !loppuu.isValid() || muutos.alkaa <= loppuu ) &&
+            ( !alkaa.isValid() || muutos.loppuu >= alkaa ))
+            versio = muutos.versio;
+    }
+    return versio;
+}
+
+void Kirjanpito::merkitseMuutos(const QDate &alkaa, const QDate &loppuu)
+{
+    muutosversio_++;
+
+    // Pitkän istunnon aikana muutoslista kootaan yhdeksi kaiken kattavaksi muutokseksi
+    if( !alkaa.isValid() || !loppuu.isValid() || muutokset_.count() >= 1000)
+    {
+        yleisversio_ = muutosversio_;
+        muutokset_.clear();
+    }
+    else
+        muutokset_.append( KirjausMuutos{ alkaa, loppuu, muutosversio_ } );
+}
+
+LaskuPohja *Kirjanpito::laskupohja()
+{
+    if( !laskupohja_ )
+        laskupohja_ = new LaskuPohja;
+    return laskupohja_;
+}
+
+void Kirjanpito::ilmoitaTositeMuutos(const TositeMuutos &muutos)
+{
+    if( muutos.alkaa.isValid())
+        merkitseMuutos(muutos.alkaa, muutos.loppuu);
+    emit tositeMuuttui(muutos);
+}
+
+QSqlQuery &Kirjanpito::kysely(const QString &sql)
+{
+    QHash<QString,QSqlQuery>::iterator iter = kyselyt_.find(sql);
+    if( iter == kyselyt_.end())
+    {
+        QSqlQuery kysely( tietokanta_ );
+        kysely.prepare(sql);
+        iter = kyselyt_.insert(sql, kysely);
+    }
+    else
+        iter.value().finish();      // Vapautetaan edellisen suorituksen tulokset
+
+    return iter.value();
+}
+
+void Kirjanpito::avausvirhe(const QString &otsikko, const QString &teksti)
+{
+    if( vainLuku_ )
+        qWarning() << otsikko << ":" << teksti;
+    else
+        QMessageBox::critical(nullptr, otsikko, teksti);
+}
+
 
 QString Kirjanpito::satujono(int pituus)
 {
@@ -445,6 +584,13 @@ QString Kirjanpito::satujono(int pituus)
     return randomString;
 }
 
+void Kirjanpito::paivitaTilastot()
+{
+    QSqlQuery kysely( tietokanta_ );
+    if( !kysely.exec("ANALYZE"))
+        qWarning() << "Tilastojen päivittäminen epäonnistui" << kysely.lastError().text();
+}
+
 void Kirjanpito::paivita(int versioon)
 {
     QFile sqltiedosto( QString(":/sql/update%1.sql").arg(versioon));
@@ -462,6 +608,122 @@ void Kirjanpito::paivita(int versioon)
     }
 }
 
+void Kirjanpito::siirraLaskurivit()
+{
+    // Siirretään erissä, jottei yksittäinen transaktio kasva suureksi
+    const int ERAKOKO = 500;
+    int viimeisin = 0;
+
+    QSqlQuery kysely( tietokanta_ );
+    kysely.prepare("SELECT id, json FROM vienti WHERE viite IS NOT NULL AND json LIKE '%Laskurivit%' "
+                   "AND id > :viimeisin ORDER BY id LIMIT :erakoko");
+    forever
+    {
+        kysely.bindValue(":viimeisin", viimeisin);
+        kysely.bindValue(":erakoko", ERAKOKO);
+        kysely.exec();
+
+        QList<QPair<int,QByteArray>> era;
+        while( kysely.next())
+            era.append( qMakePair( kysely.value(0).toInt(), kysely.value(1).toByteArray()));
+        kysely.finish();
+
+        if( era.isEmpty())
+            break;
+
+        tietokanta_.transaction();
+        for( const auto& vienti : era)
+        {
+            JsonKentta json( vienti.second );
+            VientiModel::tallennaLaskurivit( vienti.first, json.variant("Laskurivit").toList());
+        }
+        tietokanta_.commit();
+
+        viimeisin = era.last().first;
+        qApp->processEvents();
+    }
+}
+
+void Kirjanpito::siirraBudjetit()
+{
+    // Tilikaudet on ladattava ennen siirtoa
+    tilikaudetModel_->lataa();
+
+    QSqlQuery kysely( tietokanta_ );
+    kysely.prepare("INSERT INTO budjetti(tilikausi, kohdennus, tilinro, sentit) "
+                   "VALUES (:tilikausi, :kohdennus, :tilinro, :sentit)");
+
+    tietokanta_.transaction();
+    for(int i=0; i < tilikaudetModel_->rowCount(QModelIndex()); i++)
+    {
+        Tilikausi kausi = tilikaudetModel_->tilikausiIndeksilla(i);
+        JsonKentta *json = tilikaudetModel_->json(i);
+
+        QMapIterator<QString,QVariant> kohdennusIter( json->variant("Budjetti").toMap() );
+        while( kohdennusIter.hasNext())
+        {
+            kohdennusIter.next();
+            QMapIterator<QString,QVariant> tiliIter( kohdennusIter.value().toMap() );
+            while( tiliIter.hasNext())
+            {
+                tiliIter.next();
+                kysely.bindValue(":tilikausi", kausi.alkaa());
+                kysely.bindValue(":kohdennus", kohdennusIter.key().toInt());
+                kysely.bindValue(":tilinro", tiliIter.key().toInt());
+                kysely.bindValue(":sentit", tiliIter.value().toLongLong());
+                kysely.exec();
+            }
+        }
+        if( json->avaimet().contains("Budjetti"))
+            json->unset("Budjetti");
+    }
+    tietokanta_.commit();
+    tilikaudetModel_->tallennaJSON();
+}
+
+void Kirjanpito::siirraAsiakkaat()
+{
+    // Asiakkaan yhteystiedoiksi viimeisimmän myyntiviennin tiedot
+    QSqlQuery kysely( tietokanta_ );
+    kysely.exec("SELECT asiakasid, json FROM vienti WHERE asiakasid IS NOT NULL AND iban IS NULL "
+                "AND json IS NOT NULL ORDER BY asiakasid, muokattu DESC");
+
+    QList<Asiakas> asiakkaat;
+    int edellinen = 0;
+    while( kysely.next())
+    {
+        int asiakasid = kysely.value(0).toInt();
+        if( asiakasid == edellinen)
+            continue;
+
+        JsonKentta json( kysely.value(1).toByteArray());
+        Asiakas asiakas;
+        asiakas.id = asiakasid;
+        asiakas.osoite = json.str("Osoite");
+        asiakas.email = json.str("Email");
+        asiakas.ytunnus = json.str("YTunnus");
+        asiakas.verkkolaskuosoite = json.str("VerkkolaskuOsoite");
+        asiakas.verkkolaskuvalittaja = json.str("VerkkolaskuValittaja");
+
+        if( asiakas.osoite.isEmpty() && asiakas.email.isEmpty() && asiakas.ytunnus.isEmpty() &&
+            asiakas.verkkolaskuosoite.isEmpty())
+            continue;   // Ei yhteystietoja, katsotaan aiempia vientejä
+
+        asiakkaat.append(asiakas);
+        edellinen = asiakasid;
+    }
+    kysely.finish();
+
+    tietokanta_.transaction();
+    for( Asiakas& asiakas : asiakkaat)
+        asiakas.tallenna(false);     // Yhteystiedot siirretään myyntivienneistä
+
+    // Yhteystietoja varten lisätyt tositteettomat viennit ovat nyt tarpeettomia
+    kysely.exec("DELETE FROM vienti WHERE tosite IS NULL AND tili IS NULL AND debetsnt IS NULL "
+                "AND kreditsnt IS NULL AND asiakas IS NOT NULL");
+    tietokanta_.commit();
+}
+
 Kirjanpito* Kirjanpito::instanssi__ = nullptr;
 
 Kirjanpito *kp()  { return Kirjanpito::db(); }
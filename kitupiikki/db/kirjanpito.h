@@ -29,6 +29,8 @@
 #include <QMap>
 #include <QDir>
 #include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QHash>
 #include <QDate>
 #include <QTemporaryDir>
 #include <QImage>
@@ -49,6 +51,9 @@
 
 class QPrinter;
 class QSettings;
+class HakuIndeksi;
+class LaskuPohja;
+struct TositeMuutos;
 
 /**
  * @brief Kirjanpidon käsittely
@@ -162,6 +167,12 @@ public:
      */
     TuoteModel *tuotteet() const { return tuotteet_; }
 
+    /**
+     * @brief Tositteiden ja liitteiden tekstihaun indeksi
+     * @since 1.1
+     */
+    HakuIndeksi *hakuindeksi() const { return hakuindeksi_; }
+
     /**
      * @brief Sql-tietokanta
      *
@@ -172,12 +183,76 @@ public:
      */
     QSqlDatabase *tietokanta()  { return &tietokanta_; }
 
+    /**
+     * @brief Valmisteltu kysely
+     *
+     * Sama sql-lause jäsennetään ja valmistellaan vain kerran tietokantayhteyttä
+     * kohden, joten toistuvissa kyselyissä arvot sidotaan bindValue():lla.
+     *
+     * Kysely on jaettu kaikkien saman lauseen käyttäjien kesken: arvot on
+     * sidottava ja kysely suoritettava ja luettava ennen kuin samaa lausetta
+     * käytetään uudelleen, eikä samaa lausetta voi käyttää sisäkkäin.
+     *
+     * @param sql Kyselyn sql-lause, arvojen paikalla :nimetyt parametrit
+     * @return Valmisteltu kysely
+     */
+    QSqlQuery& kysely(const QString& sql);
+
+    /**
+     * @brief Kirjausten muutosversio aikavälille
+     *
+     * Versio kasvaa aina, kun aikavälille osuvia vientejä tallennetaan tai
+     * poistetaan sekä kun tilikarttaa, tilikausia, kohdennuksia tai
+     * perusasetuksia muokataan. Raportin välimuisti vertaa versiota
+     * raportin muodostamishetken versioon.
+     *
+     * @param alkaa Aikavälin alku, QDate() jos kirjanpidon alusta
+     * @param loppuu Aikavälin loppu, QDate() jos loppumaton
+     * @since 1.1
+     */
+    qulonglong muutosversio(const QDate& alkaa = QDate(), const QDate& loppuu = QDate()) const;
+
+    /**
+     * @brief Merkitsee aikavälin kirjaukset muuttuneiksi
+     *
+     * Ilman päivämääriä merkitään koko kirjanpito muuttuneeksi
+     * @since 1.1
+     */
+    void merkitseMuutos(const QDate& alkaa = QDate(), const QDate& loppuu = QDate());
+
+    /**
+     * @brief Ilmoittaa tositteen tallentamisesta tai poistamisesta
+     *
+     * Merkitsee vientien aikavälin muuttuneeksi ja lähettää
+     * tositeMuuttui()-signaalin, jolla listat päivittävät muuttuneet rivit
+     * @since 1.1
+     */
+    void ilmoitaTositeMuutos(const TositeMuutos& muutos);
+
+    /**
+     * @brief Päivittää kyselysuunnittelijan tilastot (ANALYZE)
+     *
+     * Kutsutaan tietokannan päivityksen ja tiliotteiden kaltaisten
+     * massatuontien jälkeen, jotta raporttikyselyt käyttävät oikeita indeksejä.
+     * @since 1.1
+     */
+    void paivitaTilastot();
+
     /**
      * @brief QPrinter kaikenlaiseen tulosteluun
      * @return
      */
     QPrinter *printer() { return printer_;}
 
+    /**
+     * @brief Kaikkien laskujen yhteinen tulostuspohja
+     *
+     * Pohja luodaan ensimmäisellä käyttökerralla. Kirjanpito omistaa pohjan,
+     * jotta sen fontit ja kuvat tuhotaan ennen sovellusoliota.
+     * @since 1.1
+     */
+    LaskuPohja *laskupohja();
+
     /**
      * @brief Näyttää halutun ohjesivun selaimessa
      * @param ohjesivu
@@ -250,6 +325,14 @@ signals:
      */
     void kirjanpitoaMuokattu();
 
+    /**
+     * @brief Tosite on tallennettu tai poistettu
+     *
+     * Lähetetään ennen kirjanpitoaMuokattu()-signaalia
+     * @since 1.1
+     */
+    void tositeMuuttui(const TositeMuutos& muutos);
+
     /**
      * @brief Perusasetuksia muutetaan, joten aloitussivu päivitetään
      */
@@ -284,9 +367,10 @@ public slots:
     /**
      * @brief Avaa kirjanpitotietokannan
      * @param tiedosto Kirjanpidon kitupiikki.sqlite-tiedoston täydellinen polku
+     * @param vainLuku Avataan vain luettavaksi ilman dialogeja (eräajo), virheet tulostetaan lokiin
      * @return tosi, jos onnistuu
      */
-    bool avaaTietokanta(const QString& tiedosto, bool ilmoitaVirheesta = true);
+    bool avaaTietokanta(const QString& tiedosto, bool ilmoitaVirheesta = true, bool vainLuku = false);
 
     /**
      * @brief Lataa tietokannan uudelleen rakenteen muutoksen jälkeen
@@ -304,6 +388,7 @@ public slots:
 protected:
     QString polkuTiedostoon_;
     QSqlDatabase tietokanta_;
+    QHash<QString,QSqlQuery> kyselyt_;
     QMap<QString,QString> viimetiedostot;
     QDate harjoitusPvm;
 
@@ -315,8 +400,10 @@ protected:
     VerotyyppiModel *veroTyypit_;
     TilityyppiModel *tiliTyypit_;
     TuoteModel *tuotteet_;
+    HakuIndeksi *hakuindeksi_;
     LiiteModel *liitteet_;
     QPrinter *printer_;
+    LaskuPohja *laskupohja_;
 
     QTemporaryDir *tempDir_;
     QImage logo_;
@@ -324,6 +411,19 @@ protected:
     QSettings* settings_;
     QString portableDir_;      // Portable-ohjelman käynnistyshakemisto
 
+    /**
+     * @brief Muutettujen kirjausten aikaväli
+     */
+    struct KirjausMuutos
+    {
+        QDate alkaa;
+        QDate loppuu;
+        qulonglong versio;
+    };
+    QList<KirjausMuutos> muutokset_;
+    qulonglong muutosversio_ = 0;
+    qulonglong yleisversio_ = 0;     /** Koko kirjanpitoa koskeneen muutoksen versio */
+
 public:
     /**
      * @brief Staattinen funktio, jonka kautta Kirjanpitoon päästään käsiksi
@@ -349,7 +449,7 @@ public:
      *
      * Jos yritetään avata uudempaa, tulee virhe
      */
-    static const int TIETOKANTAVERSIO = 10;
+    static const int TIETOKANTAVERSIO = 15;
 
     /**
      * @brief Palauttaa satunnaismerkkijonon
@@ -364,14 +464,44 @@ public:
      */
     QString portableDir() const { return portableDir_;}
 
+    /**
+     * @brief Onko kirjanpito avattu vain luettavaksi
+     */
+    bool onkoVainLuku() const { return vainLuku_; }
+
 private:
     static Kirjanpito *instanssi__;
 
+    /**
+     * @brief Näyttää avaamisen virheen, tai vain luettaessa kirjoittaa sen lokiin
+     */
+    void avausvirhe(const QString& otsikko, const QString& teksti);
+
+    bool vainLuku_ = false;
+
     /**
      * @brief Suorittaa päivitykset
      * @param versioon Tietokantaversion (ei ohjelmaversio!)
      */
     void paivita(int versioon);
+
+    /**
+     * @brief Siirtää laskujen json-kenttiin tallennetut rivit laskurivi-tauluun
+     * @since 1.1
+     */
+    void siirraLaskurivit();
+
+    /**
+     * @brief Siirtää tilikausien json-kenttiin tallennetut budjetit budjetti-tauluun
+     * @since 1.1
+     */
+    void siirraBudjetit();
+
+    /**
+     * @brief Poimii asiakasrekisteriin asiakkaiden viimeisimmät yhteystiedot
+     * @since 1.1
+     */
+    void siirraAsiakkaat();
 };
 
 /**
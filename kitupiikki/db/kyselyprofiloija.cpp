@@ -0,0 +1,242 @@
+/*
+   Copyright (C) 2018 Arto Hyvättinen
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRegularExpression>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QJsonDocument>
+#include <QHash>
+#include <QPair>
+#include <QStringList>
+
+#include "kyselyprofiloija.h"
+
+bool KyselyProfiloija::kaytossa_ = false;
+QVector<KyselyProfiloija::Kirjaus> KyselyProfiloija::puskuri_;
+int KyselyProfiloija::seuraava_ = 0;
+QString KyselyProfiloija::alue_;
+int KyselyProfiloija::operaatio_ = 0;
+int KyselyProfiloija::sisakkaisia_ = 0;
+
+namespace {
+    QMutex puskurinLukko;
+    QElapsedTimer kello;
+}
+
+KyselyProfiloija::Operaatio::Operaatio(const QString &alue)
+    : alue_(alue)
+{
+    if( !kaytossa_ )
+        return;
+
+    kirjataan_ = true;
+    edellinenAlue_ = KyselyProfiloija::alue_;
+    KyselyProfiloija::alue_ = alue;
+    if( !sisakkaisia_++ )
+        operaatio_++;
+    alkaaUs_ = aikaUs();
+}
+
+KyselyProfiloija::Operaatio::~Operaatio()
+{
+    if( !kirjataan_ )
+        return;
+
+    Kirjaus kirjaus;
+    kirjaus.alue = alue_;
+    kirjaus.operaatio = operaatio_;
+    kirjaus.alkaaUs = alkaaUs_;
+    kirjaus.kestoUs = aikaUs() - alkaaUs_;
+    kirjaa(kirjaus);
+
+    KyselyProfiloija::alue_ = edellinenAlue_;
+    sisakkaisia_--;
+}
+
+void KyselyProfiloija::asetaKayttoon(bool kaytossa)
+{
+    if( kaytossa && !kello.isValid())
+        kello.start();
+    kaytossa_ = kaytossa;
+}
+
+bool KyselyProfiloija::suorita(QSqlQuery &kysely)
+{
+    if( !kaytossa_ )
+        return kysely.exec();
+    return suoritaKirjaten(kysely, QString());
+}
+
+bool KyselyProfiloija::suorita(QSqlQuery &kysely, const QString &sql)
+{
+    if( !kaytossa_ )
+        return kysely.exec(sql);
+    return suoritaKirjaten(kysely, sql);
+}
+
+QVector<KyselyProfiloija::Kirjaus> KyselyProfiloija::kirjaukset()
+{
+    QMutexLocker lukko(&puskurinLukko);
+    if( puskuri_.count() < KIRJAUKSIA )
+        return puskuri_;
+    // Puskuri on kiertänyt: vanhin kirjaus on seuraavaksi korvattavan kohdalla
+    return puskuri_.mid(seuraava_) + puskuri_.mid(0, seuraava_);
+}
+
+void KyselyProfiloija::tyhjenna()
+{
+    QMutexLocker lukko(&puskurinLukko);
+    puskuri_.clear();
+    seuraava_ = 0;
+}
+
+QList<KyselyProfiloija::Toisto> KyselyProfiloija::toistot(int kynnys)
+{
+    QHash<QPair<int,QString>, Toisto> toistot;    // (operaatio, muoto)
+    for( const Kirjaus& kirjaus : kirjaukset())
+    {
+        if( kirjaus.sql.isEmpty() || !kirjaus.operaatio )
+            continue;
+
+        QString kyselynMuoto = muoto(kirjaus.sql);
+        Toisto& toisto = toistot[ qMakePair(kirjaus.operaatio, kyselynMuoto) ];
+        toisto.muoto = kyselynMuoto;
+        toisto.alue = kirjaus.alue;
+        toisto.operaatio = kirjaus.operaatio;
+        toisto.kertoja++;
+        toisto.kestoUs += kirjaus.kestoUs;
+    }
+
+    QList<Toisto> lista;
+    for( const Toisto& toisto : toistot)
+        if( toisto.kertoja > kynnys )
+            lista.append(toisto);
+    return lista;
+}
+
+QString KyselyProfiloija::muoto(const QString &sql)
+{
+    static const QRegularExpression merkkijonot("'[^']*'|\"[^\"]*\"");
+    static const QRegularExpression luvut("\\b\\d+(\\.\\d+)?\\b");
+    static const QRegularExpression luettelot("\\(\\s*\\?(\\s*,\\s*\\?)*\\s*\\)");
+
+    QString tulos = sql.simplified();
+    tulos.replace(merkkijonot, "?");
+    tulos.replace(luvut, "?");
+    tulos.replace(luettelot, "(?)");
+    return tulos;
+}
+
+QByteArray KyselyProfiloija::chromeJalki()
+{
+    QJsonArray tapahtumat;
+    for( const Kirjaus& kirjaus : kirjaukset())
+    {
+        QJsonObject tapahtuma;
+        tapahtuma.insert("ph", "X");
+        tapahtuma.insert("pid", 1);
+        tapahtuma.insert("tid", 1);
+        tapahtuma.insert("ts", kirjaus.alkaaUs);
+        tapahtuma.insert("dur", kirjaus.kestoUs);
+
+        QJsonObject tiedot;
+        tiedot.insert("operaatio", kirjaus.operaatio);
+        if( kirjaus.sql.isEmpty())
+        {
+            tapahtuma.insert("name", kirjaus.alue);
+            tapahtuma.insert("cat", "operaatio");
+        }
+        else
+        {
+            tapahtuma.insert("name", muoto(kirjaus.sql).left(80));
+            tapahtuma.insert("cat", kirjaus.alue.isEmpty() ? QString("sql") : kirjaus.alue);
+            tiedot.insert("sql", kirjaus.sql);
+            tiedot.insert("parametrit", kirjaus.parametrit);
+            tiedot.insert("rivit", kirjaus.rivit);
+        }
+        tapahtuma.insert("args", tiedot);
+        tapahtumat.append(tapahtuma);
+    }
+
+    QJsonObject juuri;
+    juuri.insert("traceEvents", tapahtumat);
+    juuri.insert("displayTimeUnit", "ms");
+    return QJsonDocument(juuri).toJson(QJsonDocument::Compact);
+}
+
+void KyselyProfiloija::kirjaa(const Kirjaus &kirjaus)
+{
+    QMutexLocker lukko(&puskurinLukko);
+    if( puskuri_.count() < KIRJAUKSIA )
+        puskuri_.append(kirjaus);
+    else
+        puskuri_[seuraava_] = kirjaus;
+    seuraava_ = (seuraava_ + 1) % KIRJAUKSIA;
+}
+
+qint64 KyselyProfiloija::aikaUs()
+{
+    return kello.nsecsElapsed() / 1000;
+}
+
+bool KyselyProfiloija::suoritaKirjaten(QSqlQuery &kysely, const QString &sql)
+{
+    Kirjaus kirjaus;
+    kirjaus.alue = alue_;
+    kirjaus.operaatio = sisakkaisia_ ? operaatio_ : 0;
+
+    if( sql.isEmpty())
+    {
+        QStringList parametrit;
+        QMapIterator<QString,QVariant> iter( kysely.boundValues() );
+        while( iter.hasNext())
+        {
+            iter.next();
+            parametrit.append( QString("%1=%2").arg(iter.key(), iter.value().toString()) );
+        }
+        kirjaus.parametrit = parametrit.join(", ");
+    }
+
+    kirjaus.alkaaUs = aikaUs();
+    bool onnistui = sql.isEmpty() ? kysely.exec() : kysely.exec(sql);
+    kirjaus.kestoUs = aikaUs() - kirjaus.alkaaUs;
+    kirjaus.sql = kysely.lastQuery();
+
+    // SQLite ei kerro hakukyselyn rivimäärää etukäteen, joten rivit lasketaan
+    // selaamalla tulos loppuun ja palaamalla alkuun. Tämä tehdään vasta ajoituksen
+    // jälkeen, eikä eteenpäin selattaville kyselyille, joihin ei voi palata.
+    if( onnistui && kysely.isSelect())
+    {
+        if( !kysely.isForwardOnly() && kysely.last())
+        {
+            kirjaus.rivit = kysely.at() + 1;
+            kysely.seek(QSql::BeforeFirstRow);
+        }
+        else if( !kysely.isForwardOnly())
+            kirjaus.rivit = 0;
+    }
+    else if( onnistui )
+        kirjaus.rivit = kysely.numRowsAffected();
+
+    kirjaa(kirjaus);
+    return onnistui;
+}
@@ -0,0 +1,143 @@
+/*
+   Copyright (C) 2018 Arto Hyvättinen
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef KYSELYPROFILOIJA_H
+#define KYSELYPROFILOIJA_H
+
+#include <QString>
+#include <QVector>
+#include <QList>
+#include <QByteArray>
+
+class QSqlQuery;
+
+/**
+ * @brief Tietokantakyselyjen ajoitus kehittäjän työkaluihin
+ *
+ * Kun profilointi on otettu käyttöön, kyselyjen tekstit, sidotut parametrit,
+ * rivimäärät ja kestot kirjataan rengaspuskuriin, josta uusimmat
+ * KIRJAUKSIA kirjausta voidaan tarkastella DevTool-ikkunassa tai viedä
+ * Chromen jäljitysmuotoon (chrome://tracing).
+ *
+ * Kyselyt suoritetaan suorita()-funktiolla ja raskaat lataukset
+ * rajataan Operaatio-oliolla, jonka nimi kirjataan kyselyjen alueeksi.
+ * Samanmuotoisen kyselyn toistuminen yhden operaation aikana kertoo
+ * yleensä rivikohtaisista lisäkyselyistä (N+1).
+ *
+ * Profilointi on oletuksena pois käytöstä, jolloin suorita() vain
+ * suorittaa kyselyn.
+ *
+ * @since 1.1
+ */
+class KyselyProfiloija
+{
+public:
+    enum { KIRJAUKSIA = 10000 };
+
+    /**
+     * @brief Yksi kirjattu kysely tai operaatio
+     */
+    struct Kirjaus
+    {
+        QString sql;            /** Tyhjä, jos kirjaus on operaatio */
+        QString parametrit;
+        QString alue;           /** Operaatio, jonka aikana kysely suoritettiin */
+        int operaatio = 0;      /** Uloimman operaation järjestysnumero */
+        int rivit = -1;
+        qint64 alkaaUs = 0;     /** Mikrosekunteina profiloinnin käynnistämisestä */
+        qint64 kestoUs = 0;
+    };
+
+    /**
+     * @brief Saman operaation aikana toistuva kysely
+     */
+    struct Toisto
+    {
+        QString muoto;          /** Kysely ilman vakioarvoja */
+        QString alue;
+        int operaatio = 0;
+        int kertoja = 0;
+        qint64 kestoUs = 0;
+    };
+
+    /**
+     * @brief Rajaa operaation, jonka kyselyt kirjataan samalle alueelle
+     *
+     * @code
+     * KyselyProfiloija::Operaatio mittaus("Selaus");
+     * @endcode
+     */
+    class Operaatio
+    {
+    public:
+        Operaatio(const QString& alue);
+        ~Operaatio();
+    private:
+        QString alue_;
+        QString edellinenAlue_;
+        qint64 alkaaUs_ = 0;
+        bool kirjataan_ = false;
+    };
+
+    static void asetaKayttoon(bool kaytossa);
+    static bool kaytossa() { return kaytossa_; }
+
+    /**
+     * @brief Suorittaa valmistellun kyselyn ja kirjaa sen, jos profilointi on käytössä
+     * @return QSqlQuery::exec():n paluuarvo
+     */
+    static bool suorita(QSqlQuery& kysely);
+    /**
+     * @brief Suorittaa kyselyn tekstistä ja kirjaa sen, jos profilointi on käytössä
+     */
+    static bool suorita(QSqlQuery& kysely, const QString& sql);
+
+    /**
+     * @brief Kirjatut kyselyt ja operaatiot vanhimmasta alkaen
+     */
+    static QVector<Kirjaus> kirjaukset();
+    static void tyhjenna();
+
+    /**
+     * @brief Kyselyt, joiden muoto toistuu saman operaation aikana useammin kuin kynnys
+     */
+    static QList<Toisto> toistot(int kynnys);
+
+    /**
+     * @brief Kyselyn muoto, jossa merkkijono- ja lukuvakiot on korvattu ?-merkillä
+     */
+    static QString muoto(const QString& sql);
+
+    /**
+     * @brief Kirjaukset Chromen jäljitysmuodossa (Trace Event Format)
+     */
+    static QByteArray chromeJalki();
+
+protected:
+    static void kirjaa(const Kirjaus& kirjaus);
+    static qint64 aikaUs();
+    static bool suoritaKirjaten(QSqlQuery& kysely, const QString& sql);
+
+    static bool kaytossa_;
+    static QVector<Kirjaus> puskuri_;
+    static int seuraava_;           /** Puskurin seuraavaksi korvattava paikka */
+    static QString alue_;
+    static int operaatio_;
+    static int sisakkaisia_;
+};
+
+#endif // KYSELYPROFILOIJA_H
@@ -34,6 +34,7 @@
 #include "liitemodel.h"
 #include "tositemodel.h"
 #include "kirjanpito.h"
+#include "hakuindeksi.h"
 
 #include <QDebug>
 #include <QSqlError>
@@ -354,6 +355,9 @@ bool LiiteModel::tallenna()
                     return false;
                 liitteet_[i].id = kysely.lastInsertId().toInt();
 
+                if( tositeModel_ )
+                    kp()->hakuindeksi()->indeksoiUudetLiitteet();
+
                 if( !inboxPolku.isEmpty() && liitteet_.at(i).lisattyPolusta.startsWith( inboxPolku ) )
                     QFile::remove( liitteet_.at(i).lisattyPolusta );
 
@@ -365,6 +369,7 @@ bool LiiteModel::tallenna()
                 kysely.bindValue(":otsikko", liitteet_[i].otsikko);
                 if( !kysely.exec() )
                     return false;
+                kp()->hakuindeksi()->paivitaLiitteenOtsikko( liitteet_.at(i).id, liitteet_.at(i).otsikko );
             }
             liitteet_[i].muokattu = false;
         }
@@ -372,7 +377,10 @@ bool LiiteModel::tallenna()
 
     // Poistetut liitteet
     for( int poistettuId : poistetutIdt_)
+    {
         kysely.exec( QString("DELETE from liite WHERE id=%1").arg(poistettuId) );
+        kp()->hakuindeksi()->poistaLiite( poistettuId );
+    }
 
     muokattu_ = false;
     return true;
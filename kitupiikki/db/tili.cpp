@@ -60,15 +60,18 @@ int Tili::ysivertailuluku() const
 
 qlonglong Tili::saldoPaivalle(const QDate &pvm)
 {
-    QString kysymys = QString("SELECT SUM(debetsnt), SUM(kreditsnt) FROM vienti WHERE tili=%1 ").arg(id());
-    if( onko(TiliLaji::TASE) )
-        kysymys.append( QString(" AND pvm <= \"%1\" ").arg(pvm.toString(Qt::ISODate)));
-    else
-        kysymys.append( QString(" AND pvm BETWEEN \"%1\" AND \"%2\" ")
-                        .arg( kp()->tilikaudet()->tilikausiPaivalle(pvm).alkaa().toString(Qt::ISODate) )
-                        .arg( pvm.toString(Qt::ISODate )));
+    Tilikausi kausi = kp()->tilikaudet()->tilikausiPaivalle(pvm);
+
+    // Taseen tileille saldo alusta alkaen, muille tilikauden alusta
+    QSqlQuery& kysely = onko(TiliLaji::TASE) ?
+                kp()->kysely("SELECT SUM(debetsnt), SUM(kreditsnt) FROM vienti WHERE tili=:tili AND pvm <= :pvm") :
+                kp()->kysely("SELECT SUM(debetsnt), SUM(kreditsnt) FROM vienti WHERE tili=:tili AND pvm BETWEEN :alku AND :pvm");
+    kysely.bindValue(":tili", id());
+    if( !onko(TiliLaji::TASE))
+        kysely.bindValue(":alku", kausi.alkaa() );
+    kysely.bindValue(":pvm", pvm);
+    kysely.exec();
 
-    QSqlQuery kysely(kysymys);
     if( kysely.next())
     {
         qlonglong debet = kysely.value(0).toLongLong();
@@ -77,10 +80,11 @@ qlonglong Tili::saldoPaivalle(const QDate &pvm)
         if( onko(TiliLaji::EDELLISTENTULOS) )
         {
             // Edellisten yli/alijaamaan pitää laskea vielä edellisten tulokset
-            QSqlQuery edelliskysely( QString("SELECT SUM(debetsnt), SUM(kreditsnt) FROM vienti, tili "
-                                             "WHERE vienti.tili = tili.id AND pvm < \"%1\" "
-                                             "AND ysiluku > 300000000 ")
-                                     .arg(kp()->tilikaudet()->tilikausiPaivalle(pvm).alkaa().toString(Qt::ISODate)));
+            QSqlQuery& edelliskysely = kp()->kysely("SELECT SUM(debetsnt), SUM(kreditsnt) FROM vienti, tili "
+                                                    "WHERE vienti.tili = tili.id AND pvm < :alku "
+                                                    "AND ysiluku > 300000000 ");
+            edelliskysely.bindValue(":alku", kausi.alkaa());
+            edelliskysely.exec();
             if( edelliskysely.next())
             {
                 return kredit + edelliskysely.value(1).toLongLong() - debet - edelliskysely.value(0).toLongLong();
@@ -89,11 +93,12 @@ qlonglong Tili::saldoPaivalle(const QDate &pvm)
         else if( onko(TiliLaji::KAUDENTULOS))
         {
             // Tämän tilikauden yli/alijaamaan
-            QSqlQuery edelliskysely( QString("SELECT SUM(debetsnt), SUM(kreditsnt) FROM vienti, tili "
-                                             "WHERE vienti.tili = tili.id AND pvm BETWEEN \"%1\" and \"%2\" "
-                                             "AND ysiluku > 300000000 ")
-                                     .arg(kp()->tilikaudet()->tilikausiPaivalle(pvm).alkaa().toString(Qt::ISODate))
-                                     .arg(kp()->tilikaudet()->tilikausiPaivalle(pvm).paattyy().toString(Qt::ISODate)));
+            QSqlQuery& edelliskysely = kp()->kysely("SELECT SUM(debetsnt), SUM(kreditsnt) FROM vienti, tili "
+                                                    "WHERE vienti.tili = tili.id AND pvm BETWEEN :alku AND :loppu "
+                                                    "AND ysiluku > 300000000 ");
+            edelliskysely.bindValue(":alku", kausi.alkaa());
+            edelliskysely.bindValue(":loppu", kausi.paattyy());
+            edelliskysely.exec();
             if( edelliskysely.next())
             {
                 return kredit + edelliskysely.value(1).toLongLong() - debet - edelliskysely.value(0).toLongLong();
@@ -0,0 +1,189 @@
+/*
+   Copyright (C) 2018 Arto Hyvättinen
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "tilihakemisto.h"
+#include "tilimodel.h"
+
+#include <QRegExp>
+
+TiliHakemisto::TiliHakemisto()
+{
+    numerot_.append( Solmu() );
+    nimet_.append( Solmu() );
+}
+
+void TiliHakemisto::rakenna(const TiliModel *model)
+{
+    int tileja = model->rowCount(QModelIndex());
+
+    numerot_.clear();
+    numerot_.append( Solmu() );
+    nimet_.clear();
+    nimet_.append( Solmu() );
+    tekstit_.clear();
+    pienetNimet_.clear();
+    tyypit_.clear();
+    tyyppimaskit_.clear();
+
+    kaytossa_ = QBitArray(tileja);
+    suosikit_ = QBitArray(tileja);
+
+    for(int rivi = 0; rivi < tileja; rivi++)
+    {
+        Tili tili = model->tiliIndeksilla(rivi);
+
+        tekstit_.append( QString("%1 %2").arg(tili.numero()).arg(tili.nimi()) );
+        pienetNimet_.append( tili.nimi().toLower() );
+        tyypit_.append( tili.tyyppiKoodi() );
+
+        if( tili.tila() )
+            kaytossa_.setBit(rivi);
+        if( tili.tila() == 2)
+            suosikit_.setBit(rivi);
+
+        // Otsikoita ei valita tilinvalinnassa
+        if( tili.otsikkotaso())
+            continue;
+
+        QString numero = QString::number( tili.numero() );
+        lisaa( numerot_, numero, rivi, numero.length());
+
+        // Nimi haetaan jokaisen sanan alusta
+        const QString& nimi = pienetNimet_.last();
+        for(int i=0; i < nimi.length(); i++)
+        {
+            if( nimi.at(i).isLetterOrNumber() && ( i == 0 || !nimi.at(i-1).isLetterOrNumber()))
+                lisaa( nimet_, nimi.mid(i), rivi, NIMISYVYYS);
+        }
+    }
+}
+
+int TiliHakemisto::numerolla(const QString &alku) const
+{
+    int solmu = etsi( numerot_, alku);
+    if( solmu < 0 || numerot_.at(solmu).tilit.isEmpty())
+        return -1;
+    return numerot_.at(solmu).tilit.first();
+}
+
+QList<int> TiliHakemisto::numeronAlulla(const QString &alku, const QBitArray &maski, int enintaan) const
+{
+    QList<int> tulos;
+    int solmu = etsi( numerot_, alku);
+    if( solmu < 0)
+        return tulos;
+
+    for( int rivi : numerot_.at(solmu).tilit)
+    {
+        if( !maski.isEmpty() && !maski.testBit(rivi))
+            continue;
+        tulos.append(rivi);
+        if( tulos.count() >= enintaan)
+            break;
+    }
+    return tulos;
+}
+
+QList<int> TiliHakemisto::nimenAlulla(const QString &alku, const QBitArray &maski, int enintaan) const
+{
+    QList<int> tulos;
+    QString pieni = alku.toLower();
+    int solmu = etsi( nimet_, pieni.left(NIMISYVYYS));
+    if( solmu < 0)
+        return tulos;
+
+    for( int rivi : nimet_.at(solmu).tilit)
+    {
+        if( !maski.isEmpty() && !maski.testBit(rivi))
+            continue;
+
+        // Puuta pidemmät haut tarkastetaan nimestä
+        if( pieni.length() > NIMISYVYYS )
+        {
+            const QString& nimi = pienetNimet_.at(rivi);
+            int i = nimi.indexOf(pieni);
+            while( i > 0 && nimi.at(i-1).isLetterOrNumber())
+                i = nimi.indexOf(pieni, i + 1);
+            if( i < 0 )
+                continue;
+        }
+
+        tulos.append(rivi);
+        if( tulos.count() >= enintaan)
+            break;
+    }
+    return tulos;
+}
+
+QBitArray TiliHakemisto::tyyppimaski(const QString &regexp) const
+{
+    if( tyyppimaskit_.contains(regexp))
+        return tyyppimaskit_.value(regexp);
+
+    QRegExp lauseke(regexp);
+    QBitArray maski( tyypit_.count());
+    for(int rivi=0; rivi < tyypit_.count(); rivi++)
+        if( lauseke.indexIn( tyypit_.at(rivi) ) > -1)
+            maski.setBit(rivi);
+
+    tyyppimaskit_.insert(regexp, maski);
+    return maski;
+}
+
+QStringList TiliHakemisto::tekstit(const QList<int> &rivit) const
+{
+    QStringList lista;
+    for( int rivi : rivit)
+        lista.append( tekstit_.value(rivi));
+    return lista;
+}
+
+int TiliHakemisto::lapsi(const QVector<Solmu> &puu, int solmu, QChar merkki) const
+{
+    for( const auto& lapsi : puu.at(solmu).lapset)
+        if( lapsi.first == merkki)
+            return lapsi.second;
+    return -1;
+}
+
+void TiliHakemisto::lisaa(QVector<Solmu> &puu, const QString &avain, int rivi, int syvyys)
+{
+    int solmu = 0;
+    for(int i=0; i < avain.length() && i < syvyys; i++)
+    {
+        int seuraava = lapsi(puu, solmu, avain.at(i));
+        if( seuraava < 0 )
+        {
+            seuraava = puu.count();
+            puu[solmu].lapset.append( qMakePair( avain.at(i), seuraava ));
+            puu.append( Solmu() );
+        }
+        solmu = seuraava;
+
+        // Saman nimen useampi sana voi päätyä samaan solmuun
+        QVector<int>& tilit = puu[solmu].tilit;
+        if( tilit.isEmpty() || tilit.last() != rivi)
+            tilit.append(rivi);
+    }
+}
+
+int TiliHakemisto::etsi(const QVector<Solmu> &puu, const QString &alku) const
+{
+    int solmu = 0;
+    for(int i=0; i < alku.length() && solmu >= 0; i++)
+        solmu = lapsi(puu, solmu, alku.at(i));
+    return solmu;
+}
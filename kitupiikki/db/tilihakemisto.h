@@ -0,0 +1,114 @@
+/*
+   Copyright (C) 2018 Arto Hyvättinen
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef TILIHAKEMISTO_H
+#define TILIHAKEMISTO_H
+
+#include <QBitArray>
+#include <QHash>
+#include <QPair>
+#include <QStringList>
+#include <QVector>
+
+class TiliModel;
+
+/**
+ * @brief Tilien hakemisto tilinvalinnan täydentämiseen
+ *
+ * Tilinumeroiden ja -nimien alkuosista on etukäteen lasketut puut, joista
+ * saadaan täydennysehdotukset ja valittu tili käymättä tilikarttaa läpi.
+ * Tilien tila ja tyyppisuodattimet ovat bittijoukkoja, joiden bitti on
+ * tilin rivi TiliModelissa.
+ *
+ * TiliModel rakentaa hakemiston uudelleen vasta, kun tilejä on muutettu
+ * ja hakemistoa seuraavan kerran tarvitaan.
+ *
+ * @since 1.1
+ */
+class TiliHakemisto
+{
+public:
+    TiliHakemisto();
+
+    void rakenna(const TiliModel *model);
+
+    /**
+     * @brief Ensimmäinen tili, jonka numero alkaa annetuilla numeroilla
+     * @return Tilin rivi, -1 jos tiliä ei löydy
+     */
+    int numerolla(const QString& alku) const;
+
+    /**
+     * @brief Tilit, joiden numero alkaa annetuilla numeroilla
+     * @param maski Vain tilit, joiden bitti on asetettu (tyhjä: kaikki)
+     * @return Tilien rivit tilikartan järjestyksessä
+     */
+    QList<int> numeronAlulla(const QString& alku, const QBitArray& maski = QBitArray(), int enintaan = 200) const;
+    /**
+     * @brief Tilit, joiden nimen jokin sana alkaa annetulla tekstillä
+     */
+    QList<int> nimenAlulla(const QString& alku, const QBitArray& maski = QBitArray(), int enintaan = 200) const;
+
+    /**
+     * @brief Tilit, joiden tyyppikoodi täsmää säännölliseen lausekkeeseen
+     *
+     * Vastaa aiempaa QSortFilterProxyModelin suodatusta tyyppiroolilla.
+     * Maskit säilytetään, kunnes hakemisto rakennetaan uudelleen.
+     */
+    QBitArray tyyppimaski(const QString& regexp) const;
+    /**
+     * @brief Käytössä olevat tai suosikkitilit (tila 1 tai 2)
+     */
+    const QBitArray& kaytossa() const { return kaytossa_; }
+    /**
+     * @brief Suosikkitilit (tila 2)
+     */
+    const QBitArray& suosikit() const { return suosikit_; }
+
+    /**
+     * @brief Tilin numero ja nimi täydentäjässä näytettäväksi
+     */
+    QString teksti(int rivi) const { return tekstit_.value(rivi); }
+    QStringList tekstit(const QList<int>& rivit) const;
+
+protected:
+    struct Solmu
+    {
+        QVector<QPair<QChar,int>> lapset;
+        QVector<int> tilit;         /** Tilit, joiden avain alkaa tämän solmun kohdalla, rivijärjestyksessä */
+    };
+
+    int lapsi(const QVector<Solmu>& puu, int solmu, QChar merkki) const;
+    void lisaa(QVector<Solmu>& puu, const QString& avain, int rivi, int syvyys);
+    int etsi(const QVector<Solmu>& puu, const QString& alku) const;
+
+    /**
+     * @brief Nimipuun syvyys, tätä pidemmät haut tarkastetaan vertailemalla
+     */
+    static const int NIMISYVYYS = 8;
+
+    QVector<Solmu> numerot_;
+    QVector<Solmu> nimet_;
+    QStringList tekstit_;
+    QStringList pienetNimet_;
+
+    QBitArray kaytossa_;
+    QBitArray suosikit_;
+    QVector<QString> tyypit_;
+    mutable QHash<QString,QBitArray> tyyppimaskit_;
+};
+
+#endif // TILIHAKEMISTO_H
@@ -182,6 +182,9 @@ void Tilikausi::asetaKausitunnus(const QString &kausitunnus)
 
 bool Tilikausi::onkoBudjettia()
 {
-    return !json_.variant("Budjetti").toMap().isEmpty();
+    QSqlQuery& kysely = kp()->kysely("SELECT 1 FROM budjetti WHERE tilikausi=:tilikausi LIMIT 1");
+    kysely.bindValue(":tilikausi", alkaa_);
+    kysely.exec();
+    return kysely.next();
 }
 
@@ -174,6 +174,7 @@ void TilikausiModel::muokkaaViimeinenTilikausi(const QDate &paattyy)
     {
         beginRemoveRows( QModelIndex(), kaudet_.count()-1, kaudet_.count()-1);
         tietokanta_->exec(QString("DELETE FROM tilikausi WHERE alkaa='%1' ").arg( kaudet_.last().alkaa().toString(Qt::ISODate) ) );
+        tietokanta_->exec(QString("DELETE FROM budjetti WHERE tilikausi='%1' ").arg( kaudet_.last().alkaa().toString(Qt::ISODate) ) );
         kaudet_.removeLast();
         endRemoveRows();
     }
@@ -246,12 +247,9 @@ QDate TilikausiModel::kirjanpitoLoppuu() const
 
 bool TilikausiModel::onkoBudjetteja() const
 {
-    for(auto kausi: kaudet_)
-    {
-        if( kausi.json()->avaimet().contains("Budjetti"))
-            return true;
-    }
-    return false;
+    QSqlQuery kysely( *tietokanta_ );
+    kysely.exec("SELECT 1 FROM budjetti LIMIT 1");
+    return kysely.next();
 }
 
 void TilikausiModel::lataa()
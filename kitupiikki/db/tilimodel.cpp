@@ -34,7 +34,13 @@
 TiliModel::TiliModel(QSqlDatabase *tietokanta, QObject *parent) :
     QAbstractTableModel(parent), tietokanta_(tietokanta)
 {
-
+    // Tilinvalinnan hakemisto rakennetaan uudelleen vasta tarvittaessa
+    auto vanhenna = [this] { hakemistoVanhentunut_ = true; };
+    connect( this, &TiliModel::dataChanged, this, vanhenna);
+    connect( this, &TiliModel::modelReset, this, vanhenna);
+    connect( this, &TiliModel::rowsInserted, this, vanhenna);
+    connect( this, &TiliModel::rowsRemoved, this, vanhenna);
+    connect( this, &TiliModel::layoutChanged, this, vanhenna);
 }
 
 int TiliModel::rowCount(const QModelIndex & /* parent */) const
@@ -273,6 +279,16 @@ JsonKentta *TiliModel::jsonIndeksilla(int i)
     return tilit_[i].json();
 }
 
+const TiliHakemisto &TiliModel::hakemisto() const
+{
+    if( hakemistoVanhentunut_ )
+    {
+        hakemisto_.rakenna(this);
+        hakemistoVanhentunut_ = false;
+    }
+    return hakemisto_;
+}
+
 bool TiliModel::onkoMuokattu() const
 {
     if( poistetutIdt_.count())  // Tallennettuja rivejä poistettu
@@ -23,6 +23,7 @@
 #include <QList>
 
 #include "db/tili.h"
+#include "db/tilihakemisto.h"
 
 /**
  * @brief Tilit
@@ -89,6 +90,14 @@ public:
 
     bool onkoMuokattu() const;
 
+    /**
+     * @brief Tilinvalinnan hakemisto
+     *
+     * Rakennetaan uudelleen, jos tilejä on muutettu edellisen haun jälkeen
+     * @since 1.1
+     */
+    const TiliHakemisto& hakemisto() const;
+
     void lataa();
     bool tallenna(bool tietokantaaLuodaan = false);
 
@@ -98,6 +107,8 @@ protected:
     QList<Tili> tilit_;
     QList<int> poistetutIdt_;
 
+    mutable TiliHakemisto hakemisto_;
+    mutable bool hakemistoVanhentunut_ = true;
 };
 
 #endif // TILIMODEL_H
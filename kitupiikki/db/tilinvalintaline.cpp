@@ -19,32 +19,24 @@
 #include "tilinvalintadialogi.h"
 
 #include <QCompleter>
+#include <QStringListModel>
 
 #include <QDebug>
 #include <QKeyEvent>
 
 KantaTilinvalintaLine::KantaTilinvalintaLine(QWidget *parent)
-    : QLineEdit(parent)
+    : QLineEdit(parent),
+      tilit_( kp()->tilit() ),
+      tyyppiSuodatin_("[ABCD].*"),
+      ehdotukset_( new QStringListModel(this))
 {
-
-
-    proxyTyyppi_ = new QSortFilterProxyModel(parent);
-    proxyTyyppi_->setSourceModel( kp()->tilit());
-    proxyTyyppi_->setFilterRole(TiliModel::TyyppiRooli);
-    proxyTyyppi_->setFilterRegExp("[ABCD].*");
-
-    proxyTila_ = new QSortFilterProxyModel(parent);
-    proxyTila_->setSourceModel(proxyTyyppi_);
-    proxyTila_->setFilterRole(TiliModel::TilaRooli);
-    proxyTila_->setFilterRegExp("[12]");
-
-    QCompleter *taydennin = new QCompleter() ;
-    taydennin->setCompletionColumn( TiliModel::NRONIMI);
-    taydennin->setModel( proxyTila_ );
+    QCompleter *taydennin = new QCompleter(this) ;
+    taydennin->setModel( ehdotukset_ );
 
     taydennin->setCompletionMode( QCompleter::UnfilteredPopupCompletion);
     setCompleter(taydennin);
 
+    connect( this, &QLineEdit::textEdited, this, &KantaTilinvalintaLine::paivitaEhdotukset);
 }
 
 int KantaTilinvalintaLine::valittuTilinumero() const
@@ -79,7 +71,27 @@ void KantaTilinvalintaLine::valitseTili(const Tili& tili)
 
 void KantaTilinvalintaLine::suodataTyypilla(const QString &regexp)
 {
-    proxyTyyppi_->setFilterRegExp(regexp);
+    tyyppiSuodatin_ = regexp;
+}
+
+void KantaTilinvalintaLine::paivitaEhdotukset(const QString &teksti)
+{
+    const TiliHakemisto& hakemisto = tilit_->hakemisto();
+
+    // Ehdotetaan vain käytössä olevia, suodattimen mukaisia tilejä
+    QBitArray maski = hakemisto.tyyppimaski(tyyppiSuodatin_) & hakemisto.kaytossa();
+
+    QString alku = teksti.trimmed();
+    QList<int> rivit;
+    if( !alku.isEmpty() && alku.at(0).isDigit())
+        rivit = hakemisto.numeronAlulla( alku.left( alku.indexOf(' ') ), maski);
+    else if( !alku.isEmpty())
+        rivit = hakemisto.nimenAlulla( alku, maski);
+
+    ehdotukset_->setStringList( hakemisto.tekstit(rivit) );
+    completer()->setCompletionPrefix( teksti );
+    if( !rivit.isEmpty())
+        completer()->complete();
 }
 
 
@@ -89,19 +101,10 @@ Tili KantaTilinvalintaLine::valittuTili() const
     if( sana.isEmpty() || !sana.at(0).isDigit() )
         return Tili();
 
-    for( int i=0; i < kp()->tilit()->rowCount( QModelIndex()); i++)
-    {
-        Tili tili = kp()->tilit()->tiliIndeksilla(i);
-        if( !tili.otsikkotaso())
-        {
-            QString nroTxt = QString::number( tili.numero() );
-            if( nroTxt.startsWith(sana))
-            {
-                return tili;
-            }
-        }
-    }
-    return Tili();
+    int rivi = tilit_->hakemisto().numerolla(sana);
+    if( rivi < 0 )
+        return Tili();
+    return tilit_->tiliIndeksilla(rivi);
 }
 
 
@@ -134,7 +137,7 @@ TilinvalintaLine::TilinvalintaLine(QWidget *parent)
 
 void TilinvalintaLine::asetaModel(TiliModel *model)
 {
-    proxyTyyppi_->setSourceModel( model );
+    tilit_ = model;
     model_ = model;
 }
 
@@ -147,9 +150,9 @@ void TilinvalintaLine::keyPressEvent(QKeyEvent *event)
         Tili valittu;
 
         if( event->key() == Qt::Key_Space)
-            valittu = TilinValintaDialogi::valitseTili(QString(), proxyTyyppi_->filterRegExp().pattern(), model_ );
+            valittu = TilinValintaDialogi::valitseTili(QString(), tyyppiSuodatin_, model_ );
         else
-            valittu = TilinValintaDialogi::valitseTili( event->text(), proxyTyyppi_->filterRegExp().pattern(), model_ );
+            valittu = TilinValintaDialogi::valitseTili( event->text(), tyyppiSuodatin_, model_ );
         if( valittu.id())
         {
             valitseTili( valittu);
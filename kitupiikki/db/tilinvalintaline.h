@@ -20,14 +20,17 @@
 
 #include <QLineEdit>
 #include <QModelIndex>
-#include <QSortFilterProxyModel>
 
 #include "kirjanpito.h"
 #include "vientimodel.h"
 
+class QStringListModel;
 
 /**
  * @brief Kantaluokka tilien valinnan lineEditille
+ *
+ * Täydennysehdotukset ja valittu tili haetaan TiliModelin hakemistosta,
+ * joten näppäilyt eivät käy tilikarttaa läpi.
  */
 class KantaTilinvalintaLine : public QLineEdit
 {
@@ -47,9 +50,16 @@ public slots:
 
     void suodataTyypilla(const QString& regexp);
 
+protected slots:
+    /**
+     * @brief Päivittää täydentäjän ehdotukset kirjoitetun alun mukaan
+     */
+    void paivitaEhdotukset(const QString& teksti);
+
 protected:
-    QSortFilterProxyModel *proxyTyyppi_;
-    QSortFilterProxyModel *proxyTila_;
+    TiliModel *tilit_;
+    QString tyyppiSuodatin_;
+    QStringListModel *ehdotukset_;
 };
 
 
@@ -76,15 +76,12 @@ int Tositelaji::seuraavanTunnistenumero(const QDate pvm) const
         return 0;
 
     Tilikausi kausi = kp()->tilikausiPaivalle( pvm );
-    QString kysymys = QString("SELECT max(tunniste) FROM tosite WHERE "
-                    " pvm BETWEEN \"%1\" AND \"%2\" "
-                    " AND laji=\"%3\" ")
-                                .arg(kausi.alkaa().toString(Qt::ISODate))
-                                .arg(kausi.paattyy().toString(Qt::ISODate))
-                                .arg( id() );
-
-    QSqlQuery kysely;
-    kysely.exec(kysymys);
+    QSqlQuery& kysely = kp()->kysely("SELECT max(tunniste) FROM tosite WHERE "
+                                     "pvm BETWEEN :alku AND :loppu AND laji=:laji");
+    kysely.bindValue(":alku", kausi.alkaa());
+    kysely.bindValue(":loppu", kausi.paattyy());
+    kysely.bindValue(":laji", id());
+    kysely.exec();
 
     if( kysely.next())
         return kysely.value(0).toInt() + 1;
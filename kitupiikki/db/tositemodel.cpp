@@ -21,6 +21,7 @@
 
 #include "db/tositelajimodel.h"
 #include "db/kirjanpito.h"
+#include "db/hakuindeksi.h"
 
 #include <QDebug>
 #include <QSqlError>
@@ -63,15 +64,15 @@ bool TositeModel::kelpaakoTunniste(int tunnistenumero) const
     // Tunniste ei kelpaa, jos kyseisellä kaudella se on jo
 
     Tilikausi kausi = kp()->tilikausiPaivalle( pvm() );
-    QString kysymys = QString("SELECT id FROM tosite WHERE tunniste=\"%1\" "
-                              "AND pvm BETWEEN \"%2\" AND \"%3\" AND id <> %4 "
-                              "AND laji=\"%5\" ").arg( tunnistenumero )
-                                                 .arg(kausi.alkaa().toString(Qt::ISODate))
-                                                 .arg(kausi.paattyy().toString(Qt::ISODate))
-                                                 .arg( id() )
-                                                 .arg( tositelaji_ );
-    QSqlQuery kysely( *tietokanta_ );
-    kysely.exec(kysymys);
+    QSqlQuery& kysely = kp()->kysely("SELECT id FROM tosite WHERE tunniste=:tunniste "
+                                     "AND pvm BETWEEN :alku AND :loppu AND id <> :id "
+                                     "AND laji=:laji");
+    kysely.bindValue(":tunniste", tunnistenumero);
+    kysely.bindValue(":alku", kausi.alkaa());
+    kysely.bindValue(":loppu", kausi.paattyy());
+    kysely.bindValue(":id", id());
+    kysely.bindValue(":laji", tositelaji_);
+    kysely.exec();
     return !kysely.next();
 }
 
@@ -279,8 +280,11 @@ bool TositeModel::tallenna()
         return false;
     }
 
+    kp()->hakuindeksi()->paivitaTosite( id() );
+
     tietokanta()->commit();
 
+    kp()->ilmoitaTositeMuutos( vientiModel_->muutos() );
     emit kp()->kirjanpitoaMuokattu();
     muokattu_ = false;
     muokattuAika_ = QDateTime::currentDateTime();
@@ -301,12 +305,20 @@ bool TositeModel::poista()
     tietokanta()->transaction();
     QSqlQuery kysely(*tietokanta());
 
+    TositeMuutos muutos;
+    muutos.tositeId = id();
+    muutos.poistettu = true;
+    muutos.lisaaTallennetut( id() );
+
+    kp()->hakuindeksi()->poistaTosite( id() );
+    kysely.exec(QString("DELETE FROM laskurivi WHERE vienti IN (SELECT id FROM vienti WHERE tosite=%1)").arg( id() ));
     kysely.exec(QString("DELETE FROM vienti WHERE tosite=%1").arg( id() ));
     kysely.exec(QString("DELETE FROM liite WHERE tosite=%1").arg( id() ));
     kysely.exec(QString("DELETE FROM tosite WHERE id=%1").arg( id()) );
 
     if( tietokanta()->commit())
     {
+        kp()->ilmoitaTositeMuutos(muutos);
         emit kp()->kirjanpitoaMuokattu();
         return true;
     }
@@ -19,6 +19,7 @@
 #include "db/tositemodel.h"
 #include "db/kirjanpito.h"
 #include "db/tilikausi.h"
+#include "db/asiakas.h"
 
 #include "db/tilinvalintadialogi.h"
 
@@ -568,6 +569,19 @@ QModelIndex VientiModel::lisaaVienti(const VientiRivi& rivi, int indeksi)
     return index( indeksi, 0);
 }
 
+void VientiModel::lisaaViennit(const QList<VientiRivi> &rivit)
+{
+    if( rivit.isEmpty())
+        return;
+
+    beginInsertRows( QModelIndex(), viennit_.count(), viennit_.count() + rivit.count() - 1);
+    viennit_.append(rivit);
+    endInsertRows();
+
+    muokattu_ = true;
+    emit muuttunut();
+}
+
 qlonglong VientiModel::debetSumma() const
 {
     qlonglong summa = 0;
@@ -608,6 +622,12 @@ void VientiModel::uusiPohjalta(const QString &otsikko)
 bool VientiModel::tallenna()
 {
     QSqlQuery query(*tositeModel_->tietokanta());
+
+    // Muuttuneiksi merkitään sekä aiemmin tallennetut että tallennettavat viennit
+    muutos_ = TositeMuutos();
+    muutos_.tositeId = tositeModel_->id();
+    muutos_.lisaaTallennetut( tositeModel_->id() );
+
     for(int i=0; i < viennit_.count() ; i++)
     {
         VientiRivi rivi = viennit_[i];
@@ -621,7 +641,7 @@ bool VientiModel::tallenna()
                           "kreditsnt=:kreditsnt, selite=:selite, alvkoodi=:alvkoodi,"
                           "kohdennus=:kohdennus, eraid=:eraid, alvprosentti=:alvprosentti, "
                           "viite=:viite, iban=:iban, erapvm=:erapvm, arkistotunnus=:arkistotunnus, "
-                          "muokattu=:muokattu, json=:json, asiakas=:asiakas, vientirivi=:rivinro, laskupvm=:laskupvm"
+                          "muokattu=:muokattu, json=:json, asiakas=:asiakas, asiakasid=:asiakasid, vientirivi=:rivinro, laskupvm=:laskupvm"
                           " WHERE id=:id");
             query.bindValue(":id", rivi.vientiId);
             if( poistetutVientiIdt_.contains(rivi.vientiId))
@@ -631,15 +651,14 @@ bool VientiModel::tallenna()
         {
             query.prepare("INSERT INTO vienti(tosite,pvm,tili,debetsnt,kreditsnt,selite,"
                            "alvkoodi, alvprosentti, luotu, muokattu, json, kohdennus, eraid, vientirivi,"
-                           "viite, iban, erapvm, arkistotunnus,asiakas,laskupvm) "
+                           "viite, iban, erapvm, arkistotunnus,asiakas,asiakasid,laskupvm) "
                             "VALUES(:tosite,:pvm,:tili,:debetsnt,:kreditsnt,:selite,"
                             ":alvkoodi, :alvprosentti, :luotu, :muokattu, :json, :kohdennus, :eraid, :rivinro,"
-                            ":viite, :iban, :erapvm, :arkistotunnus, :asiakas, :laskupvm)");
+                            ":viite, :iban, :erapvm, :arkistotunnus, :asiakas, :asiakasid, :laskupvm)");
             query.bindValue(":luotu",  QDateTime::currentDateTime() );            
         }
         query.bindValue(":rivinro", i + 1);        // Pidetään viennit siististi numeroituina
 
-
         query.bindValue(":tosite", tositeModel_->id() );
 
         if( rivi.pvm.isValid())
@@ -683,6 +702,10 @@ bool VientiModel::tallenna()
         query.bindValue(":laskupvm", rivi.laskupvm);
         query.bindValue(":arkistotunnus", rivi.arkistotunnus);
         query.bindValue(":asiakas", rivi.asiakas);
+        if( rivi.asiakas.isEmpty())
+            query.bindValue(":asiakasid", QVariant());
+        else
+            query.bindValue(":asiakasid", Asiakas::idNimella( rivi.asiakas, !rivi.ibanTili.isEmpty()));
         query.bindValue(":json", rivi.json.toSqlJson());
 
         if( !query.exec() )
@@ -699,8 +722,21 @@ bool VientiModel::tallenna()
                 query.exec(QString("UPDATE vienti SET eraid=%1 WHERE id=%1").arg(viennit_[i].vientiId) );
         }
         else
+        {
             // Poistetaan tagit, jotta ne voitaisiin kohta lisätä...
             query.exec( QString("DELETE FROM merkkaus WHERE vienti=%1").arg( rivi.vientiId));
+        }
+
+        if( rivi.eraId > 0)
+            muutos_.lisaa( rivi.pvm, rivi.tili.id(), rivi.eraId);
+        else if( rivi.eraId == TaseEra::UUSIERA)
+            muutos_.lisaa( rivi.pvm, rivi.tili.id(), viennit_.at(i).vientiId);
+        else
+            muutos_.lisaa( rivi.pvm, rivi.tili.id(), 0);
+
+        if( rivi.json.avaimet().contains("Laskurivit") &&
+            !tallennaLaskurivit( viennit_.at(i).vientiId, rivi.json.variant("Laskurivit").toList() ))
+            return false;
 
         for(const Kohdennus& tagi : rivi.tagit)
         {
@@ -715,6 +751,7 @@ bool VientiModel::tallenna()
     // Lopuksi pitäisi vielä poistaa ne rivit, jotka on poistettu...
     foreach (int id, poistetutVientiIdt_)
     {
+        query.exec( QString("DELETE FROM laskurivi WHERE vienti=%1").arg(id));
         if( !query.exec( QString("DELETE FROM vienti WHERE id=%1").arg(id)) )
             return false;
     }
@@ -724,6 +761,41 @@ bool VientiModel::tallenna()
     return true;
 }
 
+bool VientiModel::tallennaLaskurivit(int vientiId, const QVariantList &laskurivit)
+{
+    QSqlQuery& poisto = kp()->kysely("DELETE FROM laskurivi WHERE vienti=:vienti");
+    poisto.bindValue(":vienti", vientiId);
+    if( !poisto.exec())
+        return false;
+
+    QSqlQuery& lisays = kp()->kysely("INSERT INTO laskurivi(vienti, rivi, nimike, maara, yksikko, tuote, ahintasnt, "
+                                     "tilinro, kohdennus, alvkoodi, alvprosentti, nettosnt, alvsnt, yhteensasnt) "
+                                     "VALUES (:vienti, :rivi, :nimike, :maara, :yksikko, :tuote, :ahinta, "
+                                     ":tili, :kohdennus, :alvkoodi, :alvprosentti, :netto, :alv, :yhteensa)");
+    int rivinro = 0;
+    for( const QVariant& var : laskurivit)
+    {
+        QVariantMap map = var.toMap();
+        lisays.bindValue(":vienti", vientiId);
+        lisays.bindValue(":rivi", ++rivinro);
+        lisays.bindValue(":nimike", map.value("Nimike").toString());
+        lisays.bindValue(":maara", map.value("Maara").toDouble());
+        lisays.bindValue(":yksikko", map.value("Yksikko").toString());
+        lisays.bindValue(":tuote", map.value("Tuotekoodi").toInt());
+        lisays.bindValue(":ahinta", map.value("YksikkohintaSnt").toDouble());
+        lisays.bindValue(":tili", map.value("Tili").toInt());
+        lisays.bindValue(":kohdennus", map.value("Kohdennus").toInt());
+        lisays.bindValue(":alvkoodi", map.value("Alvkoodi").toInt());
+        lisays.bindValue(":alvprosentti", map.value("Alvprosentti").toInt());
+        lisays.bindValue(":netto", map.value("Nettoyht").toLongLong());
+        lisays.bindValue(":alv", map.value("Alv").toLongLong());
+        lisays.bindValue(":yhteensa", map.value("Yhteensa").toLongLong());
+        if( !lisays.exec())
+            return false;
+    }
+    return true;
+}
+
 void VientiModel::tyhjaa()
 {
     beginResetModel();
@@ -842,7 +914,26 @@ VientiRivi VientiModel::uusiRivi()
     return uusirivi;
 }
 
+void TositeMuutos::lisaa(const QDate &pvm, int tiliId, int eraId)
+{
+    if( pvm.isValid())
+    {
+        if( !alkaa.isValid() || pvm < alkaa)
+            alkaa = pvm;
+        if( !loppuu.isValid() || pvm > loppuu)
+            loppuu = pvm;
+    }
+    if( tiliId )
+        tilit.insert(tiliId);
+    if( eraId > 0)
+        erat.insert(eraId);
+}
 
-
-
-
+void TositeMuutos::lisaaTallennetut(int tositeId)
+{
+    QSqlQuery& kysely = kp()->kysely("SELECT pvm, tili, eraid FROM vienti WHERE tosite=:tosite");
+    kysely.bindValue(":tosite", tositeId);
+    kysely.exec();
+    while( kysely.next())
+        lisaa( kysely.value(0).toDate(), kysely.value(1).toInt(), kysely.value(2).toInt());
+}
@@ -20,6 +20,7 @@
 
 #include <QAbstractTableModel>
 #include <QList>
+#include <QSet>
 
 #include "db/tili.h"
 #include "db/kohdennus.h"
@@ -57,6 +58,31 @@ struct VientiRivi
     QList<Kohdennus> tagit;
 };
 
+/**
+ * @brief Tositteen tallentamisen tai poistamisen muuttamat viennit
+ *
+ * Välitetään Kirjanpito::tositeMuuttui()-signaalilla, jotta listat voivat
+ * päivittää vain muuttuneet rivit lataamatta kaikkea uudelleen.
+ *
+ * @since 1.1
+ */
+struct TositeMuutos
+{
+    int tositeId = 0;
+    QDate alkaa;        /** Vientien varhaisin päivämäärä ennen tai jälkeen muutoksen */
+    QDate loppuu;       /** Vientien viimeisin päivämäärä ennen tai jälkeen muutoksen */
+    QSet<int> tilit;    /** Vientien tilien id:t */
+    QSet<int> erat;     /** Tase-erät, joihin viennit kohdistuvat */
+    bool poistettu = false;
+    bool koko = false;  /** Kaikki aikavälin tositteet ovat voineet muuttua (esim. numeroinnin siirto) */
+
+    void lisaa(const QDate& pvm, int tiliId, int eraId);
+    /**
+     * @brief Lisää tositteen tietokantaan tallennetut viennit
+     */
+    void lisaaTallennetut(int tositeId);
+};
+
 /**
  * @brief Yhden tositteen vientien tiedot
  *
@@ -141,6 +167,16 @@ public:
      */
     QModelIndex lisaaVienti(const VientiRivi &rivi, int indeksi = -1);
 
+    /**
+     * @brief Lisää valmiit vientirivit loppuun
+     *
+     * Näkymät ja summat päivitetään kerran koko lisäyksen jälkeen,
+     * joten tätä käytetään tiliotteen rivejä tuotaessa.
+     *
+     * @since 1.1
+     */
+    void lisaaViennit(const QList<VientiRivi>& rivit);
+
 
     qlonglong debetSumma() const;
     qlonglong kreditSumma() const;
@@ -157,6 +193,25 @@ public:
      */
     void uusiPohjalta(const QString& otsikko);
 
+    /**
+     * @brief Tallentaa laskun rivit laskurivi-tauluun
+     *
+     * Laskun rivit ovat laskun vientien json-kentässä (Laskurivit), ja myyntiraportti
+     * lasketaan laskurivi-taulusta. Vanhat rivit korvataan.
+     *
+     * @param vientiId Laskun rahavienti
+     * @param laskurivit Json-kentän Laskurivit
+     * @return tosi, jos onnistui
+     * @since 1.1
+     */
+    static bool tallennaLaskurivit(int vientiId, const QVariantList& laskurivit);
+
+    /**
+     * @brief Viimeisimmän tallennuksen muuttamat viennit
+     * @since 1.1
+     */
+    const TositeMuutos& muutos() const { return muutos_; }
+
 public slots:
     /**
      * @brief Tallentaa viennit
@@ -178,6 +233,7 @@ protected:
     bool muokattu_;
 
     QList<int> poistetutVientiIdt_;
+    TositeMuutos muutos_;
 };
 
 #endif // VIENTIMODEL_H
@@ -0,0 +1,416 @@
+/*
+   Copyright (C) 2018 Arto Hyvättinen
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSysInfo>
+#include <QDateTime>
+
+#include "eraajo.h"
+
+#include "db/kirjanpito.h"
+#include "arkistoija/arkistoija.h"
+
+#include "raportti/raportoija.h"
+#include "raportti/paakirjaraportti.h"
+#include "raportti/paivakirjaraportti.h"
+#include "raportti/taseerittely.h"
+
+#include "selaus/selausmodel.h"
+#include "selaus/tositeselausmodel.h"
+#include "laskutus/laskutmodel.h"
+
+Eraajo::Eraajo()
+{
+
+}
+
+bool Eraajo::onkoEraajo(int argc, char *argv[])
+{
+    for(int i=1; i < argc; i++)
+        if( QString(argv[i]) == "--eraajo")
+            return true;
+    return false;
+}
+
+int Eraajo::suorita(const QStringList &argumentit)
+{
+    QCommandLineParser jasennin;
+    jasennin.setApplicationDescription(tr("Kitupiikin raporttien muodostaminen eräajona"));
+    jasennin.addHelpOption();
+
+    QCommandLineOption eraajoValinta("eraajo", tr("Suoritetaan eräajona ilman käyttöliittymää"));
+    QCommandLineOption raporttiValinta(QStringList() << "r" << "raportti",
+                                       tr("Muodostettava raportti: paakirja, paivakirja, taseerittely "
+                                          "tai muokattavan raportin nimi. Voidaan antaa useasti."), tr("raportti"));
+    QCommandLineOption muotoValinta(QStringList() << "m" << "muoto", tr("Tiedostomuoto: pdf, csv tai html"), tr("muoto"), "pdf");
+    QCommandLineOption kohdeValinta(QStringList() << "o" << "kohde", tr("Hakemisto, johon raportit kirjoitetaan"), tr("hakemisto"), ".");
+    QCommandLineOption alkaaValinta("alkaa", tr("Raporttikauden alkupäivä (vvvv-kk-pp)"), tr("pvm"));
+    QCommandLineOption paattyyValinta("paattyy", tr("Raporttikauden loppupäivä (vvvv-kk-pp)"), tr("pvm"));
+    QCommandLineOption arkistoValinta(QStringList() << "a" << "arkisto", tr("Muodostetaan raporttikauden päättävän tilikauden arkisto"));
+    QCommandLineOption rinnakkainValinta(QStringList() << "j" << "rinnakkain", tr("Rinnakkain käsiteltävien kirjanpitojen määrä"), tr("määrä"), "1");
+    QCommandLineOption ajoitusValinta("ajoitus", tr("Kirjoitetaan vaiheiden kestot JSON-tiedostoon. "
+                                                    "Kirjanpidot käsitellään tällöin peräkkäin."), tr("tiedosto"));
+
+    jasennin.addOption(eraajoValinta);
+    jasennin.addOption(raporttiValinta);
+    jasennin.addOption(muotoValinta);
+    jasennin.addOption(kohdeValinta);
+    jasennin.addOption(alkaaValinta);
+    jasennin.addOption(paattyyValinta);
+    jasennin.addOption(arkistoValinta);
+    jasennin.addOption(rinnakkainValinta);
+    jasennin.addOption(ajoitusValinta);
+    jasennin.addPositionalArgument("kirjanpito", tr("Käsiteltävät .kitupiikki-tiedostot"), "kirjanpito...");
+
+    if( !jasennin.parse(argumentit))
+    {
+        virhe( jasennin.errorText() );
+        return 2;
+    }
+    if( jasennin.isSet("help"))
+    {
+        QTextStream(stdout) << jasennin.helpText();
+        return 0;
+    }
+
+    raportit_ = jasennin.values(raporttiValinta);
+    tiedostot_ = jasennin.positionalArguments();
+    muoto_ = jasennin.value(muotoValinta).toLower();
+    kohde_ = jasennin.value(kohdeValinta);
+    annettuAlkaa_ = QDate::fromString( jasennin.value(alkaaValinta), Qt::ISODate);
+    annettuPaattyy_ = QDate::fromString( jasennin.value(paattyyValinta), Qt::ISODate);
+    arkisto_ = jasennin.isSet(arkistoValinta);
+    ajoitustiedosto_ = jasennin.value(ajoitusValinta);
+
+    if( tiedostot_.isEmpty() || ( raportit_.isEmpty() && !arkisto_ && ajoitustiedosto_.isEmpty() ))
+    {
+        virhe( tr("Anna käsiteltävät kirjanpidot sekä muodostettavat raportit tai arkisto"));
+        return 2;
+    }
+    if( muoto_ != "pdf" && muoto_ != "csv" && muoto_ != "html")
+    {
+        virhe( tr("Tuntematon tiedostomuoto %1").arg(muoto_));
+        return 2;
+    }
+    if( !QDir().mkpath(kohde_))
+    {
+        virhe( tr("Hakemistoa %1 ei voi luoda").arg(kohde_));
+        return 2;
+    }
+
+    int rinnakkain = jasennin.value(rinnakkainValinta).toInt();
+    // Rinnakkaiset prosessit kilpailevat samasta levystä ja suorittimesta,
+    // jolloin kestot eivät olisi vertailukelpoisia
+    if( rinnakkain > 1 && tiedostot_.count() > 1 && ajoitustiedosto_.isEmpty())
+    {
+        // Aliprosesseille samat valinnat, mutta kullekin vain yksi kirjanpito
+        aliprosessinArgumentit_ << "--eraajo" << "-m" << muoto_ << "-o" << kohde_;
+        for( const QString& nimi : raportit_)
+            aliprosessinArgumentit_ << "-r" << nimi;
+        if( annettuAlkaa_.isValid())
+            aliprosessinArgumentit_ << "--alkaa" << annettuAlkaa_.toString(Qt::ISODate);
+        if( annettuPaattyy_.isValid())
+            aliprosessinArgumentit_ << "--paattyy" << annettuPaattyy_.toString(Qt::ISODate);
+        if( arkisto_ )
+            aliprosessinArgumentit_ << "-a";
+
+        return suoritaRinnakkain(rinnakkain);
+    }
+
+    int virheita = 0;
+    for( const QString& tiedosto : tiedostot_)
+        if( !kasitteleKirjanpito(tiedosto))
+            virheita++;
+
+    if( !ajoitustiedosto_.isEmpty() && !kirjoitaAjoitukset())
+        virheita++;
+
+    return virheita ? 1 : 0;
+}
+
+bool Eraajo::kasitteleKirjanpito(const QString &tiedosto)
+{
+    vaiheet_ = QJsonArray();
+    QElapsedTimer ajastin;
+    ajastin.start();
+
+    if( !QFile::exists(tiedosto) || !kp()->avaaTietokanta(tiedosto, false, true))
+    {
+        virhe( tr("Kirjanpitoa %1 ei voi avata").arg(tiedosto));
+        return false;
+    }
+    kirjaaAjoitus("avaus", ajastin.elapsed());
+
+    // Oletuksena raportoidaan kuluvalta tilikaudelta
+    Tilikausi kausi = kp()->tilikaudet()->tilikausiPaivalle( annettuPaattyy_.isValid() ? annettuPaattyy_ : kp()->paivamaara() );
+    alkaa_ = annettuAlkaa_.isValid() ? annettuAlkaa_ : kausi.alkaa();
+    paattyy_ = annettuPaattyy_.isValid() ? annettuPaattyy_ : kausi.paattyy();
+
+    QString etuliite = QFileInfo(tiedosto).completeBaseName();
+    bool onnistui = true;
+
+    if( !ajoitustiedosto_.isEmpty())
+        ajoitaLataukset();
+
+    for( const QString& nimi : raportit_)
+    {
+        QString tiedostonimi = QString("%1-%2.%3").arg(etuliite).arg(nimi.toLower().remove(' ').remove('/')).arg(muoto_);
+        if( !kirjoitaRaportti(nimi, QDir(kohde_).absoluteFilePath(tiedostonimi)))
+            onnistui = false;
+    }
+
+    if( arkisto_ && !arkistoi())
+        onnistui = false;
+
+    if( !ajoitustiedosto_.isEmpty())
+    {
+        QJsonObject kirjanpito;
+        kirjanpito.insert("kirjanpito", QFileInfo(tiedosto).absoluteFilePath());
+        kirjanpito.insert("alkaa", alkaa_.toString(Qt::ISODate));
+        kirjanpito.insert("paattyy", paattyy_.toString(Qt::ISODate));
+        kirjanpito.insert("vaiheet", vaiheet_);
+        ajoitukset_.append(kirjanpito);
+    }
+
+    return onnistui;
+}
+
+bool Eraajo::kirjoitaRaportti(const QString &nimi, const QString &tiedostonimi)
+{
+    QString pieni = nimi.toLower();
+    if( muoto_ != "pdf" && ( pieni == "paakirja" || pieni == "paivakirja"))
+        return kirjoitaVirtana(pieni, tiedostonimi);
+
+    bool ok = true;
+    QElapsedTimer ajastin;
+    ajastin.start();
+
+    RaportinKirjoittaja rk = raportti(nimi, &ok);
+    if( !ok )
+    {
+        virhe( tr("Raporttia %1 ei löydy kirjanpidosta %2").arg(nimi).arg(kp()->asetukset()->asetus("Nimi")));
+        return false;
+    }
+    kirjaaAjoitus( QString("raportti:%1").arg(nimi), ajastin.restart(), rk.riveja() );
+
+    QByteArray data;
+    if( muoto_ == "pdf")
+        data = rk.pdf();
+    else if( muoto_ == "html")
+        data = rk.html().toUtf8();
+    else if( rk.csvKaytossa())
+        data = rk.csv();
+    else
+    {
+        virhe( tr("Raporttia %1 ei voi muodostaa csv-muodossa").arg(nimi));
+        return false;
+    }
+    kirjaaAjoitus( QString("%1:%2").arg(muoto_).arg(nimi), ajastin.elapsed());
+
+    QFile tiedosto(tiedostonimi);
+    if( !tiedosto.open(QIODevice::WriteOnly | QIODevice::Truncate) || tiedosto.write(data) != data.size())
+    {
+        virhe( tr("Tiedostoon %1 kirjoittaminen epäonnistui").arg(tiedostonimi));
+        return false;
+    }
+    QTextStream(stdout) << tiedostonimi << "\n";
+    return true;
+}
+
+bool Eraajo::kirjoitaVirtana(const QString &nimi, const QString &tiedostonimi)
+{
+    QElapsedTimer ajastin;
+    ajastin.start();
+
+    QFile tiedosto(tiedostonimi);
+    if( !tiedosto.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        virhe( tr("Tiedostoon %1 kirjoittaminen epäonnistui").arg(tiedostonimi));
+        return false;
+    }
+
+    RaportinKirjoittaja rk;
+    rk.asetaVirta( &tiedosto, muoto_ == "html" ? RaportinKirjoittaja::HTML : RaportinKirjoittaja::CSV);
+    if( nimi == "paakirja")
+        PaakirjaRaportti::kirjoita(rk, alkaa_, paattyy_, -1, true, true);
+    else
+        PaivakirjaRaportti::kirjoita(rk, alkaa_, paattyy_, -1, false, false, true, true);
+
+    int riveja = rk.riveja();
+    if( !rk.lopetaVirta())
+    {
+        virhe( tr("Tiedostoon %1 kirjoittaminen epäonnistui").arg(tiedostonimi));
+        return false;
+    }
+    kirjaaAjoitus( QString("%1:%2").arg(muoto_).arg(nimi), ajastin.elapsed(), riveja);
+    QTextStream(stdout) << tiedostonimi << "\n";
+    return true;
+}
+
+bool Eraajo::arkistoi()
+{
+    Tilikausi kausi = kp()->tilikaudet()->tilikausiPaivalle(paattyy_);
+    if( !kausi.alkaa().isValid())
+    {
+        virhe( tr("Päivälle %1 ei ole tilikautta").arg(paattyy_.toString("dd.MM.yyyy")));
+        return false;
+    }
+
+    // Arkistoa ei merkitä kirjanpitoon, koska kirjanpito on avattu vain luettavaksi
+    QElapsedTimer ajastin;
+    ajastin.start();
+    QString sha = Arkistoija::arkistoi(kausi);
+    kirjaaAjoitus("arkisto", ajastin.elapsed());
+    QTextStream(stdout) << kp()->arkistopolku() << " " << sha << "\n";
+    return true;
+}
+
+RaportinKirjoittaja Eraajo::raportti(const QString &nimi, bool *ok)
+{
+    QString pieni = nimi.toLower();
+
+    if( pieni == "paakirja")
+        return PaakirjaRaportti::kirjoitaRaportti(alkaa_, paattyy_, -1, true, true);
+    else if( pieni == "paivakirja")
+        return PaivakirjaRaportti::kirjoitaRaportti(alkaa_, paattyy_, -1, false, false, true, true);
+    else if( pieni == "taseerittely")
+        return TaseErittely::kirjoitaRaportti(alkaa_, paattyy_);
+
+    Raportoija raportoija(nimi);
+    if( !raportoija.tyyppi())
+    {
+        *ok = false;
+        return RaportinKirjoittaja();
+    }
+
+    if( raportoija.onkoKausiraportti())
+    {
+        raportoija.lisaaKausi(alkaa_, paattyy_);
+        if( raportoija.tyyppi() == Raportoija::KOHDENNUSLASKELMA)
+            raportoija.etsiKohdennukset();
+    }
+    else
+        raportoija.lisaaTasepaiva(paattyy_);
+
+    return raportoija.raportti();
+}
+
+int Eraajo::suoritaRinnakkain(int rinnakkain)
+{
+    for(int i=0; i < rinnakkain && !tiedostot_.isEmpty(); i++)
+        kaynnistaSeuraava();
+
+    if( kaynnissa_ )
+        silmukka_.exec();
+    return epaonnistui_ ? 1 : 0;
+}
+
+void Eraajo::kaynnistaSeuraava()
+{
+    QProcess *prosessi = new QProcess(this);
+    prosessi->setProcessChannelMode(QProcess::ForwardedChannels);
+    connect( prosessi, static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished),
+             this, &Eraajo::prosessiValmis);
+
+    QString tiedosto = tiedostot_.takeFirst();
+    prosessi->start( QCoreApplication::applicationFilePath(), QStringList(aliprosessinArgumentit_) << tiedosto );
+
+    if( prosessi->waitForStarted())
+        kaynnissa_++;
+    else
+    {
+        virhe( tr("Kirjanpidon %1 käsittelyä ei voitu käynnistää").arg(tiedosto));
+        epaonnistui_++;
+        prosessi->deleteLater();
+        if( !tiedostot_.isEmpty())
+            kaynnistaSeuraava();
+    }
+}
+
+void Eraajo::prosessiValmis(int paluuarvo, QProcess::ExitStatus tila)
+{
+    if( paluuarvo || tila != QProcess::NormalExit)
+        epaonnistui_++;
+
+    sender()->deleteLater();
+    kaynnissa_--;
+
+    if( !tiedostot_.isEmpty())
+        kaynnistaSeuraava();
+    else if( !kaynnissa_ )
+        silmukka_.quit();
+}
+
+void Eraajo::ajoitaLataukset()
+{
+    QElapsedTimer ajastin;
+    ajastin.start();
+
+    SelausModel selaus;
+    selaus.lataa(alkaa_, paattyy_);
+    kirjaaAjoitus("selaus", ajastin.restart(), selaus.rowCount(QModelIndex()));
+
+    TositeSelausModel tositteet;
+    tositteet.lataa(alkaa_, paattyy_);
+    kirjaaAjoitus("tositeselaus", ajastin.restart(), tositteet.rowCount(QModelIndex()));
+
+    LaskutModel laskut;
+    laskut.paivita(LaskutModel::KAIKKI, alkaa_, paattyy_);
+    kirjaaAjoitus("laskut", ajastin.elapsed(), laskut.rowCount(QModelIndex()));
+}
+
+void Eraajo::kirjaaAjoitus(const QString &vaihe, qint64 millisekunnit, int rivit)
+{
+    QJsonObject ajoitus;
+    ajoitus.insert("vaihe", vaihe);
+    ajoitus.insert("ms", millisekunnit);
+    if( rivit >= 0 )
+        ajoitus.insert("rivit", rivit);
+    vaiheet_.append(ajoitus);
+}
+
+bool Eraajo::kirjoitaAjoitukset()
+{
+    QJsonObject juuri;
+    juuri.insert("versio", qApp->applicationVersion());
+    juuri.insert("tietokantaversio", Kirjanpito::TIETOKANTAVERSIO);
+    juuri.insert("kaannos", QSysInfo::buildAbi());
+    juuri.insert("aika", QDateTime::currentDateTime().toString(Qt::ISODate));
+    juuri.insert("kirjanpidot", ajoitukset_);
+
+    QByteArray data = QJsonDocument(juuri).toJson();
+    QFile tiedosto(ajoitustiedosto_);
+    if( !tiedosto.open(QIODevice::WriteOnly | QIODevice::Truncate) || tiedosto.write(data) != data.size())
+    {
+        virhe( tr("Tiedostoon %1 kirjoittaminen epäonnistui").arg(ajoitustiedosto_));
+        return false;
+    }
+    return true;
+}
+
+void Eraajo::virhe(const QString &teksti)
+{
+    QTextStream(stderr) << teksti << "\n";
+}
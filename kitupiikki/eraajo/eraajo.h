@@ -0,0 +1,134 @@
+/*
+   Copyright (C) 2018 Arto Hyvättinen
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+  * @dir eraajo
+  * @brief Raporttien ja arkiston muodostaminen komentoriviltä
+  */
+
+#ifndef ERAAJO_H
+#define ERAAJO_H
+
+#include <QObject>
+#include <QStringList>
+#include <QDate>
+#include <QEventLoop>
+#include <QProcess>
+#include <QJsonArray>
+
+#include "raportti/raportinkirjoittaja.h"
+
+/**
+ * @brief Komentorivin eräajo
+ *
+ * Avaa kirjanpidot vain luettavaksi ja kirjoittaa valitut raportit
+ * pdf-, csv- tai html-tiedostoiksi sekä tarvittaessa tilikauden arkiston
+ * ilman käyttöliittymää.
+ *
+ * @code
+ * kitupiikki --eraajo -r Tuloslaskelma -r paakirja -m pdf -o raportit asiakas1.kitupiikki asiakas2.kitupiikki
+ * @endcode
+ *
+ * Kirjanpidon tiedot ovat ohjelman yhteisessä Kirjanpito-oliossa, joten yksi prosessi
+ * käsittelee kerrallaan yhden kirjanpidon. Useampi kirjanpito voidaan käsitellä
+ * rinnakkain (--rinnakkain), jolloin jokainen kirjanpito käsitellään omassa
+ * aliprosessissaan.
+ *
+ * Valinnalla --ajoitus kirjanpidon avaamisen, selausnäkymien ja laskulistan
+ * lataamisen, raporttien muodostamisen ja arkistoinnin kestot kirjoitetaan
+ * JSON-tiedostoon, jotta eri versioiden suorituskykyä voidaan verrata
+ * samoilla kirjanpidoilla.
+ *
+ * @since 1.1
+ */
+class Eraajo : public QObject
+{
+    Q_OBJECT
+public:
+    Eraajo();
+
+    /**
+     * @brief Onko ohjelma käynnistetty eräajona
+     *
+     * Tarkastetaan ennen sovellusolion luomista, jotta eräajossa
+     * voidaan käyttää näytötöntä (offscreen) alustaa
+     */
+    static bool onkoEraajo(int argc, char *argv[]);
+
+    /**
+     * @brief Suorittaa eräajon
+     * @param argumentit Ohjelman komentoriviargumentit
+     * @return Ohjelman paluuarvo, 0 jos kaikki onnistui
+     */
+    int suorita(const QStringList& argumentit);
+
+private slots:
+    void prosessiValmis(int paluuarvo, QProcess::ExitStatus tila);
+
+protected:
+    bool kasitteleKirjanpito(const QString& tiedosto);
+    bool kirjoitaRaportti(const QString& nimi, const QString& tiedostonimi);
+    /**
+     * @brief Kirjoittaa päivä- tai pääkirjan html- tai csv-tiedostoon rivi kerrallaan
+     */
+    bool kirjoitaVirtana(const QString& nimi, const QString& tiedostonimi);
+    bool arkistoi();
+
+    /**
+     * @brief Muodostaa raportin nimen perusteella
+     * @param nimi paakirja, paivakirja, taseerittely tai muokattavan raportin nimi
+     * @param ok Asetetaan epätodeksi, ellei raporttia löydy
+     */
+    RaportinKirjoittaja raportti(const QString& nimi, bool *ok);
+
+    int suoritaRinnakkain(int rinnakkain);
+    void kaynnistaSeuraava();
+
+    /**
+     * @brief Ajaa selausnäkymien ja laskulistan lataukset ajoitettuina
+     */
+    void ajoitaLataukset();
+    /**
+     * @brief Kirjaa vaiheen keston ajoitukseen
+     * @param rivit Käsiteltyjen rivien määrä, jos tiedossa
+     */
+    void kirjaaAjoitus(const QString& vaihe, qint64 millisekunnit, int rivit = -1);
+    bool kirjoitaAjoitukset();
+
+    void virhe(const QString& teksti);
+
+    QStringList raportit_;
+    QStringList tiedostot_;
+    QString muoto_;
+    QString kohde_;
+    QDate annettuAlkaa_;
+    QDate annettuPaattyy_;
+    QDate alkaa_;       /** Käsiteltävän kirjanpidon raporttikausi */
+    QDate paattyy_;
+    bool arkisto_ = false;
+
+    QString ajoitustiedosto_;
+    QJsonArray ajoitukset_;     /** Kirjanpidoittain vaiheiden kestot */
+    QJsonArray vaiheet_;        /** Käsiteltävän kirjanpidon vaiheet */
+
+    QStringList aliprosessinArgumentit_;
+    QEventLoop silmukka_;
+    int kaynnissa_ = 0;
+    int epaonnistui_ = 0;
+};
+
+#endif // ERAAJO_H
@@ -55,6 +55,12 @@ public:
      */
      void tallenna(VientiModel *model, int yhdistettavaVastatiliNumero = 0, QDate yhdistettavaPvm = QDate(), int indeksi = -1 );
 
+     /**
+      * @brief Ehdotetut viennit
+      * @since 1.1
+      */
+     QList<VientiRivi> viennit() const { return viennit_; }
+
 
      /**
       * @brief Viimeistelee ehdotukseen maksuperusteisen arvonlisäveron
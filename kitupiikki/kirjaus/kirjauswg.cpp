@@ -52,6 +52,7 @@
 #include "siirrydlg.h"
 
 #include "db/kirjanpito.h"
+#include "db/hakuindeksi.h"
 #include "laskutus/laskunmaksudialogi.h"
 
 #include "tuonti/tuonti.h"
@@ -207,6 +208,7 @@ void KirjausWg::tyhjenna()
     ui->tunnisteEdit->setStyleSheet("color: black;");
     // Tyhjennetään ensin model
     model_->tyhjaa();
+    tuotu_ = false;
     // ja sitten päivitetään lomakkeen tiedot modelista
     tiedotModelista();
     // Ei voi tallentaa eikä poistaa kun ei ole mitään...
@@ -330,6 +332,10 @@ void KirjausWg::tallenna()
         return;
     }
 
+    // Tuotu tiliote tai palkkatosite lisää kerralla paljon vientejä
+    if( tuotu_ )
+        kp()->paivitaTilastot();
+
     emit kp()->onni(tr("Tosite %1%2/%3 tallennettu")
                     .arg(model_->tositelaji().tunnus())
                     .arg(model_->tunniste())
@@ -487,6 +493,13 @@ void KirjausWg::numeroSiirto()
 
         QSqlQuery kysely(kasky);
 
+        // Tunnisteet näkyvät raporteissa ja selauksessa koko tilikaudelta
+        TositeMuutos muutos;
+        muutos.koko = true;
+        muutos.alkaa = kausi.alkaa();
+        muutos.loppuu = kausi.paattyy();
+        kp()->ilmoitaTositeMuutos(muutos);
+
         paivitaTunnisteVari();
     }
 
@@ -522,8 +535,25 @@ void KirjausWg::siirryTositteeseen()
 
 void KirjausWg::paivitaOtsikonTaydennys(const QString &teksti)
 {
-    if( teksti.length() > 2 && !teksti.contains(QChar('\'')))
-        taydennysSql_->setQuery(QString("SELECT otsikko FROM tosite WHERE otsikko LIKE '%1%' order by otsikko").arg(teksti));
+    QString sana = teksti.section(' ', 0, 0).remove('"');
+
+    if( teksti.length() > 2 && !sana.isEmpty())
+    {
+        QSqlQuery kysely( *kp()->tietokanta() );
+        if( kp()->hakuindeksi()->kaytossa())
+        {
+            // Rajataan ehdokkaat ensin tekstihaun indeksistä
+            kysely.prepare("SELECT DISTINCT otsikko FROM tosite WHERE id IN "
+                           "(SELECT rowid FROM tositehaku WHERE tositehaku MATCH :sana) "
+                           "AND otsikko LIKE :alku ORDER BY otsikko");
+            kysely.bindValue(":sana", QString("otsikko : \"%1\"*").arg(sana));
+        }
+        else
+            kysely.prepare("SELECT DISTINCT otsikko FROM tosite WHERE otsikko LIKE :alku ORDER BY otsikko");
+        kysely.bindValue(":alku", teksti + "%");
+        kysely.exec();
+        taydennysSql_->setQuery(kysely);
+    }
     else
         taydennysSql_->clear();
 
@@ -784,8 +814,15 @@ void KirjausWg::lisaaLiite(const QString& polku)
         // PDF-tiedosto tuodaan kuitenkin vain tyhjälle tositteelle
         // Tämä siksi, että pdf-tiliote voidaan tuoda csv-tilitietojen tositteeksi
         if( !(polku.endsWith(".pdf",Qt::CaseInsensitive)
-             && model()->vientiModel()->rowCount(QModelIndex()) ) &&  !Tuonti::tuo(polku, this))
-            return;
+             && model()->vientiModel()->rowCount(QModelIndex()) ))
+        {
+            int riveja = model()->vientiModel()->rowCount(QModelIndex());
+            bool liitteeksi = Tuonti::tuo(polku, this);
+            if( model()->vientiModel()->rowCount(QModelIndex()) > riveja )
+                tuotu_ = true;
+            if( !liitteeksi )
+                return;
+        }
 
         QFileInfo info(polku);
         model_->liiteModel()->lisaaTiedosto(polku, info.fileName());
@@ -224,6 +224,8 @@ protected:
 
     QSqlQueryModel *taydennysSql_;
 
+    bool tuotu_ = false;    /** Tositteeseen on tuotu vientejä tiedostosta */
+
 
 };
 
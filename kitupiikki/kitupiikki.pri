@@ -0,0 +1,429 @@
+# Kitupiikin sovelluksen ja suorituskykymittausten yhteiset lähdetiedostot
+#
+# Polut ovat suhteessa tähän hakemistoon, jotta tiedoston voi sisällyttää
+# myös alihakemistossa olevasta projektista (bench/bench.pro).
+
+
+QT += gui
+QT += widgets
+QT += sql
+QT += printsupport
+QT += network
+QT += svg
+QT += xml
+
+
+LIBS += -lpoppler-qt5
+LIBS += -lpoppler
+LIBS += -lzip
+
+
+macx {
+    LIBS += -L/usr/local/opt/poppler/lib -lpoppler-qt5
+    LIBS += -L/usr/local/opt/libzip -lzip
+    INCLUDEPATH += /usr/local/include
+}
+
+CONFIG += c++14
+
+INCLUDEPATH += $$PWD
+
+SOURCES += \
+    $$PWD/uusikp/uusikirjanpito.cpp \
+    $$PWD/uusikp/introsivu.cpp \
+    $$PWD/uusikp/nimisivu.cpp \
+    $$PWD/uusikp/tilikarttasivu.cpp \
+    $$PWD/uusikp/loppusivu.cpp \
+    $$PWD/uusikp/sijaintisivu.cpp \
+    $$PWD/uusikp/tilikausisivu.cpp \
+    $$PWD/kitupiikkiikkuna.cpp \
+    $$PWD/aloitussivu/aloitussivu.cpp \
+    $$PWD/db/kirjanpito.cpp \
+    $$PWD/maaritys/perusvalinnat.cpp \
+    $$PWD/maaritys/maarityssivu.cpp \
+    $$PWD/kirjaus/kirjauswg.cpp \
+    $$PWD/kirjaus/kirjaussivu.cpp \
+    $$PWD/db/tili.cpp \
+    $$PWD/kirjaus/tilidelegaatti.cpp \
+    $$PWD/kirjaus/eurodelegaatti.cpp \
+    $$PWD/selaus/selauswg.cpp \
+    $$PWD/db/tilikausi.cpp \
+    $$PWD/selaus/selausmodel.cpp \
+    $$PWD/raportti/raporttisivu.cpp \
+    $$PWD/raportti/raportti.cpp \
+    $$PWD/raportti/paivakirjaraportti.cpp \
+    $$PWD/maaritys/tilinavaus.cpp \
+    $$PWD/maaritys/tilinavausmodel.cpp \
+    $$PWD/kirjaus/pvmdelegaatti.cpp \
+    $$PWD/maaritys/tositelajit.cpp \
+    $$PWD/db/tositelajimodel.cpp \
+    $$PWD/db/asetusmodel.cpp \
+    $$PWD/db/tilimodel.cpp \
+    $$PWD/db/tilihakemisto.cpp \
+    $$PWD/db/hakuindeksi.cpp \
+    $$PWD/db/kyselyprofiloija.cpp \
+    $$PWD/db/kohdennusmodel.cpp \
+    $$PWD/db/kohdennus.cpp \
+    $$PWD/db/tositelaji.cpp \
+    $$PWD/db/tilikausimodel.cpp \
+    $$PWD/kitupiikkisivu.cpp \
+    $$PWD/raportti/raportinkirjoittaja.cpp \
+    $$PWD/raportti/raporttirivi.cpp \
+    $$PWD/raportti/raporttivalimuisti.cpp \
+    $$PWD/db/tositemodel.cpp \
+    $$PWD/db/vientimodel.cpp \
+    $$PWD/db/liitemodel.cpp \
+    $$PWD/db/jsonkentta.cpp \
+    $$PWD/db/asiakas.cpp \
+    $$PWD/kirjaus/naytaliitewg.cpp \
+    $$PWD/maaritys/tilikarttamuokkaus.cpp \
+    $$PWD/db/tilinvalintaline.cpp \
+    $$PWD/db/tilinvalintadialogi.cpp \
+    $$PWD/maaritys/tilinmuokkausdialog.cpp \
+    $$PWD/maaritys/kohdennusmuokkaus.cpp \
+    $$PWD/maaritys/kohdennusdialog.cpp \
+    $$PWD/maaritys/tositelajidialogi.cpp \
+    $$PWD/kirjaus/kirjausapuridialog.cpp \
+    $$PWD/db/verotyyppimodel.cpp \
+    $$PWD/kirjaus/kohdennusdelegaatti.cpp \
+    $$PWD/maaritys/raporttimuokkaus.cpp \
+    $$PWD/maaritys/raportinkorostin.cpp \
+    $$PWD/raportti/muokattavaraportti.cpp \
+    $$PWD/ktpvienti/ktpintro.cpp \
+    $$PWD/ktpvienti/ktpperustiedot.cpp \
+    $$PWD/ktpvienti/ktpkuvaus.cpp \
+    $$PWD/ktpvienti/ktpaloitusteksti.cpp \
+    $$PWD/ktpvienti/ktpvienti.cpp \
+    $$PWD/onniwidget.cpp \
+    $$PWD/raportti/raportoija.cpp \
+    $$PWD/raportti/paakirjaraportti.cpp \
+    $$PWD/raportti/tilikarttaraportti.cpp \
+    $$PWD/selaus/tositeselausmodel.cpp \
+    $$PWD/arkistoija/arkistoija.cpp \
+    $$PWD/raportti/tositeluetteloraportti.cpp \
+    $$PWD/tilinpaatoseditori/tilinpaatoseditori.cpp \
+    $$PWD/tilinpaatoseditori/tilinpaatostulostaja.cpp \
+    $$PWD/maaritys/liitetietokaavamuokkaus.cpp \
+    $$PWD/tilinpaatoseditori/tpaloitus.cpp \
+    $$PWD/tilinpaatoseditori/mrichtexteditor/mrichtextedit.cpp \
+    $$PWD/tilinpaatoseditori/mrichtexteditor/mtextedit.cpp \
+    $$PWD/arkisto/arkistosivu.cpp \
+    $$PWD/maaritys/maarityswidget.cpp \
+    $$PWD/kirjaus/ehdotusmodel.cpp \
+    $$PWD/db/eranvalintamodel.cpp \
+    $$PWD/kirjaus/verodialogi.cpp \
+    $$PWD/db/tilityyppimodel.cpp \
+    $$PWD/kirjaus/taseeravalintadialogi.cpp \
+    $$PWD/maaritys/alvmaaritys.cpp \
+    $$PWD/maaritys/alvilmoitusdialog.cpp \
+    $$PWD/maaritys/alvilmoitustenmodel.cpp \
+    $$PWD/laskutus/laskumodel.cpp \
+    $$PWD/laskutus/laskudialogi.cpp \
+    $$PWD/laskutus/laskuntulostaja.cpp \
+    $$PWD/laskutus/laskupohja.cpp \
+    $$PWD/laskutus/laskutusverodelegaatti.cpp \
+    $$PWD/maaritys/laskuvalintawidget.cpp \
+    $$PWD/laskutus/tuotemodel.cpp \
+    $$PWD/laskutus/smtpjono.cpp \
+    $$PWD/maaritys/emailmaaritys.cpp \
+    $$PWD/laskutus/laskunmaksudialogi.cpp \
+    $$PWD/laskutus/laskutmodel.cpp \
+    $$PWD/raportti/taseerittely.cpp \
+    $$PWD/arkisto/tilinpaattaja.cpp \
+    $$PWD/arkisto/poistaja.cpp \
+    $$PWD/maaritys/kaavankorostin.cpp \
+    $$PWD/kirjaus/kohdennusproxymodel.cpp \
+    $$PWD/maaritys/tilikarttaohje.cpp \
+    $$PWD/uusikp/paivitakirjanpito.cpp \
+    $$PWD/arkisto/tararkisto.cpp \
+    $$PWD/tuonti/tuonti.cpp \
+    $$PWD/tuonti/pdftuonti.cpp \
+    $$PWD/validator/viitevalidator.cpp \
+    $$PWD/validator/ibanvalidator.cpp \
+    $$PWD/raportti/laskuraportti.cpp \
+    $$PWD/maaritys/tuontimaarityswidget.cpp \
+    $$PWD/tuonti/csvtuonti.cpp \
+    $$PWD/tuonti/tuontisarakedelegaatti.cpp \
+    $$PWD/tuonti/tilimuuntomodel.cpp \
+    $$PWD/uusikp/skripti.cpp \
+    $$PWD/tools/devtool.cpp \
+    $$PWD/lisaikkuna.cpp \
+    $$PWD/kirjaus/apurivinkki.cpp \
+    $$PWD/laskutus/nayukiQR/BitBuffer.cpp \
+    $$PWD/laskutus/nayukiQR/QrCode.cpp \
+    $$PWD/laskutus/nayukiQR/QrSegment.cpp \
+    $$PWD/tuonti/titotuonti.cpp \
+    $$PWD/kirjaus/siirrydlg.cpp \
+    $$PWD/laskutus/ostolaskutmodel.cpp \
+    $$PWD/tools/kpdateedit.cpp \
+    $$PWD/uusikp/kirjausperustesivu.cpp \
+    $$PWD/tuonti/palkkafituonti.cpp \
+    $$PWD/raportti/alverittely.cpp \
+    $$PWD/raportti/alvlaskelma.cpp \
+    $$PWD/eraajo/eraajo.cpp \
+    $$PWD/raportti/myyntiraportti.cpp \
+    $$PWD/validator/ytunnusvalidator.cpp \
+    $$PWD/laskutus/asiakkaatmodel.cpp \
+    $$PWD/laskutus/laskusivu.cpp \
+    $$PWD/laskutus/yhteystietowidget.cpp \
+    $$PWD/naytin/naytinscene.cpp \
+    $$PWD/naytin/pdfscene.cpp \
+    $$PWD/naytin/naytinview.cpp \
+    $$PWD/naytin/kuvanaytin.cpp \
+    $$PWD/naytin/raporttiscene.cpp \
+    $$PWD/naytin/raporttisivuitem.cpp \
+    $$PWD/naytin/naytinikkuna.cpp \
+    $$PWD/maaritys/tallentavamaarityswidget.cpp \
+    $$PWD/maaritys/inboxmaaritys.cpp \
+    $$PWD/tools/inboxlista.cpp \
+    $$PWD/arkisto/budjettimodel.cpp \
+    $$PWD/arkisto/budjettidlg.cpp \
+    $$PWD/arkisto/budjettikohdennusproxy.cpp \
+    $$PWD/laskutus/laskuryhmamodel.cpp \
+    $$PWD/laskutus/ryhmaasiakasproxy.cpp \
+    $$PWD/laskutus/ryhmantuontidlg.cpp \
+    $$PWD/laskutus/ryhmantuontimodel.cpp \
+    $$PWD/laskutus/finvoice.cpp \
+    $$PWD/maaritys/finvoicemaaritys.cpp \
+    $$PWD/raportti/budjettivertailu.cpp
+
+HEADERS += \
+    $$PWD/uusikp/uusikirjanpito.h \
+    $$PWD/uusikp/introsivu.h \
+    $$PWD/uusikp/nimisivu.h \
+    $$PWD/uusikp/tilikarttasivu.h \
+    $$PWD/uusikp/loppusivu.h \
+    $$PWD/uusikp/sijaintisivu.h \
+    $$PWD/uusikp/tilikausisivu.h \
+    $$PWD/kitupiikkiikkuna.h \
+    $$PWD/aloitussivu/aloitussivu.h \
+    $$PWD/db/kirjanpito.h \
+    $$PWD/maaritys/perusvalinnat.h \
+    $$PWD/maaritys/maarityssivu.h \
+    $$PWD/kirjaus/kirjauswg.h \
+    $$PWD/kirjaus/kirjaussivu.h \
+    $$PWD/db/tili.h \
+    $$PWD/kirjaus/tilidelegaatti.h \
+    $$PWD/kirjaus/eurodelegaatti.h \
+    $$PWD/selaus/selauswg.h \
+    $$PWD/db/tilikausi.h \
+    $$PWD/selaus/selausmodel.h \
+    $$PWD/raportti/raporttisivu.h \
+    $$PWD/raportti/raportti.h \
+    $$PWD/raportti/paivakirjaraportti.h \
+    $$PWD/maaritys/tilinavaus.h \
+    $$PWD/maaritys/tilinavausmodel.h \
+    $$PWD/kirjaus/pvmdelegaatti.h \
+    $$PWD/maaritys/tositelajit.h \
+    $$PWD/db/tositelajimodel.h \
+    $$PWD/db/asetusmodel.h \
+    $$PWD/db/tilimodel.h \
+    $$PWD/db/tilihakemisto.h \
+    $$PWD/db/hakuindeksi.h \
+    $$PWD/db/kyselyprofiloija.h \
+    $$PWD/db/kohdennusmodel.h \
+    $$PWD/db/kohdennus.h \
+    $$PWD/db/tositelaji.h \
+    $$PWD/db/tilikausimodel.h \
+    $$PWD/maaritys/maarityswidget.h \
+    $$PWD/kitupiikkisivu.h \
+    $$PWD/raportti/raportinkirjoittaja.h \
+    $$PWD/raportti/raporttirivi.h \
+    $$PWD/raportti/raporttivalimuisti.h \
+    $$PWD/db/tositemodel.h \
+    $$PWD/db/vientimodel.h \
+    $$PWD/db/liitemodel.h \
+    $$PWD/db/jsonkentta.h \
+    $$PWD/db/asiakas.h \
+    $$PWD/kirjaus/naytaliitewg.h \
+    $$PWD/maaritys/tilikarttamuokkaus.h \
+    $$PWD/db/tilinvalintaline.h \
+    $$PWD/db/tilinvalintadialogi.h \
+    $$PWD/maaritys/tilinmuokkausdialog.h \
+    $$PWD/maaritys/kohdennusmuokkaus.h \
+    $$PWD/maaritys/kohdennusdialog.h \
+    $$PWD/maaritys/tositelajidialogi.h \
+    $$PWD/kirjaus/kirjausapuridialog.h \
+    $$PWD/db/verotyyppimodel.h \
+    $$PWD/kirjaus/kohdennusdelegaatti.h \
+    $$PWD/maaritys/raporttimuokkaus.h \
+    $$PWD/maaritys/raportinkorostin.h \
+    $$PWD/raportti/muokattavaraportti.h \
+    $$PWD/ktpvienti/ktpintro.h \
+    $$PWD/ktpvienti/ktpperustiedot.h \
+    $$PWD/ktpvienti/ktpkuvaus.h \
+    $$PWD/ktpvienti/ktpaloitusteksti.h \
+    $$PWD/ktpvienti/ktpvienti.h \
+    $$PWD/onniwidget.h \
+    $$PWD/raportti/raportoija.h \
+    $$PWD/raportti/paakirjaraportti.h \
+    $$PWD/raportti/tilikarttaraportti.h \
+    $$PWD/selaus/tositeselausmodel.h \
+    $$PWD/arkistoija/arkistoija.h \
+    $$PWD/raportti/tositeluetteloraportti.h \
+    $$PWD/tilinpaatoseditori/tilinpaatoseditori.h \
+    $$PWD/tilinpaatoseditori/tilinpaatostulostaja.h \
+    $$PWD/maaritys/liitetietokaavamuokkaus.h \
+    $$PWD/tilinpaatoseditori/tpaloitus.h \
+    $$PWD/tilinpaatoseditori/mrichtexteditor/mrichtextedit.h \
+    $$PWD/tilinpaatoseditori/mrichtexteditor/mtextedit.h \
+    $$PWD/arkisto/arkistosivu.h \
+    $$PWD/kirjaus/ehdotusmodel.h \
+    $$PWD/db/eranvalintamodel.h \
+    $$PWD/kirjaus/verodialogi.h \
+    $$PWD/db/tilityyppimodel.h \
+    $$PWD/kirjaus/taseeravalintadialogi.h \
+    $$PWD/maaritys/alvmaaritys.h \
+    $$PWD/maaritys/alvilmoitusdialog.h \
+    $$PWD/maaritys/alvilmoitustenmodel.h \
+    $$PWD/laskutus/laskumodel.h \
+    $$PWD/laskutus/laskudialogi.h \
+    $$PWD/laskutus/laskuntulostaja.h \
+    $$PWD/laskutus/laskupohja.h \
+    $$PWD/laskutus/laskutusverodelegaatti.h \
+    $$PWD/maaritys/laskuvalintawidget.h \
+    $$PWD/laskutus/tuotemodel.h \
+    $$PWD/laskutus/smtpjono.h \
+    $$PWD/maaritys/emailmaaritys.h \
+    $$PWD/laskutus/laskunmaksudialogi.h \
+    $$PWD/laskutus/laskutmodel.h \
+    $$PWD/raportti/taseerittely.h \
+    $$PWD/arkisto/tilinpaattaja.h \
+    $$PWD/arkisto/poistaja.h \
+    $$PWD/maaritys/kaavankorostin.h \
+    $$PWD/kirjaus/kohdennusproxymodel.h \
+    $$PWD/maaritys/tilikarttaohje.h \
+    $$PWD/uusikp/paivitakirjanpito.h \
+    $$PWD/arkisto/tararkisto.h \
+    $$PWD/tuonti/pdftuonti.h \
+    $$PWD/tuonti/tuonti.h \
+    $$PWD/validator/viitevalidator.h \
+    $$PWD/validator/ibanvalidator.h \
+    $$PWD/raportti/laskuraportti.h \
+    $$PWD/maaritys/tuontimaarityswidget.h \
+    $$PWD/tuonti/csvtuonti.h \
+    $$PWD/tuonti/tuontisarakedelegaatti.h \
+    $$PWD/tuonti/tilimuuntomodel.h \
+    $$PWD/uusikp/skripti.h \
+    $$PWD/tools/devtool.h \
+    $$PWD/lisaikkuna.h \
+    $$PWD/kirjaus/apurivinkki.h \
+    $$PWD/laskutus/nayukiQR/BitBuffer.hpp \
+    $$PWD/laskutus/nayukiQR/QrCode.hpp \
+    $$PWD/laskutus/nayukiQR/QrSegment.hpp \
+    $$PWD/tuonti/titotuonti.h \
+    $$PWD/kirjaus/siirrydlg.h \
+    $$PWD/laskutus/ostolaskutmodel.h \
+    $$PWD/tools/kpdateedit.h \
+    $$PWD/uusikp/kirjausperustesivu.h \
+    $$PWD/tuonti/palkkafituonti.h \
+    $$PWD/raportti/alverittely.h \
+    $$PWD/raportti/alvlaskelma.h \
+    $$PWD/eraajo/eraajo.h \
+    $$PWD/raportti/myyntiraportti.h \
+    $$PWD/validator/ytunnusvalidator.h \
+    $$PWD/laskutus/asiakkaatmodel.h \
+    $$PWD/laskutus/laskusivu.h \
+    $$PWD/laskutus/yhteystietowidget.h \
+    $$PWD/naytin/naytinscene.h \
+    $$PWD/naytin/pdfscene.h \
+    $$PWD/naytin/naytinview.h \
+    $$PWD/naytin/kuvanaytin.h \
+    $$PWD/naytin/raporttiscene.h \
+    $$PWD/naytin/raporttisivuitem.h \
+    $$PWD/naytin/naytinikkuna.h \
+    $$PWD/maaritys/tallentavamaarityswidget.h \
+    $$PWD/maaritys/inboxmaaritys.h \
+    $$PWD/tools/inboxlista.h \
+    $$PWD/arkisto/budjettimodel.h \
+    $$PWD/arkisto/budjettidlg.h \
+    $$PWD/arkisto/budjettikohdennusproxy.h \
+    $$PWD/laskutus/laskuryhmamodel.h \
+    $$PWD/laskutus/ryhmaasiakasproxy.h \
+    $$PWD/laskutus/ryhmantuontidlg.h \
+    $$PWD/laskutus/ryhmantuontimodel.h \
+    $$PWD/laskutus/finvoice.h \
+    $$PWD/maaritys/finvoicemaaritys.h \
+    $$PWD/versio.h \
+    $$PWD/raportti/budjettivertailu.h
+
+RESOURCES += \
+    $$PWD/tilikartat/tilikartat.qrc \
+    $$PWD/pic/pic.qrc \
+    $$PWD/uusikp/sql.qrc \
+    $$PWD/aloitussivu/qrc/aloitus.qrc \
+    $$PWD/arkistoija/arkisto.qrc
+
+FORMS += \
+    $$PWD/uusikp/intro.ui \
+    $$PWD/uusikp/nimi.ui \
+    $$PWD/uusikp/tilikartta.ui \
+    $$PWD/uusikp/sijainti.ui \
+    $$PWD/uusikp/tilikausi.ui \
+    $$PWD/maaritys/perusvalinnat.ui \
+    $$PWD/kirjaus/kirjaus.ui \
+    $$PWD/kirjaus/tositewg.ui \
+    $$PWD/selaus/selauswg.ui \
+    $$PWD/raportti/paivakirja.ui \
+    $$PWD/maaritys/tilinavaus.ui \
+    $$PWD/maaritys/tositelajit.ui \
+    $$PWD/maaritys/tilikarttamuokkaus.ui \
+    $$PWD/maaritys/tilinmuokkaus.ui \
+    $$PWD/db/tilinvalintadialogi.ui \
+    $$PWD/maaritys/kohdennukset.ui \
+    $$PWD/maaritys/kohdennusdialog.ui \
+    $$PWD/maaritys/tositelajidialogi.ui \
+    $$PWD/kirjaus/kirjausapuridialog.ui \
+    $$PWD/maaritys/raportinmuokkaus.ui \
+    $$PWD/raportti/muokattavaraportti.ui \
+    $$PWD/ktpvienti/ktpintro.ui \
+    $$PWD/ktpvienti/ktpperustiedot.ui \
+    $$PWD/ktpvienti/ktpkuvaus.ui \
+    $$PWD/ktpvienti/ktpaloitusteksti.ui \
+    $$PWD/onniwidget.ui \
+    $$PWD/raportti/tilikarttaraportti.ui \
+    $$PWD/aloitussivu/aboutdialog.ui \
+    $$PWD/tilinpaatoseditori/tpaloitus.ui \
+    $$PWD/tilinpaatoseditori/mrichtexteditor/mrichtextedit.ui \
+    $$PWD/aloitussivu/aloitus.ui \
+    $$PWD/arkisto/arkisto.ui \
+    $$PWD/arkisto/lisaatilikausidlg.ui \
+    $$PWD/arkisto/lukitsetilikausi.ui \
+    $$PWD/kirjaus/verodialogi.ui \
+    $$PWD/kirjaus/taseeravalintadialogi.ui \
+    $$PWD/maaritys/arvonlisavero.ui \
+    $$PWD/maaritys/alvilmoitusdialog.ui \
+    $$PWD/laskutus/laskudialogi.ui \
+    $$PWD/maaritys/laskumaaritys.ui \
+    $$PWD/maaritys/emailmaaritys.ui \
+    $$PWD/laskutus/laskunmaksudialogi.ui \
+    $$PWD/raportti/taseerittely.ui \
+    $$PWD/arkisto/tilinpaattaja.ui \
+    $$PWD/arkisto/poistaja.ui \
+    $$PWD/maaritys/lisaaraporttidialogi.ui \
+    $$PWD/maaritys/kaavaeditori.ui \
+    $$PWD/arkisto/muokkaatilikausi.ui \
+    $$PWD/maaritys/tilikarttaohje.ui \
+    $$PWD/aloitussivu/tervetuloa.ui \
+    $$PWD/uusikp/tkpaivitys.ui \
+    $$PWD/uusikp/paivityskorvaa.ui \
+    $$PWD/arkisto/arkistonvienti.ui \
+    $$PWD/raportti/csvvientivalinnat.ui \
+    $$PWD/raportti/laskuraportti.ui \
+    $$PWD/maaritys/tuontimaaritys.ui \
+    $$PWD/tuonti/csvtuontidlg.ui \
+    $$PWD/tuonti/tilimuuntodlg.ui \
+    $$PWD/tools/devtool.ui \
+    $$PWD/maaritys/maksuperusteinen.ui \
+    $$PWD/kirjaus/apurivinkki.ui \
+    $$PWD/kirjaus/numerosiirto.ui \
+    $$PWD/kirjaus/siirry.ui \
+    $$PWD/kirjaus/kopioitosite.ui \
+    $$PWD/uusikp/kirjausperuste.ui \
+    $$PWD/laskutus/yhteystiedot.ui \
+    $$PWD/maaritys/inboxmaaritys.ui \
+    $$PWD/arkisto/budjettidlg.ui \
+    $$PWD/laskutus/ryhmantuontidlg.ui \
+    $$PWD/maaritys/verkkolaskumaaritys.ui \
+    $$PWD/aloitussivu/muistiinpanot.ui \
+    $$PWD/raportti/budjettivertailu.ui
@@ -81,37 +81,31 @@ void AsiakkaatModel::paivita(bool toimittajat)
 {
     toimittajat_ = toimittajat;
 
-    QString kysely = "select distinct asiakas from vienti where iban is ";
-
-    if( toimittajat_ )
-        kysely.append("not");
-
-    kysely.append(" null order by asiakas");
-
     beginResetModel();
     rivit_.clear();
-    QSqlQuery query( kysely );
+    QSqlQuery query( toimittajat_ ? "SELECT id, nimi FROM asiakas WHERE osto ORDER BY nimi" :
+                                    "SELECT id, nimi FROM asiakas WHERE myynti ORDER BY nimi");
 
     while( query.next())
     {
         AsiakasRivi rivi;
-        rivi.nimi = query.value(0).toString();
+        int asiakasId = query.value(0).toInt();
+        rivi.nimi = query.value(1).toString();
 
         if( rivi.nimi.isEmpty())
             continue;
 
         // TODO: Summien laskeminen eri kyselyllä
-        QString summakysely = QString("SELECT id, pvm, debetsnt, kreditsnt, erapvm, eraid FROM vienti "
-                                      "WHERE asiakas=\"%1\" and iban is ").arg(rivi.nimi.replace("\"","\\\""));
-        if( toimittajat_)
-            summakysely.append("not ");
-        summakysely.append("null");
+        QSqlQuery& summaquery = kp()->kysely( toimittajat_ ?
+                "SELECT id, pvm, debetsnt, kreditsnt, erapvm, eraid FROM vienti WHERE asiakasid=:asiakas and iban is not null" :
+                "SELECT id, pvm, debetsnt, kreditsnt, erapvm, eraid FROM vienti WHERE asiakasid=:asiakas and iban is null");
+        summaquery.bindValue(":asiakas", asiakasId);
+        summaquery.exec();
 
         qlonglong summa=0;
         qlonglong eraantyneet=0;
         qlonglong avoimet = 0;
 
-        QSqlQuery summaquery( summakysely );
         while( summaquery.next())
         {
            qlonglong sentit = toimittajat_ ? summaquery.value("kreditsnt").toLongLong() - summaquery.value("debetsnt").toLongLong()  :  summaquery.value("debetsnt").toLongLong() - summaquery.value("kreditsnt").toLongLong();
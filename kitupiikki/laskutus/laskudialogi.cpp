@@ -17,6 +17,7 @@
 
 
 #include "db/kirjanpito.h"
+#include "db/asiakas.h"
 
 #include "laskudialogi.h"
 #include "ui_laskudialogi.h"
@@ -48,7 +49,7 @@
 #include <QPrintDialog>
 #include <QDesktopServices>
 #include <QCompleter>
-#include <QSqlQueryModel>
+#include <QStringListModel>
 #include <QSqlQuery>
 #include <QRegExp>
 #include <QMessageBox>
@@ -117,13 +118,19 @@ LaskuDialogi::LaskuDialogi(LaskuModel *laskumodel) :
     ui->tabWidget->setTabEnabled(VERKKOLASKU, false);
 
 
-    // Laitetaan täydentäjä nimen syöttöön
+    // Laitetaan täydentäjä nimen syöttöön. Ehdotukset haetaan asiakasrekisteristä
+    // kirjoitettaessa, joten kaikkia nimiä ei ladata dialogia avattaessa
     QCompleter *nimiTaydentaja = new QCompleter(this);
-    QSqlQueryModel *sqlmalli = new QSqlQueryModel(this);
-    sqlmalli->setQuery("select distinct asiakas from vienti order by asiakas");
-    nimiTaydentaja->setModel(sqlmalli);
-    nimiTaydentaja->setModelSorting(QCompleter::CaseSensitivelySortedModel);
+    QStringListModel *nimiMalli = new QStringListModel(this);
+    nimiTaydentaja->setModel(nimiMalli);
+    nimiTaydentaja->setCaseSensitivity(Qt::CaseInsensitive);
     ui->saajaEdit->setCompleter(nimiTaydentaja);
+    connect( ui->saajaEdit, &QLineEdit::textEdited, [nimiTaydentaja, nimiMalli] (const QString& teksti) {
+        nimiMalli->setStringList( teksti.isEmpty() ? QStringList() : Asiakas::nimet(teksti) );
+        nimiTaydentaja->setCompletionPrefix(teksti);
+        if( nimiMalli->rowCount() )
+            nimiTaydentaja->complete();
+    });
 
     connect( ui->lisaaNappi, SIGNAL(clicked(bool)), model, SLOT(lisaaRivi()));
     connect( ui->poistaNappi, SIGNAL(clicked(bool)), this, SLOT(poistaLaskuRivi()));
@@ -380,25 +387,20 @@ void LaskuDialogi::perusteVaihtuu()
 
 void LaskuDialogi::haeOsoite()
 {
-    QSqlQuery kysely;
     QString nimistr = ui->saajaEdit->text();
-    nimistr.remove(QRegExp("['\"]"));
 
-    kysely.exec( QString("SELECT json FROM vienti WHERE asiakas='%1' AND iban is null ORDER BY muokattu DESC").arg( nimistr)) ;
-
-    if( kysely.next() )
+    Asiakas asiakas = Asiakas::haeNimella(nimistr);
+    if( asiakas.id )
     {
-        JsonKentta json;
-        json.fromJson( kysely.value(0).toByteArray() );
-        ui->emailEdit->setText( json.str("Email"));
-        ui->ytunnus->setText( json.str("YTunnus"));
-        ui->verkkoOsoiteEdit->setText( json.str("VerkkolaskuOsoite"));
-        ui->verkkoValittajaEdit->setText( json.str("VerkkolaskuValittaja"));
-
-        if( !json.str("Osoite").isEmpty())
+        ui->emailEdit->setText( asiakas.email );
+        ui->ytunnus->setText( asiakas.ytunnus );
+        ui->verkkoOsoiteEdit->setText( asiakas.verkkolaskuosoite );
+        ui->verkkoValittajaEdit->setText( asiakas.verkkolaskuvalittaja );
+
+        if( !asiakas.osoite.isEmpty())
         {
             // Haetaan aiempi osoite
-            ui->osoiteEdit->setPlainText( json.str("Osoite"));
+            ui->osoiteEdit->setPlainText( asiakas.osoite );
             return;
         }
     }
@@ -513,7 +515,13 @@ void LaskuDialogi::lahetaSahkopostilla()
     vieMalliin();
     if( model->tyyppi() == LaskuModel::RYHMALASKU)
     {
-        ryhmaLahetys_.append(-1);
+        if( ryhmaJono_ )
+            return;     // Edellinen lähetys on vielä kesken
+
+        ryhmaLahetys_.clear();
+        ryhmaLahetetty_ = 0;
+        ryhmaVirheita_ = 0;
+
         if( !ui->ryhmaView->selectionModel()->hasSelection())
             ui->ryhmaView->selectAll();
 
@@ -522,54 +530,107 @@ void LaskuDialogi::lahetaSahkopostilla()
             if( !indeksi.data(LaskuRyhmaModel::SahkopostiRooli).toString().isEmpty())
                 ryhmaLahetys_.append( ryhmaProxy_->mapToSource(indeksi).row() );
         }
-        lahetaRyhmanSeuraava();
+        if( ryhmaLahetys_.isEmpty())
+            return;
+
+        // Kaikki ryhmän laskut lähetetään samalla yhteydellä
+        ryhmaJono_ = uusiSmtpJono();
+        ryhmaJono_->setParent(this);
+        connect( ryhmaJono_, &SmtpJono::viestiLahetetty, this, &LaskuDialogi::ryhmanViestiLahetetty);
+        connect( ryhmaJono_, &SmtpJono::viestiEpaonnistui, this, &LaskuDialogi::ryhmanViestiEpaonnistui);
+        connect( ryhmaJono_, &SmtpJono::valmis, this, &LaskuDialogi::ryhmanLahetysValmis);
+
+        taydennaRyhmanJonoa();
         return;
     }
 
+    SmtpJono *smtp = uusiSmtpJono();
+    connect( smtp, &SmtpJono::viestiLahetetty, this, [this] { smtpViesti(tr("Sähköposti lähetetty")); });
+    connect( smtp, &SmtpJono::viestiEpaonnistui, this, [this] (int, const QString& virhe)
+    {
+        smtpViesti(tr("Sähköpostin lähetys epäonnistui"));
+        QMessageBox::warning( this, tr( "Virhe sähköpostin lähetyksessä" ), tr( "Sähköpostipalvelin ilmoitti virheen: %1" ).arg( virhe ) );
+    });
+    connect( smtp, &SmtpJono::valmis, smtp, &SmtpJono::deleteLater);
 
-    Smtp *smtp = new Smtp( kp()->settings()->value("SmtpUser").toString(), kp()->settings()->value("SmtpPassword").toString(),
-                     kp()->settings()->value("SmtpServer").toString(), kp()->settings()->value("SmtpPort", 465).toInt() );
-    connect( smtp, SIGNAL(status(QString)), this, SLOT(smtpViesti(QString)));
+    smtp->lisaa( laskunSahkoposti() );
+}
 
+void LaskuDialogi::ryhmanViestiLahetetty(int rivi)
+{
+    model->ryhmaModel()->sahkopostiLahetetty( rivi );
+    ryhmaLahetetty_++;
+    smtpViesti( tr("Lähetetty %1/%2 ...").arg(ryhmaLahetetty_ + ryhmaVirheita_).arg( ryhmaLahetetty_ + ryhmaVirheita_ + ryhmaLahetys_.count() + ryhmaJono_->jonossa()));
 
-    QString kenelta = QString("=?utf-8?Q?%1?= <%2>").arg(kp()->asetukset()->asetus("EmailNimi"))
-                                                .arg(kp()->asetukset()->asetus("EmailOsoite"));
-    QString kenelle = QString("=?utf-8?Q?%1?= <%2>").arg( ui->saajaEdit->text() )
-                                            .arg(ui->emailEdit->text() );
+    taydennaRyhmanJonoa();
+}
 
-    smtp->lahetaLiitteella(kenelta, kenelle, tr("Lasku %1 - %2").arg( model->viitenumero() ).arg( kp()->asetukset()->asetus("Nimi") ),
-                           tulostaja->html(), tr("lasku%1.pdf").arg( model->viitenumero()), tulostaja->pdf());
+void LaskuDialogi::ryhmanViestiEpaonnistui(int rivi, const QString &virhe)
+{
+    model->ryhmaModel()->sahkopostiEpaonnistui( rivi, virhe );
+    ryhmaVirheita_++;
 
+    if( ryhmaJono_->lopetettu())
+        hylkaaRyhmanLoput(virhe);
+    else
+        taydennaRyhmanJonoa();
 }
 
-void LaskuDialogi::lahetaRyhmanSeuraava(const QString &viesti)
+void LaskuDialogi::ryhmanLahetysValmis()
 {
-    smtpViesti(viesti);
-
-    if( viesti.endsWith('.'))   // Ei ole vielä lopettava viesti
-        return;
-    else if( viesti == tr("Sähköposti lähetetty"))
-        model->ryhmaModel()->sahkopostiLahetetty( ryhmaLahetys_.first() );
+    hylkaaRyhmanLoput( tr("Sähköpostin lähetys keskeytyi"));
 
-    ryhmaLahetys_.removeFirst();
-    if( !ryhmaLahetys_.isEmpty() )
+    if( !ryhmaVirheita_ )
+        smtpViesti( tr("Sähköposti lähetetty"));
+    else
     {
-        model->haeRyhmasta(ryhmaLahetys_.first());
-
-
-        Smtp *smtp = new Smtp( kp()->settings()->value("SmtpUser").toString(), kp()->settings()->value("SmtpPassword").toString(),
-                         kp()->settings()->value("SmtpServer").toString(), kp()->settings()->value("SmtpPort", 465).toInt() );
-        connect( smtp, &Smtp::status, this, &LaskuDialogi::lahetaRyhmanSeuraava);
+        ui->onniLabel->setText( tr("%1 laskua lähetetty, %2 lähetystä epäonnistui").arg(ryhmaLahetetty_).arg(ryhmaVirheita_) );
+        ui->onniLabel->setStyleSheet("color: red;");
+    }
+    ryhmaJono_->deleteLater();
+    ryhmaJono_ = nullptr;
+}
 
+SmtpViesti LaskuDialogi::laskunSahkoposti(int tunniste)
+{
+    SmtpViesti viesti;
+    viesti.tunniste = tunniste;
+    viesti.lahettaja = QString("=?utf-8?Q?%1?= <%2>").arg(kp()->asetukset()->asetus("EmailNimi"))
+                                                .arg(kp()->asetukset()->asetus("EmailOsoite"));
+    viesti.vastaanottaja = QString("=?utf-8?Q?%1?= <%2>").arg( model->laskunsaajanNimi() )
+                                            .arg(model->email() );
+    viesti.otsikko = tr("Lasku %1 - %2").arg( model->viitenumero() ).arg( kp()->asetukset()->asetus("Nimi") );
+    viesti.html = tulostaja->html();
+    viesti.liitenimi = tr("lasku%1.pdf").arg( model->viitenumero());
+    viesti.liite = tulostaja->pdf();
+    return viesti;
+}
 
-        QString kenelta = QString("=?utf-8?Q?%1?= <%2>").arg(kp()->asetukset()->asetus("EmailNimi"))
-                                                    .arg(kp()->asetukset()->asetus("EmailOsoite"));
-        QString kenelle = QString("=?utf-8?Q?%1?= <%2>").arg( model->laskunsaajanNimi() )
-                                                .arg(model->email() );
+SmtpJono *LaskuDialogi::uusiSmtpJono()
+{
+    SmtpJono *smtp = new SmtpJono( kp()->settings()->value("SmtpUser").toString(), kp()->settings()->value("SmtpPassword").toString(),
+                     kp()->settings()->value("SmtpServer").toString(), kp()->settings()->value("SmtpPort", 465).toInt() );
+    connect( smtp, &SmtpJono::status, this, &LaskuDialogi::smtpViesti);
+    return smtp;
+}
 
-        smtp->lahetaLiitteella(kenelta, kenelle, tr("Lasku %1 - %2").arg( model->viitenumero() ).arg( kp()->asetukset()->asetus("Nimi") ),
-                               tulostaja->html(), tr("lasku%1.pdf").arg( model->viitenumero()), tulostaja->pdf());
+void LaskuDialogi::taydennaRyhmanJonoa()
+{
+    while( ryhmaJono_ && !ryhmaJono_->lopetettu() && ryhmaJono_->jonossa() < 2 && !ryhmaLahetys_.isEmpty())
+    {
+        int rivi = ryhmaLahetys_.takeFirst();
+        model->haeRyhmasta( rivi );
+        ryhmaJono_->lisaa( laskunSahkoposti(rivi) );
+    }
+}
 
+void LaskuDialogi::hylkaaRyhmanLoput(const QString &virhe)
+{
+    // Lähettämättömille laskuille ei muodosteta enää viestiä
+    while( !ryhmaLahetys_.isEmpty())
+    {
+        model->ryhmaModel()->sahkopostiEpaonnistui( ryhmaLahetys_.takeFirst(), virhe );
+        ryhmaVirheita_++;
     }
 }
 
@@ -637,34 +698,13 @@ void LaskuDialogi::ryhmaNapit(const QItemSelection &valinta)
 
 void LaskuDialogi::lisaaAsiakasListalta(const QModelIndex &indeksi)
 {
-    QSqlQuery kysely;
     QString nimistr = indeksi.data(AsiakkaatModel::NimiRooli).toString();
-    nimistr.remove(QRegExp("['\"]"));
-
-    kysely.exec( QString("SELECT json FROM vienti WHERE asiakas='%1' AND iban is null ORDER BY muokattu DESC").arg( nimistr)) ;
-    QString osoite = nimistr;
-    QString email;
-    QString ytunnus;
-    QString verkkolaskuosoite;
-    QString verkkolaskuvalittaja;
 
-    if( kysely.next() )
-    {
-        JsonKentta json;
-        json.fromJson( kysely.value(0).toByteArray() );
-        email =  json.str("Email");
-        ytunnus = json.str("YTunnus");
-        verkkolaskuosoite = json.str("VerkkolaskuOsoite");
-        verkkolaskuvalittaja = json.str("VerkkolaskuValittaja");
-
-        if( !json.str("Osoite").isEmpty())
-        {
-            // Haetaan aiempi osoite
-            osoite = json.str("Osoite");
-        }
-    }
+    Asiakas asiakas = Asiakas::haeNimella(nimistr);
+    QString osoite = asiakas.osoite.isEmpty() ? nimistr : asiakas.osoite;
 
-    model->ryhmaModel()->lisaa( nimistr, osoite, email, ytunnus, verkkolaskuosoite, verkkolaskuvalittaja);
+    model->ryhmaModel()->lisaa( nimistr, osoite, asiakas.email, asiakas.ytunnus,
+                                asiakas.verkkolaskuosoite, asiakas.verkkolaskuvalittaja);
 
 }
 
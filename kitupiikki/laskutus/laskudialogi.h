@@ -26,7 +26,7 @@
 #include "laskuntulostaja.h"
 #include "laskutmodel.h"
 
-#include "smtp.h"
+#include "smtpjono.h"
 
 namespace Ui {
 class LaskuDialogi;
@@ -76,7 +76,9 @@ private slots:
 
     void onkoPostiKaytossa();
     void lahetaSahkopostilla();
-    void lahetaRyhmanSeuraava(const QString& viesti = {} );
+    void ryhmanViestiLahetetty(int rivi);
+    void ryhmanViestiEpaonnistui(int rivi, const QString& virhe);
+    void ryhmanLahetysValmis();
 
     void smtpViesti(const QString &viesti);
     void tulostaLasku();
@@ -97,6 +99,23 @@ private:
      */
     void paivitaTuoteluettelonNaytto();
 
+    /**
+     * @brief Muodostaa sähköpostiviestin mallissa olevasta laskusta
+     */
+    SmtpViesti laskunSahkoposti(int tunniste = 0);
+    SmtpJono *uusiSmtpJono();
+    /**
+     * @brief Lisää ryhmän laskuja lähetysjonoon
+     *
+     * Jonossa pidetään vain muutama valmis lasku kerrallaan, jotta
+     * kaikkien laskujen pdf-tiedostoja ei tarvitse pitää muistissa
+     */
+    void taydennaRyhmanJonoa();
+    /**
+     * @brief Merkitsee jonoon lisäämättömät ryhmän laskut epäonnistuneiksi
+     */
+    void hylkaaRyhmanLoput(const QString& virhe);
+
     static int laskuIkkunoita__;
 
 public slots:
@@ -118,6 +137,9 @@ private:
     QSortFilterProxyModel *ryhmaProxy_;
 
     QList<int> ryhmaLahetys_;
+    SmtpJono *ryhmaJono_ = nullptr;
+    int ryhmaLahetetty_ = 0;
+    int ryhmaVirheita_ = 0;
     
 };
 
@@ -20,6 +20,7 @@
 #include "laskumodel.h"
 #include "laskutusverodelegaatti.h"
 #include "db/kirjanpito.h"
+#include "db/asiakas.h"
 #include "db/tilinvalintadialogi.h"
 #include "kirjaus/verodialogi.h"
 #include "laskuntulostaja.h"
@@ -769,6 +770,18 @@ bool LaskuModel::tallenna(Tili rahatili)
         return false;
     }
 
+    // Laskun saajan yhteystiedot asiakasrekisteriin seuraavia laskuja varten
+    if( !laskunsaajanNimi().isEmpty())
+    {
+        Asiakas asiakas = Asiakas::haeNimella( laskunsaajanNimi() );
+        asiakas.osoite = osoite();
+        asiakas.email = email();
+        asiakas.ytunnus = ytunnus();
+        asiakas.verkkolaskuosoite = verkkolaskuOsoite();
+        asiakas.verkkolaskuvalittaja = verkkolaskuValittaja();
+        asiakas.tallenna(false);
+    }
+
     if( laskunro() > kp()->asetukset()->isoluku("LaskuSeuraavaId"))
         kp()->asetukset()->aseta("LaskuSeuraavaId", laskunro() );
 
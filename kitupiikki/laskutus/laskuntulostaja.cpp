@@ -17,7 +17,6 @@
 
 #include <QDebug>
 #include <cmath>
-#include <QSvgRenderer>
 #include <QPdfWriter>
 
 #include <QApplication>
@@ -25,11 +24,10 @@
 #include "laskuntulostaja.h"
 #include "db/kirjanpito.h"
 #include "laskumodel.h"
-#include "nayukiQR/QrCode.hpp"
 
 
 
-LaskunTulostaja::LaskunTulostaja(LaskuModel *model) : QObject(model), model_(model)
+LaskunTulostaja::LaskunTulostaja(LaskuModel *model) : QObject(model), model_(model), pohja_( kp()->laskupohja() )
 {
     // Hakee laskulle tulostuvan IBAN-numeron
     iban = kp()->tilit()->tiliNumerolla( kp()->asetukset()->luku("LaskuTili")).json()->str("IBAN");
@@ -37,7 +35,10 @@ LaskunTulostaja::LaskunTulostaja(LaskuModel *model) : QObject(model), model_(mod
 
 bool LaskunTulostaja::tulosta(QPagedPaintDevice *printer, QPainter *painter)
 {
-    double mm = printer->width() * 1.00 / printer->widthMM();
+    // Laskusta toiseen samana pysyvät tiedot lasketaan vain kerran
+    pohja_->valmistele(printer, painter);
+
+    double mm = pohja_->mm();
     qreal marginaali = 0.0;
 
     if( kp()->asetukset()->onko("Harjoitus") && !kp()->asetukset()->onko("Demo") )
@@ -286,15 +287,11 @@ QString LaskunTulostaja::valeilla(const QString &teksti)
 void LaskunTulostaja::ylaruudukko(QPagedPaintDevice *printer, QPainter *painter)
 {
     const int TEKSTIPT = 10;
-    const int OTSAKEPT = 7;
 
-    double mm = printer->width() * 1.00 / printer->widthMM();
+    double mm = pohja_->mm();
 
-    // Lasketaan rivinkorkeus. Tehdään painterin kautta, jotta toimii myös pdf-writerillä
-    painter->setFont( QFont("Sans",OTSAKEPT) );
-    double rk = painter->fontMetrics().height();
-    painter->setFont(QFont("Sans",TEKSTIPT));
-    rk += painter->fontMetrics().height();
+    // Rivinkorkeus on laskettu pohjaan tulostuslaitteen mukaan
+    double rk = pohja_->rivikorkeus(LaskuPohja::OTSAKE) + pohja_->rivikorkeus(LaskuPohja::TEKSTI);
     rk += 2 * mm;
 
     double leveys = painter->window().width();
@@ -330,29 +327,27 @@ void LaskunTulostaja::ylaruudukko(QPagedPaintDevice *printer, QPainter *painter)
     // Lähettäjätiedot
 
     double vasen = 0.0;
-    if( !kp()->logo().isNull() )
+    QImage logo = pohja_->logo( rk * 2 );   // Logo on valmiiksi skaalattu, sallittu suhde enintään 5:1
+    if( !logo.isNull() )
     {
-        double logosuhde = (1.0 * kp()->logo().width() ) / kp()->logo().height();
-        double skaala = logosuhde < 5.00 ? logosuhde : 5.00;    // Logon sallittu suhde enintään 5:1
-
-        painter->drawImage( QRectF( lahettajaAlue.x()+mm, lahettajaAlue.y()+mm, rk*2*skaala, rk*2 ),  kp()->logo()  );
-        vasen += rk * 2.2 * skaala;
+        painter->drawImage( QRectF( lahettajaAlue.x()+mm, lahettajaAlue.y()+mm, logo.width(), logo.height() ),  logo  );
+        vasen += logo.width() * 1.1;
 
     }
-    painter->setFont(QFont("Sans",14));
-    double pv = painter->fontMetrics().height();
-    QString nimi = kp()->asetukset()->onko("LogossaNimi") ? QString() : kp()->asetus("Nimi");   // Jos nimi logossa, sitä ei toisteta
-    QRectF lahettajaRect = painter->boundingRect( QRectF( lahettajaAlue.x()+vasen, lahettajaAlue.y(),
+    painter->setFont( pohja_->fontti(LaskuPohja::NIMI));
+    double pv = pohja_->rivikorkeus(LaskuPohja::NIMI);
+    QString nimi = kp()->asetukset()->onko("LogossaNimi") ? QString() : pohja_->nimi();   // Jos nimi logossa, sitä ei toisteta
+    QRectF lahettajaRect = pohja_->mittaa( LaskuPohja::NIMI, QRectF( lahettajaAlue.x()+vasen, lahettajaAlue.y(),
                                                        lahettajaAlue.width()-vasen, 20 * mm), Qt::TextWordWrap, nimi );
     painter->drawText(QRectF( lahettajaRect), Qt::AlignLeft | Qt::TextWordWrap, nimi);
 
-    painter->setFont(QFont("Sans",9));
-    QRectF lahettajaosoiteRect = painter->boundingRect( QRectF( lahettajaAlue.x()+vasen, lahettajaAlue.y() + lahettajaRect.height(),
-                                                       lahettajaAlue.width()-vasen, 20 * mm), Qt::TextWordWrap, kp()->asetus("Osoite") );
-    painter->drawText(lahettajaosoiteRect, Qt::AlignLeft, kp()->asetus("Osoite") );
+    painter->setFont( pohja_->fontti(LaskuPohja::OSOITE));
+    QRectF lahettajaosoiteRect = pohja_->mittaa( LaskuPohja::OSOITE, QRectF( lahettajaAlue.x()+vasen, lahettajaAlue.y() + lahettajaRect.height(),
+                                                       lahettajaAlue.width()-vasen, 20 * mm), Qt::TextWordWrap, pohja_->osoite() );
+    painter->drawText(lahettajaosoiteRect, Qt::AlignLeft, pohja_->osoite() );
 
     // Tulostetaan saajan osoite ikkunaan
-    painter->setFont(QFont("Sans", TEKSTIPT));
+    painter->setFont( pohja_->fontti(LaskuPohja::TEKSTI));
     painter->drawText(ikkuna, Qt::TextWordWrap, model_->osoite());
 
     pv += rk ;     // pv = perusviiva
@@ -369,7 +364,7 @@ void LaskunTulostaja::ylaruudukko(QPagedPaintDevice *printer, QPainter *painter)
     for(int i=1; i<6; i++)
         painter->drawLine(QLineF(keskiviiva, pv + i * rk, leveys, pv + i * rk));
 
-    painter->setFont( QFont("Sans",OTSAKEPT) );
+    painter->setFont( pohja_->fontti(LaskuPohja::OTSAKE) );
     if( model_->kirjausperuste() != LaskuModel::MAKSUPERUSTE)
     {
         painter->drawLine(QLineF(puoliviiva, pv-rk, puoliviiva, pv));
@@ -400,7 +395,7 @@ void LaskunTulostaja::ylaruudukko(QPagedPaintDevice *printer, QPainter *painter)
     painter->drawText(QRectF( puoliviiva + mm, pv + rk * 3 + mm, leveys / 4, rk ), Qt::AlignTop, tr("Viivästyskorko"));
     painter->drawText(QRectF( keskiviiva + mm, pv + rk * 4 + mm, leveys / 4, rk ), Qt::AlignTop, tr("Asiakkaan viite"));
 
-    painter->setFont(QFont("Sans", TEKSTIPT));
+    painter->setFont( pohja_->fontti(LaskuPohja::TEKSTI));
 
     // Haetaan tositetunniste
     if( model_->kirjausperuste() != LaskuModel::MAKSUPERUSTE)
@@ -435,7 +430,7 @@ void LaskunTulostaja::ylaruudukko(QPagedPaintDevice *printer, QPainter *painter)
         {
             painter->setFont( QFont("Sans", TEKSTIPT+2,QFont::Black));
             painter->drawText(QRectF( keskiviiva + mm, pv - rk * 2, leveys / 4, rk-mm ), Qt::AlignBottom,  tr("MAKSUMUISTUTUS") );
-            painter->setFont(QFont("Sans", TEKSTIPT));
+            painter->setFont( pohja_->fontti(LaskuPohja::TEKSTI));
         }
         else
             painter->drawText(QRectF( keskiviiva + mm, pv - rk * 2, leveys / 4, rk-mm ), Qt::AlignBottom,  tr("Lasku") );
@@ -462,24 +457,25 @@ void LaskunTulostaja::ylaruudukko(QPagedPaintDevice *printer, QPainter *painter)
 
 void LaskunTulostaja::lisatieto(QPainter *painter, const QString& lisatieto)
 {
-    painter->setFont( QFont("Sans", 10));
-    QRectF ltRect = painter->boundingRect(QRect(0,0,painter->window().width(), painter->window().height()), Qt::TextWordWrap, lisatieto );
+    painter->setFont( pohja_->fontti(LaskuPohja::TEKSTI));
+    QRectF ltRect = pohja_->mittaa(LaskuPohja::TEKSTI, QRect(0,0,painter->window().width(), painter->window().height()), Qt::TextWordWrap, lisatieto );
     painter->drawText(ltRect, Qt::TextWordWrap, lisatieto );
     if( ltRect.height() > 0 )
-        painter->translate( 0, ltRect.height() + painter->fontMetrics().height());  // Vähän väliä
+        painter->translate( 0, ltRect.height() + pohja_->rivikorkeus(LaskuPohja::TEKSTI));  // Vähän väliä
 
 
 }
 
 qreal LaskunTulostaja::alatunniste(QPagedPaintDevice *printer, QPainter *painter)
 {
-    painter->setFont( QFont("Sans",10));
-    qreal rk = painter->fontMetrics().height();
+    Q_UNUSED(printer);
+    painter->setFont( pohja_->fontti(LaskuPohja::ALATUNNISTE));
+    qreal rk = pohja_->rivikorkeus(LaskuPohja::ALATUNNISTE);
     painter->save();
     painter->translate(0, -2.5 * rk);
 
     qreal leveys = painter->window().width();
-    double mm = printer->width() * 1.00 / printer->widthMM();
+    double mm = pohja_->mm();
 
     if( !kp()->asetukset()->asetus("Puhelin").isEmpty() )
         painter->drawText(QRectF(0,0,leveys/3,rk), Qt::AlignLeft, tr("Puh. %1").arg(kp()->asetus("Puhelin")));
@@ -523,12 +519,12 @@ void LaskunTulostaja::erittely(LaskuModel *model, QPagedPaintDevice *printer, QP
 {
     bool alv = kp()->asetukset()->onko("AlvVelvollinen");
     erittelyOtsikko(printer, painter, alv);
-    double mm = printer->width() * 1.00 / printer->widthMM();
+    double mm = pohja_->mm();
 
-    painter->setFont( QFont("Sans",10));
+    painter->setFont( pohja_->fontti(LaskuPohja::TEKSTI));
     qreal leveys = painter->window().width();
     qreal korkeus = painter->window().height() - marginaali;
-    qreal rk = painter->fontMetrics().height();
+    qreal rk = pohja_->rivikorkeus(LaskuPohja::TEKSTI);
     qreal kokoNetto = 0.0;
     qreal kokoVero = 0.0;
 
@@ -561,7 +557,8 @@ void LaskunTulostaja::erittely(LaskuModel *model, QPagedPaintDevice *printer, QP
         kokoVero += verosnt;
 
 
-        QRectF rect = alv ? painter->boundingRect(QRectF(0,0, 5 * leveys/16, leveys), Qt::TextWordWrap, nimike ) : painter->boundingRect(QRectF(0,0,5*leveys/8, leveys), Qt::TextWordWrap, nimike );
+        // Rivin korkeus mitataan valmiiksi lasketuilla fonttimetriikoilla
+        QRectF rect = pohja_->mittaa(LaskuPohja::TEKSTI, QRectF(0,0, alv ? 5 * leveys/16 : 5 * leveys/8, leveys), Qt::TextWordWrap, nimike );
 
         qreal tamarivi = rect.height() > 0.0 ? rect.height() : rk;
         if( tamarivi + painter->transform().dy() > korkeus - 4 * rk )
@@ -571,6 +568,7 @@ void LaskunTulostaja::erittely(LaskuModel *model, QPagedPaintDevice *printer, QP
             painter->resetTransform();
             korkeus = painter->window().height();
             erittelyOtsikko(printer, painter, alv);
+            painter->setFont( pohja_->fontti(LaskuPohja::TEKSTI));
         }
         painter->drawText(rect, Qt::TextWordWrap, nimike);
 
@@ -642,10 +640,11 @@ void LaskunTulostaja::erittely(LaskuModel *model, QPagedPaintDevice *printer, QP
 
 void LaskunTulostaja::erittelyOtsikko(QPagedPaintDevice *printer, QPainter *painter, bool alv)
 {
-    painter->setFont( QFont("Sans",8));
-    qreal rk = painter->fontMetrics().height();
+    Q_UNUSED(printer);
+    painter->setFont( pohja_->fontti(LaskuPohja::ERITTELYOTSIKKO));
+    qreal rk = pohja_->rivikorkeus(LaskuPohja::ERITTELYOTSIKKO);
     qreal leveys = painter->window().width();
-    double mm = printer->width() * 1.00 / printer->widthMM();
+    double mm = pohja_->mm();
 
     painter->drawText(QRectF(0,0,leveys/2,rk), Qt::AlignLeft, tr("Nimike"));
 
@@ -671,57 +670,21 @@ void LaskunTulostaja::erittelyOtsikko(QPagedPaintDevice *printer, QPainter *pain
 
 void LaskunTulostaja::tilisiirto(QPagedPaintDevice *printer, QPainter *painter)
 {
-    painter->setFont(QFont("Sans", 7));
-    double mm = printer->width() * 1.00 / printer->widthMM();
+    double mm = pohja_->mm();
 
-    // QR-koodi
+    // QR-koodi piirretään suoraan vektoreina
     if( !kp()->asetukset()->onko("LaskuEiQR"))
     {
-        QByteArray qrTieto = qrSvg();
+        QString qrTieto = qrData();
         if( !qrTieto.isEmpty())
-        {
-            QSvgRenderer qrr( qrTieto );
-            qrr.render( painter, QRectF( ( printer->widthMM() - 35 ) *mm, 5 * mm, 30 * mm, 30 * mm  ) );
-        }
+            painter->fillPath( LaskuPohja::qrPolku( qrTieto, QRectF( ( printer->widthMM() - 35 ) *mm, 5 * mm, 30 * mm, 30 * mm  ) ),
+                               QBrush(Qt::black));
     }
 
-    painter->drawText( QRectF(0,0,mm*19,mm*16.9), Qt::AlignRight | Qt::AlignHCenter, tr("Saajan\n tilinumero\n Mottagarens\n kontonummer"));
-    painter->drawText( QRectF(0, mm*18, mm*19, mm*14.8), Qt::AlignRight | Qt::AlignHCenter, tr("Saaja\n Mottagare"));
-    painter->drawText( QRectF(0, mm*32.7, mm*19, mm*20), Qt::AlignRight | Qt::AlignTop, tr("Maksajan\n nimi ja\n osoite\n Betalarens\n namn och\n address"));
-    painter->drawText( QRectF(0, mm*51.3, mm*19, mm*10), Qt::AlignRight | Qt::AlignBottom , tr("Allekirjoitus\n Underskrift"));
-    painter->drawText( QRectF(0, mm*62.3, mm*19, mm*8.5), Qt::AlignRight | Qt::AlignHCenter, tr("Tililtä nro\n Från konto nr"));
-    painter->drawText( QRectF(mm * 22, 0, mm*20, mm*10), Qt::AlignLeft, tr("IBAN"));
-
-    painter->drawText( QRectF(mm*112.4, mm*53.8, mm*15, mm*8.5), Qt::AlignLeft | Qt::AlignTop, tr("Viitenumero\nRef.nr."));
-    painter->drawText( QRectF(mm*112.4, mm*62.3, mm*15, mm*8.5), Qt::AlignLeft | Qt::AlignTop, tr("Eräpäivä\nFörfallodag"));
-    painter->drawText( QRectF(mm*159, mm*62.3, mm*19, mm*8.5), Qt::AlignLeft, tr("Euro"));
-
-
-    painter->setFont(QFont("Sans",6));
-    painter->drawText( QRectF( mm * 140, mm * 72, mm * 60, mm * 20), Qt::AlignLeft | Qt::TextWordWrap, tr("Maksu välitetään saajalle maksujenvälityksen ehtojen "
-                                                                                                          "mukaisesti ja vain maksajan ilmoittaman tilinumeron perusteella.\n"
-                                                                                                          "Betalning förmedlas till mottagaren enligt villkoren för "
-                                                                                                          "betalningsförmedling och endast till det kontonummer som "
-                                                                                                          "betalaren angivit.") );
-    painter->setPen( QPen( QBrush(Qt::black), mm * 0.5));
-    painter->drawLine(QLineF(mm*111.4,0,mm*111.4,mm*69.8));
-    painter->drawLine(QLineF(0, mm*16.9, mm*111.4, mm*16.9));
-    painter->drawLine(QLineF(0, mm*31.7, mm*111.4, mm*31.7));
-    painter->drawLine(QLineF(mm*20, 0, mm*20, mm*31.7));
-    painter->drawLine(QLineF(0, mm*61.3, mm*200, mm*61.3));
-    painter->drawLine(QLineF(0, mm*69.8, mm*200, mm*69.8));
-    painter->drawLine(QLineF(mm*111.4, mm*52.8, mm*200, mm*52.8));
-    painter->drawLine(QLineF(mm*131.4, mm*52.8, mm*131.4, mm*69.8));
-    painter->drawLine(QLineF(mm*158, mm*61.3, mm*158, mm*69.8));
-    painter->drawLine(QLineF(mm*20, mm*61.3, mm*20, mm*69.8));
+    // Lomakkeen kiinteät tekstit ja viivat sekä saajan tiedot
+    pohja_->piirraTilisiirtopohja(painter);
 
-    painter->setPen( QPen(QBrush(Qt::black), mm * 0.13));
-    painter->drawLine( QLineF( mm*22, mm*57.1, mm*108, mm*57.1));
-
-    painter->setPen( QPen(QBrush(Qt::black), mm * 0.13, Qt::DashLine));
-    painter->drawLine( QLineF( 0, -1 * mm, painter->window().width(), -1 * mm));
-
-    painter->setFont(QFont("Sans", 10));
+    painter->setFont( pohja_->fontti(LaskuPohja::TEKSTI));
 
     painter->drawText(QRectF( mm*22, mm * 33, mm * 90, mm * 25), Qt::TextWordWrap, model_->osoite());
 
@@ -730,82 +693,27 @@ void LaskunTulostaja::tilisiirto(QPagedPaintDevice *printer, QPainter *painter)
     painter->drawText( QRectF(mm*133.4, mm*62.3, mm*30, mm*7.5), Qt::AlignLeft | Qt::AlignBottom, model_->erapaiva().toString("dd.MM.yyyy") );
     painter->drawText( QRectF(mm*165, mm*62.3, mm*30, mm*7.5), Qt::AlignRight | Qt::AlignBottom, QString("%L1").arg( (model_->laskunSumma() / 100.0) ,0,'f',2) );
 
-    painter->drawText( QRectF(mm*22, mm*17, mm*90, mm*13), Qt::AlignTop | Qt::TextWordWrap, kp()->asetus("Nimi") + "\n" + kp()->asetus("Osoite")  );
-    painter->drawText( QRectF(mm*22, 0, mm*90, mm*17), Qt::AlignVCenter ,  valeilla( iban )  );
-
-
-    painter->save();
-    painter->setFont(QFont("Sans", 7));
-    painter->translate(mm * 2, mm* 60);
-    painter->rotate(-90.0);
-    painter->drawText(0,0,tr("TILISIIRTO. GIRERING"));
-    painter->restore();
-
     // Viivakoodi
     if( !kp()->asetukset()->onko("LaskuEiViivakoodi"))
-    {
-        painter->save();
-
-        QFont koodifontti( "code128_XL", 36);
-        koodifontti.setLetterSpacing(QFont::AbsoluteSpacing, 0.0);
-        painter->setFont( koodifontti);
-        QString koodi( code128() );
-        painter->drawText( QRectF( mm*20, mm*72, mm*100, mm*13), Qt::AlignCenter, koodi  );
-
-        painter->restore();
-    }
+        painter->fillPath( LaskuPohja::viivakoodiPolku( virtuaaliviivakoodi(), QRectF( mm*20, mm*72, mm*100, mm*13) ),
+                           QBrush(Qt::black));
 }
 
-QString LaskunTulostaja::code128() const
-{
-    QString koodi;
-    koodi.append( QChar(210) );   // Code C aloitusmerkki
-
-    int summa = 105;
-    int paino = 1;
-
-    QString koodattava = virtuaaliviivakoodi();
-    if( koodattava.length() != 54)  // Pitää olla kelpo virtuaalikoodi
-        return QString();
-
-    for(int i = 0; i < koodattava.length(); i = i + 2)
-    {
-        int luku = koodattava.at(i).digitValue()*10 + koodattava.at(i+1).digitValue();
-        koodi.append( code128c(luku) );
-        summa += paino * luku;
-        paino++;
-    }
-
-    koodi.append( code128c( summa % 103 ) );
-    koodi.append( QChar(211) );
-
-    return koodi;
-}
-
-QChar LaskunTulostaja::code128c(int koodattava) const
-{
-    if( koodattava < 95)
-        return QChar( 32 + koodattava);
-    else
-        return QChar( 105 + koodattava);
-}
-
-QByteArray LaskunTulostaja::qrSvg() const
+QString LaskunTulostaja::qrData() const
 {
     // Esitettävä tieto
     QString data("BCD\n001\n1\nSCT\n");
 
-    QString bic = LaskutModel::bicIbanilla(iban);
+    QString bic = pohja_->bic();
     if( bic.isEmpty())
-        return QByteArray();
+        return QString();
     data.append(bic + "\n");
-    data.append(kp()->asetukset()->asetus("Nimi") + "\n");
+    data.append(pohja_->nimi() + "\n");
     data.append(iban + "\n");
     data.append( QString("EUR%1.%2\n\n").arg( model_->laskunSumma() / 100 ).arg( model_->laskunSumma() % 100, 2, 10, QChar('0') ));
     data.append(model_->viitenumero().remove(QChar(' ')) + "\n\n");
     data.append( QString("ReqdExctnDt/%1").arg( model_->erapaiva().toString(Qt::ISODate) ));
 
-    qrcodegen::QrCode qr = qrcodegen::QrCode::encodeText( data.toUtf8().data() , qrcodegen::QrCode::Ecc::QUARTILE);
-    return QByteArray::fromStdString( qr.toSvgString(1) );
+    return data;
 }
 
@@ -24,6 +24,7 @@
 #include <QFile>
 
 #include "laskumodel.h"
+#include "laskupohja.h"
 
 /**
  * @brief Laskuntulostajan alv-erittelyä varten
@@ -78,25 +79,14 @@ protected:
     QString iban;
 
     /**
-     * @brief Pankkiviivakoodi valmiiksi code128-koodattuna
-     * @return
-     */
-    QString code128() const;
-    /**
-     * @brief Code 128C viivakoodin merkki joka vastaa annettua numeroparia
-     * @param koodattava
-     * @return
-     */
-    QChar code128c(int koodattava) const;
-
-    /**
-     * @brief QR-koodi SVG-muodossa
-     * @return
+     * @brief QR-koodiin tuleva tilisiirron tieto
+     * @return Tyhjä, ellei BIC-tunnusta tunneta
      */
-    QByteArray qrSvg() const;
+    QString qrData() const;
 
 private:
     LaskuModel *model_;
+    LaskuPohja *pohja_;
 
 };
 
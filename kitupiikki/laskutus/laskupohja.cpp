@@ -0,0 +1,279 @@
+/*
+   Copyright (C) 2018 Arto Hyvättinen
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QPagedPaintDevice>
+#include <QPainter>
+#include <QFontMetrics>
+#include <QStringList>
+
+#include "laskupohja.h"
+#include "laskutmodel.h"
+#include "laskuntulostaja.h"
+#include "db/kirjanpito.h"
+#include "nayukiQR/QrCode.hpp"
+
+namespace {
+
+/**
+ * @brief Code 128 -merkkien viiva- ja välileveydet moduuleina
+ *
+ * Indeksi on merkin arvo 0..105, jokaisen merkin leveys on 11 moduulia
+ */
+const char* const CODE128_KUVIOT[] = {
+    "212222", "222122", "222221", "121223", "121322", "131222", "122213", "122312", "132212", "221213",
+    "221312", "231212", "112232", "122132", "122231", "113222", "123122", "123221", "223211", "221132",
+    "221231", "213212", "223112", "312131", "311222", "321122", "321221", "312212", "322112", "322211",
+    "212123", "212321", "232121", "111323", "131123", "131321", "112313", "132113", "132311", "211313",
+    "231113", "231311", "112133", "112331", "132131", "113123", "113321", "133121", "313121", "211331",
+    "231131", "213113", "213311", "213131", "311123", "311321", "331121", "312113", "312311", "332111",
+    "314111", "221411", "431111", "111224", "111422", "121124", "121421", "141122", "141221", "112214",
+    "112412", "122114", "122411", "142112", "142211", "241211", "221114", "413111", "241112", "134111",
+    "111242", "121142", "121241", "114212", "124112", "124211", "411212", "421112", "421211", "212141",
+    "214121", "412121", "111143", "111341", "131141", "114113", "114311", "411113", "411311", "113141",
+    "114131", "311141", "411131", "211412", "211214", "211232"
+};
+
+const char* const CODE128_LOPPU = "2331112";
+const int CODE128_ALOITUS_C = 105;
+
+}
+
+LaskuPohja::LaskuPohja()
+{
+    for(int i=0; i < FONTTEJA; i++)
+        korkeudet_[i] = 0.0;
+}
+
+void LaskuPohja::valmistele(QPagedPaintDevice *printer, QPainter *painter)
+{
+    QString uusiTunniste = tunniste(printer, painter);
+    if( uusiTunniste == tunniste_ )
+        return;     // Pohja on jo valmiina tälle laitteelle
+
+    tunniste_ = uusiTunniste;
+    mm_ = printer->width() * 1.00 / printer->widthMM();
+
+    fontit_[OTSAKE] = QFont("Sans", 7);
+    fontit_[TEKSTI] = QFont("Sans", 10);
+    fontit_[NIMI] = QFont("Sans", 14);
+    fontit_[OSOITE] = QFont("Sans", 9);
+    fontit_[ALATUNNISTE] = QFont("Sans", 10);
+    fontit_[ERITTELYOTSIKKO] = QFont("Sans", 8);
+    fontit_[TILISIIRTO] = QFont("Sans", 7);
+    fontit_[TILISIIRTOPIENI] = QFont("Sans", 6);
+
+    // Rivikorkeudet lasketaan laitteen mukaan, jotta toimii myös pdf-writerillä
+    metriikat_.clear();
+    for(int i=0; i < FONTTEJA; i++)
+    {
+        korkeudet_[i] = QFontMetrics( fontit_[i], printer ).height();
+        metriikat_.append( QFontMetricsF( fontit_[i], printer ));
+    }
+
+    iban_ = kp()->tilit()->tiliNumerolla( kp()->asetukset()->luku("LaskuTili")).json()->str("IBAN");
+    bic_ = LaskutModel::bicIbanilla( iban_ );
+    nimi_ = kp()->asetus("Nimi");
+    osoite_ = kp()->asetus("Osoite");
+
+    logo_ = QImage();
+    logonKorkeus_ = 0.0;
+
+    // Tilisiirtolomakkeen kiinteät tekstit
+    double mm = mm_;
+    tilisiirtoTekstit_.clear();
+
+    tilisiirtoTekstit_.append( PohjaTeksti( QRectF(0,0,mm*19,mm*16.9), Qt::AlignRight | Qt::AlignHCenter, tr("Saajan\n tilinumero\n Mottagarens\n kontonummer"), TILISIIRTO));
+    tilisiirtoTekstit_.append( PohjaTeksti( QRectF(0, mm*18, mm*19, mm*14.8), Qt::AlignRight | Qt::AlignHCenter, tr("Saaja\n Mottagare"), TILISIIRTO));
+    tilisiirtoTekstit_.append( PohjaTeksti( QRectF(0, mm*32.7, mm*19, mm*20), Qt::AlignRight | Qt::AlignTop, tr("Maksajan\n nimi ja\n osoite\n Betalarens\n namn och\n address"), TILISIIRTO));
+    tilisiirtoTekstit_.append( PohjaTeksti( QRectF(0, mm*51.3, mm*19, mm*10), Qt::AlignRight | Qt::AlignBottom , tr("Allekirjoitus\n Underskrift"), TILISIIRTO));
+    tilisiirtoTekstit_.append( PohjaTeksti( QRectF(0, mm*62.3, mm*19, mm*8.5), Qt::AlignRight | Qt::AlignHCenter, tr("Tililtä nro\n Från konto nr"), TILISIIRTO));
+    tilisiirtoTekstit_.append( PohjaTeksti( QRectF(mm * 22, 0, mm*20, mm*10), Qt::AlignLeft, tr("IBAN"), TILISIIRTO));
+
+    tilisiirtoTekstit_.append( PohjaTeksti( QRectF(mm*112.4, mm*53.8, mm*15, mm*8.5), Qt::AlignLeft | Qt::AlignTop, tr("Viitenumero\nRef.nr."), TILISIIRTO));
+    tilisiirtoTekstit_.append( PohjaTeksti( QRectF(mm*112.4, mm*62.3, mm*15, mm*8.5), Qt::AlignLeft | Qt::AlignTop, tr("Eräpäivä\nFörfallodag"), TILISIIRTO));
+    tilisiirtoTekstit_.append( PohjaTeksti( QRectF(mm*159, mm*62.3, mm*19, mm*8.5), Qt::AlignLeft, tr("Euro"), TILISIIRTO));
+
+    tilisiirtoTekstit_.append( PohjaTeksti( QRectF( mm * 140, mm * 72, mm * 60, mm * 20), Qt::AlignLeft | Qt::TextWordWrap,
+                                            tr("Maksu välitetään saajalle maksujenvälityksen ehtojen "
+                                               "mukaisesti ja vain maksajan ilmoittaman tilinumeron perusteella.\n"
+                                               "Betalning förmedlas till mottagaren enligt villkoren för "
+                                               "betalningsförmedling och endast till det kontonummer som "
+                                               "betalaren angivit."), TILISIIRTOPIENI ));
+
+    // Saajan tiedot ovat kaikilla laskuilla samat
+    tilisiirtoTekstit_.append( PohjaTeksti( QRectF(mm*22, mm*17, mm*90, mm*13), Qt::AlignTop | Qt::TextWordWrap, nimi_ + "\n" + osoite_, TEKSTI));
+    tilisiirtoTekstit_.append( PohjaTeksti( QRectF(mm*22, 0, mm*90, mm*17), Qt::AlignVCenter, LaskunTulostaja::valeilla(iban_), TEKSTI));
+
+    // Tilisiirtolomakkeen viivat
+    tilisiirtoViivat_.clear();
+    tilisiirtoViivat_.append( PohjaViiva( QLineF(mm*111.4,0,mm*111.4,mm*69.8), mm * 0.5));
+    tilisiirtoViivat_.append( PohjaViiva( QLineF(0, mm*16.9, mm*111.4, mm*16.9), mm * 0.5));
+    tilisiirtoViivat_.append( PohjaViiva( QLineF(0, mm*31.7, mm*111.4, mm*31.7), mm * 0.5));
+    tilisiirtoViivat_.append( PohjaViiva( QLineF(mm*20, 0, mm*20, mm*31.7), mm * 0.5));
+    tilisiirtoViivat_.append( PohjaViiva( QLineF(0, mm*61.3, mm*200, mm*61.3), mm * 0.5));
+    tilisiirtoViivat_.append( PohjaViiva( QLineF(0, mm*69.8, mm*200, mm*69.8), mm * 0.5));
+    tilisiirtoViivat_.append( PohjaViiva( QLineF(mm*111.4, mm*52.8, mm*200, mm*52.8), mm * 0.5));
+    tilisiirtoViivat_.append( PohjaViiva( QLineF(mm*131.4, mm*52.8, mm*131.4, mm*69.8), mm * 0.5));
+    tilisiirtoViivat_.append( PohjaViiva( QLineF(mm*158, mm*61.3, mm*158, mm*69.8), mm * 0.5));
+    tilisiirtoViivat_.append( PohjaViiva( QLineF(mm*20, mm*61.3, mm*20, mm*69.8), mm * 0.5));
+
+    tilisiirtoViivat_.append( PohjaViiva( QLineF( mm*22, mm*57.1, mm*108, mm*57.1), mm * 0.13));
+    tilisiirtoViivat_.append( PohjaViiva( QLineF( 0, -1 * mm, painter->window().width(), -1 * mm), mm * 0.13, Qt::DashLine));
+}
+
+QRectF LaskuPohja::mittaa(LaskuPohja::Fontti fontti, const QRectF &alue, int liput, const QString &teksti) const
+{
+    return metriikat_.at(fontti).boundingRect(alue, liput, teksti);
+}
+
+QImage LaskuPohja::logo(qreal korkeus)
+{
+    if( kp()->logo().isNull())
+        return QImage();
+
+    if( logo_.isNull() || !qFuzzyCompare( korkeus, logonKorkeus_))
+    {
+        double logosuhde = (1.0 * kp()->logo().width() ) / kp()->logo().height();
+        double skaala = logosuhde < 5.00 ? logosuhde : 5.00;    // Logon sallittu suhde enintään 5:1
+
+        logo_ = kp()->logo().scaled( qRound( korkeus * skaala ), qRound( korkeus ),
+                                     Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        logonKorkeus_ = korkeus;
+    }
+    return logo_;
+}
+
+void LaskuPohja::piirraTilisiirtopohja(QPainter *painter) const
+{
+    painter->save();
+
+    for(const PohjaTeksti& teksti : tilisiirtoTekstit_)
+    {
+        painter->setFont( fontit_[teksti.fontti_]);
+        painter->drawText( teksti.alue_, teksti.liput_, teksti.teksti_);
+    }
+
+    for(const PohjaViiva& viiva : tilisiirtoViivat_)
+    {
+        painter->setPen( QPen( QBrush(Qt::black), viiva.paksuus_, viiva.tyyli_));
+        painter->drawLine( viiva.viiva_ );
+    }
+
+    painter->setFont( fontit_[TILISIIRTO] );
+    painter->translate(mm_ * 2, mm_ * 60);
+    painter->rotate(-90.0);
+    painter->drawText(0,0,tr("TILISIIRTO. GIRERING"));
+
+    painter->restore();
+}
+
+QPainterPath LaskuPohja::qrPolku(const QString &data, const QRectF &alue)
+{
+    QPainterPath polku;
+    polku.setFillRule( Qt::WindingFill );
+
+    qrcodegen::QrCode qr = qrcodegen::QrCode::encodeText( data.toUtf8().data() , qrcodegen::QrCode::Ecc::QUARTILE);
+    int koko = qr.getSize();
+    if( koko < 1)
+        return polku;
+
+    // Koodin ympärillä on yhden moduulin reunus
+    qreal moduuli = qMin( alue.width(), alue.height() ) / ( koko + 2 );
+
+    for(int y=0; y < koko; y++)
+    {
+        // Vierekkäiset tummat moduulit yhdistetään yhdeksi suorakaiteeksi
+        int alku = -1;
+        for(int x=0; x <= koko; x++)
+        {
+            bool tumma = x < koko && qr.getModule(x, y);
+            if( tumma && alku < 0)
+                alku = x;
+            else if( !tumma && alku > -1)
+            {
+                polku.addRect( alue.x() + ( alku + 1 ) * moduuli, alue.y() + ( y + 1 ) * moduuli,
+                               ( x - alku ) * moduuli, moduuli );
+                alku = -1;
+            }
+        }
+    }
+    return polku;
+}
+
+QPainterPath LaskuPohja::viivakoodiPolku(const QString &virtuaaliviivakoodi, const QRectF &alue)
+{
+    QPainterPath polku;
+
+    if( virtuaaliviivakoodi.length() != 54)  // Pitää olla kelpo virtuaalikoodi
+        return polku;
+
+    // Code 128C: aloitusmerkki, numeroparit, tarkiste ja lopetusmerkki
+    QList<int> arvot;
+    arvot.append( CODE128_ALOITUS_C );
+
+    int summa = CODE128_ALOITUS_C;
+    int paino = 1;
+
+    for(int i = 0; i < virtuaaliviivakoodi.length(); i = i + 2)
+    {
+        int luku = virtuaaliviivakoodi.at(i).digitValue()*10 + virtuaaliviivakoodi.at(i+1).digitValue();
+        if( luku < 0 )
+            return polku;
+        arvot.append( luku );
+        summa += paino * luku;
+        paino++;
+    }
+    arvot.append( summa % 103 );
+
+    QStringList kuviot;
+    for(int arvo : arvot)
+        kuviot.append( QString::fromLatin1( CODE128_KUVIOT[arvo] ));
+    kuviot.append( QString::fromLatin1( CODE128_LOPPU ));
+
+    // Merkit ovat 11 moduulin levyisiä, lopetusmerkki 13 moduulia.
+    // Molemmille puolille jätetään kymmenen moduulin tyhjä alue.
+    int moduuleja = 11 * arvot.count() + 13;
+    qreal moduuli = alue.width() / ( moduuleja + 20 );
+    qreal x = alue.x() + ( alue.width() - moduuleja * moduuli ) / 2;
+
+    for(const QString& kuvio : kuviot)
+    {
+        for(int i=0; i < kuvio.length(); i++)
+        {
+            qreal leveys = kuvio.at(i).digitValue() * moduuli;
+            if( i % 2 == 0)     // Parilliset ovat viivoja, parittomat välejä
+                polku.addRect( x, alue.y(), leveys, alue.height());
+            x += leveys;
+        }
+    }
+    return polku;
+}
+
+QString LaskuPohja::tunniste(QPagedPaintDevice *printer, QPainter *painter) const
+{
+    QStringList tunniste;
+    tunniste << QString::number( printer->width() )
+             << QString::number( printer->height() )
+             << QString::number( printer->widthMM() )
+             << QString::number( painter->window().width() )
+             << QString::number( painter->window().height() )
+             << QString::number( kp()->logo().cacheKey() )
+             << kp()->tilit()->tiliNumerolla( kp()->asetukset()->luku("LaskuTili")).json()->str("IBAN")
+             << kp()->asetus("Nimi")
+             << kp()->asetus("Osoite");
+    return tunniste.join('\n');
+}
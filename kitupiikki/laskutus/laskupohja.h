@@ -0,0 +1,153 @@
+/*
+   Copyright (C) 2018 Arto Hyvättinen
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LASKUPOHJA_H
+#define LASKUPOHJA_H
+
+#include <QCoreApplication>
+#include <QFont>
+#include <QFontMetricsF>
+#include <QImage>
+#include <QList>
+#include <QPainterPath>
+#include <QRectF>
+#include <QLineF>
+
+class QPagedPaintDevice;
+class QPainter;
+
+/**
+ * @brief Laskun tulostuksen uudelleenkäytettävä pohja
+ *
+ * Säilyttää laskusta toiseen samana pysyvät tiedot: fontit ja niiden
+ * rivikorkeudet tulostuslaitteella, skaalatun logon, kirjanpidon
+ * yhteystiedot sekä tilisiirtolomakkeen kiinteät tekstit ja viivat.
+ *
+ * Pohja lasketaan uudelleen vain, kun tulostuslaite, logo tai
+ * laskulle tulostuvat asetukset muuttuvat. Näin ryhmälaskuja
+ * tulostettaessa jokaiselle laskulle lasketaan vain laskukohtaiset tiedot.
+ *
+ * @since 1.1
+ */
+class LaskuPohja
+{
+    Q_DECLARE_TR_FUNCTIONS(LaskuPohja)
+
+public:
+    enum Fontti { OTSAKE, TEKSTI, NIMI, OSOITE, ALATUNNISTE, ERITTELYOTSIKKO, TILISIIRTO, TILISIIRTOPIENI, FONTTEJA };
+
+    LaskuPohja();
+
+    /**
+     * @brief Päivittää pohjan annetulle laitteelle, ellei se ole jo ajan tasalla
+     * @param printer Tulostuslaite
+     * @param painter Tulostuksen painter
+     */
+    void valmistele(QPagedPaintDevice *printer, QPainter *painter);
+
+    double mm() const { return mm_; }
+    const QFont& fontti(Fontti fontti) const { return fontit_[fontti]; }
+    /**
+     * @brief Fontin rivikorkeus tulostuslaitteella
+     */
+    qreal rivikorkeus(Fontti fontti) const { return korkeudet_[fontti]; }
+    /**
+     * @brief Mittaa tekstin tarvitseman alueen ilman painterin tilan muuttamista
+     */
+    QRectF mittaa(Fontti fontti, const QRectF& alue, int liput, const QString& teksti) const;
+
+    /**
+     * @brief Logo valmiiksi skaalattuna tulostuskokoon
+     * @param korkeus Logon korkeus laitteen yksiköissä
+     * @return Tyhjä kuva, jos logoa ei ole
+     */
+    QImage logo(qreal korkeus);
+
+    QString iban() const { return iban_; }
+    QString bic() const { return bic_; }
+    QString nimi() const { return nimi_; }
+    QString osoite() const { return osoite_; }
+
+    /**
+     * @brief Piirtää tilisiirtolomakkeen kiinteät osat
+     *
+     * Painterin origo on tilisiirtolomakkeen vasemmassa yläkulmassa
+     */
+    void piirraTilisiirtopohja(QPainter *painter) const;
+
+    /**
+     * @brief QR-koodi vektoripolkuna
+     * @param data Koodattava tieto
+     * @param alue Alue, johon koodi mahtuu (yhden moduulin reunus mukaan lukien)
+     * @return Tyhjä polku, jos koodaaminen ei onnistu
+     */
+    static QPainterPath qrPolku(const QString& data, const QRectF& alue);
+
+    /**
+     * @brief Pankkiviivakoodi (Code 128C) vektoripolkuna
+     * @param virtuaaliviivakoodi 54-numeroinen virtuaaliviivakoodi
+     * @param alue Alue, jonka keskelle viivakoodi piirretään
+     * @return Tyhjä polku, ellei koodi ole kelvollinen
+     */
+    static QPainterPath viivakoodiPolku(const QString& virtuaaliviivakoodi, const QRectF& alue);
+
+private:
+    QString tunniste(QPagedPaintDevice *printer, QPainter *painter) const;
+
+    struct PohjaTeksti
+    {
+        PohjaTeksti() {}
+        PohjaTeksti(const QRectF& alue, int liput, const QString& teksti, Fontti fontti) :
+            alue_(alue), liput_(liput), teksti_(teksti), fontti_(fontti) {}
+
+        QRectF alue_;
+        int liput_ = 0;
+        QString teksti_;
+        Fontti fontti_ = TILISIIRTO;
+    };
+
+    struct PohjaViiva
+    {
+        PohjaViiva() {}
+        PohjaViiva(const QLineF& viiva, qreal paksuus, Qt::PenStyle tyyli = Qt::SolidLine) :
+            viiva_(viiva), paksuus_(paksuus), tyyli_(tyyli) {}
+
+        QLineF viiva_;
+        qreal paksuus_ = 0.0;
+        Qt::PenStyle tyyli_ = Qt::SolidLine;
+    };
+
+    QString tunniste_;
+    double mm_ = 1.0;
+
+    QFont fontit_[FONTTEJA];
+    qreal korkeudet_[FONTTEJA];
+    QList<QFontMetricsF> metriikat_;
+
+    QImage logo_;
+    qreal logonKorkeus_ = 0.0;
+
+    QString iban_;
+    QString bic_;
+    QString nimi_;
+    QString osoite_;
+
+    QList<PohjaTeksti> tilisiirtoTekstit_;
+    QList<PohjaViiva> tilisiirtoViivat_;
+};
+
+#endif // LASKUPOHJA_H
@@ -102,6 +102,13 @@ QVariant LaskuRyhmaModel::data(const QModelIndex &index, int role) const
     {
         if( ryhma_.at(index.row()).lahetetty)
             return QIcon(":/pic/ok.png");
+        if( !ryhma_.at(index.row()).lahetysvirhe.isEmpty())
+            return QIcon(":/pic/varoitus.png");
+    }
+    else if( role == Qt::ToolTipRole && index.column() == SAHKOPOSTI)
+    {
+        if( !ryhma_.at(index.row()).lahetysvirhe.isEmpty())
+            return tr("Lähetys epäonnistui: %1").arg( ryhma_.at(index.row()).lahetysvirhe );
     }
     else if( role == Qt::DecorationRole && index.column() == NIMI)
     {
@@ -157,6 +164,13 @@ bool LaskuRyhmaModel::onkoNimella(const QString &nimi)
 void LaskuRyhmaModel::sahkopostiLahetetty(int indeksiin)
 {
     ryhma_[indeksiin].lahetetty = true;
+    ryhma_[indeksiin].lahetysvirhe.clear();
+    emit dataChanged( index(indeksiin, SAHKOPOSTI), index(indeksiin, SAHKOPOSTI) );
+}
+
+void LaskuRyhmaModel::sahkopostiEpaonnistui(int indeksiin, const QString &virhe)
+{
+    ryhma_[indeksiin].lahetysvirhe = virhe;
     emit dataChanged( index(indeksiin, SAHKOPOSTI), index(indeksiin, SAHKOPOSTI) );
 }
 
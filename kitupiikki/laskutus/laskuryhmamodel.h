@@ -31,6 +31,7 @@ struct Laskutettava
     QString verkkolaskuosoite;
     QString verkkolaskuvalittaja;
     bool lahetetty = false;
+    QString lahetysvirhe;
     bool verkkolaskutettu = false;
 };
 
@@ -72,6 +73,7 @@ public:
     void poista(int indeksi);
     bool onkoNimella(const QString& nimi);
     void sahkopostiLahetetty(int indeksiin);
+    void sahkopostiEpaonnistui(int indeksiin, const QString& virhe);
     void finvoiceMuodostettu(int indeksiin);
 
     bool canDropMimeData(const QMimeData* data, Qt::DropAction action, int row, int column, const QModelIndex &parent) const override;
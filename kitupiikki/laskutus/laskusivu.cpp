@@ -23,6 +23,7 @@
 #include "laskudialogi.h"
 #include "db/kirjanpito.h"
 #include "db/tositemodel.h"
+#include "db/vientimodel.h"
 #include "lisaikkuna.h"
 #include "naytin/naytinikkuna.h"
 #include "yhteystietowidget.h"
@@ -85,7 +86,7 @@ LaskuSivu::LaskuSivu()
              this, &LaskuSivu::asiakasValintaMuuttuu);
     connect( mistaEdit_, &QDateEdit::dateChanged, this, &LaskuSivu::paivitaLaskulista);
     connect( mihinEdit_, &QDateEdit::dateChanged, this, &LaskuSivu::paivitaLaskulista);
-    connect( kp(), &Kirjanpito::kirjanpitoaMuokattu, this, &LaskuSivu::paivitaLaskulista);
+    connect( kp(), &Kirjanpito::tositeMuuttui, this, &LaskuSivu::paivitaTosite);
     connect( laskuView_->selectionModel(), &QItemSelectionModel::selectionChanged,
              this, &LaskuSivu::laskuValintaMuuttuu);
 
@@ -115,6 +116,7 @@ void LaskuSivu::paaTab(int indeksi)
     else if(indeksi != ASIAKAS && lajiTab_->count() == 4)
         lajiTab_->removeTab(TIEDOT);
     uusiAsiakasNappi_->setVisible(indeksi == ASIAKAS);
+    yhteystiedot_->asetaToimittaja(indeksi == TOIMITTAJA);
 
     if( indeksi ==  ASIAKAS)
         asiakasmodel_->paivita(false);
@@ -166,6 +168,18 @@ void LaskuSivu::paivitaLaskulista()
     }
 }
 
+void LaskuSivu::paivitaTosite(const TositeMuutos &muutos)
+{
+    // Laskuluettelosta päivitetään vain muuttuneen tositteen laskut
+    if( lajiTab_->currentIndex() < TIEDOT && laskumodel_)
+    {
+        laskumodel_->paivitaTosite(muutos);
+        laskuValintaMuuttuu();
+    }
+    else
+        paivitaLaskulista();
+}
+
 void LaskuSivu::asiakasValintaMuuttuu()
 {
     laskuAsiakasProxy_->setFilterFixedString( asiakasView_->currentIndex().data(AsiakkaatModel::NimiRooli).toString() );
@@ -25,6 +25,8 @@
 
 #include "kitupiikkisivu.h"
 
+struct TositeMuutos;
+
 class QTabBar;
 class QSplitter;
 class QTableView;
@@ -62,6 +64,7 @@ public slots:
     void paaTab(int indeksi);
     void paivitaAsiakasSuodatus();
     void paivitaLaskulista();
+    void paivitaTosite(const TositeMuutos& muutos);
     void asiakasValintaMuuttuu();
     void laskuValintaMuuttuu();
 
@@ -17,8 +17,11 @@
 
 #include "laskutmodel.h"
 #include "db/kirjanpito.h"
+#include "db/vientimodel.h"
+#include "db/kyselyprofiloija.h"
 #include <QSqlQuery>
 #include <QSqlError>
+#include <QHash>
 #include <QDebug>
 
 
@@ -192,66 +195,139 @@ void LaskutModel::lataaAvoimet()
 
 void LaskutModel::paivita(int valinta, QDate mista, QDate mihin)
 {
-    QString kysely = QString("SELECT vienti.id, pvm, tili, debetsnt, kreditsnt, eraid, viite, erapvm, vienti.json, tosite, asiakas, laskupvm, kohdennus, tyyppi, selite "
-                             "FROM vienti LEFT OUTER JOIN tili ON vienti.tili=tili.id "
-                             "WHERE ((viite IS NOT NULL AND iban IS NULL) OR (tyyppi='AO' and vienti.id=vienti.eraid)) ");
-
-    if( mista.isValid() && mihin.isValid())
-        kysely.append( QString(" AND pvm BETWEEN '%1' AND '%2' ") .arg(mista.toString(Qt::ISODate)).arg(mihin.toString(Qt::ISODate)) );
+    valinta_ = valinta;
+    mista_ = mista;
+    mihin_ = mihin;
 
+    KyselyProfiloija::Operaatio mittaus("Laskut");
     beginResetModel();
     laskut.clear();
-    QSqlQuery query( kysely );
+    QSqlQuery query;
+    KyselyProfiloija::suorita(query, rajattuKysely());
 
     while( query.next())
     {
-        TaseEra era( query.value("eraid").toInt());
-        int vientiId = query.value("vienti.id").toInt();
+        AvoinLasku lasku;
+        if( lueLasku(query, valinta, lasku))
+            laskut.append(lasku);
+    }
+    endResetModel();
+}
 
-        if( valinta == AVOIMET && (!era.saldoSnt || !query.value("erapvm").toDate().isValid() ))
-            continue;
-        if( valinta == ERAANTYNEET && ( !era.saldoSnt || query.value("erapvm").toDate() > kp()->paivamaara() ))
-            continue;
+void LaskutModel::paivitaTosite(const TositeMuutos &muutos)
+{
+    // Laskuluettelossa ei näytetä tositteiden tunnisteita
+    if( muutos.koko )
+        return;
 
-        JsonKentta json( query.value("vienti.json").toByteArray() );
+    QStringList erat;
+    for( int eraId : muutos.erat)
+        erat.append( QString::number(eraId));
 
-        // Tämä lasku kelpaa ;)        
+    QString kysely = rajattuKysely();
+    if( erat.isEmpty())
+        kysely.append( QString(" AND vienti.tosite=%1 ").arg(muutos.tositeId));
+    else
+        kysely.append( QString(" AND (vienti.tosite=%1 OR vienti.eraid IN (%2)) ").arg(muutos.tositeId).arg(erat.join(',')));
+
+    QHash<int,AvoinLasku> uudet;
+    QSqlQuery query( kysely );
+    while( query.next())
+    {
         AvoinLasku lasku;
-        lasku.vientiId = vientiId;
-        lasku.viite = query.value("viite").toString();
-        lasku.pvm = query.value("laskupvm").toDate();
-        lasku.erapvm = query.value("erapvm").toDate();
-        lasku.eraId = query.value("eraid").toInt();
-        lasku.summaSnt = query.value("debetSnt").toInt() - query.value("kreditSnt").toInt();
-        lasku.avoinSnt = json.luku("Hyvityslasku") ? 0 : era.saldoSnt;        // Hyvityslaskuille avoinsnt näytetään nollaa
-        lasku.asiakas = query.value("asiakas").toString();
-        if( lasku.asiakas.isEmpty())
-            lasku.asiakas = query.value("selite").toString();
-        lasku.tosite = query.value("tosite").toInt();
-        lasku.kirjausperuste =  json.luku("Kirjausperuste");
-        lasku.tiliid = query.value("tili").toInt();
-        lasku.json = json;
-        lasku.kohdennusId = query.value("kohdennus").toInt();
-
-        if( valinta != KAIKKI && !lasku.avoinSnt)
-            continue;   // Hyvityslaskuja ei näytetä avoimina saatika erääntyneinä
-
-        // Jos lasku on erääntynyt, selvitetään, onko siitä jo lähetetty maksumuistutus
-        if( lasku.erapvm < kp()->paivamaara())
+        if( lueLasku(query, valinta_, lasku))
+            uudet.insert(lasku.vientiId, lasku);
+    }
+
+    // Päivitetään tai poistetaan luettelossa jo olevat muuttuneet laskut
+    for(int i = laskut.count() - 1; i >= 0; i--)
+    {
+        int vientiId = laskut.at(i).vientiId;
+        if( laskut.at(i).tosite != muutos.tositeId && !muutos.erat.contains(laskut.at(i).eraId) && !uudet.contains(vientiId))
+            continue;
+
+        if( uudet.contains(vientiId))
         {
-            QString muistutuskysymys = QString("SELECT json FROM vienti WHERE eraid=%1").arg(lasku.eraId);
-            QSqlQuery muistutuskysely(muistutuskysymys);
-            while( muistutuskysely.next())
-            {
-                JsonKentta muistutusJson( muistutuskysely.value("json").toByteArray() );
-                if( muistutusJson.str("Maksumuistutus")==lasku.viite)
-                    lasku.muistutettu = true;
-            }
+            laskut[i] = uudet.take(vientiId);
+            emit dataChanged( index(i, NUMERO), index(i, ASIAKAS));
         }
+        else
+        {
+            beginRemoveRows(QModelIndex(), i, i);
+            laskut.removeAt(i);
+            endRemoveRows();
+        }
+    }
 
-        laskut.append(lasku);
+    // Uudet laskut luettelon loppuun, näkymän lajittelu järjestää ne
+    if( !uudet.isEmpty())
+    {
+        beginInsertRows(QModelIndex(), laskut.count(), laskut.count() + uudet.count() - 1);
+        for( const AvoinLasku& lasku : uudet)
+            laskut.append(lasku);
+        endInsertRows();
     }
-    endResetModel();
+}
+
+QString LaskutModel::laskukysely() const
+{
+    return QString("SELECT vienti.id, pvm, tili, debetsnt, kreditsnt, eraid, viite, erapvm, vienti.json, tosite, asiakas, laskupvm, kohdennus, tyyppi, selite "
+                   "FROM vienti LEFT OUTER JOIN tili ON vienti.tili=tili.id "
+                   "WHERE ((viite IS NOT NULL AND iban IS NULL) OR (tyyppi='AO' and vienti.id=vienti.eraid)) ");
+}
+
+bool LaskutModel::lueLasku(QSqlQuery &query, int valinta, AvoinLasku &lasku) const
+{
+    TaseEra era( query.value("eraid").toInt());
+
+    if( valinta == AVOIMET && (!era.saldoSnt || !query.value("erapvm").toDate().isValid() ))
+        return false;
+    if( valinta == ERAANTYNEET && ( !era.saldoSnt || query.value("erapvm").toDate() > kp()->paivamaara() ))
+        return false;
+
+    JsonKentta json( query.value("vienti.json").toByteArray() );
+
+    // Tämä lasku kelpaa ;)
+    lasku.vientiId = query.value("vienti.id").toInt();
+    lasku.viite = query.value("viite").toString();
+    lasku.pvm = query.value("laskupvm").toDate();
+    lasku.erapvm = query.value("erapvm").toDate();
+    lasku.eraId = query.value("eraid").toInt();
+    lasku.summaSnt = query.value("debetSnt").toInt() - query.value("kreditSnt").toInt();
+    lasku.avoinSnt = json.luku("Hyvityslasku") ? 0 : era.saldoSnt;        // Hyvityslaskuille avoinsnt näytetään nollaa
+    lasku.asiakas = query.value("asiakas").toString();
+    if( lasku.asiakas.isEmpty())
+        lasku.asiakas = query.value("selite").toString();
+    lasku.tosite = query.value("tosite").toInt();
+    lasku.kirjausperuste =  json.luku("Kirjausperuste");
+    lasku.tiliid = query.value("tili").toInt();
+    lasku.json = json;
+    lasku.kohdennusId = query.value("kohdennus").toInt();
+
+    if( valinta != KAIKKI && !lasku.avoinSnt)
+        return false;   // Hyvityslaskuja ei näytetä avoimina saatika erääntyneinä
+
+    // Jos lasku on erääntynyt, selvitetään, onko siitä jo lähetetty maksumuistutus
+    if( lasku.erapvm < kp()->paivamaara())
+    {
+        QString muistutuskysymys = QString("SELECT json FROM vienti WHERE eraid=%1").arg(lasku.eraId);
+        QSqlQuery muistutuskysely(muistutuskysymys);
+        while( muistutuskysely.next())
+        {
+            JsonKentta muistutusJson( muistutuskysely.value("json").toByteArray() );
+            if( muistutusJson.str("Maksumuistutus")==lasku.viite)
+                lasku.muistutettu = true;
+        }
+    }
+    return true;
+}
+
+QString LaskutModel::rajattuKysely() const
+{
+    QString kysely = laskukysely();
+    if( mista_.isValid() && mihin_.isValid())
+        kysely.append( QString(" AND pvm BETWEEN '%1' AND '%2' ") .arg(mista_.toString(Qt::ISODate)).arg(mihin_.toString(Qt::ISODate)) );
+    return kysely;
 }
 
 void LaskutModel::maksa(int indeksi, int senttia)
@@ -24,6 +24,9 @@
 
 #include "db/jsonkentta.h"
 
+class QSqlQuery;
+struct TositeMuutos;
+
 /**
  * @brief Laskunmaksudialogissa näytettävä avoin lasku
  */
@@ -90,7 +93,17 @@ public:
 
 public slots:
     void lataaAvoimet();
-    virtual void paivita(int valinta = KAIKKI, QDate mista=QDate(), QDate mihin = QDate());
+    void paivita(int valinta = KAIKKI, QDate mista=QDate(), QDate mihin = QDate());
+
+    /**
+     * @brief Päivittää tallennetun tai poistetun tositteen laskut
+     *
+     * Hakee vain muuttuneen tositteen ja sen erien laskut, joten
+     * luetteloa ei tarvitse ladata kokonaan uudelleen.
+     *
+     * @since 1.1
+     */
+    void paivitaTosite(const TositeMuutos& muutos);
 
     /**
      * @brief Vähentää laskun avointa määrää ja poistaa jos kokonaan maksettu
@@ -108,7 +121,24 @@ public:
     static QString bicIbanilla(const QString& iban);
 
 protected:
+    /**
+     * @brief Laskujen hakulause, johon voidaan lisätä ehtoja
+     *
+     * Päivämäärärajaus lisätään tämän perään
+     */
+    virtual QString laskukysely() const;
+    /**
+     * @brief Lukee kyselyn rivin laskuksi
+     * @return tosi, jos lasku kuuluu valinnan mukaan luetteloon
+     */
+    virtual bool lueLasku(QSqlQuery& query, int valinta, AvoinLasku& lasku) const;
+
+    QString rajattuKysely() const;
+
     QList<AvoinLasku> laskut;
+    int valinta_ = KAIKKI;
+    QDate mista_;
+    QDate mihin_;
 
 };
 
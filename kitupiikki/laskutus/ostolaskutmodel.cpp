@@ -49,53 +49,42 @@ void OstolaskutModel::lataaAvoimet()
     paivita(AVOIMET);
 }
 
-void OstolaskutModel::paivita(int valinta, QDate mista, QDate mihin)
+QString OstolaskutModel::laskukysely() const
 {
-    QString kysely = QString("SELECT vienti.id, pvm, tili, debetsnt, kreditsnt, eraid, viite, erapvm, vienti.json as json, tosite, asiakas, laskupvm, kohdennus, selite FROM vienti,tili "
-                     "WHERE vienti.tili=tili.id AND tili.tyyppi='BO' AND eraid=vienti.id ");
-
-
-    if( mista.isValid() && mihin.isValid())
-        kysely.append( QString(" AND pvm BETWEEN '%1' AND '%2' ") .arg(mista.toString(Qt::ISODate)).arg(mihin.toString(Qt::ISODate)) );
-
-    beginResetModel();
-    laskut.clear();
-    QSqlQuery query( kysely );
-
-    while( query.next())
-    {
-        TaseEra era( query.value("eraid").toInt());
-
-        JsonKentta json( query.value("json").toByteArray() );
-        int vientiId = query.value("vienti.id").toInt();
-
-        if( valinta == AVOIMET && (!era.saldoSnt || era.eraId != vientiId))
-            continue;
-        if( valinta == ERAANTYNEET && ( !era.saldoSnt || query.value("erapvm").toDate() > kp()->paivamaara() ))
-            continue;
-
-        // Tämä lasku kelpaa ;)
-        AvoinLasku lasku;
-        lasku.viite = query.value("viite").toString();
-        lasku.pvm = query.value("laskupvm").toDate();
-        lasku.erapvm = query.value("erapvm").toDate();
-        lasku.eraId = query.value("eraid").toInt();
-        lasku.summaSnt = query.value("kreditSnt").toInt() -  query.value("debetSnt").toInt();
-        lasku.avoinSnt = 0LL - era.saldoSnt;
-
-        lasku.asiakas = query.value("asiakas").toString();
-        if( lasku.asiakas.length())
-            lasku.asiakas.append(" ");
-        lasku.asiakas.append( query.value("selite").toString());
-
-        lasku.tosite = query.value("tosite").toInt();
-        lasku.kirjausperuste =  json.luku("Kirjausperuste");
-        lasku.tiliid = query.value("tili").toInt();
-        lasku.json = json;
-        lasku.kohdennusId = query.value("kohdennus").toInt();
-        laskut.append(lasku);
-    }
-    endResetModel();
+    return QString("SELECT vienti.id, pvm, tili, debetsnt, kreditsnt, eraid, viite, erapvm, vienti.json as json, tosite, asiakas, laskupvm, kohdennus, selite FROM vienti,tili "
+                   "WHERE vienti.tili=tili.id AND tili.tyyppi='BO' AND eraid=vienti.id ");
 }
 
-
+bool OstolaskutModel::lueLasku(QSqlQuery &query, int valinta, AvoinLasku &lasku) const
+{
+    TaseEra era( query.value("eraid").toInt());
+
+    JsonKentta json( query.value("json").toByteArray() );
+    int vientiId = query.value("vienti.id").toInt();
+
+    if( valinta == AVOIMET && (!era.saldoSnt || era.eraId != vientiId))
+        return false;
+    if( valinta == ERAANTYNEET && ( !era.saldoSnt || query.value("erapvm").toDate() > kp()->paivamaara() ))
+        return false;
+
+    // Tämä lasku kelpaa ;)
+    lasku.vientiId = vientiId;
+    lasku.viite = query.value("viite").toString();
+    lasku.pvm = query.value("laskupvm").toDate();
+    lasku.erapvm = query.value("erapvm").toDate();
+    lasku.eraId = query.value("eraid").toInt();
+    lasku.summaSnt = query.value("kreditSnt").toInt() -  query.value("debetSnt").toInt();
+    lasku.avoinSnt = 0LL - era.saldoSnt;
+
+    lasku.asiakas = query.value("asiakas").toString();
+    if( lasku.asiakas.length())
+        lasku.asiakas.append(" ");
+    lasku.asiakas.append( query.value("selite").toString());
+
+    lasku.tosite = query.value("tosite").toInt();
+    lasku.kirjausperuste =  json.luku("Kirjausperuste");
+    lasku.tiliid = query.value("tili").toInt();
+    lasku.json = json;
+    lasku.kohdennusId = query.value("kohdennus").toInt();
+    return true;
+}
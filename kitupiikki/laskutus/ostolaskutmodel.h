@@ -38,9 +38,10 @@ public:
 
 public slots:
     void lataaAvoimet();
-    void paivita(int valinta=KAIKKI, QDate mista=QDate(), QDate mihin = QDate()) override;
-
 
+protected:
+    QString laskukysely() const override;
+    bool lueLasku(QSqlQuery& query, int valinta, AvoinLasku& lasku) const override;
 };
 
 #endif // OSTOLASKUTMODEL_H
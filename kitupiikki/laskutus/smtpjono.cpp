@@ -0,0 +1,470 @@
+/*
+   Copyright (C) 2018 Arto Hyvättinen
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QApplication>
+#include <QDateTime>
+#include <QRandomGenerator>
+#include <QRegularExpression>
+#include <QDebug>
+
+#include "smtpjono.h"
+#include "db/kirjanpito.h"
+
+namespace {
+
+const int AIKAKATKAISU = 30000;
+const qint64 KIRJOITUSPUSKURI = 64 * 1024;  // Kirjoitetaan lisää, kun lähtevää on vähemmän
+const int LIITEPALA = 57 * 256;              // Base64-rivillä 57 tavua = 76 merkkiä
+
+}
+
+SmtpJono::SmtpJono(const QString &user, const QString &pass, const QString &host, int port, QObject *parent) :
+    QObject(parent), user_(user), pass_(pass), host_(host), port_(port), salattu_( port != 25 ),
+    socket_( new QSslSocket(this))
+{
+    connect( socket_, &QSslSocket::readyRead, this, &SmtpJono::lueVastaus);
+    connect( socket_, &QSslSocket::bytesWritten, this, &SmtpJono::kirjoitaRunkoa);
+    connect( socket_, &QSslSocket::encryptedBytesWritten, this, &SmtpJono::kirjoitaRunkoa);
+    connect( socket_, &QSslSocket::disconnected, this, &SmtpJono::yhteysKatkesi);
+    connect( socket_, SIGNAL(error(QAbstractSocket::SocketError)), this, SLOT(socketVirhe(QAbstractSocket::SocketError)));
+
+    ajastin_.setSingleShot(true);
+    connect( &ajastin_, &QTimer::timeout, this, &SmtpJono::aikakatkaisu);
+}
+
+SmtpJono::~SmtpJono()
+{
+    socket_->abort();
+}
+
+void SmtpJono::lisaa(const SmtpViesti &viesti)
+{
+    if( lopetettu_ )
+    {
+        emit viestiEpaonnistui( viesti.tunniste, tr("Sähköpostin lähetys on keskeytetty"));
+        return;
+    }
+
+    jono_.append(viesti);
+
+    if( tila_ == EiYhteytta )
+    {
+        yhteysyrityksia_ = 0;
+        yhdista();
+    }
+}
+
+QString SmtpJono::poimiPelkkaOsoite(const QString &osoite)
+{
+    QRegularExpression re("<.*@.*>");
+    QRegularExpressionMatch mats = re.match(osoite);
+    if( mats.hasMatch() )
+        return mats.captured(0);
+    return QString();
+}
+
+void SmtpJono::lueVastaus()
+{
+    ajastin_.start(AIKAKATKAISU);
+
+    // Samassa lukukerrassa voi tulla useampi vastaus, kun komennot on ketjutettu
+    while( socket_->canReadLine())
+    {
+        QString rivi = QString::fromUtf8( socket_->readLine() ).trimmed();
+        if( rivi.length() < 3)
+            continue;
+
+        vastausRivit_.append( rivi.mid(4) );
+
+        // Monirivisen vastauksen välirivit ovat muotoa 250-TEKSTI
+        if( rivi.length() > 3 && rivi.at(3) == '-')
+            continue;
+
+        int koodi = rivi.left(3).toInt();
+        QStringList rivit = vastausRivit_;
+        vastausRivit_.clear();
+
+        kasitteleVastaus(koodi, rivit);
+    }
+}
+
+void SmtpJono::kasitteleVastaus(int koodi, const QStringList &rivit)
+{
+    QString teksti = QString("%1 %2").arg(koodi).arg( rivit.join(' ') );
+
+    if( tila_ == Yhdistetaan )
+    {
+        if( koodi == 220 )
+        {
+            emit status( tr("Lähetetään sähköpostia..."));
+            komento("EHLO localhost");
+            tila_ = Ehlo;
+        }
+        else
+            hylkaaJono(teksti);
+    }
+    else if( tila_ == Ehlo || tila_ == Helo )
+    {
+        if( koodi == 250 )
+        {
+            pipelining_ = false;
+            if( tila_ == Ehlo )
+            {
+                for(const QString& rivi : rivit)
+                    if( rivi.trimmed().toUpper() == "PIPELINING")
+                        pipelining_ = true;
+            }
+
+            if( salattu_ && !user_.isEmpty())
+            {
+                komento("AUTH LOGIN");
+                tila_ = AuthLogin;
+            }
+            else
+            {
+                tila_ = Valmiina;
+                aloitaSeuraava();
+            }
+        }
+        else if( tila_ == Ehlo )
+        {
+            // Vanha palvelin ei tunne EHLO-komentoa
+            komento("HELO localhost");
+            tila_ = Helo;
+        }
+        else
+            hylkaaJono(teksti);
+    }
+    else if( tila_ == AuthLogin && koodi == 334)
+    {
+        komento( user_.toUtf8().toBase64());
+        tila_ = Kayttaja;
+    }
+    else if( tila_ == Kayttaja && koodi == 334)
+    {
+        komento( pass_.toUtf8().toBase64());
+        tila_ = Salasana;
+    }
+    else if( tila_ == Salasana && koodi == 235)
+    {
+        tila_ = Valmiina;
+        aloitaSeuraava();
+    }
+    else if( tila_ == AuthLogin || tila_ == Kayttaja || tila_ == Salasana)
+    {
+        // Kirjautuminen epäonnistui, eikä uusi yritys auta
+        hylkaaJono(teksti);
+    }
+    else if( tila_ == MailFrom || tila_ == RcptTo || tila_ == Data )
+    {
+        Tila odotettu = odotetut_.isEmpty() ? tila_ : odotetut_.takeFirst();
+
+        if( odotettu == Data && koodi == 354 )
+        {
+            if( viestinVirhe_.isEmpty())
+            {
+                tila_ = Runko;
+                valmisteleRunko();
+                kirjoitaRunkoa();
+            }
+            else
+            {
+                // Aiempi komento epäonnistui, joten lopetetaan tyhjä viesti heti
+                komento(".");
+                tila_ = RungonLoppu;
+            }
+            return;
+        }
+
+        if( koodi != 250 && viestinVirhe_.isEmpty())
+        {
+            viestinVirhe_ = teksti;
+            viestinVirheTilapainen_ = koodi >= 400 && koodi < 500;
+        }
+
+        if( pipelining_ )
+        {
+            // Odotetaan kaikki ketjutettujen komentojen vastaukset
+            if( odotetut_.isEmpty())
+            {
+                komento("RSET");
+                tila_ = Rset;
+            }
+            return;
+        }
+
+        if( !viestinVirhe_.isEmpty())
+        {
+            komento("RSET");
+            tila_ = Rset;
+        }
+        else if( tila_ == MailFrom )
+        {
+            komento("RCPT TO: " + poimiPelkkaOsoite( nykyinen_.vastaanottaja ).toUtf8());
+            tila_ = RcptTo;
+        }
+        else if( tila_ == RcptTo )
+        {
+            komento("DATA");
+            tila_ = Data;
+        }
+    }
+    else if( tila_ == RungonLoppu )
+    {
+        if( !viestinVirhe_.isEmpty())
+            viestiKasitelty(viestinVirhe_, viestinVirheTilapainen_);
+        else if( koodi == 250 )
+            viestiKasitelty();
+        else
+            viestiKasitelty(teksti, koodi >= 400 && koodi < 500);
+        aloitaSeuraava();
+    }
+    else if( tila_ == Runko )
+    {
+        // Palvelin keskeytti viestin kesken lähetyksen, aloitetaan uudella yhteydellä
+        viestiKasitelty(teksti, koodi >= 400 && koodi < 500);
+        socket_->abort();
+        yhteysKatkesi();
+    }
+    else if( tila_ == Rset )
+    {
+        viestiKasitelty( viestinVirhe_, viestinVirheTilapainen_);
+        aloitaSeuraava();
+    }
+    else if( tila_ == Lopetus )
+    {
+        socket_->disconnectFromHost();
+    }
+}
+
+void SmtpJono::aloitaSeuraava()
+{
+    if( jono_.isEmpty())
+    {
+        komento("QUIT");
+        tila_ = Lopetus;
+        return;
+    }
+
+    nykyinen_ = jono_.takeFirst();
+    nykyinen_.yrityksia++;
+    lahetettavana_ = true;
+    viestinVirhe_.clear();
+    viestinVirheTilapainen_ = false;
+    odotetut_.clear();
+
+    QByteArray mailFrom = "MAIL FROM: " + poimiPelkkaOsoite( nykyinen_.lahettaja ).toUtf8();
+
+    if( pipelining_ )
+    {
+        // Ketjutetaan lähettäjä, vastaanottaja ja DATA yhdellä kirjoituksella
+        socket_->write( mailFrom + "\r\n" +
+                        "RCPT TO: " + poimiPelkkaOsoite( nykyinen_.vastaanottaja ).toUtf8() + "\r\n" +
+                        "DATA\r\n");
+        ajastin_.start(AIKAKATKAISU);
+        odotetut_ << MailFrom << RcptTo << Data;
+        tila_ = Data;
+    }
+    else
+    {
+        komento( mailFrom );
+        tila_ = MailFrom;
+    }
+}
+
+void SmtpJono::komento(const QByteArray &komento)
+{
+    socket_->write( komento + "\r\n");
+    ajastin_.start(AIKAKATKAISU);
+}
+
+void SmtpJono::valmisteleRunko()
+{
+    QString osoite = kp()->asetukset()->asetus("EmailOsoite");
+    QString domain = osoite.mid( osoite.indexOf('@') );
+
+    QString message = "To: " + nykyinen_.vastaanottaja + "\n";
+    message.append("From: " + nykyinen_.lahettaja + "\n");
+    message.append("Subject: =?utf-8?Q?" + nykyinen_.otsikko + "?=\n");
+    message.append("Message-Id: <" +  QString::number(QDateTime::currentDateTime().toMSecsSinceEpoch()) + "-" + QString::number(QRandomGenerator::global()->generate64(),16) +
+                   "-" + kp()->asetukset()->asetus("Ytunnus").left(7) + domain + ">\n");
+    message.append("Date: " + QDateTime::currentDateTime().toString(Qt::RFC2822Date) + "\n" );
+    message.append("X-Mailer: Kitupiikki " + qApp->applicationVersion() + "\n");
+
+    message.append("MIME-Version: 1.0\n");
+    message.append("Content-Type: multipart/mixed; boundary=frontier\n\n");
+
+    message.append( "--frontier\n" );
+    message.append( "Content-Type: text/html; charset=\"UTF-8\"\n\n" );
+    message.append( nykyinen_.html );
+    message.append("\n\n");
+    message.append( "--frontier\n" );
+    message.append( "Content-Type: application/octet-stream\nContent-Disposition: attachment; filename="+ nykyinen_.liitenimi +";\nContent-Transfer-Encoding: base64\n\n" );
+
+    message.replace( QString::fromLatin1( "\n" ), QString::fromLatin1( "\r\n" ) );
+    // Pisteellä alkavat rivit kahdennetaan, jotta piste ei päätä viestiä
+    message.replace( QString::fromLatin1( "\r\n." ),QString::fromLatin1( "\r\n.." ) );
+
+    rungonAlku_ = message.toUtf8();
+    liitettaKoodattu_ = 0;
+    rungonLoppuKirjoitettu_ = false;
+}
+
+void SmtpJono::kirjoitaRunkoa()
+{
+    if( tila_ != Runko )
+        return;
+
+    ajastin_.start(AIKAKATKAISU);
+
+    // Kirjoitetaan lisää vain sen verran, että lähtevä puskuri pysyy pienenä
+    while( socket_->bytesToWrite() + socket_->encryptedBytesToWrite() < KIRJOITUSPUSKURI && !rungonLoppuKirjoitettu_)
+    {
+        if( !rungonAlku_.isEmpty())
+        {
+            socket_->write( rungonAlku_ );
+            rungonAlku_.clear();
+        }
+        else if( liitettaKoodattu_ < nykyinen_.liite.length())
+        {
+            QByteArray base64 = nykyinen_.liite.mid( liitettaKoodattu_, LIITEPALA ).toBase64();
+            liitettaKoodattu_ += LIITEPALA;
+
+            QByteArray rivitetty;
+            rivitetty.reserve( base64.length() + base64.length() / 76 * 2 + 2);
+            for(int i=0; i < base64.length(); i += 76)
+                rivitetty.append( base64.mid(i, 76) ).append("\r\n");
+            socket_->write( rivitetty );
+        }
+        else
+        {
+            socket_->write( "\r\n--frontier--\r\n.\r\n");
+            rungonLoppuKirjoitettu_ = true;
+            tila_ = RungonLoppu;
+        }
+    }
+}
+
+void SmtpJono::socketVirhe(QAbstractSocket::SocketError virhe)
+{
+    qDebug() << "SmtpJono " << virhe << socket_->errorString();
+
+    // Jos yhteyttä ei saatu lainkaan, disconnected-signaalia ei tule
+    if( socket_->state() == QAbstractSocket::UnconnectedState )
+        yhteysKatkesi();
+}
+
+void SmtpJono::yhteysKatkesi()
+{
+    ajastin_.stop();
+
+    if( tila_ == EiYhteytta )
+        return;
+
+    tila_ = EiYhteytta;
+
+    if( lahetettavana_ )
+        viestiKasitelty( socket_->errorString(), true);
+
+    if( jono_.isEmpty())
+    {
+        lopetettu_ = true;
+        emit valmis();
+    }
+    else if( ++yhteysyrityksia_ < YRITYKSIA )
+    {
+        // Yhteys katkesi kesken, yritetään hetken päästä uudelleen
+        emit status( tr("Yhdistetään uudelleen sähköpostipalvelimeen..."));
+        QTimer::singleShot( 2000 * yhteysyrityksia_, this, &SmtpJono::yhdista);
+    }
+    else
+    {
+        hylkaaJono( socket_->errorString() );
+        emit valmis();
+    }
+}
+
+void SmtpJono::aikakatkaisu()
+{
+    qDebug() << "SmtpJono aikakatkaisu tilassa " << tila_;
+    socket_->abort();
+    yhteysKatkesi();
+}
+
+void SmtpJono::yhdista()
+{
+    if( tila_ != EiYhteytta || lopetettu_ )
+        return;
+
+    emit status(tr("Yhdistetään sähköpostipalvelimeen..."));
+    tila_ = Yhdistetaan;
+    vastausRivit_.clear();
+    ajastin_.start(AIKAKATKAISU);
+
+    if( salattu_ )
+        socket_->connectToHostEncrypted(host_, static_cast<quint16>(port_));
+    else
+        socket_->connectToHost(host_, static_cast<quint16>(port_));
+}
+
+void SmtpJono::viestiKasitelty(const QString &virhe, bool tilapainen)
+{
+    if( !lahetettavana_)
+        return;
+    lahetettavana_ = false;
+
+    if( virhe.isEmpty())
+    {
+        yhteysyrityksia_ = 0;
+        emit viestiLahetetty( nykyinen_.tunniste );
+    }
+    else if( tilapainen && nykyinen_.yrityksia < YRITYKSIA)
+    {
+        // Tilapäinen virhe: viesti jonon perälle uutta yritystä varten
+        jono_.append( nykyinen_ );
+    }
+    else
+    {
+        emit viestiEpaonnistui( nykyinen_.tunniste, virhe);
+    }
+}
+
+void SmtpJono::hylkaaJono(const QString &virhe)
+{
+    // Merkitään ennen signaaleja, jotta kutsuja ei täydennä hylättävää jonoa
+    lopetettu_ = true;
+
+    if( lahetettavana_ )
+    {
+        lahetettavana_ = false;
+        emit viestiEpaonnistui( nykyinen_.tunniste, virhe);
+    }
+    while( !jono_.isEmpty())
+        emit viestiEpaonnistui( jono_.takeFirst().tunniste, virhe);
+
+    if( socket_->state() == QAbstractSocket::ConnectedState)
+    {
+        komento("QUIT");
+        tila_ = Lopetus;
+    }
+    else if( socket_->state() != QAbstractSocket::UnconnectedState)
+    {
+        tila_ = EiYhteytta;
+        ajastin_.stop();
+        socket_->abort();
+    }
+}
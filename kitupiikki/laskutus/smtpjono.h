@@ -0,0 +1,161 @@
+/*
+   Copyright (C) 2018 Arto Hyvättinen
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SMTPJONO_H
+#define SMTPJONO_H
+
+#include <QObject>
+#include <QList>
+#include <QByteArray>
+#include <QTimer>
+#include <QtNetwork/QSslSocket>
+
+/**
+ * @brief Jonoon lisättävä sähköpostiviesti
+ */
+struct SmtpViesti
+{
+    int tunniste = 0;           /** Kutsujan tunniste, jolla lähetyksen tila ilmoitetaan */
+    QString lahettaja;          /** Muodossa =?utf-8?Q?Nimi?= <osoite@domain> */
+    QString vastaanottaja;
+    QString otsikko;
+    QString html;
+    QString liitenimi;
+    QByteArray liite;
+    int yrityksia = 0;
+};
+
+/**
+ * @brief Sähköpostien lähettäminen jonosta samalla yhteydellä
+ *
+ * Avaa yhden (salatun) yhteyden sähköpostipalvelimeen, kirjautuu kerran
+ * ja lähettää kaikki jonoon lisätyt viestit saman istunnon aikana.
+ * Jos palvelin ilmoittaa tukevansa PIPELINING-laajennusta, lähettäjä,
+ * vastaanottaja ja DATA-komento lähetetään kerralla.
+ *
+ * Liite base64-koodataan paloina sitä mukaa kun yhteys vetää, joten
+ * isoja liitteitä ei tarvitse koodata kerralla muistiin. Tilapäiset
+ * virheet (4xx ja katkennut yhteys) yritetään uudelleen.
+ *
+ * Portissa 25 toimitaan oletuksena ilman salausta ja kirjautumista,
+ * muissa porteissa salatulla yhteydellä (SMTPS).
+ *
+ * @since 1.1
+ */
+class SmtpJono : public QObject
+{
+    Q_OBJECT
+public:
+    SmtpJono( const QString &user, const QString &pass,
+              const QString &host, int port = 465, QObject *parent = nullptr);
+    ~SmtpJono();
+
+    /**
+     * @brief Käytetäänkö salattua yhteyttä ja kirjautumista
+     *
+     * Salauksen voi kytkeä pois esimerkiksi paikallista testipalvelinta varten
+     */
+    void asetaSalaus(bool salattu) { salattu_ = salattu; }
+
+    /**
+     * @brief Lisää viestin lähetysjonoon ja avaa tarvittaessa yhteyden
+     */
+    void lisaa(const SmtpViesti& viesti);
+
+    /**
+     * @brief Lähettämistä odottavien viestien määrä (ei sisällä lähetettävänä olevaa)
+     */
+    int jonossa() const { return jono_.count(); }
+
+    /**
+     * @brief Onko jono hylätty tai valmis
+     *
+     * Lopetettuun jonoon ei enää lisätä viestejä eikä avata uutta yhteyttä,
+     * joten kutsujan ei pidä muodostaa sille uusia viestejä.
+     */
+    bool lopetettu() const { return lopetettu_; }
+
+    /**
+     * @brief Poimii pelkän osoitteen saajasta
+     * @param osoite Saaja muodossa "Nimi" <osoite@domain>
+     * @return pelkkä osoite muodossa <osoite@domain>
+     */
+    static QString poimiPelkkaOsoite(const QString& osoite);
+
+    static const int YRITYKSIA = 3;
+
+signals:
+    void status( const QString& viesti);
+    void viestiLahetetty(int tunniste);
+    void viestiEpaonnistui(int tunniste, const QString& virhe);
+    /**
+     * @brief Jono on tyhjä ja yhteys suljettu
+     */
+    void valmis();
+
+private slots:
+    void lueVastaus();
+    void kirjoitaRunkoa();
+    void socketVirhe(QAbstractSocket::SocketError virhe);
+    void yhteysKatkesi();
+    void aikakatkaisu();
+
+private:
+    enum Tila { EiYhteytta, Yhdistetaan, Ehlo, Helo, AuthLogin, Kayttaja, Salasana,
+                Valmiina, MailFrom, RcptTo, Data, Runko, RungonLoppu, Rset, Lopetus };
+
+    void yhdista();
+    void kasitteleVastaus(int koodi, const QStringList& rivit);
+    void aloitaSeuraava();
+    void komento(const QByteArray& komento);
+    void valmisteleRunko();
+    /**
+     * @brief Viestin käsittely päättyi
+     * @param virhe Tyhjä, jos onnistui
+     * @param tilapainen Yritetäänkö uudelleen
+     */
+    void viestiKasitelty(const QString& virhe = QString(), bool tilapainen = false);
+    void hylkaaJono(const QString& virhe);
+
+    QString user_;
+    QString pass_;
+    QString host_;
+    int port_;
+    bool salattu_;
+
+    QSslSocket *socket_;
+    QTimer ajastin_;
+    Tila tila_ = EiYhteytta;
+    bool lopetettu_ = false;
+
+    QList<SmtpViesti> jono_;
+    SmtpViesti nykyinen_;
+    bool lahetettavana_ = false;
+    QString viestinVirhe_;
+    bool viestinVirheTilapainen_ = false;
+
+    bool pipelining_ = false;
+    QList<Tila> odotetut_;
+    QStringList vastausRivit_;
+    int yhteysyrityksia_ = 0;
+
+    QByteArray rungonAlku_;
+    int liitettaKoodattu_ = 0;
+    bool rungonLoppuKirjoitettu_ = false;
+};
+
+#endif // SMTPJONO_H
@@ -18,12 +18,10 @@
 
 #include "ui_yhteystiedot.h"
 #include "validator/ytunnusvalidator.h"
-#include "db/jsonkentta.h"
+#include "db/asiakas.h"
 
-#include <QSqlQuery>
 
 #include <QDebug>
-#include <QSqlError>
 
 YhteystietoWidget::YhteystietoWidget(QWidget *parent) : QWidget(parent), ui_( new Ui::Yhteystiedot)
 {
@@ -55,20 +53,13 @@ void YhteystietoWidget::haeTiedot(const QString &nimi)
 
     if( !nimi.isEmpty())
     {
-
-        QSqlQuery kysely;
-        kysely.exec( QString("SELECT json FROM vienti WHERE asiakas='%1' AND iban is null ORDER BY muokattu DESC").arg( nimi_ )) ;
-        if( kysely.next())
-        {
-            JsonKentta json;
-            json.fromJson( kysely.value(0).toByteArray());
-            if( !json.str("Osoite").isEmpty())
-                osoite_ = json.str("Osoite");
-            sahkoposti_ = json.str("Email");
-            ytunnus_ = json.str("YTunnus");
-            verkkolaskuosoite_ = json.str("VerkkolaskuOsoite");
-            verkkolaskuvalittaja_ = json.str("VerkkolaskuValittaja");
-        }
+        Asiakas asiakas = Asiakas::haeNimella(nimi);
+        if( !asiakas.osoite.isEmpty())
+            osoite_ = asiakas.osoite;
+        sahkoposti_ = asiakas.email;
+        ytunnus_ = asiakas.ytunnus;
+        verkkolaskuosoite_ = asiakas.verkkolaskuosoite;
+        verkkolaskuvalittaja_ = asiakas.verkkolaskuvalittaja;
     }
 
     nollaa();
@@ -90,28 +81,13 @@ void YhteystietoWidget::tallenna()
     verkkolaskuosoite_ = ui_->verkkolaskuOsoite->text();
     verkkolaskuvalittaja_ = ui_->valittajaTunnus->text();
 
-    JsonKentta json;
-    if( !osoite_.isEmpty())
-        json.set("Osoite", osoite_);
-    if( !sahkoposti_.isEmpty())
-        json.set("Email", sahkoposti_);
-    if( !ytunnus_.isEmpty())
-        json.set("YTunnus", ytunnus_);
-    if( !verkkolaskuosoite_.isEmpty())
-        json.set("VerkkolaskuOsoite", verkkolaskuosoite_);
-    if( !verkkolaskuvalittaja_.isEmpty())
-        json.set("VerkkolaskuValittaja", verkkolaskuvalittaja_);
-
-
-    QSqlQuery kysely;
-    kysely.prepare("INSERT INTO vienti (vientirivi, asiakas, json, luotu, muokattu) "
-                   "VALUES (0, :asiakas, :json, :luotu, :muokattu)");
-    kysely.bindValue(":asiakas", nimi_);
-    kysely.bindValue(":json", json.toSqlJson());
-    kysely.bindValue(":luotu", QDateTime::currentDateTime());
-    kysely.bindValue(":muokattu", QDateTime::currentDateTime());
-
-    kysely.exec();
+    Asiakas asiakas = Asiakas::haeNimella(nimi_);
+    asiakas.osoite = osoite_;
+    asiakas.email = sahkoposti_;
+    asiakas.ytunnus = ytunnus_;
+    asiakas.verkkolaskuosoite = verkkolaskuosoite_;
+    asiakas.verkkolaskuvalittaja = verkkolaskuvalittaja_;
+    asiakas.tallenna(toimittaja_);
 
     ui_->tallennaNappi->setEnabled(false);
     ui_->nimiEdit->setEnabled(false);
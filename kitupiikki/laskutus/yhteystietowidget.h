@@ -42,6 +42,10 @@ public slots:
     void tallenna();
     void muokattu();
     void nollaa();
+    /**
+     * @brief Näytetäänkö toimittajan vai asiakkaan tietoja
+     */
+    void asetaToimittaja(bool toimittaja) { toimittaja_ = toimittaja; }
 
 private:
     Ui::Yhteystiedot* ui_;
@@ -52,6 +56,7 @@ private:
     QString ytunnus_;
     QString verkkolaskuosoite_;
     QString verkkolaskuvalittaja_;
+    bool toimittaja_ = false;
 
 };
 
@@ -20,6 +20,7 @@
 #include <QPrinter>
 #include <QPainter>
 #include <QSqlError>
+#include <QHash>
 
 #include <QTextDocument>
 #include <QMessageBox>
@@ -30,6 +31,7 @@
 #include "db/kirjanpito.h"
 
 #include "raportti/alverittely.h"
+#include "raportti/alvlaskelma.h"
 
 
 AlvIlmoitusDialog::AlvIlmoitusDialog(QWidget *parent) :
@@ -83,33 +85,45 @@ QDate AlvIlmoitusDialog::teeAlvIlmoitus(QDate alkupvm, QDate loppupvm)
 
 bool AlvIlmoitusDialog::alvIlmoitus(QDate alkupvm, QDate loppupvm)
 {
+    AlvLaskelma laskelma = AlvLaskelma::kaudelle(alkupvm, loppupvm);
+
     QMap<int,qlonglong> verotKannoittainSnt;  // verokanta - maksettava vero
 
     // Lisätään kotimaiset verokannat, jotta ilmoitus näyttää paremmalta
     verotKannoittainSnt.insert(24, 0);
     verotKannoittainSnt.insert(14, 0);
     verotKannoittainSnt.insert(10, 0);
+    QMapIterator<int,qlonglong> kannat( laskelma.verotKannoittain() );
+    while( kannat.hasNext())
+    {
+        kannat.next();
+        verotKannoittainSnt.insert( kannat.key(), kannat.value());
+    }
 
-
-    int bruttoveroayhtSnt = 0;
-    int bruttovahennettavaaSnt = 0;
+    qlonglong bruttoveroayhtSnt = laskelma.bruttoVeroSnt();
+    qlonglong bruttovahennettavaaSnt = laskelma.bruttoVahennysSnt();
+    qlonglong nettoverosnt = laskelma.nettoVeroSnt();
+    qlonglong nettovahennyssnt = laskelma.nettoVahennysSnt();
 
     EhdotusModel ehdotus;
-    QSqlQuery query( *kp()->tietokanta() );
+
+    Tili alvvelka = kp()->tilit()->tiliTyypilla(TiliLaji::ALVVELKA);
+    Tili alvsaatava = kp()->tilit()->tiliTyypilla(TiliLaji::ALVSAATAVA);
+    QHash<int,Tili> tilit;
 
     // 1) Bruttojen oikaisut
     // Korjattu 6.3.2018 #81 since 0.6
 
-    query.exec(  QString("select alvkoodi,alvprosentti,sum(debetsnt) as debetit, sum(kreditsnt) as kreditit, tili from vienti where pvm between \"%3\" and \"%4\" and (alvkoodi=%1 or alvkoodi=%2) group by alvkoodi,tili,alvprosentti")
-                 .arg(AlvKoodi::MYYNNIT_BRUTTO).arg(AlvKoodi::OSTOT_BRUTTO)
-                 .arg(alkupvm.toString(Qt::ISODate)).arg(loppupvm.toString(Qt::ISODate)));
-
-    while( query.next() && query.value("alvprosentti").toInt())
+    for( const AlvLaskelma::Ryhma& ryhma : laskelma.ryhmat())
     {
+        if( ( ryhma.alvkoodi != AlvKoodi::MYYNNIT_BRUTTO && ryhma.alvkoodi != AlvKoodi::OSTOT_BRUTTO) || !ryhma.alvprosentti )
+            continue;
 
-        Tili tili = kp()->tilit()->tiliIdlla( query.value("tili").toInt() );
-        int alvprosentti = query.value("alvprosentti").toInt();
-        qlonglong saldoSnt =  query.value("kreditit").toInt() - query.value("debetit").toLongLong();
+        if( !tilit.contains(ryhma.tiliId))
+            tilit.insert( ryhma.tiliId, kp()->tilit()->tiliIdlla( ryhma.tiliId ));
+        Tili tili = tilit.value( ryhma.tiliId );
+        int alvprosentti = ryhma.alvprosentti;
+        qlonglong saldoSnt =  ryhma.saldoSnt();
 
 
         VientiRivi rivi;        // Rivi, jolla tiliä oikaistaan
@@ -123,7 +137,7 @@ bool AlvIlmoitusDialog::alvIlmoitus(QDate alkupvm, QDate loppupvm)
         verorivi.alvprosentti = alvprosentti;
 
         // Brutosta erotetaan verot
-        qlonglong veroSnt = qRound( ( alvprosentti * (double) saldoSnt ) / ( 100 + alvprosentti) );
+        qlonglong veroSnt = ryhma.bruttoVeroSnt();
         qlonglong nettoSnt = saldoSnt - veroSnt;
 
         if( nettoSnt > 0)
@@ -135,11 +149,8 @@ bool AlvIlmoitusDialog::alvIlmoitus(QDate alkupvm, QDate loppupvm)
             verorivi.debetSnt = 0 - veroSnt;
         }
 
-        if( query.value("alvkoodi").toInt() == AlvKoodi::MYYNNIT_BRUTTO )
+        if( ryhma.alvkoodi == AlvKoodi::MYYNNIT_BRUTTO )
         {
-            verotKannoittainSnt[ alvprosentti ] = verotKannoittainSnt.value(alvprosentti, 0) + veroSnt;
-            bruttoveroayhtSnt += veroSnt;
-
             rivi.selite = tr("Alv-kirjaus %1 - %2 %3 % vero (NETTO %L4 €, BRUTTO %L5€)").arg(alkupvm.toString("dd.MM.yyyy"))
                     .arg(loppupvm.toString("dd.MM.yyyy"))
                     .arg(alvprosentti)
@@ -147,21 +158,19 @@ bool AlvIlmoitusDialog::alvIlmoitus(QDate alkupvm, QDate loppupvm)
                     .arg(saldoSnt / 100.0,0, 'f', 2);            
             rivi.debetSnt = veroSnt;
 
-            verorivi.tili = kp()->tilit()->tiliTyypilla(TiliLaji::ALVVELKA);
+            verorivi.tili = alvvelka;
             verorivi.alvkoodi = AlvKoodi::MYYNNIT_BRUTTO + AlvKoodi::ALVKIRJAUS;
 
         }
         else
         {
-            bruttovahennettavaaSnt += qAbs(veroSnt);
-
             rivi.selite = tr("Alv-kirjaus %1 - %2 %3 % vähennys (NETTO %L4 €, BRUTTO %L5€) ").arg(alkupvm.toString("dd.MM.yyyy"))
                     .arg(loppupvm.toString("dd.MM.yyyy"))
                     .arg(alvprosentti)
                     .arg(qAbs(nettoSnt) / 100.0,0, 'f',2)
                     .arg(qAbs(saldoSnt) / 100.0,0, 'f', 2);
 
-            verorivi.tili = kp()->tilit()->tiliTyypilla(TiliLaji::ALVSAATAVA);
+            verorivi.tili = alvsaatava;
             verorivi.alvkoodi = AlvKoodi::OSTOT_BRUTTO + AlvKoodi::ALVVAHENNYS;
         }
 
@@ -174,59 +183,12 @@ bool AlvIlmoitusDialog::alvIlmoitus(QDate alkupvm, QDate loppupvm)
         ehdotus.lisaaVienti(verorivi);
     }
 
-    // 2) Nettokirjausten koonti
-    query.exec( QString("select alvprosentti, sum(debetsnt) as debetit, sum(kreditsnt) as kreditit from vienti where pvm between \"%1\" and \"%2\" and (alvkoodi=%3 or alvkoodi=%4) group by alvprosentti")
-                .arg(alkupvm.toString(Qt::ISODate)).arg(loppupvm.toString(Qt::ISODate))
-                .arg(AlvKoodi::ALVKIRJAUS + AlvKoodi::MYYNNIT_NETTO).arg(AlvKoodi::ALVKIRJAUS + AlvKoodi::MAKSUPERUSTEINEN_MYYNTI) );
-
-    while( query.next())
-    {
-        int alvprosentti = query.value("alvprosentti").toInt();
-        int saldo = query.value("kreditit").toInt() - query.value("debetit").toInt();
-        verotKannoittainSnt[ alvprosentti ] = verotKannoittainSnt.value(alvprosentti) + saldo;
-    }
-
-
-    // Muut kirjaukset tauluihin
-    query.exec( QString("select alvkoodi, sum(debetsnt) as debetit, sum(kreditsnt) as kreditit from vienti where pvm between \"%1\" and \"%2\" group by alvkoodi")
-                .arg(alkupvm.toString(Qt::ISODate)).arg(loppupvm.toString(Qt::ISODate)) );
-
-    QMap<int,qlonglong> kooditaulu;
-
-    int nettoverosnt = 0;
-    int nettovahennyssnt = 0;
-
-    while( query.next())
-    {
-        qlonglong saldo = query.value("kreditit").toLongLong() - query.value("debetit").toLongLong();
-        int koodi = query.value("alvkoodi").toInt();
-
-        if( koodi > AlvKoodi::MAKSUPERUSTEINEN_KOHDENTAMATON)
-            continue;   // Ei kirjaus eikä vähennys
-        if( koodi  > AlvKoodi::ALVVAHENNYS)
-        {
-            nettovahennyssnt += 0 - saldo;
-            kooditaulu.insert(koodi, 0-saldo);
-        }
-        else if( koodi > AlvKoodi::ALVKIRJAUS)
-        {
-            nettoverosnt += saldo;
-            kooditaulu.insert(koodi, saldo);
-        }
-        else
-        {
-            if( koodi / 10 % 2 )  // 10 myynti, 20 osto jne.
-                kooditaulu.insert(koodi, saldo);
-            else
-                kooditaulu.insert(koodi, 0 - saldo);
-        }
-    }
     // Kirjaus alv-saamistililtä ja alv-velkatililtä verovelkatilille
     if( nettoverosnt + bruttoveroayhtSnt)
     {
         VientiRivi rivi;
         rivi.pvm = loppupvm;
-        rivi.tili = kp()->tilit()->tiliTyypilla(TiliLaji::ALVVELKA);
+        rivi.tili = alvvelka;
         rivi.selite = tr("Alv-kirjaus %1 - %2 ").arg(alkupvm.toString("dd.MM.yyyy")).arg(loppupvm.toString("dd.MM.yyyy"));
         rivi.debetSnt = nettoverosnt + bruttoveroayhtSnt;
         rivi.alvkoodi = AlvKoodi::TILITYS;
@@ -236,14 +198,14 @@ bool AlvIlmoitusDialog::alvIlmoitus(QDate alkupvm, QDate loppupvm)
     {
         VientiRivi rivi;
         rivi.pvm = loppupvm;
-        rivi.tili = kp()->tilit()->tiliTyypilla(TiliLaji::ALVSAATAVA);
+        rivi.tili = alvsaatava;
         rivi.selite = tr("Alv-kirjaus %1 - %2 ").arg(alkupvm.toString("dd.MM.yyyy")).arg(loppupvm.toString("dd.MM.yyyy"));
         rivi.kreditSnt = nettovahennyssnt + bruttovahennettavaaSnt;
         rivi.alvkoodi = AlvKoodi::TILITYS;
         ehdotus.lisaaVienti(rivi);
     }
     // Ja lopuksi kirjataan verot verotilille
-    int maksettavavero = bruttoveroayhtSnt + nettoverosnt - bruttovahennettavaaSnt - nettovahennyssnt;
+    qlonglong maksettavavero = laskelma.maksettavaSnt();
     if( maksettavavero )
     {
         VientiRivi rivi;
@@ -293,24 +255,24 @@ bool AlvIlmoitusDialog::alvIlmoitus(QDate alkupvm, QDate loppupvm)
 
 
     otsikko("Vero ostoista ja maahantuonneista");
-    luku(tr("Vero tavaraostoista muista EU-maista"), kooditaulu.value(AlvKoodi::ALVKIRJAUS + AlvKoodi::YHTEISOHANKINNAT_TAVARAT)  );
-    luku(tr("Vero palveluostoista muista EU-maista"), kooditaulu.value(AlvKoodi::ALVKIRJAUS + AlvKoodi::YHTEISOHANKINNAT_PALVELUT)  );
-    luku(tr("Vero tavaroiden maahantuonnista EU:n ulkopuolelta"), kooditaulu.value(AlvKoodi::ALVKIRJAUS + AlvKoodi::MAAHANTUONTI) );
-    luku(tr("Vero rakentamispalvelun ja metalliromun ostoista"), kooditaulu.value(AlvKoodi::ALVKIRJAUS + AlvKoodi::RAKENNUSPALVELU_OSTO) );
+    luku(tr("Vero tavaraostoista muista EU-maista"), laskelma.koodilla(AlvKoodi::ALVKIRJAUS + AlvKoodi::YHTEISOHANKINNAT_TAVARAT)  );
+    luku(tr("Vero palveluostoista muista EU-maista"), laskelma.koodilla(AlvKoodi::ALVKIRJAUS + AlvKoodi::YHTEISOHANKINNAT_PALVELUT)  );
+    luku(tr("Vero tavaroiden maahantuonnista EU:n ulkopuolelta"), laskelma.koodilla(AlvKoodi::ALVKIRJAUS + AlvKoodi::MAAHANTUONTI) );
+    luku(tr("Vero rakentamispalvelun ja metalliromun ostoista"), laskelma.koodilla(AlvKoodi::ALVKIRJAUS + AlvKoodi::RAKENNUSPALVELU_OSTO) );
 
 
     otsikko("Vähennettävä vero");
     luku(tr("Verokauden vähennettävä vero"), nettovahennyssnt + bruttovahennettavaaSnt );
 
     otsikko( tr("Myynnit ja ostot"));
-    luku(tr("0-verokannan alainen liikevaihto"), kooditaulu.value(AlvKoodi::ALV0) );
-    luku(tr("Tavaroiden myynti muihin EU-maihin"), kooditaulu.value(AlvKoodi::YHTEISOMYYNTI_TAVARAT) );
-    luku(tr("Palveluiden myynti muihin EU-maihin"), kooditaulu.value(AlvKoodi::YHTEISOMYYNTI_PALVELUT) );
-    luku(tr("Tavaraostot muista EU-maista"),kooditaulu.value(AlvKoodi::YHTEISOHANKINNAT_TAVARAT)  );
-    luku(tr("Palveluostot muista EU-maista"), kooditaulu.value(AlvKoodi::YHTEISOHANKINNAT_PALVELUT) );
-    luku(tr("Tavaroiden maahantuonnit EU:n ulkopuolelta"), kooditaulu.value(AlvKoodi::MAAHANTUONTI)  );
-    luku(tr("Rakentamispalveluiden ja metalliromun myynnit"), kooditaulu.value(AlvKoodi::RAKENNUSPALVELU_MYYNTI) );
-    luku(tr("Rakentamispalveluiden ja metalliromun ostot"), kooditaulu.value(AlvKoodi::RAKENNUSPALVELU_OSTO) );
+    luku(tr("0-verokannan alainen liikevaihto"), laskelma.koodilla(AlvKoodi::ALV0) );
+    luku(tr("Tavaroiden myynti muihin EU-maihin"), laskelma.koodilla(AlvKoodi::YHTEISOMYYNTI_TAVARAT) );
+    luku(tr("Palveluiden myynti muihin EU-maihin"), laskelma.koodilla(AlvKoodi::YHTEISOMYYNTI_PALVELUT) );
+    luku(tr("Tavaraostot muista EU-maista"),laskelma.koodilla(AlvKoodi::YHTEISOHANKINNAT_TAVARAT)  );
+    luku(tr("Palveluostot muista EU-maista"), laskelma.koodilla(AlvKoodi::YHTEISOHANKINNAT_PALVELUT) );
+    luku(tr("Tavaroiden maahantuonnit EU:n ulkopuolelta"), laskelma.koodilla(AlvKoodi::MAAHANTUONTI)  );
+    luku(tr("Rakentamispalveluiden ja metalliromun myynnit"), laskelma.koodilla(AlvKoodi::RAKENNUSPALVELU_MYYNTI) );
+    luku(tr("Rakentamispalveluiden ja metalliromun ostot"), laskelma.koodilla(AlvKoodi::RAKENNUSPALVELU_OSTO) );
 
 
     otsikko(tr("Maksettava vero"));
@@ -451,53 +413,63 @@ void AlvIlmoitusDialog::luku(const QString &nimike, qlonglong senttia, bool viiv
 bool AlvIlmoitusDialog::maksuperusteisenTilitys(const QDate &paivayksesta, const QDate &tilityspvm)
 {
     // Hakee kaikki sanottua vanhemmat erät ja jos niillä saldoa, niin lävähtävät maksuun
-    QSqlQuery kysely( QString("SELECT id, alvkoodi, alvprosentti FROM vienti WHERE (tili=%1 OR tili=%2) "
-                              "AND pvm <='%3'")
-                      .arg( kp()->tilit()->tiliTyypilla(TiliLaji::KOHDENTAMATONALVVELKA).id() )
-                      .arg( kp()->tilit()->tiliTyypilla(TiliLaji::KOHDENTAMATONALVSAATAVA).id())
-                      .arg( paivayksesta.toString(Qt::ISODate)));
+    // Erien saldot lasketaan samalla kyselyllä
+    QSqlQuery kysely( *kp()->tietokanta() );
+    kysely.prepare("SELECT era.id AS id, era.alvkoodi AS alvkoodi, era.alvprosentti AS alvprosentti, "
+                   "era.pvm AS pvm, era.selite AS selite, tosite.tunniste AS tunniste, tosite.laji AS laji, "
+                   "SUM(vienti.debetsnt) AS debetit, SUM(vienti.kreditsnt) AS kreditit "
+                   "FROM vienti AS era JOIN vienti ON vienti.eraid=era.id "
+                   "JOIN tosite ON era.tosite=tosite.id "
+                   "WHERE (era.tili=:velka OR era.tili=:saatava) AND era.pvm <= :pvm "
+                   "AND (era.alvkoodi=:myynti OR era.alvkoodi=:osto) "
+                   "GROUP BY era.id HAVING SUM(vienti.debetsnt) <> SUM(vienti.kreditsnt)");
+    kysely.bindValue(":velka", kp()->tilit()->tiliTyypilla(TiliLaji::KOHDENTAMATONALVVELKA).id());
+    kysely.bindValue(":saatava", kp()->tilit()->tiliTyypilla(TiliLaji::KOHDENTAMATONALVSAATAVA).id());
+    kysely.bindValue(":pvm", paivayksesta);
+    kysely.bindValue(":myynti", AlvKoodi::MAKSUPERUSTEINEN_KOHDENTAMATON + AlvKoodi::MAKSUPERUSTEINEN_MYYNTI);
+    kysely.bindValue(":osto", AlvKoodi::MAKSUPERUSTEINEN_KOHDENTAMATON + AlvKoodi::MAKSUPERUSTEINEN_OSTO);
+    kysely.exec();
 
     EhdotusModel ehdotus;
 
+    Tili kohdentamatonSaatava = kp()->tilit()->tiliTyypilla(TiliLaji::KOHDENTAMATONALVSAATAVA);
+    Tili kohdentamatonVelka = kp()->tilit()->tiliTyypilla(TiliLaji::KOHDENTAMATONALVVELKA);
+    Tili alvsaatava = kp()->tilit()->tiliTyypilla(TiliLaji::ALVSAATAVA);
+    Tili alvvelka = kp()->tilit()->tiliTyypilla(TiliLaji::ALVVELKA);
+
     while( kysely.next())
     {
         int alvkoodi = kysely.value("alvkoodi").toInt();
-        if( alvkoodi != AlvKoodi::MAKSUPERUSTEINEN_KOHDENTAMATON + AlvKoodi::MAKSUPERUSTEINEN_MYYNTI &&
-            alvkoodi != AlvKoodi::MAKSUPERUSTEINEN_KOHDENTAMATON + AlvKoodi::MAKSUPERUSTEINEN_OSTO )
-            continue;
-
-        TaseEra veroEra( kysely.value("id").toInt() );
-        qlonglong saldo = veroEra.saldoSnt;
+        bool osto = alvkoodi == AlvKoodi::MAKSUPERUSTEINEN_KOHDENTAMATON + AlvKoodi::MAKSUPERUSTEINEN_OSTO;
 
-        if( !saldo )
-            continue;
+        qlonglong saldo = kysely.value("debetit").toLongLong() - kysely.value("kreditit").toLongLong();
+        QDate pvm = kysely.value("pvm").toDate();
+        QString tositteenTunniste = QString("%1%2/%3")
+                .arg( kp()->tositelajit()->tositelaji( kysely.value("laji").toInt() ).tunnus() )
+                .arg( kysely.value("tunniste").toInt() )
+                .arg( kp()->tilikaudet()->tilikausiPaivalle( pvm ).kausitunnus() );
 
         // Kirjataan kohdentamattomasta alv-velasta (saatavasta) alv-velkaan (saatavaan)
 
         VientiRivi kohdentamaton;
         kohdentamaton.pvm = tilityspvm;
-        kohdentamaton.tili = alvkoodi == AlvKoodi::MAKSUPERUSTEINEN_KOHDENTAMATON + AlvKoodi::MAKSUPERUSTEINEN_OSTO ?
-                    kp()->tilit()->tiliTyypilla(TiliLaji::KOHDENTAMATONALVSAATAVA) :
-                    kp()->tilit()->tiliTyypilla(TiliLaji::KOHDENTAMATONALVVELKA);
+        kohdentamaton.tili = osto ? kohdentamatonSaatava : kohdentamatonVelka;
         kohdentamaton.kreditSnt = saldo > 0 ? saldo : 0;
         kohdentamaton.debetSnt = saldo < 0 ? 0 - saldo : 0;
         kohdentamaton.alvkoodi = AlvKoodi::TILITYS;
         kohdentamaton.eraId = kysely.value("id").toInt();
         kohdentamaton.selite = tr("Maksuperusteinen %1 % alv %2 / %3 [%4]").arg( kysely.value("alvprosentti").toInt() )
-                .arg(veroEra.tositteenTunniste()).arg(veroEra.pvm.toString("dd.MM.yyyy"))
-                .arg(veroEra.selite);
+                .arg(tositteenTunniste).arg(pvm.toString("dd.MM.yyyy"))
+                .arg(kysely.value("selite").toString());
 
         VientiRivi verorivi;
         verorivi.pvm = tilityspvm;
-        verorivi.tili = alvkoodi == AlvKoodi::MAKSUPERUSTEINEN_KOHDENTAMATON + AlvKoodi::MAKSUPERUSTEINEN_OSTO ?
-                    kp()->tilit()->tiliTyypilla(TiliLaji::ALVSAATAVA) :
-                    kp()->tilit()->tiliTyypilla(TiliLaji::ALVVELKA);
+        verorivi.tili = osto ? alvsaatava : alvvelka;
         verorivi.debetSnt = kohdentamaton.kreditSnt;
         verorivi.kreditSnt = kohdentamaton.debetSnt;
         verorivi.selite = kohdentamaton.selite;
-        verorivi.alvkoodi = alvkoodi == AlvKoodi::MAKSUPERUSTEINEN_KOHDENTAMATON + AlvKoodi::MAKSUPERUSTEINEN_OSTO ?
-                    AlvKoodi::ALVVAHENNYS + AlvKoodi::MAKSUPERUSTEINEN_OSTO :
-                    AlvKoodi::ALVKIRJAUS + AlvKoodi::MAKSUPERUSTEINEN_MYYNTI;
+        verorivi.alvkoodi = osto ? AlvKoodi::ALVVAHENNYS + AlvKoodi::MAKSUPERUSTEINEN_OSTO :
+                                   AlvKoodi::ALVKIRJAUS + AlvKoodi::MAKSUPERUSTEINEN_MYYNTI;
         verorivi.alvprosentti = kysely.value("alvprosentti").toInt();
 
         ehdotus.lisaaVienti(kohdentamaton);
@@ -18,7 +18,7 @@
 #include <QSettings>
 #include <QSslSocket>
 
-#include "laskutus/smtp.h"
+#include "laskutus/smtpjono.h"
 
 #include "emailmaaritys.h"
 #include "db/kirjanpito.h"
@@ -114,17 +114,27 @@ void EmailMaaritys::kokeile()
     ui->tulosLabel->clear();
     QString osoite = QString("=?utf-8?Q?%1?= <%2>").arg(ui->nimiEdit->text()).arg(ui->emailEdit->text());
 
-    Smtp *smtp = new Smtp( ui->kayttajaEdit->text(), ui->salasanaEdit->text(), ui->palvelinEdit->text(), ui->porttiSpin->value());
+    SmtpJono *smtp = new SmtpJono( ui->kayttajaEdit->text(), ui->salasanaEdit->text(), ui->palvelinEdit->text(), ui->porttiSpin->value());
     connect( smtp, SIGNAL(status(QString)), ui->tulosLabel, SLOT(setText(QString)));
+    connect( smtp, &SmtpJono::viestiLahetetty, ui->tulosLabel, [this] { ui->tulosLabel->setText(tr("Sähköposti lähetetty")); });
+    connect( smtp, &SmtpJono::viestiEpaonnistui, ui->tulosLabel, [this] (int, const QString& virhe)
+        { ui->tulosLabel->setText(tr("Sähköpostin lähetys epäonnistui: %1").arg(virhe)); });
+    connect( smtp, &SmtpJono::valmis, smtp, &SmtpJono::deleteLater);
 
 
     QFile kuva(":/pic/possukirjaa.png");
     kuva.open(QIODevice::ReadOnly);
 
-    smtp->lahetaLiitteella(osoite, osoite, tr("Kitupiikin sähköpostikokeilu"),
-                           tr("<html><body><h3>Kitupiikin sähköposti</h3><p>Sähköpostin lähettäminen Kitupiikki-ohjelmasta onnistui.</p>"
-                              "<hr>%1 </body></html>").arg(QDateTime::currentDateTime().toString("dd.MM.yyyy hh.mm")),
-                       "possu.png", kuva.readAll());
+    SmtpViesti viesti;
+    viesti.lahettaja = osoite;
+    viesti.vastaanottaja = osoite;
+    viesti.otsikko = tr("Kitupiikin sähköpostikokeilu");
+    viesti.html = tr("<html><body><h3>Kitupiikin sähköposti</h3><p>Sähköpostin lähettäminen Kitupiikki-ohjelmasta onnistui.</p>"
+                     "<hr>%1 </body></html>").arg(QDateTime::currentDateTime().toString("dd.MM.yyyy hh.mm"));
+    viesti.liitenimi = "possu.png";
+    viesti.liite = kuva.readAll();
+
+    smtp->lisaa(viesti);
 
 }
 
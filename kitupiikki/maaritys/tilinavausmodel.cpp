@@ -16,6 +16,7 @@
 */
 
 #include "tilinavausmodel.h"
+#include "db/hakuindeksi.h"
 
 #include <QSqlQuery>
 #include <QMessageBox>
@@ -216,7 +217,9 @@ bool TilinavausModel::tallenna()
         }
         kysely.exec();
     }
+    kp()->hakuindeksi()->paivitaTosite(0);
     kp()->asetukset()->aseta("Tilinavaus",1);   // Tilit merkitään avatuiksi
+    kp()->merkitseMuutos();     // Avaussaldot vaikuttavat kaikkiin raportteihin
 
     muokattu_ = false;
     return true;
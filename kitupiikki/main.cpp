@@ -22,11 +22,11 @@
 #include <QTextCodec>
 #include <QIcon>
 #include <QTranslator>
-#include <QFontDatabase>
 
 #include "db/kirjanpito.h"
 #include "kitupiikkiikkuna.h"
 #include "versio.h"
+#include "eraajo/eraajo.h"
 
 #include <QDebug>
 #include <QDir>
@@ -65,6 +65,11 @@ void lisaaLinuxinKaynnistysValikkoon()
 
 int main(int argc, char *argv[])
 {
+    // Eräajossa ei tarvita näyttöä
+    bool eraajo = Eraajo::onkoEraajo(argc, argv);
+    if( eraajo && qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
     QApplication a(argc, argv);
 
 #if defined (Q_OS_WIN) || defined (Q_OS_MACX)
@@ -109,6 +114,11 @@ int main(int argc, char *argv[])
 #endif
     Kirjanpito::asetaInstanssi(&kirjanpito);
 
+    if( eraajo )
+    {
+        Eraajo ajo;
+        return ajo.suorita( argumentit );
+    }
 
     // Jos versio on muuttunut, näytetään tervetulodialogi    
     if( kp()->settings()->value("ViimeksiVersiolla").toString() != a.applicationVersion()  )
@@ -140,9 +150,6 @@ int main(int argc, char *argv[])
     splash->setPixmap( QPixmap(":/pic/splash.png"));
     splash->show();
 
-    // Viivakoodifontti
-    QFontDatabase::addApplicationFont(":/code128_XL.ttf");
-
     KitupiikkiIkkuna ikkuna;
 
     ikkuna.show();
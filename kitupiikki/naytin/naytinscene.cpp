@@ -16,6 +16,8 @@
 */
 #include "naytinscene.h"
 
+#include <QIODevice>
+
 
 
 NaytinScene::NaytinScene(QObject *parent)
@@ -29,3 +31,12 @@ bool NaytinScene::raidoita(bool /* raidat */)
     return false;
 }
 
+bool NaytinScene::kirjoitaCsv(QIODevice *laite)
+{
+    return laite->write( csv() ) > -1;
+}
+
+bool NaytinScene::kirjoitaHtml(QIODevice *laite)
+{
+    return laite->write( html().toUtf8() ) > -1;
+}
@@ -25,6 +25,7 @@
  */
 
 class QPrinter;
+class QIODevice;
 
 /**
  * @brief Scenen kantaluokka Nayttimeen
@@ -49,6 +50,17 @@ public:
     virtual QByteArray data() = 0;
     virtual QString html() { return QString(); }
 
+    /**
+     * @brief Kirjoittaa csv-muodon avattuun tiedostoon
+     * @since 1.1
+     */
+    virtual bool kirjoitaCsv(QIODevice *laite);
+    /**
+     * @brief Kirjoittaa html-muodon avattuun tiedostoon
+     * @since 1.1
+     */
+    virtual bool kirjoitaHtml(QIODevice *laite);
+
     virtual void tulosta(QPrinter* printer) = 0;
 
     virtual bool raidoita(bool raidat = false);
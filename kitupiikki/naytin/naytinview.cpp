@@ -31,7 +31,6 @@
 #include <QMessageBox>
 #include <QDesktopServices>
 #include <QPrintDialog>
-#include <QTextStream>
 
 #include <QDialog>
 #include "ui_csvvientivalinnat.h"
@@ -158,11 +157,7 @@ void NaytinView::avaaHtml()
 
     QFile tiedosto( tiedostonnimi);
     tiedosto.open( QIODevice::WriteOnly);
-
-    QTextStream out( &tiedosto);
-    out.setCodec("UTF-8");
-
-    out << html();
+    scene_->kirjoitaHtml( &tiedosto );
     tiedosto.close();
 
     Kirjanpito::avaaUrl(QUrl::fromLocalFile(tiedostonnimi));
@@ -191,10 +186,9 @@ void NaytinView::tallennaHtml()
                                   tr("Tiedostoon %1 kirjoittaminen epäonnistui.").arg(polku));
             return;
         }
-        QTextStream out( &tiedosto);
-        out.setCodec("UTF-8");
-
-        out << html();
+        if( !scene_->kirjoitaHtml( &tiedosto ))
+            QMessageBox::critical(this, tr("Tiedoston vieminen"),
+                                  tr("Tiedostoon %1 kirjoittaminen epäonnistui.").arg(polku));
         tiedosto.close();
     }
 }
@@ -265,7 +259,9 @@ void NaytinView::tallennaCsv()
                                   tr("Tiedostoon %1 kirjoittaminen epäonnistui.").arg(polku));
             return;
         }
-        tiedosto.write( csv() );
+        if( !scene_->kirjoitaCsv( &tiedosto ))
+            QMessageBox::critical(this, tr("Tiedoston vieminen"),
+                                  tr("Tiedostoon %1 kirjoittaminen epäonnistui.").arg(polku));
     }
 }
 
@@ -15,11 +15,15 @@
    along with this program. If not, see <http://www.gnu.org/licenses/>.
 */
 #include "raporttiscene.h"
+#include "raporttisivuitem.h"
+#include "db/kirjanpito.h"
+
 #include <QPainter>
+#include <QPageLayout>
 
 
 RaporttiScene::RaporttiScene(QObject *parent) :
-    PdfScene (parent)
+    NaytinScene (parent)
 {
 
 }
@@ -33,7 +37,7 @@ RaporttiScene::RaporttiScene(RaportinKirjoittaja raportti, QObject *parent) :
 void RaporttiScene::nayta(RaportinKirjoittaja raportti)
 {
     raportti_ = raportti;
-    naytaPdf( raportti_.pdf(raidat_) );
+    sivuta();
 }
 
 QString RaporttiScene::otsikko() const
@@ -51,16 +55,59 @@ QString RaporttiScene::html()
     return raportti_.html();
 }
 
+bool RaporttiScene::kirjoitaCsv(QIODevice *laite)
+{
+    return raportti_.kirjoitaLaitteeseen(laite, RaportinKirjoittaja::CSV);
+}
+
+bool RaporttiScene::kirjoitaHtml(QIODevice *laite)
+{
+    return raportti_.kirjoitaLaitteeseen(laite, RaportinKirjoittaja::HTML);
+}
+
+QByteArray RaporttiScene::data()
+{
+    return raportti_.pdf(raidat_);
+}
+
+void RaporttiScene::piirraLeveyteen(double leveyteen)
+{
+    setBackgroundBrush(QBrush(Qt::gray));
+    clear();
+
+    if( sivunKoko_.isEmpty())
+        return;
+
+    double skaala = leveyteen / sivunKoko_.width();
+    double korkeus = sivunKoko_.height() * skaala;
+    double ypos = 0.0;
+
+    // Sivut pinotaan päällekkäin, ja kukin piirretään vasta näkyviin tullessaan
+    for( int sivu = 0; sivu < sivut_.count(); sivu++)
+    {
+        addRect(2, ypos+2, leveyteen, korkeus, QPen(Qt::NoPen), QBrush(Qt::black) );
+
+        RaporttiSivuItem *item = new RaporttiSivuItem(this, sivu);
+        item->setScale( skaala );
+        item->setPos( 0, ypos );
+        addItem( item );
+
+        ypos += korkeus + 10.0;
+    }
+
+    setSceneRect(-5.0, -5.0, leveyteen + 10.0, ypos + 5.0  );
+}
+
 bool RaporttiScene::sivunAsetuksetMuuttuneet()
 {
-    naytaPdf( raportti_.pdf(raidat_) );
+    sivuta();
     return true;
 }
 
 bool RaporttiScene::raidoita(bool raidat)
 {
     raidat_ = raidat;
-    naytaPdf( raportti_.pdf(raidat_));
+    kuvat_.clear();
     return true;
 }
 
@@ -71,6 +118,40 @@ void RaporttiScene::tulosta(QPrinter *printer)
     painter.end();
 }
 
+QPicture RaporttiScene::sivunKuva(int sivu)
+{
+    if( !kuvat_.contains(sivu) && sivu < sivut_.count())
+    {
+        QPicture kuva;
+        kuva.setBoundingRect( QRect( QPoint(0,0), tulostusalue_.size()));
+        QPainter painter( &kuva );
+        raportti_.tulostaSivu( &painter, pieniSivu_, sivut_.at(sivu), sivu + 1, raidat_);
+        painter.end();
+        kuvat_.insert(sivu, kuva);
+    }
+    return kuvat_.value(sivu);
+}
+
+void RaporttiScene::sivuta()
+{
+    // Sivu mitoitetaan samoille pisteille, joilla kuvat piirretään
+    QPicture mitta;
+    double vaakaskaala = mitta.logicalDpiX() / 72.0;
+    double pystyskaala = mitta.logicalDpiY() / 72.0;
+
+    QPageLayout asettelu = kp()->printer()->pageLayout();
+    QRectF sivu = asettelu.fullRectPoints();
+    QRectF alue = asettelu.paintRectPoints();
+
+    sivunKoko_ = QSizeF( sivu.width() * vaakaskaala, sivu.height() * pystyskaala );
+    tulostusalue_ = QRect( qRound( alue.x() * vaakaskaala), qRound( alue.y() * pystyskaala),
+                           qRound( alue.width() * vaakaskaala), qRound( alue.height() * pystyskaala));
+    pieniSivu_ = asettelu.pageSize().size(QPageSize::Millimeter).width() < 300;
+
+    kuvat_.clear();
+    sivut_ = raportti_.sivuta( tulostusalue_.size(), pieniSivu_ );
+}
+
 bool RaporttiScene::csvMuoto()
 {
     return raportti_.csvKaytossa();
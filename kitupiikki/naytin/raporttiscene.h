@@ -17,13 +17,19 @@
 #ifndef RAPORTTISCENE_H
 #define RAPORTTISCENE_H
 
-#include "pdfscene.h"
+#include <QHash>
+#include <QPicture>
+
+#include "naytinscene.h"
 #include "raportti/raportinkirjoittaja.h"
 
 /**
  * @brief Raportin käsittely Näyttimessä
+ *
+ * Raportin sivut piirretään suoraan raportin riveistä vektorikuviksi vasta,
+ * kun sivu tulee näkyviin. Pdf-tiedosto muodostetaan vain tallennettaessa.
  */
-class RaporttiScene : public PdfScene
+class RaporttiScene : public NaytinScene
 {
     Q_OBJECT
 public:
@@ -40,14 +46,47 @@ public:
     virtual QByteArray csv() override;
     virtual QString html() override;
 
+    virtual bool kirjoitaCsv(QIODevice *laite) override;
+    virtual bool kirjoitaHtml(QIODevice *laite) override;
+
+    QString tiedostonMuoto() override { return tr("pdf-tiedosto (*.pdf)");}
+    QString tiedostoPaate() override { return "pdf"; }
+    QByteArray data() override;
+
+    void piirraLeveyteen(double leveyteen) override;
+
     virtual bool sivunAsetuksetMuuttuneet() override;
     virtual bool raidoita(bool raidat=false) override;
 
     virtual void tulosta(QPrinter *printer) override;
 
+    /**
+     * @brief Sivun koko näyttimen pisteinä
+     */
+    QSizeF sivunKoko() const { return sivunKoko_; }
+    /**
+     * @brief Sivun tulostusalue näyttimen pisteinä
+     */
+    QRect tulostusalue() const { return tulostusalue_; }
+
+    /**
+     * @brief Sivun tulostusalueen kuva
+     *
+     * Sivu piirretään ensimmäisellä kerralla, kun sitä tarvitaan
+     */
+    QPicture sivunKuva(int sivu);
+
 private:
+    void sivuta();
+
     RaportinKirjoittaja raportti_;
     bool raidat_ = false;
+
+    bool pieniSivu_ = false;
+    QSizeF sivunKoko_;
+    QRect tulostusalue_;
+    QList<int> sivut_;          /** Sivujen ensimmäiset rivit */
+    QHash<int,QPicture> kuvat_;
 };
 
 #endif // RAPORTTISCENE_H
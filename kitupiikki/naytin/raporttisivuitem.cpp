@@ -0,0 +1,41 @@
+/*
+   Copyright (C) 2018 Arto Hyvättinen
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "raporttisivuitem.h"
+#include "raporttiscene.h"
+
+#include <QPainter>
+
+RaporttiSivuItem::RaporttiSivuItem(RaporttiScene *scene, int sivu) :
+    scene_(scene), sivu_(sivu)
+{
+
+}
+
+QRectF RaporttiSivuItem::boundingRect() const
+{
+    return QRectF( QPointF(0,0), scene_->sivunKoko());
+}
+
+void RaporttiSivuItem::paint(QPainter *painter, const QStyleOptionGraphicsItem * /* option */, QWidget * /* widget */)
+{
+    painter->fillRect( boundingRect(), Qt::white);
+    painter->drawPicture( scene_->tulostusalue().topLeft(), scene_->sivunKuva(sivu_));
+
+    painter->setPen( QPen(Qt::black, 0));
+    painter->setBrush( Qt::NoBrush );
+    painter->drawRect( boundingRect());
+}
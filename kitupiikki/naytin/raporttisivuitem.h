@@ -0,0 +1,45 @@
+/*
+   Copyright (C) 2018 Arto Hyvättinen
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef RAPORTTISIVUITEM_H
+#define RAPORTTISIVUITEM_H
+
+#include <QGraphicsItem>
+
+class RaporttiScene;
+
+/**
+ * @brief Raportin yksi sivu Näyttimessä
+ *
+ * Sivun sisältö haetaan RaporttiScenestä vasta piirrettäessä, joten
+ * näkymättömiä sivuja ei piirretä lainkaan.
+ *
+ * @since 1.1
+ */
+class RaporttiSivuItem : public QGraphicsItem
+{
+public:
+    RaporttiSivuItem(RaporttiScene *scene, int sivu);
+
+    QRectF boundingRect() const override;
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+
+protected:
+    RaporttiScene *scene_;
+    int sivu_;
+};
+
+#endif // RAPORTTISIVUITEM_H
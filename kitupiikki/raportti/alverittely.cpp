@@ -15,9 +15,12 @@
    along with this program. If not, see <http://www.gnu.org/licenses/>.
 */
 
-#include <QSqlQuery>
+#include <QMap>
+#include <QPair>
 
 #include "alverittely.h"
+#include "alvlaskelma.h"
+#include "raporttivalimuisti.h"
 
 #include "ui_taseerittely.h"
 #include "db/kirjanpito.h"
@@ -48,6 +51,11 @@ RaportinKirjoittaja AlvErittely::raportti()
 
 RaportinKirjoittaja AlvErittely::kirjoitaRaporti(QDate alkupvm, QDate loppupvm)
 {
+    RaporttiValimuisti muisti( QString("AlvErittely %1 %2").arg(alkupvm.toString(Qt::ISODate)).arg(loppupvm.toString(Qt::ISODate)),
+                               alkupvm, loppupvm);
+    if( muisti.loytyi())
+        return muisti.raportti();
+
     RaportinKirjoittaja kirjoittaja(false);
     kirjoittaja.asetaOtsikko(tr("ARVONLISÄVEROLASKELMAN ERITTELY"));
     kirjoittaja.asetaKausiteksti( QString("%1 - %2").arg(alkupvm.toString("dd.MM.yyyy")).arg(loppupvm.toString("dd.MM.yyyy") ) );
@@ -66,13 +74,13 @@ RaportinKirjoittaja AlvErittely::kirjoitaRaporti(QDate alkupvm, QDate loppupvm)
     otsikko.lisaa("€",1,true);
     kirjoittaja.lisaaOtsake(otsikko);
 
-    QSqlQuery kysely;
-    QString kysymys = QString("select vienti.pvm as paiva, debetsnt, kreditsnt, selite, alvkoodi, alvprosentti, nro, tunniste, laji "
-                              "from vienti,tili,tosite where vienti.tosite=tosite.id and vienti.tili=tili.id "
-                              "and vienti.pvm between \"%1\" and \"%2\" "
-                              "and alvkoodi > 0 order by alvkoodi, alvprosentti desc, tili, vienti.pvm")
-            .arg(alkupvm.toString(Qt::ISODate))
-            .arg(loppupvm.toString(Qt::ISODate));
+    AlvLaskelma laskelma = AlvLaskelma::kaudelle(alkupvm, loppupvm);
+
+    // Bruttokirjausten veron osuus haetaan tilin ryhmästä
+    QMap<QPair<int,QPair<int,int>>, AlvLaskelma::Ryhma> ryhmat;
+    for( const AlvLaskelma::Ryhma& ryhma : laskelma.ryhmat())
+        if( ryhma.alvkoodi != AlvKoodi::TILITYS)
+            ryhmat.insert( qMakePair(ryhma.alvkoodi, qMakePair(ryhma.alvprosentti, ryhma.tiliId)), ryhma );
 
     int nAlvkoodi = -1; // edellisten alv-prosentti jne...
     int nTili = -1;
@@ -80,30 +88,27 @@ RaportinKirjoittaja AlvErittely::kirjoitaRaporti(QDate alkupvm, QDate loppupvm)
     qlonglong tilisumma = 0;
     qlonglong yhtsumma = 0;
 
-    qlonglong veroyhteensa = 0;
-    qlonglong vahennysyhteensa = 0;
+    // Teknisiä kirjauksia ei tulosteta erittelyyn
+    QList<AlvLaskelma::Vienti> viennit;
+    for( const AlvLaskelma::Vienti& vienti : laskelma.viennit())
+        if( vienti.alvkoodi != AlvKoodi::TILITYS)
+            viennit.append(vienti);
 
-    int alvkoodi = -1;
-    int alvprosentti = -1;
-    int tilinro = -1;
-
-    kysely.exec(kysymys);
-    while( true )
+    for( int i = 0; i <= viennit.count(); i++ )
     {
         // Jotta myös viimeisen rivin jälkeen tulee vielä summat
         // tulee break vasta summatulostuksen jälkeen
 
-        bool jatkuu = kysely.next();
-
+        bool jatkuu = i < viennit.count();
+        AlvLaskelma::Vienti vienti;
         if( jatkuu )
-        {
-            alvkoodi = kysely.value("alvkoodi").toInt();
-            alvprosentti = kysely.value("alvprosentti").toInt();
-            tilinro = kysely.value("nro").toInt();
-        }
+            vienti = viennit.at(i);
 
+        int alvkoodi = vienti.alvkoodi;
+        int alvprosentti = vienti.alvprosentti;
+        int tiliId = vienti.tiliId;
 
-        if( tilinro != nTili || alvkoodi != nAlvkoodi || alvprosentti != nProsentti || !jatkuu )
+        if( tiliId != nTili || alvkoodi != nAlvkoodi || alvprosentti != nProsentti || !jatkuu )
         {
             if( tilisumma)
             {
@@ -125,22 +130,20 @@ RaportinKirjoittaja AlvErittely::kirjoitaRaporti(QDate alkupvm, QDate loppupvm)
                     // lisätään se yhteissummiin. Tämä sitä varten, että myös kesken kauden
                     // tulostettavassa alv-erittelyssä näkyisi alv bruttokirjauksista
 
-                    int osuus = qRound( ( nProsentti  * (double) tilisumma ) / ( nProsentti + 100  ) );
+                    qlonglong osuus = ryhmat.value( qMakePair(nAlvkoodi, qMakePair(nProsentti, nTili))).bruttoVeroSnt();
+                    if( AlvLaskelma::debetKoodi(nAlvkoodi))
+                        osuus = 0 - osuus;
+
                     RaporttiRivi osuusRivi;
                     osuusRivi.lisaa(" ", 2);
                     osuusRivi.lisaa("Arvonlisäveron osuus bruttosummasta");
-                    if( nAlvkoodi == AlvKoodi::MYYNNIT_BRUTTO ) {
-                        veroyhteensa += osuus;
-                    } else {
-                        vahennysyhteensa += osuus;
-                    }
                     osuusRivi.lisaa(QString::number(nProsentti) );
                     osuusRivi.lisaa(osuus);
                     kirjoittaja.lisaaRivi(osuusRivi);
 
                 }
 
-                if( (alvkoodi != nAlvkoodi || alvprosentti != nProsentti || !jatkuu) && yhtsumma != tilisumma && alvkoodi != AlvKoodi::TILITYS)
+                if( (alvkoodi != nAlvkoodi || alvprosentti != nProsentti || !jatkuu) && yhtsumma != tilisumma )
                 {
                     // Lopuksi vielä lihavoituna alv-koodin ja -prosentin kokonaissumma
                     RaporttiRivi summaRivi;
@@ -165,11 +168,6 @@ RaportinKirjoittaja AlvErittely::kirjoitaRaporti(QDate alkupvm, QDate loppupvm)
         if( !jatkuu )
             break;
 
-        // Teknisiä kirjauksia ei tulosteta erittelyyn
-        if( alvkoodi == AlvKoodi::TILITYS)
-            continue;
-
-
         if( alvkoodi != nAlvkoodi || alvprosentti != nProsentti)
         {
 
@@ -199,10 +197,10 @@ RaportinKirjoittaja AlvErittely::kirjoitaRaporti(QDate alkupvm, QDate loppupvm)
             yhtsumma = 0;
         }
 
-        if( tilinro != nTili )
+        if( tiliId != nTili )
         {
             RaporttiRivi tiliOtsikko;
-            tiliOtsikko.lisaa( tr("%1 %2").arg(tilinro).arg(kp()->tilit()->tiliNumerolla(tilinro).nimi() ), 3);
+            tiliOtsikko.lisaa( tr("%1 %2").arg(vienti.tilinro).arg(kp()->tilit()->tiliNumerolla(vienti.tilinro).nimi() ), 3);
 
             if( alvkoodi == AlvKoodi::MAKSETTAVAALV)
                 tiliOtsikko.lisaa("");
@@ -210,14 +208,13 @@ RaportinKirjoittaja AlvErittely::kirjoitaRaporti(QDate alkupvm, QDate loppupvm)
                 tiliOtsikko.lisaa( QString::number(alvprosentti));
 
             kirjoittaja.lisaaRivi(tiliOtsikko);
-            nTili = tilinro;
+            nTili = tiliId;
         }
 
         RaporttiRivi rivi;
-        rivi.lisaa( kysely.value("paiva").toDate() );
-        rivi.lisaa( QString("%1%2").arg( kp()->tositelajit()->tositelaji( kysely.value("laji").toInt() ).tunnus() )
-                    .arg( kysely.value("tunniste").toInt() ));
-        rivi.lisaa( kysely.value("selite").toString());
+        rivi.lisaa( vienti.pvm );
+        rivi.lisaa( vienti.tosite );
+        rivi.lisaa( vienti.selite );
 
         if( alvkoodi == AlvKoodi::MAKSETTAVAALV)
             rivi.lisaa("");
@@ -225,31 +222,22 @@ RaportinKirjoittaja AlvErittely::kirjoitaRaporti(QDate alkupvm, QDate loppupvm)
             rivi.lisaa( QString::number(alvprosentti));
 
         // Rahamäärän etumerkitys riippuu alv-koodista
-        int debetsnt = kysely.value("debetsnt").toInt();
-        int kreditsnt = kysely.value("kreditsnt").toInt();
+        qlonglong summa = vienti.kreditSnt - vienti.debetSnt;   // MYYNTI tai KIRJAUS tai MAKSETTAVA ALV
 
-        int summa = kreditsnt - debetsnt;   // MYYNTI tai KIRJAUS tai MAKSETTAVA ALV
-
-        if( (( alvkoodi / 100 == 0 || alvkoodi / 100 == 4 ) && alvkoodi % 20 / 10 == 0  ) ||  ( alvkoodi / 100 == 2 ) )
-            // 1nx (n parillinen) = OSTO  4nx Maksuperusteinen OSTO , 2xx VÄHENNYS
-            summa = debetsnt - kreditsnt;
+        if( AlvLaskelma::debetKoodi(alvkoodi) )
+            summa = vienti.debetSnt - vienti.kreditSnt;
 
         rivi.lisaa( summa );
         kirjoittaja.lisaaRivi( rivi );
 
         tilisumma += summa;
         yhtsumma += summa;
-
-        // Brutto-alv lisätään tileittän, joten sitä ei lisätä enää alv-kirjauksesta
-        // Nettokirjausten alv:t lisätään alv-kirjauksista
-
-        if( alvkoodi >= AlvKoodi::ALVVAHENNYS && alvkoodi < AlvKoodi::MAKSUPERUSTEINEN_KOHDENTAMATON && alvkoodi != AlvKoodi::ALVVAHENNYS + AlvKoodi::OSTOT_BRUTTO)
-            vahennysyhteensa += summa;
-        else if( alvkoodi >= AlvKoodi::ALVKIRJAUS && alvkoodi < AlvKoodi::ALVVAHENNYS && alvkoodi != AlvKoodi::ALVKIRJAUS + AlvKoodi::MYYNNIT_BRUTTO)
-            veroyhteensa += summa;
-
     }
 
+    // Yhteenvedon luvut tulevat samasta laskelmasta kuin alv-ilmoituksessa
+    qlonglong veroyhteensa = laskelma.veroSnt();
+    qlonglong vahennysyhteensa = laskelma.vahennysSnt();
+
     kirjoittaja.lisaaTyhjaRivi();
 
     // Lopuksi yhteenveto verosta ja vähennyksestä
@@ -276,5 +264,5 @@ RaportinKirjoittaja AlvErittely::kirjoitaRaporti(QDate alkupvm, QDate loppupvm)
 
 
 
-    return kirjoittaja;
+    return muisti.tallenna(kirjoittaja);
 }
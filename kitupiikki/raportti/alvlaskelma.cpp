@@ -0,0 +1,173 @@
+/*
+   Copyright (C) 2018 Arto Hyvättinen
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QSqlQuery>
+#include <QHash>
+#include <QPair>
+
+#include "alvlaskelma.h"
+#include "db/kirjanpito.h"
+
+namespace {
+
+// Laskelma ja kauden kirjausten muutosversio, jolla se on laskettu
+typedef QMap<QPair<QDate,QDate>, QPair<qulonglong, AlvLaskelma>> AlvValimuisti;
+
+AlvValimuisti& valimuisti()
+{
+    static AlvValimuisti muisti;
+    static bool kytketty = false;
+
+    if( !kytketty )
+    {
+        QObject::connect( kp(), &Kirjanpito::tietokantaVaihtui, [] { muisti.clear(); });
+        kytketty = true;
+    }
+    return muisti;
+}
+
+}
+
+qlonglong AlvLaskelma::Ryhma::bruttoVeroSnt() const
+{
+    if( !alvprosentti )
+        return 0;
+    return qRound( ( alvprosentti * (double) saldoSnt() ) / ( 100 + alvprosentti) );
+}
+
+AlvLaskelma::AlvLaskelma()
+{
+
+}
+
+AlvLaskelma AlvLaskelma::kaudelle(const QDate &alkupvm, const QDate &loppupvm)
+{
+    QPair<QDate,QDate> kausi = qMakePair(alkupvm, loppupvm);
+
+    // Laskelma lasketaan uudelleen vain, jos kauden kirjauksia on muutettu
+    qulonglong versio = kp()->muutosversio(alkupvm, loppupvm);
+    AlvValimuisti& muisti = valimuisti();
+    if( !muisti.contains(kausi) || muisti.value(kausi).first != versio)
+    {
+        AlvLaskelma laskelma;
+        laskelma.laske(alkupvm, loppupvm);
+        muisti.insert(kausi, qMakePair(versio, laskelma));
+    }
+    return muisti.value(kausi).second;
+}
+
+bool AlvLaskelma::debetKoodi(int alvkoodi)
+{
+    // 1nx (n parillinen) = OSTO  4nx Maksuperusteinen OSTO , 2xx VÄHENNYS
+    return (( alvkoodi / 100 == 0 || alvkoodi / 100 == 4 ) && alvkoodi % 20 / 10 == 0  ) ||  ( alvkoodi / 100 == 2 );
+}
+
+void AlvLaskelma::laske(const QDate &alkupvm, const QDate &loppupvm)
+{
+    alkupvm_ = alkupvm;
+    loppupvm_ = loppupvm;
+
+    QSqlQuery kysely( *kp()->tietokanta() );
+    kysely.prepare("SELECT vienti.pvm AS paiva, debetsnt, kreditsnt, selite, alvkoodi, alvprosentti, "
+                   "vienti.tili AS tiliid, nro, tunniste, laji "
+                   "FROM vienti, tili, tosite WHERE vienti.tosite=tosite.id AND vienti.tili=tili.id "
+                   "AND vienti.pvm BETWEEN :alku AND :loppu AND alvkoodi > 0 "
+                   "ORDER BY alvkoodi, alvprosentti DESC, vienti.tili, vienti.pvm");
+    kysely.bindValue(":alku", alkupvm);
+    kysely.bindValue(":loppu", loppupvm);
+    kysely.exec();
+
+    QHash<int,QString> lajitunnukset;
+    Ryhma ryhma;
+
+    while( kysely.next())
+    {
+        Vienti vienti;
+        vienti.pvm = kysely.value("paiva").toDate();
+        vienti.selite = kysely.value("selite").toString();
+        vienti.alvkoodi = kysely.value("alvkoodi").toInt();
+        vienti.alvprosentti = kysely.value("alvprosentti").toInt();
+        vienti.tiliId = kysely.value("tiliid").toInt();
+        vienti.tilinro = kysely.value("nro").toInt();
+        vienti.debetSnt = kysely.value("debetsnt").toLongLong();
+        vienti.kreditSnt = kysely.value("kreditsnt").toLongLong();
+
+        int laji = kysely.value("laji").toInt();
+        if( !lajitunnukset.contains(laji))
+            lajitunnukset.insert(laji, kp()->tositelajit()->tositelaji(laji).tunnus());
+        vienti.tosite = QString("%1%2").arg( lajitunnukset.value(laji) ).arg( kysely.value("tunniste").toInt() );
+
+        if( vienti.alvkoodi != ryhma.alvkoodi || vienti.alvprosentti != ryhma.alvprosentti || vienti.tiliId != ryhma.tiliId)
+        {
+            if( ryhma.alvkoodi )
+                lisaaRyhma(ryhma);
+
+            ryhma = Ryhma();
+            ryhma.alvkoodi = vienti.alvkoodi;
+            ryhma.alvprosentti = vienti.alvprosentti;
+            ryhma.tiliId = vienti.tiliId;
+            ryhma.tilinro = vienti.tilinro;
+        }
+        ryhma.debetSnt += vienti.debetSnt;
+        ryhma.kreditSnt += vienti.kreditSnt;
+
+        viennit_.append(vienti);
+    }
+    if( ryhma.alvkoodi )
+        lisaaRyhma(ryhma);
+}
+
+void AlvLaskelma::lisaaRyhma(const Ryhma &ryhma)
+{
+    ryhmat_.append(ryhma);
+
+    int koodi = ryhma.alvkoodi;
+    qlonglong saldo = debetKoodi(koodi) ? 0 - ryhma.saldoSnt() : ryhma.saldoSnt();
+
+    koodeittain_[koodi] += saldo;
+
+    if( koodi == AlvKoodi::MYYNNIT_BRUTTO && ryhma.alvprosentti)
+    {
+        // Brutosta erotetaan verot tileittäin
+        qlonglong vero = ryhma.bruttoVeroSnt();
+        bruttoVeroSnt_ += vero;
+        verotKannoittain_[ryhma.alvprosentti] += vero;
+    }
+    else if( koodi == AlvKoodi::OSTOT_BRUTTO && ryhma.alvprosentti)
+    {
+        bruttoVahennysSnt_ -= ryhma.bruttoVeroSnt();
+    }
+    else if( koodi > AlvKoodi::MAKSUPERUSTEINEN_KOHDENTAMATON)
+    {
+        return;     // Ei kirjaus eikä vähennys
+    }
+    // Bruttokirjausten vero on jo laskettu tileittäin, joten niiden alv-kirjauksia ei lasketa toiseen kertaan
+    else if( koodi > AlvKoodi::ALVVAHENNYS )
+    {
+        if( koodi != AlvKoodi::ALVVAHENNYS + AlvKoodi::OSTOT_BRUTTO)
+            nettoVahennysSnt_ += saldo;
+    }
+    else if( koodi > AlvKoodi::ALVKIRJAUS)
+    {
+        if( koodi != AlvKoodi::ALVKIRJAUS + AlvKoodi::MYYNNIT_BRUTTO)
+            nettoVeroSnt_ += saldo;
+
+        if( koodi == AlvKoodi::ALVKIRJAUS + AlvKoodi::MYYNNIT_NETTO ||
+            koodi == AlvKoodi::ALVKIRJAUS + AlvKoodi::MAKSUPERUSTEINEN_MYYNTI )
+            verotKannoittain_[ryhma.alvprosentti] += saldo;
+    }
+}
@@ -0,0 +1,141 @@
+/*
+   Copyright (C) 2018 Arto Hyvättinen
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ALVLASKELMA_H
+#define ALVLASKELMA_H
+
+#include <QDate>
+#include <QList>
+#include <QMap>
+#include <QString>
+
+/**
+ * @brief Arvonlisäverokauden laskelma
+ *
+ * Hakee kauden kaikki arvonlisäverolliset viennit yhdellä kyselyllä
+ * ja laskee niistä sekä alv-ilmoituksen luvut että erittelyn ryhmät.
+ * AlvIlmoitusDialog ja AlvErittely käyttävät samaa laskelmaa.
+ *
+ * Laskelmat säilytetään kausittain muistissa, kunnes kirjanpitoa muokataan.
+ *
+ * @since 1.1
+ */
+class AlvLaskelma
+{
+public:
+    /**
+     * @brief Erittelyyn tuleva yksittäinen vienti
+     */
+    struct Vienti
+    {
+        QDate pvm;
+        QString tosite;         /** Tositelajin tunnus ja tositteen tunniste */
+        QString selite;
+        int alvkoodi = 0;
+        int alvprosentti = 0;
+        int tiliId = 0;
+        int tilinro = 0;
+        qlonglong debetSnt = 0;
+        qlonglong kreditSnt = 0;
+    };
+
+    /**
+     * @brief Yhden alv-koodin, verokannan ja tilin viennit yhteensä
+     */
+    struct Ryhma
+    {
+        int alvkoodi = 0;
+        int alvprosentti = 0;
+        int tiliId = 0;
+        int tilinro = 0;
+        qlonglong debetSnt = 0;
+        qlonglong kreditSnt = 0;
+
+        qlonglong saldoSnt() const { return kreditSnt - debetSnt; }
+        /**
+         * @brief Bruttokirjausten sisältämä vero (kredit-suuntaisena)
+         */
+        qlonglong bruttoVeroSnt() const;
+    };
+
+    AlvLaskelma();
+
+    /**
+     * @brief Kauden laskelma
+     *
+     * Palauttaa muistissa olevan laskelman, jos kauden kirjauksia ei ole
+     * muokattu laskemisen jälkeen, muuten laskee laskelman uudelleen.
+     */
+    static AlvLaskelma kaudelle(const QDate& alkupvm, const QDate& loppupvm);
+
+    QDate alkupvm() const { return alkupvm_; }
+    QDate loppupvm() const { return loppupvm_; }
+
+    /**
+     * @brief Viennit alv-koodin, verokannan (laskevasti), tilin ja päivämäärän mukaan järjestettynä
+     */
+    QList<Vienti> viennit() const { return viennit_; }
+    /**
+     * @brief Ryhmät samassa järjestyksessä kuin viennit
+     */
+    QList<Ryhma> ryhmat() const { return ryhmat_; }
+
+    /**
+     * @brief Alv-koodin kirjaukset yhteensä
+     *
+     * Myynnit ja verot ovat positiivisia kreditin, ostot ja vähennykset debetin suuntaan
+     */
+    qlonglong koodilla(int alvkoodi) const { return koodeittain_.value(alvkoodi); }
+    /**
+     * @brief Kotimaan myynnin vero verokannoittain
+     */
+    QMap<int,qlonglong> verotKannoittain() const { return verotKannoittain_; }
+
+    qlonglong bruttoVeroSnt() const { return bruttoVeroSnt_; }
+    qlonglong bruttoVahennysSnt() const { return bruttoVahennysSnt_; }
+    qlonglong nettoVeroSnt() const { return nettoVeroSnt_; }
+    qlonglong nettoVahennysSnt() const { return nettoVahennysSnt_; }
+
+    qlonglong veroSnt() const { return bruttoVeroSnt_ + nettoVeroSnt_; }
+    qlonglong vahennysSnt() const { return bruttoVahennysSnt_ + nettoVahennysSnt_; }
+    qlonglong maksettavaSnt() const { return veroSnt() - vahennysSnt(); }
+
+    /**
+     * @brief Onko alv-koodin etumerkki debetin suuntaan (ostot ja vähennykset)
+     */
+    static bool debetKoodi(int alvkoodi);
+
+protected:
+    void laske(const QDate& alkupvm, const QDate& loppupvm);
+    void lisaaRyhma(const Ryhma& ryhma);
+
+    QDate alkupvm_;
+    QDate loppupvm_;
+
+    QList<Vienti> viennit_;
+    QList<Ryhma> ryhmat_;
+
+    QMap<int,qlonglong> koodeittain_;
+    QMap<int,qlonglong> verotKannoittain_;
+
+    qlonglong bruttoVeroSnt_ = 0;
+    qlonglong bruttoVahennysSnt_ = 0;
+    qlonglong nettoVeroSnt_ = 0;
+    qlonglong nettoVahennysSnt_ = 0;
+};
+
+#endif // ALVLASKELMA_H
@@ -21,9 +21,6 @@
 #include "db/kirjanpito.h"
 
 #include <QSqlQuery>
-#include <QMap>
-#include <QJsonDocument>
-#include <QVariant>
 
 
 MyyntiRaportti::MyyntiRaportti()
@@ -70,52 +67,32 @@ RaportinKirjoittaja MyyntiRaportti::kirjoitaRaportti(QDate mista, QDate mihin, b
         rk.lisaaOtsake(otsikko);
     }
 
-    QMap<QString,double> myyntiKpl;
-    QMap<QString,qlonglong> myyntiSnt;
-    QMap<QString,qlonglong> bruttoSnt;
-
-    QSqlQuery kysely;
-    kysely.exec(QString("SELECT json from vienti where viite is not null and pvm between '%1' and '%2'")
-                .arg(mista.toString(Qt::ISODate)).arg(mihin.toString(Qt::ISODate)));
-
-    while( kysely.next())
-    {
-        QJsonDocument json = QJsonDocument::fromJson( kysely.value(0).toByteArray() );
-        QVariantMap vmap = json.toVariant().toMap();
-        if( vmap.contains("Laskurivit"))
-        {
-            for( const QVariant& var : vmap.value("Laskurivit").toList())
-            {
-                QString nimike = var.toMap().value("Nimike").toString();
-
-                double maara = var.toMap().value("Maara").toDouble();
-                qlonglong sentit = var.toMap().value("Nettoyht").toLongLong();
-                qlonglong brutto = var.toMap().value("Yhteensa").toLongLong();
-
-                myyntiKpl[nimike] = myyntiKpl.value(nimike,0.0) + maara;
-                myyntiSnt[nimike] = myyntiSnt.value(nimike, 0) + sentit;
-                bruttoSnt[nimike] = bruttoSnt.value(nimike, 0) + brutto;
-            }
-        }
-    }
+    QSqlQuery kysely( *kp()->tietokanta() );
+    kysely.prepare("SELECT nimike, SUM(maara), SUM(nettosnt), SUM(yhteensasnt) "
+                   "FROM laskurivi JOIN vienti ON laskurivi.vienti=vienti.id "
+                   "WHERE vienti.viite IS NOT NULL AND vienti.pvm BETWEEN :mista AND :mihin "
+                   "GROUP BY nimike ORDER BY nimike");
+    kysely.bindValue(":mista", mista);
+    kysely.bindValue(":mihin", mihin);
+    kysely.exec();
 
     qlonglong nettoSumma = 0;
     qlonglong bruttoSumma = 0;
 
-    QMapIterator<QString,double> iter(myyntiKpl);
-    while( iter.hasNext() )
+    while( kysely.next() )
     {
-        iter.next();
-
         RaporttiRivi rivi;
-        rivi.lisaa( iter.key());
+        rivi.lisaa( kysely.value(0).toString());
 
-        double kpl = iter.value();
-        qlonglong snt = myyntiSnt.value(iter.key());
-        qlonglong brutto = bruttoSnt.value(iter.key());
+        double kpl = kysely.value(1).toDouble();
+        qlonglong snt = kysely.value(2).toLongLong();
+        qlonglong brutto = kysely.value(3).toLongLong();
 
         rivi.lisaa( QString("%L1").arg(kpl,0,'f',2), 1, true );
-        rivi.lisaa( snt / kpl);
+        if( qAbs(kpl) > 1e-5 )
+            rivi.lisaa( qRound64( snt / kpl) );
+        else
+            rivi.lisaa("");
         rivi.lisaa( snt );
         rivi.lisaa( brutto );
 
@@ -16,6 +16,7 @@
 */
 
 #include <QSqlQuery>
+#include <QHash>
 
 #include "paakirjaraportti.h"
 
@@ -23,6 +24,8 @@
 #include "db/tilikausi.h"
 
 #include "raportinkirjoittaja.h"
+#include "raporttivalimuisti.h"
+#include "db/kyselyprofiloija.h"
 
 PaakirjaRaportti::PaakirjaRaportti()
     : Raportti(nullptr)
@@ -76,7 +79,25 @@ RaportinKirjoittaja PaakirjaRaportti::raportti()
 
 RaportinKirjoittaja PaakirjaRaportti::kirjoitaRaportti(QDate mista, QDate mihin, int kohdennuksella, bool tulostakohdennus, bool tulostaSummarivi, int tililta)
 {
+    // Alkusaldot lasketaan kirjanpidon alusta
+    RaporttiValimuisti muisti( QString("Paakirja %1 %2 %3 %4 %5 %6").arg(mista.toString(Qt::ISODate)).arg(mihin.toString(Qt::ISODate))
+                                                                    .arg(kohdennuksella).arg(tulostakohdennus).arg(tulostaSummarivi).arg(tililta),
+                               QDate(), mihin);
+    if( muisti.loytyi())
+        return muisti.raportti();
+
     RaportinKirjoittaja rk;
+    kirjoita(rk, mista, mihin, kohdennuksella, tulostakohdennus, tulostaSummarivi, tililta);
+    // Tiedostoon vietäessä pääkirja kirjoitetaan uudelleen suoraan virtana
+    rk.asetaUudelleenkirjoitus( [=] (RaportinKirjoittaja& virta) {
+        kirjoita(virta, mista, mihin, kohdennuksella, tulostakohdennus, tulostaSummarivi, tililta);
+    });
+    return muisti.tallenna(rk);
+}
+
+void PaakirjaRaportti::kirjoita(RaportinKirjoittaja &rk, QDate mista, QDate mihin, int kohdennuksella, bool tulostakohdennus, bool tulostaSummarivi, int tililta)
+{
+    KyselyProfiloija::Operaatio mittaus("Pääkirja");
 
     Kohdennus kohdennus = kp()->kohdennukset()->kohdennus(kohdennuksella);
 
@@ -136,7 +157,7 @@ RaportinKirjoittaja PaakirjaRaportti::kirjoitaRaportti(QDate mista, QDate mihin,
                              "FROM vienti, tili WHERE vienti.tili=tili.id AND tili.ysiluku < 300000000 AND "
                              "pvm < \"%1\" GROUP BY nro").arg(mista.toString(Qt::ISODate));
 
-    kysely.exec(kysymys);
+    KyselyProfiloija::suorita(kysely, kysymys);
     while( kysely.next())
     {
         int ysiluku = kysely.value(0).toInt();
@@ -156,7 +177,7 @@ RaportinKirjoittaja PaakirjaRaportti::kirjoitaRaportti(QDate mista, QDate mihin,
         kysymys = QString("SELECT sum(debetsnt), sum(kreditsnt) FROM vienti, tili "
                           "WHERE vienti.tili=tili.id AND ysiluku > 300000000 AND "
                           "pvm < \"%1\" ").arg(tilikausi.alkaa().toString(Qt::ISODate));
-        kysely.exec( kysymys );
+        KyselyProfiloija::suorita(kysely, kysymys);
         if( kysely.next())
         {
             qlonglong edYlijaama = kysely.value(1).toLongLong() - kysely.value(0).toLongLong();
@@ -194,7 +215,7 @@ RaportinKirjoittaja PaakirjaRaportti::kirjoitaRaportti(QDate mista, QDate mihin,
                     .arg(alkupaiva.toString(Qt::ISODate))
                     .arg(mista.toString(Qt::ISODate));
 
-        kysely.exec(kysymys);
+        KyselyProfiloija::suorita(kysely, kysymys);
         while( kysely.next())
         {
             int ysiluku = kysely.value(0).toInt();
@@ -205,74 +226,73 @@ RaportinKirjoittaja PaakirjaRaportti::kirjoitaRaportti(QDate mista, QDate mihin,
     }
 
 
-    // Varmistetaan, että kaikilla tämän tilikauden tileillä on tietue
-    if( kohdennuksella > -1 && kohdennus.tyyppi() == Kohdennus::MERKKAUS)
-        kysymys = QString("SELECT ysiluku FROM merkkaus,vienti, tili WHERE "
-                          "merkkaus.kohdennus=%3 AND merkkaus.vienti=vienti.id AND vienti.tili = tili.id AND "
-                          "pvm BETWEEN \"%1\" AND \"%2\" GROUP BY nro")
-                .arg(mista.toString(Qt::ISODate)).arg(mihin.toString(Qt::ISODate)).arg(kohdennuksella);
-    else if( kohdennuksella > -1)
-        kysymys = QString("SELECT ysiluku FROM vienti, tili WHERE vienti.tili = tili.id AND "
-                          "pvm BETWEEN \"%1\" AND \"%2\" AND vienti.kohdennus=%3 GROUP BY nro")
-                .arg(mista.toString(Qt::ISODate)).arg(mihin.toString(Qt::ISODate)).arg(kohdennuksella);
-    else
-        kysymys = QString("SELECT ysiluku FROM vienti, tili WHERE vienti.tili = tili.id AND "
-                      "pvm BETWEEN \"%1\" AND \"%2\" GROUP BY nro")
-                .arg(mista.toString(Qt::ISODate)).arg(mihin.toString(Qt::ISODate));
+    // Kauden viennit haetaan yhdellä tilin, päivämäärän ja viennin mukaan
+    // järjestetyllä kyselyllä, ja ne yhdistetään alkusaldoihin yhdellä läpikäynnillä
+    QString taulut = "vienti JOIN tili ON vienti.tili=tili.id JOIN tosite ON vienti.tosite=tosite.id "
+                     "LEFT OUTER JOIN kohdennus ON vienti.kohdennus=kohdennus.id";
+    QString ehdot = "vienti.pvm BETWEEN :mista AND :mihin";
 
-    kysely.exec(kysymys);
-    while( kysely.next() )
+    if( kohdennuksella > -1 && kohdennus.tyyppi() == Kohdennus::MERKKAUS)
     {
-        if( !alkusaldot.contains( kysely.value(0).toInt()))
-            alkusaldot.insert(kysely.value(0).toInt(), 0);
+        taulut.append(" JOIN merkkaus ON merkkaus.vienti=vienti.id");
+        ehdot.append(" AND merkkaus.kohdennus=:kohdennus");
     }
+    else if( kohdennuksella > -1)
+        ehdot.append(" AND vienti.kohdennus=:kohdennus");
+    if( tililta )
+        ehdot.append(" AND tili.nro=:tili");
+
+    // Viennit luetaan vain eteenpäin, jottei koko kauden tulosta säilytetä muistissa
+    kysely.setForwardOnly(true);
+    kysely.prepare( QString("SELECT tili.ysiluku AS ysiluku, vienti.pvm AS pvm, tosite.laji AS laji, tosite.tunniste AS tunniste, "
+                            "tosite.id AS tositeId, vienti.kohdennus AS kohdennusId, kohdennus.nimi AS kohdennusnimi, "
+                            "vienti.selite AS selite, debetsnt, kreditsnt FROM %1 WHERE %2 "
+                            "ORDER BY tili.ysiluku, vienti.pvm, vienti.id").arg(taulut).arg(ehdot));
+    kysely.bindValue(":mista", mista);
+    kysely.bindValue(":mihin", mihin);
+    if( kohdennuksella > -1)
+        kysely.bindValue(":kohdennus", kohdennuksella);
+    if( tililta )
+        kysely.bindValue(":tili", tililta);
+    KyselyProfiloija::suorita(kysely);
+
+    QHash<int,QString> lajitunnukset;
+    bool vientiJonossa = kysely.next();
 
-    // Sitten päästäänkin tulostamaan pääkirjaa
     QMapIterator<int,qlonglong> iter( alkusaldot );
     qlonglong debetYht = 0;
     qlonglong kreditYht = 0;
 
-
-    while(iter.hasNext())
+    while( iter.hasNext() || vientiJonossa )
     {
-        iter.next();
-        const Tili& tili = kp()->tilit()->tiliYsiluvulla( iter.key() );
+        // Seuraavaksi tulostetaan pienempi tileistä, joilla on alkusaldo tai kauden vientejä
+        int ysiluku = 0;
+        qlonglong saldo = 0;
+        int vientienYsiluku = vientiJonossa ? kysely.value("ysiluku").toInt() : 0;
+
+        if( iter.hasNext() && ( !vientiJonossa || iter.peekNext().key() <= vientienYsiluku ))
+        {
+            iter.next();
+            ysiluku = iter.key();
+            saldo = iter.value();
+        }
+        else
+            ysiluku = vientienYsiluku;
+
+        const Tili& tili = kp()->tilit()->tiliYsiluvulla( ysiluku );
 
         if( tililta && tili.numero() != tililta)
             continue;
 
         RaporttiRivi tiliotsikko;
         tiliotsikko.lisaaLinkilla( RaporttiRiviSarake::TILI_LINKKI, tili.numero(),  QString("%1 %2").arg(tili.numero()).arg( tili.nimi()) , 5 + (int) tulostakohdennus );
-        tiliotsikko.lisaa( iter.value());
+        tiliotsikko.lisaa( saldo );
         tiliotsikko.lihavoi();
         rk.lisaaRivi( tiliotsikko);
 
-        qlonglong saldo = iter.value();
-        QString kysymys;
-
-        if( kohdennuksella > -1 && kohdennus.tyyppi() == Kohdennus::MERKKAUS)
-            kysymys = QString("SELECT pvm, tositelaji, tunniste, kohdennusId, tositeId, "
-                                      "vientivw.kohdennus as kohdennusnimi, selite, debetsnt, kreditsnt FROM merkkaus, vientivw "
-                                      "WHERE merkkaus.kohdennus=%4 AND merkkaus.vienti=vientiId AND tilinro=%1 AND pvm BETWEEN \"%2\" AND \"%3\" "
-                                      "ORDER BY pvm, vientiId ")
-                    .arg(tili.numero()).arg(mista.toString(Qt::ISODate)).arg(mihin.toString(Qt::ISODate)).arg(kohdennuksella);
-        else if( kohdennuksella > -1)
-            kysymys = QString("SELECT pvm, tositelaji, tunniste, kohdennusId, tositeId, "
-                                      "kohdennus as kohdennusnimi, selite, debetsnt, kreditsnt FROM vientivw "
-                                      "WHERE tilinro=%1 AND pvm BETWEEN \"%2\" AND \"%3\" AND kohdennusId=%4 "
-                                      "ORDER BY pvm, vientiId ")
-                    .arg(tili.numero()).arg(mista.toString(Qt::ISODate)).arg(mihin.toString(Qt::ISODate)).arg(kohdennuksella);
-        else
-            kysymys = QString("SELECT pvm, tositelaji, tunniste, kohdennusId, tositeId, "
-                                      "kohdennus as kohdennusnimi, selite, debetsnt, kreditsnt FROM vientivw "
-                                      "WHERE tilinro=%1 AND pvm BETWEEN \"%2\" AND \"%3\" "
-                                      "ORDER BY pvm, vientiId ")
-                    .arg(tili.numero()).arg(mista.toString(Qt::ISODate)).arg(mihin.toString(Qt::ISODate));
+        bool vastaavaa = tili.onko(TiliLaji::VASTAAVAA);
 
-
-        kysely.exec(kysymys);
-
-        while(kysely.next())
+        while( vientiJonossa && kysely.value("ysiluku").toInt() == ysiluku )
         {
             qlonglong debet = kysely.value("debetsnt").toLongLong();
             qlonglong kredit = kysely.value("kreditsnt").toLongLong();
@@ -280,16 +300,20 @@ RaportinKirjoittaja PaakirjaRaportti::kirjoitaRaportti(QDate mista, QDate mihin,
             debetYht += debet;
             kreditYht += kredit;
 
-            if( tili.onko(TiliLaji::VASTAAVAA) )
+            if( vastaavaa )
                 saldo += debet - kredit;
             else
                 saldo += kredit - debet;
 
+            int laji = kysely.value("laji").toInt();
+            if( !lajitunnukset.contains(laji))
+                lajitunnukset.insert(laji, kp()->tositelajit()->tositelaji(laji).tunnus());
+
             RaporttiRivi rr;
             QDate pvm = kysely.value("pvm").toDate();
             rr.lisaa( pvm );
             rr.lisaaLinkilla( RaporttiRiviSarake::TOSITE_ID, kysely.value("tositeId").toInt() ,
-                              QString("%1%2/%3").arg(kysely.value("tositelaji").toString()).arg(kysely.value("tunniste").toInt())
+                              QString("%1%2/%3").arg(lajitunnukset.value(laji)).arg(kysely.value("tunniste").toInt())
                               .arg( kp()->tilikaudet()->tilikausiPaivalle(pvm).kausitunnus() ));
             rr.lisaa( kysely.value("selite").toString());
             if( tulostakohdennus)
@@ -303,6 +327,8 @@ RaportinKirjoittaja PaakirjaRaportti::kirjoitaRaportti(QDate mista, QDate mihin,
             rr.lisaa( kredit );
             rr.lisaa( saldo, true);
             rk.lisaaRivi( rr);
+
+            vientiJonossa = kysely.next();
         }
 
         rk.lisaaRivi(); // Tyhjä rivi tilien väliin
@@ -323,9 +349,6 @@ RaportinKirjoittaja PaakirjaRaportti::kirjoitaRaportti(QDate mista, QDate mihin,
         summarivi.viivaYlle();
         rk.lisaaRivi(summarivi);
     }
-
-    return rk;
-
 }
 
 void PaakirjaRaportti::haeTilitComboon()
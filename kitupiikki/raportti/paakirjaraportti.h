@@ -36,6 +36,17 @@ public:
                                                  bool tulostakohdennus = false,
                                                  bool tulostaSummarivi = true,
                                                  int tililta = 0);
+
+    /**
+     * @brief Kirjoittaa pääkirjan annettuun kirjoittajaan
+     *
+     * Välimuistia ei käytetä, joten kirjoittajalle voi asettaa virran,
+     * jolloin pitkänkin aikavälin pääkirja viedään tiedostoon vakiomuistilla.
+     *
+     * @since 1.1
+     */
+    static void kirjoita(RaportinKirjoittaja& rk, QDate mista, QDate mihin, int kohdennuksella = -1,
+                         bool tulostakohdennus = false, bool tulostaSummarivi = true, int tililta = 0);
 public slots:
     void haeTilitComboon();
 protected:
@@ -81,9 +81,17 @@ RaportinKirjoittaja PaivakirjaRaportti::raportti()
 
 RaportinKirjoittaja PaivakirjaRaportti::kirjoitaRaportti(QDate mista, QDate mihin, int kohdennuksella, bool tositejarjestys, bool ryhmitalajeittain, bool tulostakohdennukset, bool tulostasummat)
 {
-
     RaportinKirjoittaja kirjoittaja;
+    kirjoita(kirjoittaja, mista, mihin, kohdennuksella, tositejarjestys, ryhmitalajeittain, tulostakohdennukset, tulostasummat);
+    // Tiedostoon vietäessä päiväkirja kirjoitetaan uudelleen suoraan virtana
+    kirjoittaja.asetaUudelleenkirjoitus( [=] (RaportinKirjoittaja& rk) {
+        kirjoita(rk, mista, mihin, kohdennuksella, tositejarjestys, ryhmitalajeittain, tulostakohdennukset, tulostasummat);
+    });
+    return kirjoittaja;
+}
 
+void PaivakirjaRaportti::kirjoita(RaportinKirjoittaja &kirjoittaja, QDate mista, QDate mihin, int kohdennuksella, bool tositejarjestys, bool ryhmitalajeittain, bool tulostakohdennukset, bool tulostasummat)
+{
     if( kohdennuksella > -1 )
         // Tulostetaan vain yhdestä kohdennuksesta
         kirjoittaja.asetaOtsikko( QString("PÄIVÄKIRJA (%1)").arg( kp()->kohdennukset()->kohdennus(kohdennuksella).nimi() ) );
@@ -114,7 +122,9 @@ RaportinKirjoittaja PaivakirjaRaportti::kirjoitaRaportti(QDate mista, QDate mihi
     otsikko.lisaa("Kredit €", 1, true);
     kirjoittaja.lisaaOtsake(otsikko);
 
+    // Viennit luetaan vain eteenpäin, jottei koko kauden tulosta säilytetä muistissa
     QSqlQuery kysely;
+    kysely.setForwardOnly(true);
     QString jarjestys = "pvm, vientiId";
     if(  tositejarjestys )
         jarjestys = " tositelaji, tunniste, vientiId";
@@ -229,8 +239,6 @@ RaportinKirjoittaja PaivakirjaRaportti::kirjoitaRaportti(QDate mista, QDate mihi
         summarivi.lihavoi();
         kirjoittaja.lisaaRivi( summarivi );
     }
-
-    return kirjoittaja;
 }
 
 
@@ -53,6 +53,19 @@ public:
                                  bool ryhmitalajeittain = false, bool tulostakohdennukset = false,
                                  bool tulostasummat = false);
 
+    /**
+     * @brief Kirjoittaa päiväkirjan annettuun kirjoittajaan
+     *
+     * Kun kirjoittajalle on asetettu virta, rivit kirjoitetaan suoraan
+     * tiedostoon eikä niitä säilytetä muistissa.
+     *
+     * @since 1.1
+     */
+    static void kirjoita( RaportinKirjoittaja& kirjoittaja, QDate mista, QDate mihin,
+                          int kohdennuksella = -1, bool tositejarjestys = false,
+                          bool ryhmitalajeittain = false, bool tulostakohdennukset = false,
+                          bool tulostasummat = false);
+
 protected:
     static void kirjoitaSummaRivi(RaportinKirjoittaja &rk, qlonglong debet, qlonglong kredit, int sarakeleveys);
 
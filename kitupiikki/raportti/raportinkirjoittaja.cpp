@@ -25,6 +25,7 @@
 #include "raportinkirjoittaja.h"
 
 #include <QPdfWriter>
+#include <QPicture>
 
 #include "db/kirjanpito.h"
 
@@ -85,36 +86,103 @@ void RaportinKirjoittaja::lisaaOtsake(const RaporttiRivi& otsikkorivi)
 
 void RaportinKirjoittaja::lisaaRivi(const RaporttiRivi& rivi)
 {
-    rivit_.append(rivi);
+    if( !virta_ )
+    {
+        rivit_.append(rivi);
+        rivit_.last().jaaTekstit(tekstit_);
+        return;
+    }
+
+    if( !virtaAloitettu_ )
+    {
+        kirjoitaVirtaan( virranMuoto_ == HTML ? htmlAlku() : csvOtsakkeet(csvErotin_) );
+        virtaAloitettu_ = true;
+    }
+    kirjoitaVirtaan( virranMuoto_ == HTML ? htmlRivi(rivi, virranLinkit_) : csvRivi(rivi, csvErotin_, csvDesimaali_, csvPaivays_) );
+    virranRiveja_++;
+    edellisellaSarakkeita_ = rivi.sarakkeita() > 0;
 }
 
 void RaportinKirjoittaja::lisaaTyhjaRivi()
 {
-    if( rivit_.count())
+    if( virta_ )
+    {
+        if( edellisellaSarakkeita_ )
+            lisaaRivi( RaporttiRivi(RaporttiRivi::EICSV));
+    }
+    else if( rivit_.count())
         if( rivit_.last().sarakkeita() )
             rivit_.append( RaporttiRivi(RaporttiRivi::EICSV));
 }
 
 int RaportinKirjoittaja::tulosta(QPagedPaintDevice *printer, QPainter *painter, bool raidoita, int alkusivunumero) const
 {
-    if( rivit_.isEmpty())
+    int rivi = seuraavaTulostettava(0);
+    if( rivi >= rivit_.count())
         return 0;     // Ei tulostettavaa !
 
+    Asettelu asettelu = asettele( painter, printer->pageSizeMM().width() < 300 );
 
-    int pienennys = sarakkeet_.count() > 4 && printer->pageSizeMM().width() < 300 ? 2 : 0;
+    int sivu = 0;
+    while( rivi < rivit_.count())
+    {
+        if( sivu )
+            printer->newPage();
 
-    QFont fontti("Sans", 10 - pienennys );
-    painter->setFont(fontti);
+        painter->save();
+        rivi = piirraSivu( painter, asettelu, rivi, sivu + alkusivunumero, raidoita);
+        painter->restore();
+        sivu++;
+    }
 
-    int rivinkorkeus = painter->fontMetrics().height();
-    int sivunleveys = painter->window().width();
-    int sivunkorkeus = painter->window().height();
+    return sivu;
+}
+
+QList<int> RaportinKirjoittaja::sivuta(const QSize &tulostusalue, bool pieniSivu) const
+{
+    QList<int> sivut;
+
+    // Sivut piirretään mitoitusta varten kuvaan, joka vain hylätään
+    QPicture kuva;
+    kuva.setBoundingRect( QRect( QPoint(0,0), tulostusalue));
+    QPainter painter( &kuva );
+
+    Asettelu asettelu = asettele( &painter, pieniSivu);
+    int rivi = seuraavaTulostettava(0);
+    while( rivi < rivit_.count())
+    {
+        sivut.append(rivi);
+        painter.save();
+        rivi = piirraSivu( &painter, asettelu, rivi, 0, false);
+        painter.restore();
+    }
+    painter.end();
+
+    return sivut;
+}
+
+int RaportinKirjoittaja::tulostaSivu(QPainter *painter, bool pieniSivu, int ensimmainenRivi, int sivunumero, bool raidoita) const
+{
+    Asettelu asettelu = asettele( painter, pieniSivu);
+    return piirraSivu( painter, asettelu, ensimmainenRivi, sivunumero, raidoita);
+}
+
+RaportinKirjoittaja::Asettelu RaportinKirjoittaja::asettele(QPainter *painter, bool pieniSivu) const
+{
+    Asettelu asettelu;
+    asettelu.pienennys = sarakkeet_.count() > 4 && pieniSivu ? 2 : 0;
+
+    painter->setFont( QFont("Sans", 10 - asettelu.pienennys ));
+
+    asettelu.rivinkorkeus = painter->fontMetrics().height();
+    asettelu.sivunleveys = painter->window().width();
+    asettelu.sivunkorkeus = painter->window().height();
 
     // Lasketaan sarakkeiden leveydet
-    QVector<int> leveydet( sarakkeet_.count() );
+    asettelu.leveydet.resize( sarakkeet_.count() );
 
     int tekijayhteensa = 0; // Lasketaan jäävän tilan jako
-    int jaljella = sivunleveys;
+    int jaljella = asettelu.sivunleveys;
 
     for( int i=0; i < sarakkeet_.count(); i++)
     {
@@ -123,11 +191,11 @@ int RaportinKirjoittaja::tulosta(QPagedPaintDevice *printer, QPainter *painter,
        if( !sarakkeet_[i].leveysteksti.isEmpty())
            leveys = painter->fontMetrics().width( sarakkeet_[i].leveysteksti );
        else if( sarakkeet_[i].leveysprossa)
-           leveys = sivunleveys * sarakkeet_[i].leveysprossa / 100;
+           leveys = asettelu.sivunleveys * sarakkeet_[i].leveysprossa / 100;
        else
            tekijayhteensa += sarakkeet_[i].jakotekija;
 
-       leveydet[i] = leveys;
+       asettelu.leveydet[i] = leveys;
        jaljella -= leveys;
 
     }
@@ -137,25 +205,82 @@ int RaportinKirjoittaja::tulosta(QPagedPaintDevice *printer, QPainter *painter,
     {
         if( sarakkeet_[i].jakotekija)
         {
-            leveydet[i] = jaljella * sarakkeet_[i].jakotekija / tekijayhteensa;
+            asettelu.leveydet[i] = jaljella * sarakkeet_[i].jakotekija / tekijayhteensa;
         }
     }
 
     if( tekijayhteensa )
         jaljella = 0;   // Koko tila käytetty venyvällä sarakkeella
 
-    // Nyt taulukosta löytyy sarakkeiden leveydet, ja tulostaminen
-    // voidaan aloittaa
+    asettelu.jaljella = jaljella;
+    return asettelu;
+}
+
+int RaportinKirjoittaja::piirraSivu(QPainter *painter, const Asettelu &asettelu, int ensimmainenRivi, int sivunumero, bool raidoita) const
+{
+    const QVector<int>& leveydet = asettelu.leveydet;
+
+    // Sivulla edetään translatella, joten kuljettu matka saadaan muunnoksesta
+    QTransform alku = painter->transform();
+    auto ypos = [painter, &alku] { return (painter->transform() * alku.inverted()).dy(); };
+
+    QFont fontti("Sans", 10 - asettelu.pienennys );
+    painter->setFont(fontti);
+
+    // Tulostetaan ylätunniste
+    if( !otsikko_.isEmpty())
+        tulostaYlatunniste( painter, sivunumero);
+
+    if( !otsakkeet_.isEmpty())
+        painter->translate(0, asettelu.rivinkorkeus);
+
+    // Otsikkorivit
+    for( const RaporttiRivi& otsikkorivi : otsakkeet_)
+    {
+        if( otsikkorivi.kaytto() == RaporttiRivi::CSV)
+            continue;
+
+        int x = 0;
+        int sarake = 0;
+
+        for( int i = 0; i < otsikkorivi.sarakkeita(); i++)
+        {
+
+            int lippu = 0;
+            QString teksti = otsikkorivi.teksti(i);
+
+            if( otsikkorivi.tasattuOikealle(i))
+            {
+                lippu = Qt::AlignRight;
+                teksti.append("  ");
+            }
+            int sarakeleveys = 0;
+
+            for( int ysind = 0; ysind < otsikkorivi.leveysSaraketta(i); ysind++ )
+            {
+                sarakeleveys += leveydet[sarake];
+                sarake++;
+            }
+            painter->drawText( QRect(x,0,sarakeleveys,asettelu.rivinkorkeus),
+                              lippu, teksti );
+
+            x += sarakeleveys;
+        }
+        painter->translate(0, asettelu.rivinkorkeus);
+    } // Otsikkorivi
+    if( !otsikko_.isEmpty() || !otsakkeet_.isEmpty())
+        painter->drawLine(0,0,asettelu.sivunleveys,0);
 
-    int sivu = 1;
     int rivilla = 0;
+    int indeksi = ensimmainenRivi;
 
-    foreach (RaporttiRivi rivi, rivit_)
+    for( ; indeksi < rivit_.count(); indeksi++)
     {
+        const RaporttiRivi& rivi = rivit_.at(indeksi);
         if( rivi.kaytto() == RaporttiRivi::CSV)
             continue;
 
-        fontti.setPointSize( rivi.pistekoko() - pienennys );
+        fontti.setPointSize( rivi.pistekoko() - asettelu.pienennys );
         fontti.setBold( rivi.onkoLihava() );
         painter->setFont(fontti);
 
@@ -166,7 +291,7 @@ int RaportinKirjoittaja::tulosta(QPagedPaintDevice *printer, QPainter *painter,
         QVector<int> liput( rivi.sarakkeita() );
         QVector<QString> tekstit( rivi.sarakkeita() );
 
-        int korkeinrivi = rivinkorkeus;
+        int korkeinrivi = asettelu.rivinkorkeus;
         int x = 0;  // Missä kohtaa ollaan leveyssuunnassa
         int sarake = 0; // Missä taulukon sarakkeessa ollaan menossa
 
@@ -197,7 +322,7 @@ int RaportinKirjoittaja::tulosta(QPagedPaintDevice *printer, QPainter *painter,
             liput[i] = lippu;
             // Laatikoita ei asemoida korkeussuunnassa, vaan translatella liikutaan
             laatikot[i] = painter->boundingRect( x, 0,
-                                                sarakeleveys, sivunkorkeus,
+                                                sarakeleveys, asettelu.sivunkorkeus,
                                                 lippu, teksti );
 
             x += sarakeleveys;
@@ -205,66 +330,9 @@ int RaportinKirjoittaja::tulosta(QPagedPaintDevice *printer, QPainter *painter,
                 korkeinrivi = laatikot[i].height();
         }
 
-        if( painter->transform().dy() > sivunkorkeus - korkeinrivi)
-        {
-            // Sivu tulee täyteen
-            printer->newPage();
-            sivu++;
-            rivilla = 0;
-            painter->restore();
-        }
-
-        if( painter->transform().dy() < 0.1 )
-        {
-            // Ollaan sivun alussa
-
-            painter->save();
-            painter->setFont(QFont("Sans", 10 - pienennys));
-
-            // Tulostetaan ylätunniste
-            if( !otsikko_.isEmpty())
-                tulostaYlatunniste( painter, sivu + alkusivunumero - 1);
-
-            if( !otsakkeet_.isEmpty())
-                painter->translate(0, rivinkorkeus);
-
-            // Otsikkorivit
-            foreach (RaporttiRivi otsikkorivi, otsakkeet_)
-            {
-                if( otsikkorivi.kaytto() == RaporttiRivi::CSV)
-                    continue;
-
-                x = 0;
-                sarake = 0;
-
-                for( int i = 0; i < otsikkorivi.sarakkeita(); i++)
-                {
-
-                    int lippu = 0;
-                    QString teksti = otsikkorivi.teksti(i);
-
-                    if( otsikkorivi.tasattuOikealle(i))
-                    {
-                        lippu = Qt::AlignRight;
-                        teksti.append("  ");
-                    }
-                    int sarakeleveys = 0;
-
-                    for( int ysind = 0; ysind < otsikkorivi.leveysSaraketta(i); ysind++ )
-                    {
-                        sarakeleveys += leveydet[sarake];
-                        sarake++;
-                    }
-                    painter->drawText( QRect(x,0,sarakeleveys,rivinkorkeus),
-                                      lippu, teksti );
-
-                    x += sarakeleveys;
-                }
-                painter->translate(0, rivinkorkeus);
-            } // Otsikkorivi
-            if( !otsikko_.isEmpty() || !otsakkeet_.isEmpty())
-                painter->drawLine(0,0,sivunleveys,0);
-        }
+        // Sivu tulee täyteen
+        if( rivilla && ypos() > asettelu.sivunkorkeus - korkeinrivi)
+            break;
 
         // Jos raidoitus, niin raidoitetaan eli osan rivien taakse harmaata
         if( raidoita && rivilla % 6 > 2)
@@ -273,16 +341,12 @@ int RaportinKirjoittaja::tulosta(QPagedPaintDevice *printer, QPainter *painter,
             painter->setBrush(QBrush(QColor(222,222,222)));
             painter->setPen(Qt::NoPen);
 
-            painter->drawRect(0,0,sivunleveys, korkeinrivi);
+            painter->drawRect(0,0,asettelu.sivunleveys, korkeinrivi);
 
             painter->restore();
 
         }
 
-        fontti.setPointSize( rivi.pistekoko() - pienennys );
-        fontti.setBold( rivi.onkoLihava() );
-        painter->setFont(fontti);
-
         // Sitten tulostetaan tämä varsinainen rivi
         for( int i=0; i < rivi.sarakkeita(); i++)
         {
@@ -290,19 +354,33 @@ int RaportinKirjoittaja::tulosta(QPagedPaintDevice *printer, QPainter *painter,
         }
         if( rivi.onkoViivaa())  // Viivan tulostaminen rivin ylle
         {
-            painter->drawLine(0,0, sivunleveys - jaljella , 0);
+            painter->drawLine(0,0, asettelu.sivunleveys - asettelu.jaljella , 0);
         }
 
         painter->translate(0, korkeinrivi);
         rivilla++;
     }
 
-    painter->restore();
+    return seuraavaTulostettava(indeksi);
+}
 
-    return sivu;
+int RaportinKirjoittaja::seuraavaTulostettava(int indeksi) const
+{
+    while( indeksi < rivit_.count() && rivit_.at(indeksi).kaytto() == RaporttiRivi::CSV)
+        indeksi++;
+    return indeksi;
 }
 
 QString RaportinKirjoittaja::html(bool linkit)
+{
+    QString txt = htmlAlku();
+    for( const RaporttiRivi& rivi : rivit_)
+        txt.append( htmlRivi(rivi, linkit) );
+    txt.append( htmlLoppu() );
+    return txt;
+}
+
+QString RaportinKirjoittaja::htmlAlku() const
 {
     QString txt;
 
@@ -322,8 +400,10 @@ QString RaportinKirjoittaja::html(bool linkit)
                " table { border-collapse: collapse;}"
                " p.tulostettu { margin-top:2em; color: darkgray; }"
                " span.treeni { color: green; }"
-               "</style>"
-               "</head><body>");
+               "</style>");
+    txt.append( htmlOtsakkeeseen_ );
+    txt.append("</head><body>");
+    txt.append( htmlRunkoon_ );
 
     txt.append("<h1>" + otsikko() + "</h1>");
     txt.append("<p>" + kp()->asetukset()->asetus("Nimi") + "<br>");
@@ -331,7 +411,7 @@ QString RaportinKirjoittaja::html(bool linkit)
     txt.append("<table width=100%><thead>\n");
 
     // Otsikkorivit
-    foreach (RaporttiRivi otsikkorivi, otsakkeet_ )
+    for( const RaporttiRivi& otsikkorivi : otsakkeet_ )
     {
         if( otsikkorivi.kaytto() == RaporttiRivi::CSV)
             continue;
@@ -348,73 +428,78 @@ QString RaportinKirjoittaja::html(bool linkit)
     }
 
     txt.append("</thead>\n");
-    // Rivit
-    foreach (RaporttiRivi rivi, rivit_)
-    {
-        if( rivi.kaytto() == RaporttiRivi::CSV)
-            continue;
+    return txt;
+}
 
-        QStringList trluokat;
-        if( rivi.onkoLihava())
-            trluokat << "lihava";
-        if( rivi.onkoViivaa())
-            trluokat << "viiva";
+QString RaportinKirjoittaja::htmlRivi(const RaporttiRivi &rivi, bool linkit)
+{
+    QString txt;
+    if( rivi.kaytto() == RaporttiRivi::CSV)
+        return txt;
 
-        if( trluokat.isEmpty())
-            txt.append("<tr>");
-        else
-            txt.append("<tr class=\"" + trluokat.join(' ') + "\">");
+    QStringList trluokat;
+    if( rivi.onkoLihava())
+        trluokat << "lihava";
+    if( rivi.onkoViivaa())
+        trluokat << "viiva";
 
-        if( !rivi.sarakkeita())
-            txt.append("<td>&nbsp;</td>"); // Tyhjätkin rivit näkyviin!
+    if( trluokat.isEmpty())
+        txt.append("<tr>");
+    else
+        txt.append("<tr class=\"" + trluokat.join(' ') + "\">");
 
-        for(int i=0; i < rivi.sarakkeita(); i++)
-        {
+    if( !rivi.sarakkeita())
+        txt.append("<td>&nbsp;</td>"); // Tyhjätkin rivit näkyviin!
 
-            if( rivi.tasattuOikealle(i) )
-                txt.append(QString("<td colspan=%1 class=oikealle>").arg(rivi.leveysSaraketta(i)));
-            else
-                txt.append(QString("<td colspan=%1>").arg(rivi.leveysSaraketta(i)));
+    for(int i=0; i < rivi.sarakkeita(); i++)
+    {
+
+        if( rivi.tasattuOikealle(i) )
+            txt.append(QString("<td colspan=%1 class=oikealle>").arg(rivi.leveysSaraketta(i)));
+        else
+            txt.append(QString("<td colspan=%1>").arg(rivi.leveysSaraketta(i)));
 
-            if(linkit)
+        if(linkit)
+        {
+            if( rivi.sarake(i).linkkityyppi == RaporttiRiviSarake::TOSITE_ID)
+            {
+                // Linkki tositteeseen
+                txt.append( QString("<a href=\"%1.html\">").arg( rivi.sarake(i).linkkidata , 8, 10 , QChar('0') ) );
+            }
+            else if( rivi.sarake(i).linkkityyppi == RaporttiRiviSarake::TILI_NRO)
+            {
+                // Linkki tiliin
+                txt.append( QString("<a href=\"paakirja.html#%2\">").arg( rivi.sarake(i).linkkidata));
+            }
+            else if( rivi.sarake(i).linkkityyppi == RaporttiRiviSarake::TILI_LINKKI)
             {
-                if( rivi.sarake(i).linkkityyppi == RaporttiRiviSarake::TOSITE_ID)
-                {
-                    // Linkki tositteeseen
-                    txt.append( QString("<a href=\"%1.html\">").arg( rivi.sarake(i).linkkidata , 8, 10 , QChar('0') ) );
-                }
-                else if( rivi.sarake(i).linkkityyppi == RaporttiRiviSarake::TILI_NRO)
-                {
-                    // Linkki tiliin
-                    txt.append( QString("<a href=\"paakirja.html#%2\">").arg( rivi.sarake(i).linkkidata));
-                }
-                else if( rivi.sarake(i).linkkityyppi == RaporttiRiviSarake::TILI_LINKKI)
-                {
-                    // Nimiö dataan
-                    txt.append( QString("<a name=\"%1\">").arg( rivi.sarake(i).linkkidata));
-                }
+                // Nimiö dataan
+                txt.append( QString("<a name=\"%1\">").arg( rivi.sarake(i).linkkidata));
             }
-            QString tekstia = rivi.teksti(i);
-            tekstia.replace(' ', "&nbsp;");
-            tekstia.replace('\n', "<br>");
+        }
+        QString tekstia = rivi.teksti(i);
+        tekstia.replace(' ', "&nbsp;");
+        tekstia.replace('\n', "<br>");
 
-            txt.append(  tekstia );
+        txt.append(  tekstia );
 
-            if( linkit && rivi.sarake(i).linkkityyppi )
-                txt.append("</a>");
-
-            txt.append("&nbsp;</td>");
-        }
-        txt.append("</tr>\n");
+        if( linkit && rivi.sarake(i).linkkityyppi )
+            txt.append("</a>");
 
+        txt.append("&nbsp;</td>");
     }
-    txt.append("</table>");
+    txt.append("</tr>\n");
+    return txt;
+}
+
+QString RaportinKirjoittaja::htmlLoppu()
+{
+    QString txt("</table>");
     txt.append("<p class=tulostettu>Tulostettu " + QDate::currentDate().toString("dd.MM.yyyy"));
     if( kp()->onkoHarjoitus())
         txt.append("<br><span class=treeni>Kirjanpito on laadittu Kitupiikki-ohjelman harjoittelutilassa</span>");
 
     txt.append("</p></body></html>\n");
-
     return txt;
 }
 
@@ -445,10 +530,20 @@ QByteArray RaportinKirjoittaja::pdf(bool taustaraidat, bool tulostaA4) const
 QByteArray RaportinKirjoittaja::csv()
 {
     QChar erotin = kp()->settings()->value("CsvErotin", QChar(',')).toChar();
+    QChar desimaali = kp()->settings()->value("CsvDesimaali", QChar(',')).toChar();
+    QString pvmmuoto = kp()->settings()->value("CsvPaivays", "dd.MM.yyyy").toString();
 
-    QString txt;
+    QString txt = csvOtsakkeet(erotin);
+    for( const RaporttiRivi& rivi : rivit_ )
+        txt.append( csvRivi(rivi, erotin, desimaali, pvmmuoto));
 
-    for( RaporttiRivi otsikko : otsakkeet_)
+    return csvKoodattu(txt, kp()->settings()->value("CsvKoodaus").toString() == "latin1");
+}
+
+QString RaportinKirjoittaja::csvOtsakkeet(QChar erotin) const
+{
+    QString txt;
+    for( const RaporttiRivi& otsikko : otsakkeet_)
     {
         if( otsikko.kaytto() == RaporttiRivi::EICSV)
             continue;
@@ -458,31 +553,99 @@ QByteArray RaportinKirjoittaja::csv()
             otsakkeet.append( otsikko.csv(i));
         txt.append( otsakkeet.join(erotin));
     }
-    for( RaporttiRivi rivi : rivit_ )
-    {
-        if( rivi.kaytto() == RaporttiRivi::EICSV)
-            continue;
+    return txt;
+}
 
-        if( rivi.sarakkeita() )
-        {
+QString RaportinKirjoittaja::csvRivi(const RaporttiRivi &rivi, QChar erotin, QChar desimaalipilkku, const QString &pvmmuoto)
+{
+    if( rivi.kaytto() == RaporttiRivi::EICSV || !rivi.sarakkeita())
+        return QString();
 
-            txt.append("\r\n");
-            QStringList sarakkeet;
-            for( int i=0; i < rivi.sarakkeita(); i++)
-            {
-                sarakkeet.append( rivi.csv(i));
-            }
-            txt.append( sarakkeet.join(erotin));
-        }
+    QStringList sarakkeet;
+    for( int i=0; i < rivi.sarakkeita(); i++)
+        sarakkeet.append( rivi.csv(i, desimaalipilkku, pvmmuoto));
+
+    return "\r\n" + sarakkeet.join(erotin);
+}
+
+QByteArray RaportinKirjoittaja::csvKoodattu(QString teksti, bool latin1)
+{
+    if( latin1 )
+    {
+        teksti.replace("€","EUR");
+        return teksti.toLatin1();
     }
+    return teksti.toUtf8();
+}
+
+void RaportinKirjoittaja::asetaVirta(QIODevice *laite, RaportinKirjoittaja::VirranMuoto muoto, bool linkit)
+{
+    virta_ = laite;
+    virranMuoto_ = muoto;
+    virranLinkit_ = linkit;
+    virtaAloitettu_ = false;
+    virtaOk_ = true;
+    virranRiveja_ = 0;
+    edellisellaSarakkeita_ = false;
+    csvErotin_ = kp()->settings()->value("CsvErotin", QChar(',')).toChar();
+    csvDesimaali_ = kp()->settings()->value("CsvDesimaali", QChar(',')).toChar();
+    csvPaivays_ = kp()->settings()->value("CsvPaivays", "dd.MM.yyyy").toString();
+    csvLatin1_ = kp()->settings()->value("CsvKoodaus").toString() == "latin1";
+}
+
+bool RaportinKirjoittaja::lopetaVirta()
+{
+    if( !virta_ )
+        return false;
+
+    if( !virtaAloitettu_ )
+        kirjoitaVirtaan( virranMuoto_ == HTML ? htmlAlku() : csvOtsakkeet(csvErotin_) );
+    if( virranMuoto_ == HTML )
+        kirjoitaVirtaan( htmlLoppu() );
+    tyhjennaPuskuri();
 
-    if( kp()->settings()->value("CsvKoodaus").toString() == "latin1")
+    virta_ = nullptr;
+    return virtaOk_;
+}
+
+bool RaportinKirjoittaja::kirjoitaLaitteeseen(QIODevice *laite, RaportinKirjoittaja::VirranMuoto muoto, bool linkit)
+{
+    if( uudelleenkirjoitus_ )
     {
-        txt.replace("€","EUR");
-        return txt.toLatin1();
+        RaportinKirjoittaja rk( csvKaytossa_ );
+        rk.asetaHtmlLisat( htmlOtsakkeeseen_, htmlRunkoon_ );
+        rk.asetaVirta( laite, muoto, linkit );
+        uudelleenkirjoitus_( rk );
+        return rk.lopetaVirta();
     }
+
+    if( muoto == HTML )
+        return laite->write( html(linkit).toUtf8() ) > -1;
+    return laite->write( csv() ) > -1;
+}
+
+void RaportinKirjoittaja::asetaHtmlLisat(const QString &otsakkeeseen, const QString &runkoon)
+{
+    htmlOtsakkeeseen_ = otsakkeeseen;
+    htmlRunkoon_ = runkoon;
+}
+
+void RaportinKirjoittaja::kirjoitaVirtaan(const QString &teksti)
+{
+    if( virranMuoto_ == HTML )
+        puskuri_.append( teksti.toUtf8() );
     else
-        return txt.toUtf8();
+        puskuri_.append( csvKoodattu(teksti, csvLatin1_));
+
+    if( puskuri_.size() > 64 * 1024 )
+        tyhjennaPuskuri();
+}
+
+void RaportinKirjoittaja::tyhjennaPuskuri()
+{
+    if( virta_->write(puskuri_) != puskuri_.size())
+        virtaOk_ = false;
+    puskuri_.clear();
 }
 
 void RaportinKirjoittaja::tulostaYlatunniste(QPainter *painter, int sivu) const
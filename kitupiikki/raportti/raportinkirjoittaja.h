@@ -20,7 +20,13 @@
 
 #include <QString>
 #include <QList>
+#include <QVector>
 #include <QPrinter>
+#include <QByteArray>
+
+#include <functional>
+
+class QIODevice;
 
 #include "raporttirivi.h"
 
@@ -76,11 +82,25 @@ struct RaporttiSarake
  *    kirjoittaja.tulosta( &printer, &painter );
  * @endcode
  *
+ * Pitkät raportit voidaan myös viedä html- tai csv-muodossa suoraan tiedostoon
+ * asettamalla virta ennen rivien lisäämistä
+ *
+ * @code
+ *    kirjoittaja.asetaVirta( &tiedosto, RaportinKirjoittaja::CSV );
+ *    kirjoittaja.lisaaRivi(rivi);
+ *    kirjoittaja.lopetaVirta();
+ * @endcode
+ *
  */
 class RaportinKirjoittaja
 {
 
 public:
+    /**
+     * @brief Muoto, jossa rivit kirjoitetaan virtaan
+     */
+    enum VirranMuoto { HTML, CSV };
+
     RaportinKirjoittaja(bool csvKaytossa = true);
 
     void asetaOtsikko(const QString& otsikko);
@@ -129,6 +149,28 @@ public:
      */
     int tulosta(QPagedPaintDevice *printer, QPainter *painter, bool raidoita = false, int alkusivunumero = 1) const;
 
+    /**
+     * @brief Jakaa raportin sivuille
+     *
+     * Näytin piirtää raportin sivu kerrallaan vain näkyville sivuille,
+     * joten sivujen rajat selvitetään etukäteen.
+     *
+     * @param tulostusalue Sivun tulostusalueen koko piirtolaitteen pisteinä
+     * @param pieniSivu Alle 300 mm leveä sivu, jolle moni sarake tulostetaan pienemmällä fontilla
+     * @return Kunkin sivun ensimmäisen rivin indeksi
+     * @since 1.1
+     */
+    QList<int> sivuta(const QSize& tulostusalue, bool pieniSivu) const;
+
+    /**
+     * @brief Tulostaa yhden sivun
+     * @param ensimmainenRivi Sivun ensimmäinen rivi sivuta()-funktion mukaan
+     * @param sivunumero Ylätunnisteen sivunumero, 0 jos sivunumeroa ei tulosteta
+     * @return Seuraavan sivun ensimmäinen rivi
+     * @since 1.1
+     */
+    int tulostaSivu(QPainter *painter, bool pieniSivu, int ensimmainenRivi, int sivunumero, bool raidoita = false) const;
+
     /**
      * @brief Palauttaa raportin html-muodossa
      * @return
@@ -153,10 +195,59 @@ public:
      */
     QByteArray csv();
 
+    /**
+     * @brief Ohjaa lisättävät rivit suoraan laitteeseen
+     *
+     * Rivit muunnetaan html- tai csv-muotoon heti lisättäessä ja kirjoitetaan
+     * laitteeseen rajatun puskurin kautta, eikä niitä säilytetä kirjoittajassa.
+     * Otsikko, kausiteksti ja otsakkeet on asetettava ennen ensimmäistä riviä.
+     *
+     * @param laite Avattu laite, johon kirjoitetaan
+     * @param linkit Html-muodossa tositteiden ja tilien linkit arkistoon
+     * @since 1.1
+     */
+    void asetaVirta(QIODevice *laite, VirranMuoto muoto, bool linkit = false);
+    /**
+     * @brief Kirjoittaa puskuroidut rivit ja raportin lopun virtaan
+     * @return Onnistuiko kaikki kirjoittaminen
+     * @since 1.1
+     */
+    bool lopetaVirta();
+
+    /**
+     * @brief Asettaa funktion, jolla raportti voidaan kirjoittaa uudelleen
+     *
+     * Pitkät raportit (päiväkirja, pääkirja) kirjoitetaan tiedostoon
+     * tällä funktiolla suoraan virtana sen sijaan, että muistissa oleva
+     * raportti muunnettaisiin ensin kokonaan yhdeksi merkkijonoksi.
+     *
+     * @since 1.1
+     */
+    void asetaUudelleenkirjoitus(std::function<void(RaportinKirjoittaja&)> kirjoitus) { uudelleenkirjoitus_ = kirjoitus; }
+    /**
+     * @brief Kirjoittaa raportin html- tai csv-muodossa avattuun laitteeseen
+     *
+     * Jos uudelleenkirjoitus on asetettu, raportti kirjoitetaan sillä
+     * virtana, muuten laitteeseen kirjoitetaan html() tai csv().
+     *
+     * @return Onnistuiko kirjoittaminen
+     * @since 1.1
+     */
+    bool kirjoitaLaitteeseen(QIODevice *laite, VirranMuoto muoto, bool linkit = false);
+
+    /**
+     * @brief Lisää html-muotoisen raportin alkuun
+     * @param otsakkeeseen Lisätään ennen &lt;/head&gt;-tagia
+     * @param runkoon Lisätään heti &lt;body&gt;-tagin jälkeen
+     * @since 1.1
+     */
+    void asetaHtmlLisat(const QString& otsakkeeseen, const QString& runkoon);
+
     QString otsikko() const { return otsikko_; }
     QString kausiteksti() const { return kausiteksti_; }
 
     bool csvKaytossa() const { return csvKaytossa_;}
+    int riveja() const { return virta_ ? virranRiveja_ : rivit_.count(); }
 
     void tulostaYlatunniste(QPainter *painter, int sivu) const;
 
@@ -165,8 +256,35 @@ signals:
 public slots:
 
 protected:
+    /**
+     * @brief Sivun mitat ja sarakkeiden leveydet
+     */
+    struct Asettelu
+    {
+        int pienennys = 0;      /** Montako pistettä fonttia pienennetään */
+        int rivinkorkeus = 0;
+        int sivunleveys = 0;
+        int sivunkorkeus = 0;
+        int jaljella = 0;       /** Sarakkeilta käyttämättä jäävä leveys */
+        QVector<int> leveydet;
+    };
 
+    Asettelu asettele(QPainter *painter, bool pieniSivu) const;
+    int piirraSivu(QPainter *painter, const Asettelu& asettelu, int ensimmainenRivi, int sivunumero, bool raidoita) const;
+    int seuraavaTulostettava(int indeksi) const;
 
+    QString htmlAlku() const;
+    static QString htmlRivi(const RaporttiRivi& rivi, bool linkit);
+    static QString htmlLoppu();
+    QString csvOtsakkeet(QChar erotin) const;
+    static QString csvRivi(const RaporttiRivi& rivi, QChar erotin, QChar desimaalipilkku, const QString& pvmmuoto);
+    static QByteArray csvKoodattu(QString teksti, bool latin1);
+
+    /**
+     * @brief Lisää tekstin virran puskuriin ja tyhjentää täyden puskurin laitteeseen
+     */
+    void kirjoitaVirtaan(const QString& teksti);
+    void tyhjennaPuskuri();
 
 protected:
     QString otsikko_;
@@ -175,7 +293,25 @@ protected:
 
     QList<RaporttiSarake> sarakkeet_;
     QList<RaporttiRivi> otsakkeet_;
-    QList<RaporttiRivi> rivit_;
+    QVector<RaporttiRivi> rivit_;
+    QSet<QString> tekstit_;         /** Rivien yhteiset tekstit */
+
+    QIODevice *virta_ = nullptr;
+    VirranMuoto virranMuoto_ = HTML;
+    bool virranLinkit_ = false;
+    bool virtaAloitettu_ = false;   /** Onko alku ja otsakkeet jo kirjoitettu */
+    bool virtaOk_ = true;
+    int virranRiveja_ = 0;
+    bool edellisellaSarakkeita_ = false;
+    QChar csvErotin_;
+    QChar csvDesimaali_;
+    QString csvPaivays_;
+    bool csvLatin1_ = false;
+    QByteArray puskuri_;
+
+    std::function<void(RaportinKirjoittaja&)> uudelleenkirjoitus_;
+    QString htmlOtsakkeeseen_;
+    QString htmlRunkoon_;
 
 };
 
@@ -24,9 +24,11 @@
 
 #include "raportoija.h"
 #include "raporttirivi.h"
+#include "raporttivalimuisti.h"
 
 #include "db/kirjanpito.h"
 #include "db/tilikausi.h"
+#include "db/kyselyprofiloija.h"
 
 
 Raportoija::Raportoija(const QString &raportinNimi) :
@@ -64,6 +66,29 @@ void Raportoija::lisaaTasepaiva(const QDate &pvm)
 
 RaportinKirjoittaja Raportoija::raportti(bool tulostaErittelyt)
 {
+    // Välimuistin avain yksilöi raportin kaavan ja sarakkeet
+    QString avain = QString("Raportoija %1 %2 %3 %4").arg(otsikko_, kaava_.join('\n'), optiorivi_,
+                                                                QString::number(tulostaErittelyt));
+    QDate alkaa = alkuPaivat_.value(0);
+    QDate loppuu = loppuPaivat_.value(0);
+    for(int i=0; i < loppuPaivat_.count(); i++)
+    {
+        avain.append( QString(" %1 %2 %3").arg(alkuPaivat_.value(i).toString(Qt::ISODate))
+                      .arg(loppuPaivat_.at(i).toString(Qt::ISODate)).arg(sarakeTyypit_.value(i)));
+        if( alkuPaivat_.value(i) < alkaa )
+            alkaa = alkuPaivat_.value(i);
+        if( loppuPaivat_.at(i) > loppuu )
+            loppuu = loppuPaivat_.at(i);
+    }
+    for( int kohdennus : kohdennusKaytossa_)
+        avain.append( QString(" K%1").arg(kohdennus));
+
+    // Taseen saldot lasketaan kirjanpidon alusta
+    RaporttiValimuisti muisti( avain, tyyppi() == TASE ? QDate() : alkaa, loppuu);
+    if( muisti.loytyi())
+        return muisti.raportti();
+
+    KyselyProfiloija::Operaatio mittaus( otsikko_ );
     data_.resize( loppuPaivat_.count() );
 
     RaportinKirjoittaja rk;
@@ -134,7 +159,7 @@ RaportinKirjoittaja Raportoija::raportti(bool tulostaErittelyt)
             rk.lisaaRivi( RaporttiRivi());
         }
     }
-    return rk;
+    return muisti.tallenna(rk);
 }
 
 
@@ -522,7 +547,8 @@ void Raportoija::kirjoitaDatasta(RaportinKirjoittaja &rk, bool tulostaErittelyt)
 
 void Raportoija::sijoitaTulosKyselyData(const QString &kysymys, int i)
 {
-    QSqlQuery query(kysymys);
+    QSqlQuery query;
+    KyselyProfiloija::suorita(query, kysymys);
 
     qlonglong tulossumma = 0;
 
@@ -591,7 +617,7 @@ void Raportoija::laskeTaseDate()
 
         kysymys = QString("SELECT sum(debetsnt), sum(kreditsnt) FROM vienti, tili WHERE vienti.tili=tili.id "
                           " AND ysiluku > 300000000 AND pvm < \"%1\" ").arg( tilikausi.alkaa().toString(Qt::ISODate));
-        query.exec(kysymys);
+        KyselyProfiloija::suorita(query, kysymys);
         if( query.next())
         {
             qlonglong edYlijaama = query.value(1).toLongLong() - query.value(0).toLongLong();
@@ -610,7 +636,7 @@ void Raportoija::laskeTaseDate()
                           " AND ysiluku > 300000000 AND pvm BETWEEN \"%1\" AND \"%2\"")
                 .arg( tilikausi.alkaa().toString(Qt::ISODate) ).arg( loppuPaivat_.at(i).toString(Qt::ISODate));
 
-        query.exec(kysymys);
+        KyselyProfiloija::suorita(query, kysymys);
         if( query.next() )
         {
             qlonglong debet = query.value(0).toLongLong();
@@ -708,6 +734,8 @@ QString Raportoija::sarakeTyyppiTeksti(int sarake)
 
 void Raportoija::sijoitaBudjetti(int kohdennus)
 {
+    lataaBudjetit();
+
     budjetti_.clear();
     budjetti_.resize( sarakeTyypit_.count() );
 
@@ -720,40 +748,68 @@ void Raportoija::sijoitaBudjetti(int kohdennus)
             continue;
         }
 
-        for(int kausi=0; kausi < kp()->tilikaudet()->rowCount(QModelIndex()); kausi++ )
+        QHashIterator<int, QMap<int,qlonglong>> kohdennusIter( budjetit_.at(i) );
+        while( kohdennusIter.hasNext())
         {
-            Tilikausi tilikausi = kp()->tilikaudet()->tilikausiIndeksilla(kausi);
-            if( tilikausi.alkaa() > loppuPaivat_.value(i) || tilikausi.paattyy() < alkuPaivat_.value(i))
-                continue;
-
-            // Lisätään tämä tilikausi budjettiin
-            QVariantMap kohdennusMap = tilikausi.json()->variant("Budjetti").toMap();
-            QMapIterator<QString,QVariant> kohdennusIter(kohdennusMap);
-            while( kohdennusIter.hasNext())
-            {
-                kohdennusIter.next();
-                if( kohdennus > -1 && kohdennusIter.key().toInt() != kohdennus)
-                    continue;   // Ohitetaan väärä kohdennus
+            kohdennusIter.next();
+            if( kohdennus > -1 && kohdennusIter.key() != kohdennus)
+                continue;   // Ohitetaan väärä kohdennus
 
-                QVariantMap tiliMap = kohdennusIter.value().toMap();
-                QMapIterator<QString, QVariant> tiliIter(tiliMap);
-
-                while( tiliIter.hasNext())
-                {
-                    tiliIter.next();
-                    int tilille = Tili::ysiluku( tiliIter.key().toInt() ) + 9;
-                    qlonglong ennen = budjetti_[i].value( tilille, 0 );
-                    qlonglong lisattava = tiliIter.value().toLongLong();
-                    budjetti_[i].insert(tilille, ennen +  lisattava );
-                    summa += lisattava;
-                    tilitKaytossa_.insert( tilille, true );
-                }
+            QMapIterator<int, qlonglong> tiliIter( kohdennusIter.value());
+            while( tiliIter.hasNext())
+            {
+                tiliIter.next();
+                int tilille = Tili::ysiluku( tiliIter.key() ) + 9;
+                budjetti_[i][tilille] += tiliIter.value();
+                summa += tiliIter.value();
+                tilitKaytossa_.insert( tilille, true );
             }
         }
         budjetti_[i].insert(0, summa);
     }
 }
 
+void Raportoija::lataaBudjetit()
+{
+    // Ladataan uudelleen vain, jos sarakkeita on lisätty
+    if( budjetit_.count() == sarakeTyypit_.count())
+        return;
+
+    budjetit_.clear();
+    budjetit_.resize( sarakeTyypit_.count() );
+
+    QSqlQuery kysely;
+    kysely.prepare("SELECT kohdennus, tilinro, SUM(sentit) FROM budjetti "
+                   "JOIN tilikausi ON budjetti.tilikausi=tilikausi.alkaa "
+                   "WHERE tilikausi.alkaa <= :loppuu AND tilikausi.loppuu >= :alkaa "
+                   "GROUP BY kohdennus, tilinro");
+
+    for(int i=0; i < sarakeTyypit_.count(); i++)
+    {
+        if( sarakeTyypit_.value(i) == TOTEUTUNUT)
+            continue;
+
+        // Saman jakson budjetti haetaan vain kerran
+        int sama = 0;
+        for( ; sama < i; sama++)
+            if( sarakeTyypit_.value(sama) != TOTEUTUNUT &&
+                alkuPaivat_.value(sama) == alkuPaivat_.value(i) && loppuPaivat_.value(sama) == loppuPaivat_.value(i))
+                break;
+        if( sama < i)
+        {
+            budjetit_[i] = budjetit_.at(sama);
+            continue;
+        }
+
+        kysely.bindValue(":alkaa", alkuPaivat_.value(i));
+        kysely.bindValue(":loppuu", loppuPaivat_.value(i));
+        KyselyProfiloija::suorita(kysely);
+
+        while( kysely.next())
+            budjetit_[i][ kysely.value(0).toInt() ].insert( kysely.value(1).toInt(), kysely.value(2).toLongLong());
+    }
+}
+
 
 void Raportoija::etsiKohdennukset()
 {
@@ -774,25 +830,10 @@ void Raportoija::etsiKohdennukset()
         // budjetti
         if( sarakeTyyppi != TOTEUTUNUT)
         {
-            for(int i=0; i < loppuPaivat_.count(); i++)
-            {
-                // Lisätään budjetin kohdennukset näistä tilikausista
-                for(int kausi=0; kausi < kp()->tilikaudet()->rowCount(QModelIndex()); kausi++ )
-                {
-                    Tilikausi tilikausi = kp()->tilikaudet()->tilikausiIndeksilla(kausi);
-                    if( tilikausi.alkaa() > loppuPaivat_.value(i) || tilikausi.paattyy() < alkuPaivat_.value(i))
-                        continue;
-
-                    // Lisätään tämä tilikausi budjettiin
-                    QVariantMap kohdennusMap = tilikausi.json()->variant("Budjetti").toMap();
-                    QMapIterator<QString,QVariant> kohdennusIter(kohdennusMap);
-                    while( kohdennusIter.hasNext())
-                    {
-                        kohdennusIter.next();
-                        kohdennusKaytossa_.push_back(kohdennusIter.key().toInt());
-                    }
-                }
-            }
+            lataaBudjetit();
+            for( const auto& kohdennukset : budjetit_)
+                for( int kohdennusId : kohdennukset.keys())
+                    kohdennusKaytossa_.push_back( kohdennusId );
             break;
         }
     }
@@ -22,6 +22,7 @@
 #include <QDate>
 #include <QVector>
 #include <QMap>
+#include <QHash>
 #include <QObject>
 
 #include "raportinkirjoittaja.h"
@@ -162,6 +163,15 @@ protected:
 
     void sijoitaBudjetti(int kohdennus = -1);
 
+    /**
+     * @brief Hakee sarakkeiden budjetit kohdennuksittain
+     *
+     * Budjetit haetaan kerran yhdellä ryhmitellyllä kyselyllä kullekin
+     * eri jaksolle, jolloin kohdennuslaskelman jokainen kohdennus
+     * sijoitetaan valmiiksi haetusta datasta.
+     */
+    void lataaBudjetit();
+
 
 
 protected:
@@ -178,6 +188,7 @@ protected:
     QVector< QMap< int, qlonglong> > data_;    // ysiluku, sentit
     QVector< QMap< int, qlonglong> > budjetti_; // ysiluku, sentit
     QMap<int,bool> tilitKaytossa_;           // ysiluku
+    QVector< QHash< int, QMap<int, qlonglong> > > budjetit_;   // kohdennus, tilinumero, sentit
     std::list<int> kohdennusKaytossa_;       // kohdennusId
 
 
@@ -28,7 +28,8 @@ RaporttiRivi::RaporttiRivi(RivinKaytto kaytto)
 void RaporttiRivi::lisaa(const QString &teksti, int sarakkeet, bool tasaaOikealle)
 {
     RaporttiRiviSarake uusi;
-    uusi.arvo = QVariant(teksti);
+    uusi.tyyppi = RaporttiRiviSarake::TEKSTI;
+    uusi.teksti = teksti;
 
     uusi.leveysSaraketta = sarakkeet;
     uusi.tasaaOikealle = tasaaOikealle;
@@ -38,7 +39,8 @@ void RaporttiRivi::lisaa(const QString &teksti, int sarakkeet, bool tasaaOikeall
 void RaporttiRivi::lisaaLinkilla(RaporttiRiviSarake::Linkki linkkityyppi, int linkkitieto, const QString &teksti, int sarakkeet)
 {
     RaporttiRiviSarake uusi;
-    uusi.arvo = QVariant( teksti );
+    uusi.tyyppi = RaporttiRiviSarake::TEKSTI;
+    uusi.teksti = teksti;
 
     uusi.leveysSaraketta = sarakkeet;
     uusi.linkkityyppi = linkkityyppi;
@@ -50,7 +52,10 @@ void RaporttiRivi::lisaa(qlonglong sentit, bool tulostanollat)
 {
     RaporttiRiviSarake uusi;
     if( sentit || tulostanollat)
-        uusi.arvo = QVariant(sentit);
+    {
+        uusi.tyyppi = RaporttiRiviSarake::SENTIT;
+        uusi.arvo = sentit;
+    }
 
     uusi.tasaaOikealle = true;
     sarakkeet_.append( uusi );
@@ -58,59 +63,78 @@ void RaporttiRivi::lisaa(qlonglong sentit, bool tulostanollat)
 
 void RaporttiRivi::lisaa(const QDate &pvm)
 {
-    lisaa( pvm.toString("dd.MM.yyyy"), 1, false);
+    RaporttiRiviSarake uusi;
+    if( pvm.isValid())
+    {
+        uusi.tyyppi = RaporttiRiviSarake::PVM;
+        uusi.arvo = pvm.toJulianDay();
+    }
+    sarakkeet_.append(uusi);
 }
 
-QString RaporttiRivi::teksti(int sarake)
+QString RaporttiRivi::teksti(int sarake) const
 {
-    QVariant arvo = sarakkeet_.at(sarake).arvo;
-
-    if( arvo.type() == QVariant::LongLong )
-    {
-        return QString("%L1").arg(  arvo.toLongLong()  / 100.0 ,0,'f',2 );
-    }
-    else if( arvo.type() == QVariant::Date )
-    {
-        return arvo.toDate().toString("dd.MM.yyyy");
-    }
-    else if( arvo.type() == QVariant::String)
-    {
-        return arvo.toString();
-    }
-    else
+    const RaporttiRiviSarake& s = sarakkeet_.at(sarake);
+
+    switch (s.tyyppi) {
+    case RaporttiRiviSarake::SENTIT:
+        return QString("%L1").arg( s.arvo / 100.0 ,0,'f',2 );
+    case RaporttiRiviSarake::PVM:
+        return QDate::fromJulianDay(s.arvo).toString("dd.MM.yyyy");
+    case RaporttiRiviSarake::TEKSTI:
+        return s.teksti;
+    default:
         return QString();
+    }
+}
 
+QString RaporttiRivi::csv(int sarake) const
+{
+    return csv( sarake, kp()->settings()->value("CsvDesimaali", QChar(',')).toChar(),
+                kp()->settings()->value("CsvPaivays", "dd.MM.yyyy").toString());
 }
 
-QString RaporttiRivi::csv(int sarake)
+QString RaporttiRivi::csv(int sarake, QChar desimaalipilkku, const QString &pvmmuoto) const
 {
-    QVariant arvo = sarakkeet_.at(sarake).arvo;
+    const RaporttiRiviSarake& s = sarakkeet_.at(sarake);
 
-    if( arvo.type() == QVariant::LongLong )
+    if( s.tyyppi == RaporttiRiviSarake::SENTIT )
     {
-        QChar despilkku = kp()->settings()->value("CsvDesimaali", QChar(',')).toChar();
-        if( despilkku == ',')
-            return QString("\"%1\"").arg( arvo.toLongLong()  / 100.0 ,0,'f',2 ).replace('.',',');
+        if( desimaalipilkku == ',')
+            return QString("\"%1\"").arg( s.arvo / 100.0 ,0,'f',2 ).replace('.',',');
         else
-            return QString("\"%1\"").arg( arvo.toLongLong()  / 100.0 ,0,'f',2 );
+            return QString("\"%1\"").arg( s.arvo / 100.0 ,0,'f',2 );
     }
-    else if( arvo.type() == QVariant::Date )
+    else if( s.tyyppi == RaporttiRiviSarake::PVM )
     {
-        QString pvmmuoto = kp()->settings()->value("CsvPaivays", "dd.MM.yyyy").toString();
-        return arvo.toDate().toString(pvmmuoto);
+        return QDate::fromJulianDay(s.arvo).toString(pvmmuoto);
     }
-    else if( arvo.type() == QVariant::String)
+    else if( s.tyyppi == RaporttiRiviSarake::TEKSTI)
     {
-        QString str = arvo.toString();
+        const QString& str = s.teksti;
         if( str.contains(',') || str.contains('\"') || str.contains('\n') || str.contains(';') || str.contains(' ') || str.contains('\t'))
         {
-            str.replace("\"", "\"\"");
-            return QString("\"%1\"").arg(str);
+            QString lainattu(str);
+            lainattu.replace("\"", "\"\"");
+            return QString("\"%1\"").arg(lainattu);
         }
-        return arvo.toString();
+        return str;
     }
     else
         return QString();
 }
 
+void RaporttiRivi::jaaTekstit(QSet<QString> &tekstit)
+{
+    for( RaporttiRiviSarake& s : sarakkeet_)
+    {
+        if( s.tyyppi != RaporttiRiviSarake::TEKSTI || s.teksti.isEmpty())
+            continue;
 
+        QSet<QString>::const_iterator iter = tekstit.constFind(s.teksti);
+        if( iter == tekstit.constEnd())
+            tekstit.insert(s.teksti);
+        else
+            s.teksti = *iter;
+    }
+}
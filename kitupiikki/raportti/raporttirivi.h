@@ -20,14 +20,18 @@
 
 #include <QString>
 #include <QDate>
-#include <QList>
+#include <QVector>
+#include <QSet>
 
 /**
  * @brief Yhden raportin sarakkeen tiedot, RaporttiRivin käyttöön
+ *
+ * Rahamäärät tallennetaan sentteinä ja päivämäärät Julianisina päivinä,
+ * ja ne muotoillaan tekstiksi vasta tulostettaessa.
  */
 struct RaporttiRiviSarake
 {
-    enum Linkki
+    enum Linkki : quint8
     {
         EI_LINKKIA = 0,
         TILI_NRO = 1,
@@ -35,16 +39,18 @@ struct RaporttiRiviSarake
         TILI_LINKKI = 3
     };
 
-    bool tasaaOikealle = false;
-
-    QVariant arvo;
+    enum Tyyppi : quint8
+    {
+        TYHJA, TEKSTI, SENTIT, PVM
+    };
 
     QString teksti;
-    int leveysSaraketta = 1;
-
-    Linkki linkkityyppi = EI_LINKKIA;
+    qint64 arvo = 0;        /** Sentit tai päivämäärän Julianinen päivä */
     int linkkidata = 0;
-
+    quint16 leveysSaraketta = 1;
+    Tyyppi tyyppi = TYHJA;
+    Linkki linkkityyppi = EI_LINKKIA;
+    bool tasaaOikealle = false;
 };
 
 /**
@@ -111,35 +117,57 @@ public:
      * @param sarake Sarakkeen indeksi
      * @return
      */
-    QString teksti(int sarake);
+    QString teksti(int sarake) const;
 
     /**
      * @brief Csv-muotoon tulostettava sarake
      * @param sarake Sarakkeen indeksi
      * @return
      */
-    QString csv(int sarake);
+    QString csv(int sarake) const;
+
+    /**
+     * @brief Csv-muotoon tulostettava sarake annetuilla muotoiluilla
+     *
+     * Koko raporttia vietäessä asetukset luetaan vain kerran
+     *
+     * @param desimaalipilkku Rahamäärien desimaalierotin
+     * @param pvmmuoto Päivämäärien muoto
+     * @since 1.1
+     */
+    QString csv(int sarake, QChar desimaalipilkku, const QString& pvmmuoto) const;
 
     /**
      * @brief Palauttaa sarakkeen
      * @param indeksi Sarakkeen indeksi
      * @return
      */
-    RaporttiRiviSarake sarake(int indeksi) { return sarakkeet_[indeksi]; }
+    const RaporttiRiviSarake& sarake(int indeksi) const { return sarakkeet_.at(indeksi); }
 
     /**
      * @brief Kuinka monta ruudukkosaraketta tämä sarake täyttää
      * @param sarake
      * @return
      */
-    int leveysSaraketta(int sarake) { return sarakkeet_[sarake].leveysSaraketta; }
+    int leveysSaraketta(int sarake) const { return sarakkeet_.at(sarake).leveysSaraketta; }
 
     /**
      * @brief Onko sarake tasattu oikealle
      * @param sarake
      * @return
      */
-    bool tasattuOikealle(int sarake) { return sarakkeet_[sarake].tasaaOikealle; }
+    bool tasattuOikealle(int sarake) const { return sarakkeet_.at(sarake).tasaaOikealle; }
+
+    /**
+     * @brief Korvaa tekstit joukossa jo olevilla samansisältöisillä
+     *
+     * Raportin kirjoittaja yhdistää rivin lisätessään samat tekstit
+     * (tilien ja kohdennusten nimet, tositetunnukset) jakamaan yhden
+     * muistissa olevan merkkijonon.
+     *
+     * @since 1.1
+     */
+    void jaaTekstit(QSet<QString>& tekstit);
 
     /**
      * @brief Tyhjentää otsikkorivin
@@ -190,7 +218,7 @@ public:
 
 
 protected:
-    QList<RaporttiRiviSarake> sarakkeet_;
+    QVector<RaporttiRiviSarake> sarakkeet_;
     bool lihava_;
     bool ylaviiva_;
     int pistekoko_;
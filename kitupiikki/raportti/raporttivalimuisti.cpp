@@ -0,0 +1,64 @@
+/*
+   Copyright (C) 2018 Arto Hyvättinen
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QCache>
+
+#include "raporttivalimuisti.h"
+#include "db/kirjanpito.h"
+
+namespace {
+
+struct TallennettuRaportti
+{
+    qulonglong versio;
+    RaportinKirjoittaja raportti;
+};
+
+QCache<QString, TallennettuRaportti>& valimuisti()
+{
+    // Raportit voivat olla suuria, joten muistissa pidetään vain viimeksi käytetyt
+    static QCache<QString, TallennettuRaportti> muisti(64);
+    return muisti;
+}
+
+}
+
+RaporttiValimuisti::RaporttiValimuisti(const QString &avain, const QDate &alkaa, const QDate &loppuu)
+    : avain_(avain), versio_( kp()->muutosversio(alkaa, loppuu) )
+{
+
+}
+
+bool RaporttiValimuisti::loytyi() const
+{
+    TallennettuRaportti *tallennettu = valimuisti().object(avain_);
+    return tallennettu && tallennettu->versio == versio_;
+}
+
+RaportinKirjoittaja RaporttiValimuisti::raportti() const
+{
+    TallennettuRaportti *tallennettu = valimuisti().object(avain_);
+    if( tallennettu )
+        return tallennettu->raportti;
+    return RaportinKirjoittaja();
+}
+
+RaportinKirjoittaja RaporttiValimuisti::tallenna(const RaportinKirjoittaja &raportti)
+{
+    valimuisti().insert(avain_, new TallennettuRaportti{ versio_, raportti });
+    return raportti;
+}
@@ -0,0 +1,73 @@
+/*
+   Copyright (C) 2018 Arto Hyvättinen
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef RAPORTTIVALIMUISTI_H
+#define RAPORTTIVALIMUISTI_H
+
+#include <QString>
+#include <QDate>
+
+#include "raportinkirjoittaja.h"
+
+/**
+ * @brief Muodostettujen raporttien välimuisti
+ *
+ * Raportti tallennetaan avaimella, joka yksilöi raportin lajin ja
+ * valinnat, sekä sen aikavälin kirjausten muutosversiolla, jonka
+ * kirjauksista raportti on muodostettu. Raportti palautetaan
+ * välimuistista niin kauan, kun aikavälin kirjauksia ei ole muutettu
+ * (ks. Kirjanpito::muutosversio), joten esimerkiksi arkiston
+ * uudelleenmuodostaminen laskee uudelleen vain muuttuneiden kausien raportit.
+ *
+ * @code
+ * RaporttiValimuisti muisti( QString("Paakirja %1 %2").arg(..), QDate(), mihin);
+ * if( muisti.loytyi())
+ *     return muisti.raportti();
+ * ...
+ * return muisti.tallenna(rk);
+ * @endcode
+ *
+ * @since 1.1
+ */
+class RaporttiValimuisti
+{
+public:
+    /**
+     * @param avain Raportin laji ja valinnat
+     * @param alkaa Kirjausten aikavälin alku, josta raportti riippuu, QDate() jos kirjanpidon alusta
+     * @param loppuu Kirjausten aikavälin loppu, QDate() jos loppumaton
+     */
+    RaporttiValimuisti(const QString& avain, const QDate& alkaa, const QDate& loppuu);
+
+    /**
+     * @brief Onko ajantasainen raportti välimuistissa
+     */
+    bool loytyi() const;
+    RaportinKirjoittaja raportti() const;
+
+    /**
+     * @brief Tallentaa muodostetun raportin välimuistiin
+     * @return Tallennettu raportti
+     */
+    RaportinKirjoittaja tallenna(const RaportinKirjoittaja& raportti);
+
+protected:
+    QString avain_;
+    qulonglong versio_;
+};
+
+#endif // RAPORTTIVALIMUISTI_H
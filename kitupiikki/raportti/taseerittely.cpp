@@ -16,8 +16,11 @@
 */
 
 #include "taseerittely.h"
-#include "db/eranvalintamodel.h"
+#include "raporttivalimuisti.h"
+#include "db/kyselyprofiloija.h"
 #include <QSqlQuery>
+#include <QHash>
+#include <QPair>
 
 #include <QDebug>
 
@@ -46,6 +49,12 @@ RaportinKirjoittaja TaseErittely::raportti()
 
 RaportinKirjoittaja TaseErittely::kirjoitaRaportti(QDate mista, QDate mihin)
 {
+    RaporttiValimuisti muisti( QString("TaseErittely %1 %2").arg(mista.toString(Qt::ISODate)).arg(mihin.toString(Qt::ISODate)),
+                               QDate(), mihin);
+    if( muisti.loytyi())
+        return muisti.raportti();
+
+    KyselyProfiloija::Operaatio mittaus("Tase-erittely");
     RaportinKirjoittaja rk(false);
     rk.asetaOtsikko("TASE-ERITTELY");
     rk.asetaKausiteksti(QString("%1 - %2").arg(mista.toString("dd.MM.yyyy")).arg(mihin.toString("dd.MM.yyyy")));
@@ -70,36 +79,178 @@ RaportinKirjoittaja TaseErittely::kirjoitaRaportti(QDate mista, QDate mihin)
         rk.lisaaRivi();
     }
 
-    // Haetaan tilit, joissa kirjauksia
-    QSqlQuery kysely;
+    // Tilien saldot kauden alussa ja lopussa sekä kauden tapahtumien määrä
+    struct TiliSaldo
+    {
+        qlonglong alkuSnt = 0;      // debet - kredit ennen kauden alkua
+        qlonglong loppuSnt = 0;     // debet - kredit kauden lopussa
+        int tapahtumia = 0;
+    };
+
     QList<int> tiliIdt;
+    QHash<int,TiliSaldo> saldot;
+
+    QSqlQuery kysely;
+    kysely.prepare("SELECT tili.id, SUM(ifnull(debetsnt,0) - ifnull(kreditsnt,0)), "
+                   "SUM(CASE WHEN pvm < :mista THEN ifnull(debetsnt,0) - ifnull(kreditsnt,0) ELSE 0 END), "
+                   "SUM(CASE WHEN pvm >= :alkaa THEN 1 ELSE 0 END) "
+                   "FROM vienti JOIN tili ON vienti.tili=tili.id "
+                   "WHERE tili.ysiluku < 300000000 AND pvm <= :mihin "
+                   "GROUP BY tili.id ORDER BY tili.ysiluku");
+    kysely.bindValue(":mista", mista);
+    kysely.bindValue(":alkaa", mista);
+    kysely.bindValue(":mihin", mihin);
+    KyselyProfiloija::suorita(kysely);
 
-    kysely.exec( QString("select DISTINCT tili.id from tili,vienti where vienti.tili=tili.id and tili.ysiluku < 300000000 "
-                         "and pvm <= '%1' order by tili.ysiluku").arg(mihin.toString(Qt::ISODate)) );
     while(kysely.next() )
+    {
+        TiliSaldo saldo;
+        saldo.loppuSnt = kysely.value(1).toLongLong();
+        saldo.alkuSnt = kysely.value(2).toLongLong();
+        saldo.tapahtumia = kysely.value(3).toInt();
         tiliIdt.append( kysely.value(0).toInt());
+        saldot.insert( kysely.value(0).toInt(), saldo);
+    }
+
+    auto tilinSaldo = [&saldot, mista, mihin] (Tili& tili, bool alussa) -> qlonglong
+    {
+        // Yli/alijäämätileihin lasketaan myös tulostilit
+        if( tili.onko(TiliLaji::EDELLISTENTULOS) || tili.onko(TiliLaji::KAUDENTULOS))
+            return tili.saldoPaivalle( alussa ? mista.addDays(-1) : mihin );
+
+        qlonglong saldo = alussa ? saldot.value(tili.id()).alkuSnt : saldot.value(tili.id()).loppuSnt;
+        return tili.onko(TiliLaji::VASTAAVAA) ? saldo : 0 - saldo;
+    };
+
+    // Tilit, joiden muutokset tai tase-erät eritellään
+    QStringList muutosTilit;
+    QStringList eraTilit;
+    QStringList taydetTilit;
+    for( int tiliId : tiliIdt)
+    {
+        Tili tili = kp()->tilit()->tiliIdlla(tiliId);
+        if( tili.taseErittelyTapa() == Tili::TASEERITTELY_MUUTOKSET)
+            muutosTilit.append( QString::number(tiliId));
+        else if( tili.taseErittelyTapa() == Tili::TASEERITTELY_LISTA)
+            eraTilit.append( QString::number(tiliId));
+        else if( tili.taseErittelyTapa() == Tili::TASEERITTELY_TAYSI)
+        {
+            eraTilit.append( QString::number(tiliId));
+            taydetTilit.append( QString::number(tiliId));
+        }
+    }
+
+    // Kauden muutokset tileittäin
+    QHash<int, QList<ErittelyVienti>> muutokset;
+    if( !muutosTilit.isEmpty())
+    {
+        kysely.prepare(QString("SELECT vienti.tili, tosite.id, tosite.laji, tosite.tunniste, vienti.pvm, vienti.selite, "
+                               "vienti.debetsnt, vienti.kreditsnt FROM vienti JOIN tosite ON vienti.tosite=tosite.id "
+                               "WHERE vienti.tili IN (%1) AND vienti.pvm BETWEEN :mista AND :mihin "
+                               "ORDER BY vienti.tili, vienti.pvm, vienti.id").arg( muutosTilit.join(',')));
+        kysely.bindValue(":mista", mista);
+        kysely.bindValue(":mihin", mihin);
+        KyselyProfiloija::suorita(kysely);
+
+        while( kysely.next())
+        {
+            ErittelyVienti vienti;
+            vienti.tositeId = kysely.value(1).toInt();
+            vienti.pvm = kysely.value(4).toDate();
+            vienti.tunniste = tositeTunniste( kysely.value(2).toInt(), kysely.value(3).toInt(), vienti.pvm);
+            vienti.selite = kysely.value(5).toString();
+            vienti.debetSnt = kysely.value(6).toLongLong();
+            vienti.kreditSnt = kysely.value(7).toLongLong();
+            muutokset[ kysely.value(0).toInt() ].append(vienti);
+        }
+    }
+
+    // Tase-erät saldoineen
+    QHash<int, QList<ErittelyEra>> erat;
+    if( !eraTilit.isEmpty())
+    {
+        kysely.prepare(QString("SELECT era.tili, era.id, tosite.id, tosite.laji, tosite.tunniste, era.pvm, era.selite, "
+                               "era.debetsnt, era.kreditsnt, "
+                               "SUM(CASE WHEN liike.pvm < :mista THEN ifnull(liike.debetsnt,0) - ifnull(liike.kreditsnt,0) ELSE 0 END), "
+                               "SUM(CASE WHEN liike.pvm <= :mihin THEN ifnull(liike.debetsnt,0) - ifnull(liike.kreditsnt,0) ELSE 0 END) "
+                               "FROM vienti AS era JOIN tosite ON era.tosite=tosite.id "
+                               "LEFT OUTER JOIN vienti AS liike ON liike.eraid=era.id AND liike.tili=era.tili "
+                               "WHERE era.tili IN (%1) AND era.eraid=era.id AND era.pvm <= :loppuu "
+                               "GROUP BY era.id ORDER BY era.tili, era.pvm, era.id").arg( eraTilit.join(',')));
+        kysely.bindValue(":mista", mista);
+        kysely.bindValue(":mihin", mihin);
+        kysely.bindValue(":loppuu", mihin);
+        KyselyProfiloija::suorita(kysely);
+
+        // eraid -> tilin id ja indeksi tilin erissä
+        QHash<int, QPair<int,int>> eraIndeksit;
+
+        while( kysely.next())
+        {
+            int tiliId = kysely.value(0).toInt();
+
+            ErittelyEra era;
+            era.avaus.tositeId = kysely.value(2).toInt();
+            era.avaus.pvm = kysely.value(5).toDate();
+            era.avaus.tunniste = tositeTunniste( kysely.value(3).toInt(), kysely.value(4).toInt(), era.avaus.pvm);
+            era.avaus.selite = kysely.value(6).toString();
+            era.avaus.debetSnt = kysely.value(7).toLongLong();
+            era.avaus.kreditSnt = kysely.value(8).toLongLong();
+            era.alkusaldoSnt = kysely.value(9).toLongLong();
+            era.loppusaldoSnt = kysely.value(10).toLongLong();
+
+            eraIndeksit.insert( kysely.value(1).toInt(), qMakePair(tiliId, erat.value(tiliId).count()) );
+            erat[tiliId].append(era);
+        }
+
+        // Täysin eriteltävien tase-erien muutokset
+        if( !taydetTilit.isEmpty())
+        {
+            kysely.prepare(QString("SELECT liike.eraid, tosite.id, tosite.laji, tosite.tunniste, liike.pvm, liike.selite, "
+                                   "liike.debetsnt, liike.kreditsnt FROM vienti AS liike "
+                                   "JOIN vienti AS era ON liike.eraid=era.id JOIN tosite ON liike.tosite=tosite.id "
+                                   "WHERE era.tili IN (%1) AND era.eraid=era.id AND liike.id<>liike.eraid "
+                                   "AND liike.pvm BETWEEN :mista AND :mihin "
+                                   "ORDER BY liike.eraid, liike.pvm, liike.id").arg( taydetTilit.join(',')));
+            kysely.bindValue(":mista", mista);
+            kysely.bindValue(":mihin", mihin);
+            KyselyProfiloija::suorita(kysely);
+
+            while( kysely.next())
+            {
+                QPair<int,int> indeksi = eraIndeksit.value( kysely.value(0).toInt(), qMakePair(0,-1) );
+                if( indeksi.second < 0)
+                    continue;
+
+                ErittelyVienti vienti;
+                vienti.tositeId = kysely.value(1).toInt();
+                vienti.pvm = kysely.value(4).toDate();
+                vienti.tunniste = tositeTunniste( kysely.value(2).toInt(), kysely.value(3).toInt(), vienti.pvm);
+                vienti.selite = kysely.value(5).toString();
+                vienti.debetSnt = kysely.value(6).toLongLong();
+                vienti.kreditSnt = kysely.value(7).toLongLong();
+                erat[indeksi.first][indeksi.second].muutokset.append(vienti);
+            }
+        }
+    }
 
     long edYsiluku = 0;
 
-    foreach (int tiliId, tiliIdt)
+    for (int tiliId : tiliIdt)
     {
         Tili tili = kp()->tilit()->tiliIdlla(tiliId);
 
         // Ohitetaan tyhjät/tapahtumattomat tilit
-        if( !tili.saldoPaivalle(mihin))
+        if( !tilinSaldo(tili, false))
         {
             if(tili.taseErittelyTapa() == Tili::TASEERITTELY_SALDOT || tili.taseErittelyTapa() == Tili::TASEERITTELY_LISTA )
             {
                 continue;
             }
-            else
+            else if( !saldot.value(tiliId).tapahtumia )
             {
                 // Jos täysi tai muutos-tapahtumaerittely, niin ohitetaan jos ei myöskään tapahtumia
-                QSqlQuery tapahtumakysely( QString("SELECT count(id) from vienti where tili=%1 and pvm between '%2' and '%3")
-                                           .arg(tiliId).arg(mista.toString(Qt::ISODate)).arg(mihin.toString(Qt::ISODate)));
-                if( tapahtumakysely.next())
-                    if(!tapahtumakysely.value(0).toInt())
-                        continue;
+                continue;
             }
         }
 
@@ -124,7 +275,7 @@ RaportinKirjoittaja TaseErittely::kirjoitaRaportti(QDate mista, QDate mihin)
             RaporttiRivi rr;
             rr.lisaaLinkilla( RaporttiRiviSarake::TILI_NRO, tili.numero(), QString("%1 %2").arg(tili.numero()).arg(tili.nimi()), 3 );
 
-            rr.lisaa( tili.saldoPaivalle( mihin ), true);
+            rr.lisaa( tilinSaldo(tili, false), true);
             rr.lihavoi();
             rk.lisaaRivi(rr);
 
@@ -157,57 +308,48 @@ RaportinKirjoittaja TaseErittely::kirjoitaRaportti(QDate mista, QDate mihin)
             {
 
                 // Alkusaldo
-                quint64 alkusaldo = tili.saldoPaivalle( mista.addDays(-1));
+                qlonglong alkusaldo = tilinSaldo(tili, true);
                 if( alkusaldo )
                 {
                     RaporttiRivi ekaRivi;
                     ekaRivi.lisaa( "", 2);
                     ekaRivi.lisaa("Alkusaldo");
-                    ekaRivi.lisaa( tili.saldoPaivalle( mista.addDays(-1) ), true);
+                    ekaRivi.lisaa( alkusaldo, true);
                     rk.lisaaRivi( ekaRivi);
                 }
 
                 // Muutokset
-                kysely.exec(QString("SELECT tositelaji,tunniste,pvm,selite,debetsnt,kreditsnt,tositeId from vientivw where tilinro=%1 and "
-                            "pvm between \"%2\" and \"%3\" order by pvm")
-                            .arg(tili.numero()).arg(mista.toString(Qt::ISODate)).arg(mihin.toString(Qt::ISODate)) );
-
-                while( kysely.next() )
+                for( const ErittelyVienti& vienti : muutokset.value(tiliId))
                 {
                     RaporttiRivi rr;
-                    rr.lisaaLinkilla(RaporttiRiviSarake::TOSITE_ID, kysely.value("tositeId").toInt(),
-                                     QString("%1%2/%3").arg( kysely.value("tositelaji").toString()).arg(kysely.value("tunniste").toInt())
-                                     .arg( kp()->tilikaudet()->tilikausiPaivalle( kysely.value("pvm").toDate() ).kausitunnus() ) );
-                    rr.lisaa( kysely.value("pvm").toDate());
-                    rr.lisaa(kysely.value("selite").toString());
+                    rr.lisaaLinkilla(RaporttiRiviSarake::TOSITE_ID, vienti.tositeId, vienti.tunniste );
+                    rr.lisaa( vienti.pvm );
+                    rr.lisaa( vienti.selite );
                     if( tili.onko(TiliLaji::VASTAAVAA))
-                        rr.lisaa( kysely.value("debetsnt").toLongLong() - kysely.value("kreditsnt").toLongLong());
+                        rr.lisaa( vienti.debetSnt - vienti.kreditSnt );
                     else
-                        rr.lisaa( kysely.value("kreditsnt").toLongLong() - kysely.value("debetsnt").toLongLong());
+                        rr.lisaa( vienti.kreditSnt - vienti.debetSnt );
                     rk.lisaaRivi(rr);
                 }
 
             }
             else if( tili.taseErittelyTapa() == Tili::TASEERITTELY_LISTA)
             {
-                // Tase-erät saldoineen löytyvät kätevästi EranValintaModel:ista
-                EranValintaModel erat;
-                erat.lataa(tili, false, mihin);
-                // HUOM! Tase-erät alkavat riviltä 2, rivillä 0 "Muodosta uusi tase-erä", rivillä 1 "Ei tase-erää"
-                for(int i=2; i < erat.rowCount(QModelIndex()); i++)
+                // Tase-erät, joilla on saldoa kauden lopussa
+                for( const ErittelyEra& era : erat.value(tiliId))
                 {
-                    RaporttiRivi rr;
-                    QModelIndex ind = erat.index(i, 0);
+                    if( !era.loppusaldoSnt )
+                        continue;
 
-                    rr.lisaaLinkilla( RaporttiRiviSarake::TOSITE_ID, ind.data(EranValintaModel::TositeIdRooli).toInt(),
-                                      ind.data(EranValintaModel::TositteenTunnisteRooli).toString()  );
-                    rr.lisaa( ind.data(EranValintaModel::PvmRooli).toDate());
-                    rr.lisaa( ind.data(EranValintaModel::SeliteRooli).toString());
+                    RaporttiRivi rr;
+                    rr.lisaaLinkilla( RaporttiRiviSarake::TOSITE_ID, era.avaus.tositeId, era.avaus.tunniste );
+                    rr.lisaa( era.avaus.pvm );
+                    rr.lisaa( era.avaus.selite );
 
                     if( tili.onko(TiliLaji::VASTAAVAA))
-                        rr.lisaa( ind.data(EranValintaModel::SaldoRooli).toLongLong());
+                        rr.lisaa( era.loppusaldoSnt );
                     else
-                        rr.lisaa( 0 - ind.data(EranValintaModel::SaldoRooli).toLongLong());
+                        rr.lisaa( 0 - era.loppusaldoSnt );
                     rk.lisaaRivi(rr);
                 }
             }
@@ -215,53 +357,22 @@ RaportinKirjoittaja TaseErittely::kirjoitaRaportti(QDate mista, QDate mihin)
             {
                 // Tulostetaan tase-erät, joilla saldoa alkupäivällä tai tapahtumia tilikauden aikana
 
-                // EraId,SaldoSnt
-                QHash<int,qlonglong> alkusaldot;
-
-                // Alkusaldot
-                kysely.exec(QString("SELECT eraid, sum(debetsnt) as debetit, sum(kreditsnt) as kreditit from vienti "
-                                   "where tili=%1 and eraid is not null and pvm < \"%2\" group by eraid")
-                           .arg(tili.id()).arg(mista.toString(Qt::ISODate)));
-
-
-                // Tallennetaan saldotaulukkoon tilien eräsaldot
-                while( kysely.next() )
-                {
-                    if( tili.onko(TiliLaji::VASTATTAVAA))
-                         alkusaldot.insert( kysely.value("eraid").toInt(), kysely.value("kreditit").toLongLong() - kysely.value("debetit").toLongLong() );
-                    else
-                        alkusaldot.insert( kysely.value("eraid").toInt(), kysely.value("debetit").toLongLong() - kysely.value("kreditit").toLongLong() );
-                }
-
-                // Sitten haetaan tase-erän tiedot
-                kysely.exec(QString("SELECT vienti.id, debetsnt, kreditsnt, vienti.pvm, selite, laji, tunniste from vienti, tosite "
-                           "where tili=%1 and vienti.tosite=tosite.id and eraid=vienti.id order by vienti.pvm")
-                           .arg(tili.id()));
-
-                while( kysely.next())
+                for( const ErittelyEra& era : erat.value(tiliId))
                 {
                     rk.lisaaRivi();
 
-                    int eraId = kysely.value("id").toInt();
-
-                    qlonglong alkusnt = kysely.value("debetsnt").toLongLong() - kysely.value("kreditsnt").toLongLong();
+                    qlonglong alkusnt = era.avaus.debetSnt - era.avaus.kreditSnt;
                     if( tili.onko(TiliLaji::VASTATTAVAA))
                         alkusnt = 0 - alkusnt;
 
-
                     RaporttiRivi nimirivi;
-                    QString tunniste = QString("%1%2/%3")
-                            .arg( kp()->tositelajit()->tositelaji( kysely.value("laji").toInt() ).tunnus() )
-                            .arg( kysely.value("tunniste").toInt())
-                            .arg( kp()->tilikaudet()->tilikausiPaivalle( kysely.value("vienti.pvm").toDate() ).kausitunnus()  );
-
-                    nimirivi.lisaa(tunniste);
-                    nimirivi.lisaa( kysely.value("pvm").toDate());
-                    nimirivi.lisaa( kysely.value("selite").toString());
+                    nimirivi.lisaa( era.avaus.tunniste );
+                    nimirivi.lisaa( era.avaus.pvm );
+                    nimirivi.lisaa( era.avaus.selite );
                     nimirivi.lisaa( alkusnt);
                     rk.lisaaRivi(nimirivi);
 
-                    qlonglong saldo = alkusaldot.value(eraId);;
+                    qlonglong saldo = tili.onko(TiliLaji::VASTATTAVAA) ? 0 - era.alkusaldoSnt : era.alkusaldoSnt;
 
                     if( saldo && saldo != alkusnt )
                     {
@@ -284,27 +395,19 @@ RaportinKirjoittaja TaseErittely::kirjoitaRaportti(QDate mista, QDate mihin)
                         saldo = alkusnt;
 
                     // Muutokset
-                    QSqlQuery muKysely;
-                    muKysely.exec(QString("SELECT tositelaji,tunniste,pvm,selite,debetsnt,kreditsnt,tositeId from vientivw where eraid=%1 and "
-                                "vientiId<>eraid and  pvm between \"%2\" and \"%3\" order by pvm")
-                                .arg( eraId ).arg(mista.toString(Qt::ISODate)).arg(mihin.toString(Qt::ISODate)) );
-
-                    while( muKysely.next() )
+                    for( const ErittelyVienti& vienti : era.muutokset)
                     {
                         RaporttiRivi rr;
                         qlonglong muutos = 0;
                         if( tili.onko(TiliLaji::VASTAAVAA))
-                            muutos =  muKysely.value("debetsnt").toLongLong() - muKysely.value("kreditsnt").toLongLong();
+                            muutos =  vienti.debetSnt - vienti.kreditSnt;
                         else
-                            muutos =  muKysely.value("kreditsnt").toLongLong() - muKysely.value("debetsnt").toLongLong();
+                            muutos =  vienti.kreditSnt - vienti.debetSnt;
                         saldo += muutos;
 
-                        rr.lisaaLinkilla(RaporttiRiviSarake::TOSITE_ID, muKysely.value("tositeId").toInt(),
-                                         QString("%1%2/%3").arg( muKysely.value("tositelaji").toString()).arg(muKysely.value("tunniste").toInt())
-                                                            .arg( kp()->tilikaudet()->tilikausiPaivalle( muKysely.value("pvm").toDate() ).kausitunnus() ));
-
-                        rr.lisaa( muKysely.value("pvm").toDate());
-                        rr.lisaa( muKysely.value("selite").toString());
+                        rr.lisaaLinkilla(RaporttiRiviSarake::TOSITE_ID, vienti.tositeId, vienti.tunniste );
+                        rr.lisaa( vienti.pvm );
+                        rr.lisaa( vienti.selite );
                         rr.lisaa( muutos);
 
                         rk.lisaaRivi(rr);
@@ -325,7 +428,7 @@ RaportinKirjoittaja TaseErittely::kirjoitaRaportti(QDate mista, QDate mihin)
             RaporttiRivi vikaRivi;
             vikaRivi.lisaa("", 2);
             vikaRivi.lisaa(tr("Tilin %1 loppusaldo").arg(tili.numero()));
-            vikaRivi.lisaa( tili.saldoPaivalle(mihin), true);
+            vikaRivi.lisaa( tilinSaldo(tili, false), true);
             vikaRivi.lihavoi();
             vikaRivi.viivaYlle();
             rk.lisaaRivi( vikaRivi );
@@ -336,5 +439,12 @@ RaportinKirjoittaja TaseErittely::kirjoitaRaportti(QDate mista, QDate mihin)
 
     }
 
-    return rk;
+    return muisti.tallenna(rk);
+}
+
+QString TaseErittely::tositeTunniste(int laji, int tunniste, const QDate &pvm)
+{
+    return QString("%1%2/%3").arg( kp()->tositelajit()->tositelaji( laji ).tunnus() )
+                             .arg( tunniste )
+                             .arg( kp()->tilikaudet()->tilikausiPaivalle( pvm ).kausitunnus() );
 }
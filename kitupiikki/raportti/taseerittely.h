@@ -38,6 +38,32 @@ public:
     static RaportinKirjoittaja kirjoitaRaportti(QDate mista, QDate mihin);
 
 protected:
+    /**
+     * @brief Erittelyyn tulostettava vienti
+     */
+    struct ErittelyVienti
+    {
+        int tositeId = 0;
+        QString tunniste;
+        QDate pvm;
+        QString selite;
+        qlonglong debetSnt = 0;
+        qlonglong kreditSnt = 0;
+    };
+
+    /**
+     * @brief Tase-erä saldoineen ja kauden muutoksineen
+     */
+    struct ErittelyEra
+    {
+        ErittelyVienti avaus;           /** Tase-erän muodostava vienti */
+        qlonglong alkusaldoSnt = 0;     /** debet - kredit ennen kauden alkua */
+        qlonglong loppusaldoSnt = 0;    /** debet - kredit kauden lopussa */
+        QList<ErittelyVienti> muutokset;
+    };
+
+    static QString tositeTunniste(int laji, int tunniste, const QDate& pvm);
+
     Ui::TaseErittely *ui;
 };
 
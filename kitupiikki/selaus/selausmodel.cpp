@@ -18,7 +18,9 @@
 #include "selausmodel.h"
 
 #include <QSqlQuery>
+#include <QHash>
 #include "db/kirjanpito.h"
+#include "db/kyselyprofiloija.h"
 
 #include <QDebug>
 
@@ -160,6 +162,9 @@ QVariant SelausModel::data(const QModelIndex &index, int role) const
 
 void SelausModel::lataa(const QDate &alkaa, const QDate &loppuu)
 {
+    alkaa_ = alkaa;
+    loppuu_ = loppuu;
+
     QString kysymys = QString("SELECT vienti.tosite, vienti.pvm, tili, debetsnt, kreditsnt, selite, kohdennus, eraid, "
                               "tosite.laji, tosite.tunniste, vienti.id "
                               "FROM vienti, tosite WHERE vienti.pvm BETWEEN \"%1\" AND \"%2\" "
@@ -167,55 +172,147 @@ void SelausModel::lataa(const QDate &alkaa, const QDate &loppuu)
                               .arg( alkaa.toString(Qt::ISODate ) )
                               .arg( loppuu.toString(Qt::ISODate)) ;
 
+    KyselyProfiloija::Operaatio mittaus("Selaus");
     beginResetModel();
     rivit.clear();
     tileilla.clear();
 
+    QSqlQuery query;
+    KyselyProfiloija::suorita(query, kysymys);
+    while( query.next())
+    {
+        SelausRivi rivi = lueRivi(query);
+        rivit.append(rivi);
+        lisaaTili(rivi.tili);
+    }
+
+    tileilla.sort();
+    endResetModel();
+}
+
+void SelausModel::paivitaTosite(const TositeMuutos &muutos)
+{
+    if( muutos.koko )
+    {
+        if( muutos.loppuu >= alkaa_ && muutos.alkaa <= loppuu_)
+            lataa( alkaa_, loppuu_);
+        return;
+    }
+
+    // Tositteen omat viennit päivitetään vain, jos ne osuvat ladatulle aikavälille.
+    // Tase-erän saldo voi kuitenkin muuttua aikavälin ulkopuolisesta tositteesta
+    // (esim. helmikuussa maksettu tammikuun lasku), joten erien viennit haetaan aina.
+    bool omatViennit = muutos.alkaa.isValid() && muutos.loppuu >= alkaa_ && muutos.alkaa <= loppuu_;
+    if( !omatViennit && muutos.erat.isEmpty())
+        return;
+
+    QStringList erat;
+    for( int era : muutos.erat)
+        erat.append( QString::number(era) );
+    if( erat.isEmpty())
+        erat.append("0");
+
+    QString kysymys = QString("SELECT vienti.tosite, vienti.pvm, tili, debetsnt, kreditsnt, selite, kohdennus, eraid, "
+                              "tosite.laji, tosite.tunniste, vienti.id "
+                              "FROM vienti, tosite WHERE vienti.pvm BETWEEN \"%1\" AND \"%2\" "
+                              "AND vienti.tosite=tosite.id AND tili is not null "
+                              "AND (vienti.tosite=%3 OR vienti.eraid IN (%4))")
+                              .arg( alkaa_.toString(Qt::ISODate ) )
+                              .arg( loppuu_.toString(Qt::ISODate))
+                              .arg( omatViennit ? muutos.tositeId : 0 )
+                              .arg( erat.join(',') );
+
+    QHash<int,SelausRivi> uudet;    // vientiId, rivi
     QSqlQuery query;
     query.exec(kysymys);
     while( query.next())
     {
-        SelausRivi rivi;
-        rivi.tositeId = query.value(0).toInt();
-        rivi.pvm = query.value(1).toDate();
-        rivi.tili = kp()->tilit()->tiliIdlla( query.value(2).toInt());
-        rivi.debetSnt = query.value(3).toLongLong();
-        rivi.kreditSnt = query.value(4).toLongLong();
-        rivi.selite = query.value(5).toString();
-        rivi.kohdennus = kp()->kohdennukset()->kohdennus( query.value(6).toInt());
-        rivi.taseEra = TaseEra( query.value(7).toInt());
-        rivi.tositetunniste = QString("%1 %2/%3")
-                                       .arg( kp()->tositelajit()->tositelaji( query.value(8).toInt()  ).tunnus() )
-                                       .arg( query.value(9).toInt()  )
-                                       .arg( kp()->tilikaudet()->tilikausiPaivalle(rivi.pvm).kausitunnus() );
-        rivi.lajiteltavaTositetunniste = QString("%1%2/%3")
-                                       .arg( kp()->tositelajit()->tositelaji( query.value(8).toInt()  ).tunnus() )
-                                       .arg( query.value(9).toInt(),8,10,QChar('0'))
-                                       .arg( kp()->tilikaudet()->tilikausiPaivalle(rivi.pvm).kausitunnus() );
-        rivi.vientiId = query.value("vienti.id").toInt();
-
-
-        if( query.value("eraid").toInt() && rivi.tili.eritellaankoTase() )
+        SelausRivi rivi = lueRivi(query);
+        uudet.insert( rivi.vientiId, rivi);
+    }
+
+    // Päivitetään ja poistetaan olemassa olevat rivit
+    for(int i = rivit.count() - 1; i >= 0; i--)
+    {
+        const SelausRivi& rivi = rivit.at(i);
+        if( !( omatViennit && rivi.tositeId == muutos.tositeId) && !muutos.erat.contains(rivi.taseEra.eraId))
+            continue;
+
+        int vientiId = rivi.vientiId;
+        if( uudet.contains(vientiId) && uudet.value(vientiId).pvm == rivi.pvm)
         {
-            TaseEra era( query.value("eraid").toInt() );
-            rivi.eraMaksettu = era.saldoSnt == 0 ;
+            rivit[i] = uudet.take(vientiId);
+            emit dataChanged( index(i, TOSITE), index(i, SELITE));
         }
-
-        QSqlQuery tagikysely( QString("SELECT kohdennus FROM merkkaus WHERE vienti=%1").arg( query.value("vienti.id").toInt() ));
-        while( tagikysely.next())
+        else
         {
-            rivi.tagit.append( kp()->kohdennukset()->kohdennus( tagikysely.value(0).toInt() ).nimi() );
+            beginRemoveRows( QModelIndex(), i, i);
+            rivit.removeAt(i);
+            endRemoveRows();
         }
+    }
 
-        rivit.append(rivi);
+    // Lisätään uudet rivit päivämäärän mukaiseen paikkaan
+    for( const SelausRivi& uusi : uudet)
+    {
+        int i = 0;
+        while( i < rivit.count() && ( rivit.at(i).pvm < uusi.pvm ||
+                                      ( rivit.at(i).pvm == uusi.pvm && rivit.at(i).vientiId < uusi.vientiId)))
+            i++;
+        beginInsertRows( QModelIndex(), i, i);
+        rivit.insert(i, uusi);
+        endInsertRows();
+
+        if( lisaaTili(uusi.tili))
+            tileilla.sort();
+    }
+}
 
-        QString tilistr = QString("%1 %2")
-                    .arg(rivi.tili.numero())
-                    .arg(rivi.tili.nimi());
-        if( !tileilla.contains(tilistr))
-            tileilla.append(tilistr);
+SelausRivi SelausModel::lueRivi(QSqlQuery &query) const
+{
+    SelausRivi rivi;
+    rivi.tositeId = query.value(0).toInt();
+    rivi.pvm = query.value(1).toDate();
+    rivi.tili = kp()->tilit()->tiliIdlla( query.value(2).toInt());
+    rivi.debetSnt = query.value(3).toLongLong();
+    rivi.kreditSnt = query.value(4).toLongLong();
+    rivi.selite = query.value(5).toString();
+    rivi.kohdennus = kp()->kohdennukset()->kohdennus( query.value(6).toInt());
+    rivi.taseEra = TaseEra( query.value(7).toInt());
+    rivi.tositetunniste = QString("%1 %2/%3")
+                                   .arg( kp()->tositelajit()->tositelaji( query.value(8).toInt()  ).tunnus() )
+                                   .arg( query.value(9).toInt()  )
+                                   .arg( kp()->tilikaudet()->tilikausiPaivalle(rivi.pvm).kausitunnus() );
+    rivi.lajiteltavaTositetunniste = QString("%1%2/%3")
+                                   .arg( kp()->tositelajit()->tositelaji( query.value(8).toInt()  ).tunnus() )
+                                   .arg( query.value(9).toInt(),8,10,QChar('0'))
+                                   .arg( kp()->tilikaudet()->tilikausiPaivalle(rivi.pvm).kausitunnus() );
+    rivi.vientiId = query.value("vienti.id").toInt();
+
+
+    if( query.value("eraid").toInt() && rivi.tili.eritellaankoTase() )
+    {
+        TaseEra era( query.value("eraid").toInt() );
+        rivi.eraMaksettu = era.saldoSnt == 0 ;
     }
 
-    tileilla.sort();
-    endResetModel();
+    QSqlQuery& tagikysely = kp()->kysely("SELECT kohdennus FROM merkkaus WHERE vienti=:vienti");
+    tagikysely.bindValue(":vienti", query.value("vienti.id").toInt());
+    KyselyProfiloija::suorita(tagikysely);
+    while( tagikysely.next())
+    {
+        rivi.tagit.append( kp()->kohdennukset()->kohdennus( tagikysely.value(0).toInt() ).nimi() );
+    }
+    return rivi;
+}
+
+bool SelausModel::lisaaTili(const Tili &tili)
+{
+    QString tilistr = QString("%1 %2")
+                .arg(tili.numero())
+                .arg(tili.nimi());
+    if( tileilla.contains(tilistr))
+        return false;
+    tileilla.append(tilistr);
+    return true;
 }
@@ -25,6 +25,9 @@
 #include "db/tili.h"
 #include "db/kohdennus.h"
 #include "db/eranvalintamodel.h"
+#include "db/vientimodel.h"
+
+class QSqlQuery;
 
 /**
  * @brief SelausModel:in yhden rivin (viennin) tiedot
@@ -73,9 +76,28 @@ public:
 public slots:
     void lataa(const QDate& alkaa, const QDate& loppuu);
 
+    /**
+     * @brief Päivittää muuttuneen tositteen viennit
+     *
+     * Tositteen viennit sekä viennit, joiden tase-erään tosite
+     * kohdistuu, päivitetään, lisätään tai poistetaan riveittäin
+     *
+     * @since 1.1
+     */
+    void paivitaTosite(const TositeMuutos& muutos);
+
 protected:
+    SelausRivi lueRivi(QSqlQuery& query) const;
+    /**
+     * @brief Lisää tilin käytettyjen tilien luetteloon
+     * @return tosi, jos tili lisättiin
+     */
+    bool lisaaTili(const Tili& tili);
+
     QList<SelausRivi> rivit;
     QStringList tileilla;
+    QDate alkaa_;
+    QDate loppuu_;
 
 };
 
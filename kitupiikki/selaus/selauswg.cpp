@@ -59,6 +59,8 @@ SelausWg::SelausWg() :
     ui->selausView->sortByColumn(SelausModel::PVM, Qt::AscendingOrder);
 
     connect( ui->etsiEdit, SIGNAL(textChanged(QString)), etsiProxy, SLOT(setFilterFixedString(QString)));
+    connect( ui->etsiEdit, SIGNAL(returnPressed()), this, SLOT(etsiKaikilta()));
+    ui->etsiEdit->setToolTip(tr("Suodata näytettäviä rivejä. Enterillä haetaan tositteita, otsikoita, selitteitä ja liitteitä kaikilta tilikausilta."));
 
     connect( ui->alkuEdit, SIGNAL(editingFinished()), this, SLOT(paivita()));
     connect( ui->loppuEdit, SIGNAL(editingFinished()), this, SLOT(paivita()));
@@ -68,7 +70,7 @@ SelausWg::SelausWg() :
     ui->valintaTab->setCurrentIndex(0);     // Oletuksena tositteiden selaus
     connect( ui->valintaTab, SIGNAL(currentChanged(int)), this, SLOT(selaa(int)));
 
-    connect( Kirjanpito::db(), SIGNAL(kirjanpitoaMuokattu()), this, SLOT(paivita()));
+    connect( kp(), &Kirjanpito::tositeMuuttui, this, &SelausWg::paivitaTosite);
     connect( kp(), SIGNAL(tietokantaVaihtui()), this, SLOT(alusta()));
 
     connect( ui->alkuEdit, SIGNAL(dateChanged(QDate)), this, SLOT(alkuPvmMuuttui()));
@@ -107,24 +109,12 @@ void SelausWg::paivita()
     if( ui->valintaTab->currentIndex() == 1 )
     {
         model->lataa( ui->alkuEdit->date(), ui->loppuEdit->date());
-
-        QString valittu = ui->tiliCombo->currentText();
-        ui->tiliCombo->clear();
-        ui->tiliCombo->insertItem(0, QIcon(":/pic/Possu64.png"),"Kaikki tilit", QVariant("*"));
-        ui->tiliCombo->insertItems(1, model->kaytetytTilit());
-        ui->tiliCombo->setCurrentText(valittu);
-
+        taytaValinnat("Kaikki tilit", model->kaytetytTilit());
     }
     else
     {
         tositeModel->lataa( ui->alkuEdit->date(), ui->loppuEdit->date());
-
-        QString valittu = ui->tiliCombo->currentText();
-        ui->tiliCombo->clear();
-        ui->tiliCombo->insertItem(0, QIcon(":/pic/Possu64.png"),"Kaikki tositteet", QVariant("*"));
-        ui->tiliCombo->insertItems(1, tositeModel->lajiLista() );
-        ui->tiliCombo->setCurrentText(valittu);
-
+        taytaValinnat("Kaikki tositteet", tositeModel->lajiLista());
     }
 
     ui->selausView->resizeColumnsToContents();
@@ -244,6 +234,29 @@ void SelausWg::alkuPvmMuuttui()
         ui->loppuEdit->setDate( ui->alkuEdit->date().addMonths(1).addDays(-1) );
 }
 
+void SelausWg::etsiKaikilta()
+{
+    QString teksti = ui->etsiEdit->text();
+    if( teksti.trimmed().isEmpty())
+    {
+        paivita();
+        return;
+    }
+
+    ui->valintaTab->setCurrentIndex(0);
+    tositeModel->hae(teksti);
+
+    // Osuma voi olla muuallakin kuin otsikossa, joten osumia ei suodateta otsikon perusteella
+    etsiProxy->setFilterFixedString(QString());
+
+    ui->tiliCombo->clear();
+    ui->tiliCombo->insertItem(0, QIcon(":/pic/Possu64.png"),"Kaikki tositteet", QVariant("*"));
+    ui->tiliCombo->insertItems(1, tositeModel->lajiLista() );
+
+    ui->selausView->resizeColumnsToContents();
+    ui->summaLabel->setText( tr("%1 osumaa kaikilta tilikausilta").arg( tositeModel->rowCount(QModelIndex())));
+}
+
 void SelausWg::selaa(int kumpi)
 {
     if( kumpi == 0)
@@ -261,6 +274,33 @@ void SelausWg::siirrySivulle()
     selaa( ui->valintaTab->currentIndex() );
 }
 
+void SelausWg::paivitaTosite(const TositeMuutos &muutos)
+{
+    // Toinen välilehti ladataan joka tapauksessa uudelleen, kun sille siirrytään
+    if( ui->valintaTab->currentIndex() == 1 )
+    {
+        model->paivitaTosite(muutos);
+        if( ui->tiliCombo->count() != model->kaytetytTilit().count() + 1)
+            taytaValinnat("Kaikki tilit", model->kaytetytTilit());
+    }
+    else
+    {
+        tositeModel->paivitaTosite(muutos);
+        if( ui->tiliCombo->count() != tositeModel->lajiLista().count() + 1)
+            taytaValinnat("Kaikki tositteet", tositeModel->lajiLista());
+    }
+    paivitaSummat();
+}
+
+void SelausWg::taytaValinnat(const QString &kaikki, const QStringList &valinnat)
+{
+    QString valittu = ui->tiliCombo->currentText();
+    ui->tiliCombo->clear();
+    ui->tiliCombo->insertItem(0, QIcon(":/pic/Possu64.png"), kaikki, QVariant("*"));
+    ui->tiliCombo->insertItems(1, valinnat);
+    ui->tiliCombo->setCurrentText(valittu);
+}
+
 bool SelausWg::eventFilter(QObject *watched, QEvent *event)
 {
     if( watched == ui->selausView && event->type() == QEvent::KeyPress)
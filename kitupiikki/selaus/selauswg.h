@@ -27,6 +27,7 @@
 
 #include "ui_selauswg.h"
 #include "db/tilikausi.h"
+#include "db/vientimodel.h"
 
 #include "kitupiikkisivu.h"
 
@@ -63,12 +64,23 @@ public slots:
 
     void alkuPvmMuuttui();
 
+    /**
+     * @brief Hakee tositteita tekstihaulla kaikilta tilikausilta
+     */
+    void etsiKaikilta();
+
     /**
      * @brief Selaa tositteita tai vientejä
      * @param kumpi 0-tositteet, 1 viennit
      */
     void selaa(int kumpi);
 
+    /**
+     * @brief Päivittää muuttuneen tositteen rivit lataamatta koko listaa uudelleen
+     * @since 1.1
+     */
+    void paivitaTosite(const TositeMuutos& muutos);
+
 
 public:
     void siirrySivulle() override;
@@ -78,6 +90,11 @@ public:
 protected:
     bool eventFilter(QObject *watched, QEvent *event) override;
 
+    /**
+     * @brief Täyttää tili- tai tositelajivalinnan säilyttäen valitun
+     */
+    void taytaValinnat(const QString& kaikki, const QStringList& valinnat);
+
 signals:
     void tositeValittu(int id);
 
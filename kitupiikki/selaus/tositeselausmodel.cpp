@@ -16,12 +16,16 @@
 */
 
 #include <QSqlQuery>
+#include <QHash>
+#include <QIcon>
 
 #include <QDebug>
 #include <QSqlError>
 
 #include "tositeselausmodel.h"
 #include "db/kirjanpito.h"
+#include "db/hakuindeksi.h"
+#include "db/kyselyprofiloija.h"
 
 TositeSelausModel::TositeSelausModel()
 {
@@ -67,7 +71,7 @@ QVariant TositeSelausModel::data(const QModelIndex &index, int role) const
     if( !index.isValid())
         return QVariant();
 
-    TositeSelausRivi rivi = rivit.at( index.row());
+    const TositeSelausRivi& rivi = rivit.at( index.row());
 
     if( role == Qt::DisplayRole || role == Qt::EditRole)
     {
@@ -78,20 +82,20 @@ QVariant TositeSelausModel::data(const QModelIndex &index, int role) const
             if( role == Qt::EditRole)
                 // Lajittelua varten tasaleveä kenttä
                  return QVariant(QString("%1%2/%3")
-                        .arg( kp()->tositelajit()->tositelaji( rivi.tositeLaji ).tunnus() )
+                        .arg( rivi.lajitunnus )
                         .arg( rivi.tositeTunniste,8,10,QChar('0'))
-                        .arg( kp()->tilikaudet()->tilikausiPaivalle(rivi.pvm).kausitunnus() ));
+                        .arg( rivi.kausitunnus ));
 
 
             return QVariant(QString("%1 %2/%3")
-                    .arg( kp()->tositelajit()->tositelaji( rivi.tositeLaji ).tunnus() )
+                    .arg( rivi.lajitunnus )
                     .arg( rivi.tositeTunniste)
-                    .arg( kp()->tilikaudet()->tilikausiPaivalle(rivi.pvm).kausitunnus() ));
+                    .arg( rivi.kausitunnus ));
         case PVM:
             return QVariant( rivi.pvm );
 
         case TOSITELAJI:
-            return kp()->tositelajit()->tositelaji( rivi.tositeLaji ).nimi();
+            return rivi.lajinimi;
 
         case OTSIKKO:
             return QVariant( rivi.otsikko );
@@ -106,6 +110,14 @@ QVariant TositeSelausModel::data(const QModelIndex &index, int role) const
         }
 
     }
+    else if( role == Qt::DecorationRole && index.column() == OTSIKKO && rivi.liitteita)
+    {
+        return QIcon(":/pic/liite.png");
+    }
+    else if( role == Qt::ToolTipRole && index.column() == OTSIKKO && !rivi.ote.isEmpty())
+    {
+        return rivi.ote;
+    }
     else if( role == Qt::TextAlignmentRole)
     {
         if( index.column() == SUMMA )
@@ -129,18 +141,28 @@ QVariant TositeSelausModel::data(const QModelIndex &index, int role) const
 
 void TositeSelausModel::lataa(const QDate &alkaa, const QDate &loppuu)
 {
-    QString kysymys = QString("SELECT tosite.id, tosite.pvm, otsikko, laji, tunniste "
-                              "FROM tosite WHERE tosite.pvm BETWEEN \"%1\" AND \"%2\" "
-                              "ORDER BY tosite.pvm, tosite.id ")
-            .arg(alkaa.toString(Qt::ISODate)).arg(loppuu.toString(Qt::ISODate)) ;
+    alkaa_ = alkaa;
+    loppuu_ = loppuu;
+    haku_ = false;
+
+    // #138 Viennittömätkin tositteet näytetään, joten summat liitetään ulkoliitoksella
+    QSqlQuery& kysely = kp()->kysely("SELECT tosite.id, tosite.pvm, otsikko, laji, tunniste, "
+                                     "SUM(debetsnt), SUM(kreditsnt), "
+                                     "(SELECT COUNT(*) FROM liite WHERE liite.tosite=tosite.id) "
+                                     "FROM tosite LEFT OUTER JOIN vienti ON vienti.tosite=tosite.id "
+                                     "WHERE tosite.pvm BETWEEN :alkaa AND :loppuu "
+                                     "GROUP BY tosite.id ORDER BY tosite.pvm, tosite.id");
+    kysely.bindValue(":alkaa", alkaa);
+    kysely.bindValue(":loppuu", loppuu);
 
     beginResetModel();
 
     rivit.clear();
     kaytetytLajinimet.clear();
+    lajit_.clear();
 
-    QSqlQuery kysely;
-    kysely.exec(kysymys);
+    KyselyProfiloija::Operaatio mittaus("Tositeselaus");
+    KyselyProfiloija::suorita(kysely);
 
     while( kysely.next())
     {
@@ -151,30 +173,141 @@ void TositeSelausModel::lataa(const QDate &alkaa, const QDate &loppuu)
         rivi.tositeLaji = kysely.value(3).toInt();
         rivi.tositeTunniste = kysely.value(4).toInt();
 
-        // #138 Jotta viennittömät kirjaukset näytettäisiin, kysellään summat erikseen
-        QSqlQuery summakysely( QString("SELECT sum(debetsnt), sum(kreditsnt) FROM vienti WHERE tosite=%1").arg(rivi.tositeId));
-        if( summakysely.next())
-        {
-            qlonglong debet = summakysely.value(0).toLongLong();
-            qlonglong kredit = summakysely.value(1).toLongLong();
+        // Yleensä kreditin ja debetin pitäisi täsmätä ;)
+        rivi.summa = qMax( kysely.value(5).toLongLong(), kysely.value(6).toLongLong());
+        rivi.liitteita = kysely.value(7).toInt();
 
-            // Yleensä kreditin ja debetin pitäisi täsmätä ;)
-            if( debet > kredit)
-                rivi.summa = debet;
-            else
-                rivi.summa = kredit;
-        }
+        lisaaRivi(rivi);
+    }
+
+    kaytetytLajinimet.sort();
+    endResetModel();
+
+}
 
-        rivit.append(rivi);
+void TositeSelausModel::hae(const QString &teksti)
+{
+    haku_ = true;
+    hakuteksti_ = teksti;
+    beginResetModel();
 
-        // Listalla käytettyjen lajien tunnukset
-        QString tositelajinimi = kp()->tositelajit()->tositelaji( rivi.tositeLaji ).nimi();
-        if( !kaytetytLajinimet.contains(tositelajinimi))
-            kaytetytLajinimet.append(tositelajinimi);
+    rivit.clear();
+    kaytetytLajinimet.clear();
+    lajit_.clear();
 
+    for( const HakuIndeksi::Osuma& osuma : kp()->hakuindeksi()->hae(teksti))
+    {
+        TositeSelausRivi rivi;
+        rivi.tositeId = osuma.tositeId;
+        rivi.pvm = osuma.pvm;
+        rivi.otsikko = osuma.otsikko;
+        rivi.tositeLaji = osuma.tositeLaji;
+        rivi.tositeTunniste = osuma.tositeTunniste;
+        rivi.summa = osuma.summa;
+        rivi.ote = osuma.ote;
+        lisaaRivi(rivi);
     }
 
     kaytetytLajinimet.sort();
     endResetModel();
+}
+
+void TositeSelausModel::paivitaTosite(const TositeMuutos &muutos)
+{
+    if( muutos.koko )
+    {
+        if( haku_ )
+            hae( hakuteksti_ );
+        else if( muutos.loppuu >= alkaa_ && muutos.alkaa <= loppuu_)
+            lataa( alkaa_, loppuu_);
+        return;
+    }
 
+    int indeksi = -1;
+    for(int i=0; i < rivit.count(); i++)
+        if( rivit.at(i).tositeId == muutos.tositeId)
+            indeksi = i;
+
+    // Tekstihaun osumista päivitetään vain näytettävät tositteet
+    if( haku_ && indeksi < 0)
+        return;
+
+    TositeSelausRivi rivi;
+    bool loytyi = false;
+
+    if( !muutos.poistettu )
+    {
+        QSqlQuery& kysely = kp()->kysely("SELECT tosite.id, tosite.pvm, otsikko, laji, tunniste, "
+                                         "SUM(debetsnt), SUM(kreditsnt), "
+                                         "(SELECT COUNT(*) FROM liite WHERE liite.tosite=tosite.id) "
+                                         "FROM tosite LEFT OUTER JOIN vienti ON vienti.tosite=tosite.id "
+                                         "WHERE tosite.id=:id GROUP BY tosite.id");
+        kysely.bindValue(":id", muutos.tositeId);
+        kysely.exec();
+
+        if( kysely.next())
+        {
+            rivi.tositeId = kysely.value(0).toInt();
+            rivi.pvm = kysely.value(1).toDate();
+            rivi.otsikko = kysely.value(2).toString();
+            rivi.tositeLaji = kysely.value(3).toInt();
+            rivi.tositeTunniste = kysely.value(4).toInt();
+            rivi.summa = qMax( kysely.value(5).toLongLong(), kysely.value(6).toLongLong());
+            rivi.liitteita = kysely.value(7).toInt();
+            loytyi = haku_ || ( rivi.pvm >= alkaa_ && rivi.pvm <= loppuu_ );
+        }
+    }
+
+    if( indeksi > -1 && loytyi && ( haku_ || rivi.pvm == rivit.at(indeksi).pvm ))
+    {
+        // Päivitetään paikallaan
+        rivi.ote = rivit.at(indeksi).ote;
+        taydennaRivi(rivi);
+        kaytetytLajinimet.sort();
+        rivit[indeksi] = rivi;
+        emit dataChanged( index(indeksi, TUNNISTE), index(indeksi, OTSIKKO));
+        return;
+    }
+
+    if( indeksi > -1)
+    {
+        beginRemoveRows( QModelIndex(), indeksi, indeksi);
+        rivit.removeAt(indeksi);
+        endRemoveRows();
+    }
+
+    if( loytyi )
+    {
+        taydennaRivi(rivi);
+        kaytetytLajinimet.sort();
+        int i = 0;
+        while( i < rivit.count() && ( rivit.at(i).pvm < rivi.pvm ||
+                                      ( rivit.at(i).pvm == rivi.pvm && rivit.at(i).tositeId < rivi.tositeId)))
+            i++;
+        beginInsertRows( QModelIndex(), i, i);
+        rivit.insert(i, rivi);
+        endInsertRows();
+    }
+}
+
+void TositeSelausModel::lisaaRivi(TositeSelausRivi &rivi)
+{
+    taydennaRivi(rivi);
+    rivit.append(rivi);
+}
+
+void TositeSelausModel::taydennaRivi(TositeSelausRivi &rivi)
+{
+    if( !lajit_.contains(rivi.tositeLaji))
+    {
+        // Listalla käytettyjen lajien nimet
+        Tositelaji laji = kp()->tositelajit()->tositelaji( rivi.tositeLaji );
+        lajit_.insert(rivi.tositeLaji, laji);
+        if( !kaytetytLajinimet.contains(laji.nimi()))
+            kaytetytLajinimet.append(laji.nimi());
+    }
+    const Tositelaji& laji = lajit_[rivi.tositeLaji];
+    rivi.lajitunnus = laji.tunnus();
+    rivi.lajinimi = laji.nimi();
+    rivi.kausitunnus = kp()->tilikaudet()->tilikausiPaivalle(rivi.pvm).kausitunnus();
 }
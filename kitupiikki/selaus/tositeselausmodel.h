@@ -21,6 +21,11 @@
 #include <QAbstractTableModel>
 #include <QDate>
 #include <QList>
+#include <QHash>
+
+#include "db/tositelaji.h"
+
+struct TositeMuutos;
 
 /**
  * @brief Yhden tositteen tiedot tositteiden selauksessa
@@ -33,7 +38,14 @@ struct TositeSelausRivi
     int tositeTunniste;
 
     QString otsikko;
-    qlonglong summa;
+    qlonglong summa = 0;
+    int liitteita = 0;
+
+    QString ote;    /** Tekstihaun osuman ympäristö */
+
+    QString lajitunnus;
+    QString lajinimi;
+    QString kausitunnus;
 
 };
 
@@ -67,10 +79,40 @@ public:
 public slots:
     void lataa(const QDate& alkaa, const QDate& loppuu);
 
+    /**
+     * @brief Lataa tekstihaun osumat kaikilta tilikausilta
+     * @param teksti Haettavat sanat
+     *
+     * @since 1.1
+     */
+    void hae(const QString& teksti);
+
+    /**
+     * @brief Päivittää, lisää tai poistaa muuttuneen tositteen rivin
+     *
+     * @since 1.1
+     */
+    void paivitaTosite(const TositeMuutos& muutos);
+
 protected:
+    /**
+     * @brief Täydentää rivin tositelajin ja tilikauden tiedot
+     */
+    void taydennaRivi(TositeSelausRivi& rivi);
+    /**
+     * @brief Täydentää rivin tiedot ja lisää rivin listaan
+     */
+    void lisaaRivi(TositeSelausRivi& rivi);
+
     QList<TositeSelausRivi> rivit;
+    QHash<int,Tositelaji> lajit_;
     QStringList kaytetytLajinimet;
 
+    QDate alkaa_;
+    QDate loppuu_;
+    bool haku_ = false;     /** Näytetään tekstihaun osumia */
+    QString hakuteksti_;
+
 };
 
 #endif // TOSITESELAUSMODEL_H
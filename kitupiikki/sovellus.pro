@@ -0,0 +1,16 @@
+include(kitupiikki.pri)
+
+TARGET = kitupiikki
+
+TEMPLATE = app
+
+SOURCES += main.cpp
+
+DISTFILES += \
+    uusikp/luo.sql \
+    aloitussivu/qrc/avaanappi.png \
+    aloitussivu/qrc/aloitus.css \
+    uusikp/update3.sql
+
+
+RC_ICONS = kitupiikki.ico
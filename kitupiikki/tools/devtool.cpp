@@ -16,12 +16,26 @@
 */
 
 #include <QSettings>
+#include <QCheckBox>
+#include <QSpinBox>
+#include <QLabel>
+#include <QPushButton>
+#include <QTableWidget>
+#include <QHeaderView>
+#include <QHBoxLayout>
+#include <QVBoxLayout>
+#include <QFileDialog>
+#include <QFile>
+#include <QMessageBox>
+#include <QHash>
+#include <QPair>
 
 #include "devtool.h"
 #include "ui_devtool.h"
 
 #include "db/kirjanpito.h"
 #include "uusikp/skripti.h"
+#include "db/kyselyprofiloija.h"
 
 DevTool::DevTool(QWidget *parent) :
     QDialog(parent),
@@ -44,6 +58,7 @@ DevTool::DevTool(QWidget *parent) :
     ui->keksiLabel->setText( kp()->settings()->value("Keksi").toString());
 
     alustaRistinolla();
+    alustaProfiloija();
 
 }
 
@@ -242,3 +257,109 @@ void DevTool::alustaRistinolla()
     connect( ui->uusipeliNappi, SIGNAL(clicked(bool)), this, SLOT(uusiPeli()));
 }
 
+void DevTool::naytaKyselyt()
+{
+    enum { ALUE, KYSELY, PARAMETRIT, RIVIT, KESTO, TOISTOJA };
+
+    // Saman operaation aikana toistuvat kyselymuodot
+    QHash<QPair<int,QString>,int> toistot;
+    for( const KyselyProfiloija::Toisto& toisto : KyselyProfiloija::toistot( toistoKynnys_->value()))
+        toistot.insert( qMakePair(toisto.operaatio, toisto.muoto), toisto.kertoja);
+
+    QVector<KyselyProfiloija::Kirjaus> kirjaukset = KyselyProfiloija::kirjaukset();
+
+    kyselyTaulu_->setSortingEnabled(false);
+    kyselyTaulu_->setRowCount( kirjaukset.count() );
+
+    for(int i=0; i < kirjaukset.count(); i++)
+    {
+        const KyselyProfiloija::Kirjaus& kirjaus = kirjaukset.at(i);
+        int kertoja = kirjaus.sql.isEmpty() ? 0 :
+                      toistot.value( qMakePair(kirjaus.operaatio, KyselyProfiloija::muoto(kirjaus.sql)), 0);
+
+        QTableWidgetItem *alue = new QTableWidgetItem( kirjaus.alue );
+        QTableWidgetItem *kysely = new QTableWidgetItem( kirjaus.sql.isEmpty() ? tr("(operaatio)") : kirjaus.sql.simplified() );
+        kysely->setToolTip( kirjaus.sql );
+        QTableWidgetItem *parametrit = new QTableWidgetItem( kirjaus.parametrit );
+
+        // Luvut lajitellaan lukuina
+        QTableWidgetItem *rivit = new QTableWidgetItem;
+        if( kirjaus.rivit >= 0 )
+            rivit->setData(Qt::DisplayRole, kirjaus.rivit);
+        QTableWidgetItem *kesto = new QTableWidgetItem;
+        kesto->setData(Qt::DisplayRole, kirjaus.kestoUs / 1000.0);
+        QTableWidgetItem *toistoja = new QTableWidgetItem;
+        if( kertoja )
+            toistoja->setData(Qt::DisplayRole, kertoja);
+
+        kyselyTaulu_->setItem(i, ALUE, alue);
+        kyselyTaulu_->setItem(i, KYSELY, kysely);
+        kyselyTaulu_->setItem(i, PARAMETRIT, parametrit);
+        kyselyTaulu_->setItem(i, RIVIT, rivit);
+        kyselyTaulu_->setItem(i, KESTO, kesto);
+        kyselyTaulu_->setItem(i, TOISTOJA, toistoja);
+
+        if( kertoja )
+            for(int sarake = ALUE; sarake <= TOISTOJA; sarake++)
+                kyselyTaulu_->item(i, sarake)->setBackground( QColor(255, 220, 180));
+    }
+
+    kyselyTaulu_->setSortingEnabled(true);
+}
+
+void DevTool::vieJalki()
+{
+    QString tiedostonimi = QFileDialog::getSaveFileName(this, tr("Vie kyselyjen ajoitus"), "kyselyt.json",
+                                                        tr("Chromen jäljitys (*.json)"));
+    if( tiedostonimi.isEmpty())
+        return;
+
+    QFile tiedosto(tiedostonimi);
+    if( !tiedosto.open(QIODevice::WriteOnly | QIODevice::Truncate) || tiedosto.write( KyselyProfiloija::chromeJalki() ) < 0)
+        QMessageBox::critical(this, tr("Tiedoston kirjoittaminen epäonnistui"),
+                              tr("Tiedostoon %1 kirjoittaminen epäonnistui").arg(tiedostonimi));
+}
+
+void DevTool::alustaProfiloija()
+{
+    QWidget *sivu = new QWidget;
+    QVBoxLayout *leiska = new QVBoxLayout(sivu);
+    QHBoxLayout *valinnat = new QHBoxLayout;
+
+    QCheckBox *kaytossa = new QCheckBox(tr("Kirjaa kyselyt"));
+    kaytossa->setChecked( KyselyProfiloija::kaytossa() );
+    connect( kaytossa, &QCheckBox::toggled, this, [] (bool paalla) { KyselyProfiloija::asetaKayttoon(paalla); });
+    valinnat->addWidget(kaytossa);
+
+    valinnat->addWidget( new QLabel(tr("Toistuva, kun operaatiossa yli")));
+    toistoKynnys_ = new QSpinBox;
+    toistoKynnys_->setRange(1, 10000);
+    toistoKynnys_->setValue(20);
+    valinnat->addWidget(toistoKynnys_);
+    valinnat->addStretch();
+
+    QPushButton *paivitaNappi = new QPushButton(tr("Päivitä"));
+    QPushButton *tyhjennaNappi = new QPushButton(tr("Tyhjennä"));
+    QPushButton *vieNappi = new QPushButton(tr("Vie jäljitys..."));
+    valinnat->addWidget(paivitaNappi);
+    valinnat->addWidget(tyhjennaNappi);
+    valinnat->addWidget(vieNappi);
+    leiska->addLayout(valinnat);
+
+    kyselyTaulu_ = new QTableWidget(0, 6);
+    kyselyTaulu_->setHorizontalHeaderLabels( QStringList() << tr("Alue") << tr("Kysely") << tr("Parametrit")
+                                             << tr("Rivit") << tr("ms") << tr("Toistoja"));
+    kyselyTaulu_->horizontalHeader()->setSectionResizeMode(1, QHeaderView::Stretch);
+    kyselyTaulu_->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    kyselyTaulu_->setSelectionBehavior(QAbstractItemView::SelectRows);
+    kyselyTaulu_->verticalHeader()->hide();
+    leiska->addWidget(kyselyTaulu_);
+
+    connect( paivitaNappi, &QPushButton::clicked, this, &DevTool::naytaKyselyt);
+    connect( toistoKynnys_, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), this, &DevTool::naytaKyselyt);
+    connect( tyhjennaNappi, &QPushButton::clicked, this, [this] { KyselyProfiloija::tyhjenna(); naytaKyselyt(); });
+    connect( vieNappi, &QPushButton::clicked, this, &DevTool::vieJalki);
+
+    ui->tabWidget->addTab(sivu, tr("Kyselyt"));
+    naytaKyselyt();
+}
@@ -22,6 +22,9 @@
 #include <QDialog>
 #include <QMap>
 
+class QTableWidget;
+class QSpinBox;
+
 namespace Ui {
 class DevTool;
 }
@@ -46,6 +49,12 @@ protected slots:
     void uusiPeli();
     void peliNapautus(int ruutu);
 
+    /**
+     * @brief Näyttää profiloijan kirjaamat kyselyt ja merkitsee toistuvat
+     */
+    void naytaKyselyt();
+    void vieJalki();
+
 protected:
     /**
      * @brief Tarkastaa voiton ja ilmoittaa tuloksen
@@ -65,6 +74,10 @@ protected:
     QVector<int> peliRuudut_;
     bool pelissa_ = true;
 
+    void alustaProfiloija();
+    QTableWidget *kyselyTaulu_;
+    QSpinBox *toistoKynnys_;
+
 
 private:
     Ui::DevTool *ui;
@@ -60,7 +60,9 @@ bool Tuonti::tuo(const QString &tiedostonnimi, KirjausWg *wg)
     if( data.startsWith("%PDF"))
     {
         PdfTuonti pdftuonti(wg);
-        return pdftuonti.tuo(data);
+        bool liitteeksi = pdftuonti.tuo(data);
+        pdftuonti.kirjaaOterivit();
+        return liitteeksi;
     }
 
     QString ytunnus = QString( data.left(11).right(9) );
@@ -91,12 +93,16 @@ bool Tuonti::tuo(const QString &tiedostonnimi, KirjausWg *wg)
     else if( CsvTuonti::onkoCsv(data))
     {
         CsvTuonti csvtuonti(wg);
-        return csvtuonti.tuo(data);
+        bool liitteeksi = csvtuonti.tuo(data);
+        csvtuonti.kirjaaOterivit();
+        return liitteeksi;
     }
     else if( data.startsWith("T00322100"))  // Konekielisen tiliotteen TITO-tiedoston alkutunniste
     {
         TitoTuonti titotuonti(wg);
-        return titotuonti.tuo(data);
+        bool liitteeksi = titotuonti.tuo(data);
+        titotuonti.kirjaaOterivit();
+        return liitteeksi;
     }
 
     return true;
@@ -210,12 +216,18 @@ void Tuonti::oterivi(QDate pvm, qlonglong sentit, const QString& iban, QString v
     viite.replace( QRegularExpression("^0*"),"");
 
 
-    // Tuplatuonnin esto
+    // Tuplatuonnin esto: sama tapahtuma jo kirjanpidossa tai aiemmin samassa tiedostossa
     if(!arkistotunnus.isEmpty())
     {
-    QSqlQuery tupla( QString("SELECT id FROM vienti WHERE arkistotunnus='%1'").arg(arkistotunnus));
-    if( tupla.next() )
-        return;
+        if( arkistotunnukset_.contains(arkistotunnus))
+            return;
+        arkistotunnukset_.insert(arkistotunnus);
+
+        QSqlQuery& tupla = kp()->kysely("SELECT id FROM vienti WHERE arkistotunnus=:arkistotunnus");
+        tupla.bindValue(":arkistotunnus", arkistotunnus);
+        tupla.exec();
+        if( tupla.next() )
+            return;
     }
 
     VientiRivi vastarivi;
@@ -275,7 +287,7 @@ void Tuonti::oterivi(QDate pvm, qlonglong sentit, const QString& iban, QString v
                 EhdotusModel veronkuittaus;
                 veronkuittaus.lisaaVienti(verodebet);
                 veronkuittaus.lisaaVienti(verokredit);
-                veronkuittaus.tallenna( kirjausWg()->model()->vientiModel() );
+                oterivit_.append( veronkuittaus.viennit() );
 
             }
         }
@@ -334,6 +346,11 @@ void Tuonti::oterivi(QDate pvm, qlonglong sentit, const QString& iban, QString v
     ehdotus.lisaaVienti(rivi);
     ehdotus.lisaaVienti(vastarivi);
     ehdotus.viimeisteleMaksuperusteinen();
-    ehdotus.tallenna( kirjausWg()->model()->vientiModel() );
+    oterivit_.append( ehdotus.viennit() );
+}
 
+void Tuonti::kirjaaOterivit()
+{
+    kirjausWg()->model()->vientiModel()->lisaaViennit( oterivit_ );
+    oterivit_.clear();
 }
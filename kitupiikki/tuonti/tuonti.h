@@ -28,9 +28,12 @@
 #define TUONTI_H
 
 #include <QString>
+#include <QList>
+#include <QSet>
 
 #include "db/tositelajimodel.h"
 #include "db/tili.h"
+#include "db/vientimodel.h"
 
 class KirjausWg;
 
@@ -103,10 +106,24 @@ protected:
      */
     void oterivi(QDate pvm, qlonglong sentit, const QString &iban, QString viite, const QString &arkistotunnus, QString selite);
 
+    /**
+     * @brief Lisää tiliotteelta tuodut viennit tositteelle
+     *
+     * oterivi() kerää viennit ensin talteen, ja ne lisätään tositteen
+     * VientiModeliin yhdellä kertaa tuonnin lopuksi, jottei pitkän
+     * tiliotteen jokainen rivi päivitä näkymää ja summia erikseen.
+     *
+     * @since 1.1
+     */
+    void kirjaaOterivit();
+
     Tili tiliotetili() const { return tiliotetili_; }
 
     KirjausWg* kirjausWg_;
     Tili tiliotetili_;
+
+    QList<VientiRivi> oterivit_;        /** Tuodut, vielä tositteelle lisäämättömät viennit */
+    QSet<QString> arkistotunnukset_;    /** Tässä tuonnissa jo käsitellyt arkistotunnukset */
 };
 
 #endif // TUONTI_H
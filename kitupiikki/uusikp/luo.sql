@@ -26,6 +26,16 @@ CREATE TABLE tilikausi (
     json   TEXT
 );
 
+CREATE TABLE budjetti (
+    tilikausi       DATE NOT NULL
+                            REFERENCES tilikausi(alkaa) ON DELETE CASCADE
+                                                        ON UPDATE CASCADE,
+    kohdennus       INTEGER NOT NULL DEFAULT(0),
+    tilinro         INTEGER NOT NULL,
+    sentit          BIGINT NOT NULL,
+    PRIMARY KEY (tilikausi, kohdennus, tilinro)
+);
+
 CREATE TABLE tositelaji (
     id       INTEGER         PRIMARY KEY AUTOINCREMENT,
     tunnus   VARCHAR(5)      UNIQUE NOT NULL,
@@ -69,6 +79,21 @@ CREATE TABLE kohdennus (
 INSERT INTO kohdennus(id, nimi, tyyppi) VALUES(0,"Yleinen",0);
 
 
+CREATE TABLE asiakas (
+    id                      INTEGER PRIMARY KEY AUTOINCREMENT,
+    nimi                    VARCHAR(60) NOT NULL UNIQUE,
+    osoite                  TEXT,
+    email                   VARCHAR(120),
+    ytunnus                 VARCHAR(20),
+    verkkolaskuosoite       VARCHAR(60),
+    verkkolaskuvalittaja    VARCHAR(60),
+    myynti                  BOOLEAN DEFAULT(0),
+    osto                    BOOLEAN DEFAULT(0),
+    muokattu                DATETIME
+);
+
+CREATE INDEX asiakas_nimi_index ON asiakas(nimi COLLATE NOCASE);
+
 CREATE TABLE vienti (
     id              INTEGER PRIMARY KEY AUTOINCREMENT,
     tosite          INTEGER REFERENCES tosite (id),
@@ -92,6 +117,7 @@ CREATE TABLE vienti (
     erapvm          DATE,
     arkistotunnus   VARCHAR(60),
     asiakas         VARCHAR(60),
+    asiakasid       INTEGER REFERENCES asiakas(id) ON DELETE SET NULL,
     json            TEXT,
     luotu           DATETIME,
     muokattu        DATETIME
@@ -99,11 +125,12 @@ CREATE TABLE vienti (
 
 CREATE INDEX vienti_tosite_index ON vienti(tosite);
 CREATE INDEX vienti_pvm_index ON vienti(pvm);
-CREATE INDEX vienti_tili_index ON vienti(tili);
-CREATE INDEX vienti_kodennus_index ON vienti(kohdennus);
-CREATE INDEX vienti_taseera_index ON vienti(eraid);
+CREATE INDEX vienti_tili_pvm_index ON vienti(tili, pvm, debetsnt, kreditsnt);
+CREATE INDEX vienti_kohdennus_pvm_index ON vienti(kohdennus, pvm);
+CREATE INDEX vienti_era_index ON vienti(eraid, debetsnt, kreditsnt);
 CREATE INDEX vienti_ibanviite_index ON vienti(iban,viite);
 CREATE INDEX vienti_arkisto_index ON vienti(arkistotunnus);
+CREATE INDEX vienti_asiakas_index ON vienti(asiakasid);
 
 CREATE TABLE liite (
     id       INTEGER      PRIMARY KEY AUTOINCREMENT,
@@ -146,6 +173,28 @@ CREATE TABLE merkkaus (
 CREATE INDEX merkkaus_vienti ON merkkaus(vienti);
 CREATE INDEX merkkaus_kohdennus ON merkkaus(kohdennus);
 
+CREATE TABLE laskurivi (
+    id              INTEGER PRIMARY KEY AUTOINCREMENT,
+    vienti          INTEGER NOT NULL
+                            REFERENCES vienti(id)  ON DELETE CASCADE
+                                                   ON UPDATE CASCADE,
+    rivi            INTEGER,
+    nimike          TEXT,
+    maara           REAL,
+    yksikko         VARCHAR(16),
+    tuote           INTEGER,
+    ahintasnt       REAL,
+    tilinro         INTEGER,
+    kohdennus       INTEGER DEFAULT(0),
+    alvkoodi        INTEGER DEFAULT(0),
+    alvprosentti    INTEGER DEFAULT(0),
+    nettosnt        BIGINT,
+    alvsnt          BIGINT,
+    yhteensasnt     BIGINT
+);
+
+CREATE INDEX laskurivi_vienti_index ON laskurivi(vienti);
+
 
 CREATE VIEW vientivw AS
     SELECT vienti.id as vientiId,
@@ -0,0 +1,9 @@
+CREATE INDEX IF NOT EXISTS vienti_tili_pvm_index ON vienti(tili, pvm, debetsnt, kreditsnt);
+CREATE INDEX IF NOT EXISTS vienti_kohdennus_pvm_index ON vienti(kohdennus, pvm);
+CREATE INDEX IF NOT EXISTS vienti_era_index ON vienti(eraid, debetsnt, kreditsnt);
+
+DROP INDEX IF EXISTS vienti_tili_index;
+DROP INDEX IF EXISTS vienti_kodennus_index;
+DROP INDEX IF EXISTS vienti_taseera_index;
+
+ANALYZE;
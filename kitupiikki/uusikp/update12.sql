@@ -0,0 +1,21 @@
+CREATE TABLE IF NOT EXISTS laskurivi (
+    id              INTEGER PRIMARY KEY AUTOINCREMENT,
+    vienti          INTEGER NOT NULL
+                            REFERENCES vienti(id)  ON DELETE CASCADE
+                                                   ON UPDATE CASCADE,
+    rivi            INTEGER,
+    nimike          TEXT,
+    maara           REAL,
+    yksikko         VARCHAR(16),
+    tuote           INTEGER,
+    ahintasnt       REAL,
+    tilinro         INTEGER,
+    kohdennus       INTEGER DEFAULT(0),
+    alvkoodi        INTEGER DEFAULT(0),
+    alvprosentti    INTEGER DEFAULT(0),
+    nettosnt        BIGINT,
+    alvsnt          BIGINT,
+    yhteensasnt     BIGINT
+);
+
+CREATE INDEX IF NOT EXISTS laskurivi_vienti_index ON laskurivi(vienti);
@@ -0,0 +1,9 @@
+CREATE TABLE IF NOT EXISTS budjetti (
+    tilikausi       DATE NOT NULL
+                            REFERENCES tilikausi(alkaa) ON DELETE CASCADE
+                                                        ON UPDATE CASCADE,
+    kohdennus       INTEGER NOT NULL DEFAULT(0),
+    tilinro         INTEGER NOT NULL,
+    sentit          BIGINT NOT NULL,
+    PRIMARY KEY (tilikausi, kohdennus, tilinro)
+);
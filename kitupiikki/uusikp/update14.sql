@@ -0,0 +1,25 @@
+CREATE TABLE IF NOT EXISTS asiakas (
+    id                      INTEGER PRIMARY KEY AUTOINCREMENT,
+    nimi                    VARCHAR(60) NOT NULL UNIQUE,
+    osoite                  TEXT,
+    email                   VARCHAR(120),
+    ytunnus                 VARCHAR(20),
+    verkkolaskuosoite       VARCHAR(60),
+    verkkolaskuvalittaja    VARCHAR(60),
+    myynti                  BOOLEAN DEFAULT(0),
+    osto                    BOOLEAN DEFAULT(0),
+    muokattu                DATETIME
+);
+
+CREATE INDEX IF NOT EXISTS asiakas_nimi_index ON asiakas(nimi COLLATE NOCASE);
+
+ALTER TABLE vienti ADD COLUMN asiakasid INTEGER REFERENCES asiakas(id) ON DELETE SET NULL;
+
+INSERT OR IGNORE INTO asiakas(nimi, myynti, osto)
+    SELECT asiakas, max(iban IS NULL), max(iban IS NOT NULL) FROM vienti
+    WHERE asiakas IS NOT NULL AND asiakas <> '' GROUP BY asiakas;
+
+UPDATE vienti SET asiakasid = (SELECT id FROM asiakas WHERE asiakas.nimi=vienti.asiakas)
+    WHERE asiakas IS NOT NULL AND asiakas <> '';
+
+CREATE INDEX IF NOT EXISTS vienti_asiakas_index ON vienti(asiakasid);
@@ -0,0 +1,7 @@
+CREATE VIRTUAL TABLE IF NOT EXISTS tositehaku USING fts5(otsikko, kommentti, viennit, tokenize='unicode61');
+CREATE VIRTUAL TABLE IF NOT EXISTS liitehaku USING fts5(tosite UNINDEXED, otsikko, teksti, tokenize='unicode61');
+
+INSERT INTO tositehaku(rowid, otsikko, kommentti, viennit)
+    SELECT tosite.id, otsikko, kommentti, group_concat( coalesce(selite,'') || ' ' || coalesce(asiakas,''), ' ')
+    FROM tosite LEFT OUTER JOIN vienti ON vienti.tosite=tosite.id
+    WHERE tosite.id NOT IN (SELECT rowid FROM tositehaku) GROUP BY tosite.id;
@@ -139,23 +139,42 @@ void UusiKirjanpito::naytaOhje()
 
 bool UusiKirjanpito::alustaKirjanpito()
 {
-    // Ladataan karttatiedosto
-    QMap<QString,QStringList> kartta = lueKtkTiedosto( field("tilikartta").toString() );
-
     // Näyttää QProgressDialogin jotta käyttäjä ei hermostu
-
-    int prosessiluku = 10;
-    QProgressDialog progDlg(tr("Luodaan uutta kirjanpitoa"), QString(), 1, prosessiluku);
+    QProgressDialog progDlg(tr("Luodaan uutta kirjanpitoa"), QString(), 1, 10);
 
     progDlg.setMinimumDuration(0);
     progDlg.setValue(0);
     progDlg.setWindowModality(Qt::WindowModal);
     qApp->processEvents();
 
+    QVariantMap valinnat;
+    for( const QString& kentta : QStringList{"tilikartta","nimi","ytunnus","iban","harjoitus","muoto",
+                                             "alkaa","paattyy","onekakausi","edalkoi","edpaattyi",
+                                             "suoriteperuste","laskuperuste","maksuperuste"})
+        valinnat.insert(kentta, field(kentta));
 
     QString polku = field("sijainti").toString() + "/" + field("tiedosto").toString();
 
-    progDlg.setValue( progDlg.value() + 1 );
+    QString virhe;
+    bool onnistui = luoKirjanpito(polku, valinnat, &virhe, &progDlg);
+    if( !virhe.isEmpty())
+        QMessageBox::critical(nullptr, tr("Kirjanpidon luominen epäonnistui"), virhe);
+
+    return onnistui;
+}
+
+bool UusiKirjanpito::luoKirjanpito(const QString &polku, const QVariantMap &valinnat, QString *virhe, QProgressDialog *edistyminen)
+{
+    // Ladataan karttatiedosto
+    QMap<QString,QStringList> kartta = lueKtkTiedosto( valinnat.value("tilikartta").toString() );
+    QString iban = valinnat.value("iban").toString().simplified().remove(' ');
+
+    auto edistys = [edistyminen] {
+        if( edistyminen )
+            edistyminen->setValue( edistyminen->value() + 1 );
+    };
+
+    edistys();
 
     // Luodaan tietokanta
     {
@@ -163,7 +182,7 @@ bool UusiKirjanpito::alustaKirjanpito()
         db.setDatabaseName(polku);
         if( !db.open())
         {
-            QMessageBox::critical(nullptr, tr("Kirjanpidon luominen epäonnistui"), tr("Tietokannan luominen epäonnistui seuraavan virheen takia: %1").arg( db.lastError().text() ));
+            *virhe = tr("Tietokannan luominen epäonnistui seuraavan virheen takia: %1").arg( db.lastError().text() );
             return false;
         }
 
@@ -172,7 +191,7 @@ bool UusiKirjanpito::alustaKirjanpito()
 
         QSqlQuery query(db);
 
-        progDlg.setValue( progDlg.value() + 1 );
+        edistys();
 
         // Luodaan tietokanta
         // Tietokannan luontikäskyt ovat resurssitiedostossa luo.sql
@@ -189,14 +208,26 @@ bool UusiKirjanpito::alustaKirjanpito()
         {
             if(!query.exec(kysely))
             {
-                QMessageBox::critical(nullptr, tr("Kirjanpidon luominen epäonnostui"), tr("Virhe tietokantaa luotaessa: %1 (%2)").arg(query.lastError().text()).arg(kysely) );
+                *virhe = tr("Virhe tietokantaa luotaessa: %1 (%2)").arg(query.lastError().text()).arg(kysely);
                 return false;
             }
             qApp->processEvents();
 
         }
 
-        progDlg.setValue( progDlg.value() + 1 );
+        // Tekstihaun indeksi luodaan samoin kuin tietokantaa päivitettäessä.
+        // Ilman SQLiten FTS5-tukea kirjanpito toimii ilman indeksiä.
+        QFile hakutiedosto(":/sql/update15.sql");
+        hakutiedosto.open(QIODevice::ReadOnly);
+        QString hakuluonti = QString::fromUtf8( hakutiedosto.readAll() );
+        hakuluonti.replace("\n"," ");
+        for( const QString& kysely : hakuluonti.split(";"))
+        {
+            if( !kysely.trimmed().isEmpty() && !query.exec(kysely))
+                qWarning() << "Tekstihaun indeksiä ei voitu luoda" << query.lastError().text();
+        }
+
+        edistys();
 
         AsetusModel asetukset(&db, nullptr, true);
 
@@ -212,14 +243,14 @@ bool UusiKirjanpito::alustaKirjanpito()
             }
         }
 
-        progDlg.setValue( progDlg.value() + 1 );
+        edistys();
 
 
         // Kirjataan tietokannan perustietoja
 
-        asetukset.aseta("Nimi", field("nimi").toString());
-        asetukset.aseta("Ytunnus", field("ytunnus").toString());
-        asetukset.aseta("Harjoitus", field("harjoitus").toBool());
+        asetukset.aseta("Nimi", valinnat.value("nimi").toString());
+        asetukset.aseta("Ytunnus", valinnat.value("ytunnus").toString());
+        asetukset.aseta("Harjoitus", valinnat.value("harjoitus").toBool());
 
         if( asetukset.onko("Ytunnus"))
         {
@@ -229,14 +260,14 @@ bool UusiKirjanpito::alustaKirjanpito()
         }
 
         // Valittu muoto
-        if( field("muoto").toString() != "-")
-            asetukset.aseta("Muoto", field("muoto").toString());
+        if( !valinnat.value("muoto").toString().isEmpty() && valinnat.value("muoto").toString() != "-")
+            asetukset.aseta("Muoto", valinnat.value("muoto").toString());
 
         asetukset.aseta("Luotu", QDate::currentDate());
         asetukset.aseta("LuotuVersiolla", qApp->applicationVersion());
         asetukset.aseta("KpVersio",  Kirjanpito::TIETOKANTAVERSIO );
 
-        progDlg.setValue( progDlg.value() + 1 );
+        edistys();
 
 
 
@@ -270,12 +301,12 @@ bool UusiKirjanpito::alustaKirjanpito()
                 if( !mats.captured("asti").isEmpty() )
                     tili.json()->set("Asti", mats.captured("asti").toInt());
 
-                if( tili.onko(TiliLaji::PANKKITILI) && !field("iban").toString().isEmpty())
+                if( tili.onko(TiliLaji::PANKKITILI) && !iban.isEmpty())
                 {
                     // #70 Pankkitili jo luontivelhossa
                     // Annettu IBAN-numero yhdistetään ensimmäiseen pankkitiliin
-                    tili.json()->set("IBAN", field("iban").toString().simplified().remove(' '));
-                    setField("iban",QVariant(""));
+                    tili.json()->set("IBAN", iban);
+                    iban.clear();
                     asetukset.aseta("LaskuTili", tili.numero());
                 }
 
@@ -285,9 +316,9 @@ bool UusiKirjanpito::alustaKirjanpito()
 
         }
 
-        progDlg.setValue( progDlg.value() + 1 );
+        edistys();
         tilit.tallenna(true);
-        progDlg.setValue( progDlg.value() + 1 );
+        edistys();
 
         // Tositelajien tallentaminen
 
@@ -308,49 +339,49 @@ bool UusiKirjanpito::alustaKirjanpito()
             }
         }
         lajit.tallenna();
-        progDlg.setValue( progDlg.value() + 1 );
+        edistys();
 
         // Tilikausien kirjoittaminen
         // Nykyinen tilikausi
 
         TilikausiModel tilikaudet(&db);
-        tilikaudet.lisaaTilikausi( Tilikausi( field("alkaa").toDate(), field("paattyy").toDate() ));
+        tilikaudet.lisaaTilikausi( Tilikausi( valinnat.value("alkaa").toDate(), valinnat.value("paattyy").toDate() ));
 
         // Alv-tietojen oletukset
-        asetukset.aseta("AlvIlmoitus", field("alkaa").toDate().addDays(-1));
+        asetukset.aseta("AlvIlmoitus", valinnat.value("alkaa").toDate().addDays(-1));
         asetukset.aseta("AlvKausi",1);
         // Laskunumero
         asetukset.aseta("LaskuSeuraavaId",1009);
 
-        if( field("onekakausi").toBool())
+        if( valinnat.value("onekakausi").toBool())
         {
             // Ensimmäinen tilikausi, tilinavausta ei tarvita
             asetukset.aseta("Tilinavaus",0);
-            asetukset.aseta("TilitPaatetty", field("alkaa").toDate().addDays(-1));
+            asetukset.aseta("TilitPaatetty", valinnat.value("alkaa").toDate().addDays(-1));
         }
         else
         {
             // Edellinen tilikausi.
-            tilikaudet.lisaaTilikausi( Tilikausi(field("edalkoi").toDate(), field("edpaattyi").toDate()  ) );
+            tilikaudet.lisaaTilikausi( Tilikausi(valinnat.value("edalkoi").toDate(), valinnat.value("edpaattyi").toDate()  ) );
 
             asetukset.aseta("Tilinavaus", 2);
-            asetukset.aseta("TilinavausPvm", field("edpaattyi").toDate());
+            asetukset.aseta("TilinavausPvm", valinnat.value("edpaattyi").toDate());
 
             // #40 Mahdollisuus muokata myös tilinavauskirjausta
-            asetukset.aseta("TilitPaatetty", field("edpaattyi").toDate().addDays(-1));
+            asetukset.aseta("TilitPaatetty", valinnat.value("edpaattyi").toDate().addDays(-1));
         }
 
-        progDlg.setValue( progDlg.value() + 1 );
+        edistys();
 
         // Kirjoitetaan nollatosite tilien avaamiseen
-        if( !field("onekakausi").toBool())
+        if( !valinnat.value("onekakausi").toBool())
         {
             query.prepare("INSERT INTO TOSITE(id,pvm,otsikko,laji,tunniste) "
                           "VALUES (0,?,\"Tilinavaus\",0,0)");
-            query.addBindValue( field("edpaattyi").toDate());
+            query.addBindValue( valinnat.value("edpaattyi").toDate());
             query.exec();
         }        
-        progDlg.setValue( progDlg.value() + 1 );
+        edistys();
 
         // Yleisskripti
         Skripti::suorita( asetukset.lista("LuontiSkripti"), &asetukset, &tilit, &lajit);
@@ -362,17 +393,21 @@ bool UusiKirjanpito::alustaKirjanpito()
         // Kirjausperusteeseen liittyvät skripti
         // Jos velhossa on määritelty kirjausperuste, tehdään sen perusteella valintoja
 
-        if( field("suoriteperuste").toBool())
+        if( valinnat.value("suoriteperuste").toBool())
             Skripti::suorita( asetukset.lista("Kirjaamisperuste/Suoriteperuste"), &asetukset, &tilit, &lajit );
-        else if( field("laskuperuste").toBool())
+        else if( valinnat.value("laskuperuste").toBool())
             Skripti::suorita( asetukset.lista("Kirjaamisperuste/Laskuperuste"), &asetukset, &tilit, &lajit );
-        else if( field("maksuperuste").toBool())
+        else if( valinnat.value("maksuperuste").toBool())
             Skripti::suorita( asetukset.lista("Kirjaamisperuste/Maksuperuste"), &asetukset, &tilit, &lajit );
 
-        progDlg.setValue( prosessiluku );
+        // Kyselysuunnittelijan tilastot tilikartan ja asetusten tauluista
+        query.exec("ANALYZE");
+
+        if( edistyminen )
+            edistyminen->setValue( edistyminen->maximum() );
 
         if( db.lastError().isValid())
-            QMessageBox::critical(nullptr, tr("Virhe kirjanpitoa luotaessa"), tr("Tietokantaa luotaessa tapahtui virhe: %1").arg(db.lastError().text()));
+            *virhe = tr("Tietokantaa luotaessa tapahtui virhe: %1").arg(db.lastError().text());
 
         db.close();
 
@@ -20,9 +20,12 @@
 
 #include <QWizard>
 #include <QMap>
+#include <QVariantMap>
 
 #include "ui_intro.h"
 
+class QProgressDialog;
+
 /**
   * @dir uusikp
   * @brief Uuden kirjanpidon luomiseen ja tilikartan päivitykseen liittyvät luokat
@@ -67,6 +70,24 @@ public:
      */
     static QMap<QString,QStringList> lueKtkTiedosto(const QString& polku);
 
+    /**
+     * @brief Luo kirjanpidon tietokannan ilman valintavelhoa
+     *
+     * Velho käyttää tätä valinnoillaan, ja suorituskykymittaukset luovat
+     * tällä mittauksissa käytettävät kirjanpidot.
+     *
+     * @param polku Luotavan tietokantatiedoston polku
+     * @param valinnat Velhon kenttiä vastaavat valinnat: tilikartta, nimi, ytunnus, iban,
+     *        harjoitus, muoto, alkaa, paattyy, onekakausi, edalkoi, edpaattyi sekä
+     *        suoriteperuste, laskuperuste tai maksuperuste
+     * @param virhe Virheilmoitus, jos luomisessa tapahtui virhe
+     * @param edistyminen Edistymistä näyttävä dialogi tai nullptr
+     * @return Tosi, jos tietokanta luotiin
+     * @since 1.1
+     */
+    static bool luoKirjanpito(const QString& polku, const QVariantMap& valinnat,
+                              QString* virhe, QProgressDialog* edistyminen = nullptr);
+
 
 protected slots:
     /**